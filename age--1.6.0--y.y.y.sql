@@ -51,3 +51,196 @@ CREATE FUNCTION ag_catalog._ag_enforce_edge_uniqueness4(graphid, graphid, graphi
     STABLE
 PARALLEL SAFE
 as 'MODULE_PATHNAME';
+
+CREATE FUNCTION ag_catalog.age_graph_change_trigger()
+    RETURNS trigger
+    LANGUAGE c
+AS 'MODULE_PATHNAME';
+
+-- new labels get the change triggers when they are created, add them to the
+-- existing ones
+DO $$
+DECLARE
+    label_relation regclass;
+BEGIN
+    FOR label_relation IN SELECT relation FROM ag_catalog.ag_label
+    LOOP
+        EXECUTE format('CREATE TRIGGER _ag_graph_changes '
+                       'AFTER INSERT OR UPDATE OR DELETE ON %s '
+                       'FOR EACH ROW EXECUTE FUNCTION '
+                       'ag_catalog.age_graph_change_trigger()',
+                       label_relation);
+        EXECUTE format('CREATE TRIGGER _ag_graph_truncate '
+                       'AFTER TRUNCATE ON %s '
+                       'FOR EACH STATEMENT EXECUTE FUNCTION '
+                       'ag_catalog.age_graph_change_trigger()',
+                       label_relation);
+    END LOOP;
+END;
+$$;
+
+-- function to find the shortest path(s) for shortestPath and allShortestPaths
+CREATE FUNCTION ag_catalog.age_vle_shortest_path(IN agtype, IN agtype, IN agtype,
+                                                 IN agtype, IN agtype, IN agtype,
+                                                 IN agtype, IN agtype,
+                                                 OUT edges agtype)
+    RETURNS SETOF agtype
+LANGUAGE C
+STABLE
+CALLED ON NULL INPUT
+PARALLEL UNSAFE
+AS 'MODULE_PATHNAME';
+
+-- function to find the cheapest path(s) over a numeric edge property
+CREATE FUNCTION ag_catalog.age_weighted_shortest_path(IN agtype, IN agtype,
+                                                      IN agtype, IN agtype,
+                                                      IN agtype, IN agtype,
+                                                      IN agtype,
+                                                      OUT path agtype,
+                                                      OUT cost agtype)
+    RETURNS SETOF record
+LANGUAGE C
+STABLE
+CALLED ON NULL INPUT
+PARALLEL UNSAFE
+AS 'MODULE_PATHNAME';
+
+-- planner support to access the properties of built vertices and edges
+CREATE FUNCTION ag_catalog.agtype_access_operator_support(internal)
+    RETURNS internal
+    LANGUAGE c
+    IMMUTABLE
+STRICT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+ALTER FUNCTION ag_catalog.agtype_access_operator(VARIADIC agtype[])
+    SUPPORT ag_catalog.agtype_access_operator_support;
+
+CREATE FUNCTION ag_catalog.age_properties_support(internal)
+    RETURNS internal
+    LANGUAGE c
+    IMMUTABLE
+STRICT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+ALTER FUNCTION ag_catalog.age_properties(agtype)
+    SUPPORT ag_catalog.age_properties_support;
+
+--
+-- Exports the vertices or edges of a label, as the columns of the column
+-- definition list. The id, start_id, end_id, and properties columns are those
+-- of the label table, any other column is the property of the same name.
+--
+CREATE FUNCTION ag_catalog.age_export_label(graph_name name, label_name name)
+    RETURNS SETOF record
+    LANGUAGE c
+    STABLE
+    AS 'MODULE_PATHNAME';
+
+-- statistics and selectivity estimation functions
+CREATE FUNCTION ag_catalog.agtype_typanalyze(internal)
+    RETURNS boolean
+    LANGUAGE c
+    STRICT
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION ag_catalog.agtype_eqsel(internal, oid, internal, integer)
+    RETURNS float8
+    LANGUAGE c
+    STABLE
+STRICT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION ag_catalog.agtype_neqsel(internal, oid, internal, integer)
+    RETURNS float8
+    LANGUAGE c
+    STABLE
+STRICT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION ag_catalog.agtype_ltsel(internal, oid, internal, integer)
+    RETURNS float8
+    LANGUAGE c
+    STABLE
+STRICT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION ag_catalog.agtype_lesel(internal, oid, internal, integer)
+    RETURNS float8
+    LANGUAGE c
+    STABLE
+STRICT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION ag_catalog.agtype_gtsel(internal, oid, internal, integer)
+    RETURNS float8
+    LANGUAGE c
+    STABLE
+STRICT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION ag_catalog.agtype_gesel(internal, oid, internal, integer)
+    RETURNS float8
+    LANGUAGE c
+    STABLE
+STRICT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION ag_catalog.agtype_contsel(internal, oid, internal, integer)
+    RETURNS float8
+    LANGUAGE c
+    STABLE
+STRICT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION ag_catalog.agtype_existssel(internal, oid, internal, integer)
+    RETURNS float8
+    LANGUAGE c
+    STABLE
+STRICT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+ALTER TYPE ag_catalog.agtype SET (ANALYZE = ag_catalog.agtype_typanalyze);
+
+ALTER OPERATOR ag_catalog.= (agtype, agtype)
+    SET (RESTRICT = ag_catalog.agtype_eqsel);
+ALTER OPERATOR ag_catalog.<> (agtype, agtype)
+    SET (RESTRICT = ag_catalog.agtype_neqsel);
+ALTER OPERATOR ag_catalog.< (agtype, agtype)
+    SET (RESTRICT = ag_catalog.agtype_ltsel);
+ALTER OPERATOR ag_catalog.> (agtype, agtype)
+    SET (RESTRICT = ag_catalog.agtype_gtsel);
+ALTER OPERATOR ag_catalog.<= (agtype, agtype)
+    SET (RESTRICT = ag_catalog.agtype_lesel);
+ALTER OPERATOR ag_catalog.>= (agtype, agtype)
+    SET (RESTRICT = ag_catalog.agtype_gesel);
+ALTER OPERATOR ag_catalog.@> (agtype, agtype)
+    SET (RESTRICT = ag_catalog.agtype_contsel);
+ALTER OPERATOR ag_catalog.@>> (agtype, agtype)
+    SET (RESTRICT = ag_catalog.agtype_contsel);
+ALTER OPERATOR ag_catalog.? (agtype, text)
+    SET (RESTRICT = ag_catalog.agtype_existssel);
+ALTER OPERATOR ag_catalog.? (agtype, agtype)
+    SET (RESTRICT = ag_catalog.agtype_existssel);
+
+-- function to find the vertices reachable by a VLE, each only once
+CREATE FUNCTION ag_catalog.age_vle_reachable(IN agtype, IN agtype, IN agtype,
+                                             IN agtype, IN agtype, IN agtype,
+                                             IN agtype, IN agtype,
+                                             OUT edges agtype)
+    RETURNS SETOF agtype
+LANGUAGE C
+STABLE
+CALLED ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
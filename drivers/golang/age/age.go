@@ -260,7 +260,7 @@ func (c *CypherCursor) Next() bool {
 func (c *CypherCursor) GetRow() ([]Entity, error) {
 	var gstrs = make([]interface{}, c.columnCount)
 	for i := 0; i < c.columnCount; i++ {
-		gstrs[i] = new(string)
+		gstrs[i] = new([]byte)
 	}
 
 	err := c.rows.Scan(gstrs...)
@@ -270,10 +270,10 @@ func (c *CypherCursor) GetRow() ([]Entity, error) {
 
 	entArr := make([]Entity, c.columnCount)
 	for i := 0; i < c.columnCount; i++ {
-		gstr := gstrs[i].(*string)
-		e, err := c.unmarshaler.unmarshal(*gstr)
+		gstr := gstrs[i].(*[]byte)
+		e, err := unmarshalBytes(c.unmarshaler, *gstr)
 		if err != nil {
-			fmt.Println(i, ">>", gstr)
+			fmt.Println(i, ">>", string(*gstr))
 			return nil, err
 		}
 		entArr[i] = e
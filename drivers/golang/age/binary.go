@@ -0,0 +1,258 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+package age
+
+import (
+	"encoding/binary"
+	"math"
+	"math/big"
+	"strings"
+)
+
+// agtype binary send/recv format, see drivers/README
+const (
+	agtSendVersionText   = 1
+	agtSendVersionBinary = 2
+
+	agtSendNull    = 0
+	agtSendString  = 1
+	agtSendInteger = 2
+	agtSendFloat   = 3
+	agtSendNumeric = 4
+	agtSendBool    = 5
+	agtSendArray   = 6
+	agtSendObject  = 7
+	agtSendVertex  = 8
+	agtSendEdge    = 9
+	agtSendPath    = 10
+)
+
+// UnmarshalBinary decodes an agtype value received in binary format, as sent
+// by agtype_send. Values sent as text (version 1) are parsed as text.
+func (p *AGUnmarshaler) UnmarshalBinary(data []byte) (Entity, error) {
+	if len(data) == 0 {
+		return NewSimpleEntity(nil), nil
+	}
+
+	switch data[0] {
+	case agtSendVersionText:
+		return p.unmarshal(string(data[1:]))
+	case agtSendVersionBinary:
+		mapper, _ := p.visitor.(*MapperVisitor)
+		d := &binaryDecoder{data: data, pos: 1, mapper: mapper}
+		rst, err := d.value()
+		if err != nil {
+			return nil, err
+		}
+		if d.pos != len(data) {
+			return nil, &AgeError{msg: "improper binary format in agtype"}
+		}
+		if !IsEntity(rst) {
+			rst = NewSimpleEntity(rst)
+		}
+		return rst.(Entity), nil
+	default:
+		return nil, &AgeError{msg: "unsupported agtype version number"}
+	}
+}
+
+// unmarshalBytes decodes a result column as scanned. Text output never starts
+// with the binary version byte, so a value that does was sent in binary.
+func unmarshalBytes(p Unmarshaller, data []byte) (Entity, error) {
+	if len(data) > 0 && data[0] == agtSendVersionBinary {
+		return p.UnmarshalBinary(data)
+	}
+	return p.unmarshal(string(data))
+}
+
+type binaryDecoder struct {
+	data   []byte
+	pos    int
+	mapper *MapperVisitor // maps vertices and edges to types, if set
+}
+
+func (d *binaryDecoder) next(n int) ([]byte, error) {
+	if n < 0 || d.pos+n > len(d.data) {
+		return nil, &AgeError{msg: "insufficient data left in agtype"}
+	}
+	b := d.data[d.pos : d.pos+n]
+	d.pos += n
+	return b, nil
+}
+
+func (d *binaryDecoder) int32() (int, error) {
+	b, err := d.next(4)
+	if err != nil {
+		return 0, err
+	}
+	return int(int32(binary.BigEndian.Uint32(b))), nil
+}
+
+func (d *binaryDecoder) string() (string, error) {
+	n, err := d.int32()
+	if err != nil {
+		return "", err
+	}
+	b, err := d.next(n)
+	if err != nil {
+		return "", err
+	}
+	return string(b), nil
+}
+
+func (d *binaryDecoder) value() (interface{}, error) {
+	b, err := d.next(1)
+	if err != nil {
+		return nil, err
+	}
+
+	switch tag := b[0]; tag {
+	case agtSendNull:
+		return nil, nil
+	case agtSendString:
+		return d.string()
+	case agtSendInteger:
+		b, err := d.next(8)
+		if err != nil {
+			return nil, err
+		}
+		return int64(binary.BigEndian.Uint64(b)), nil
+	case agtSendFloat:
+		b, err := d.next(8)
+		if err != nil {
+			return nil, err
+		}
+		return math.Float64frombits(binary.BigEndian.Uint64(b)), nil
+	case agtSendNumeric:
+		numStr, err := d.string()
+		if err != nil {
+			return nil, err
+		}
+		if strings.Contains(numStr, ".") {
+			bf, ok := new(big.Float).SetString(numStr)
+			if !ok {
+				return nil, &AgeParseError{msg: "Parse big float " + numStr}
+			}
+			return bf, nil
+		}
+		bi, ok := new(big.Int).SetString(numStr, 10)
+		if !ok {
+			return nil, &AgeParseError{msg: "Parse big int " + numStr}
+		}
+		return bi, nil
+	case agtSendBool:
+		b, err := d.next(1)
+		if err != nil {
+			return nil, err
+		}
+		return b[0] != 0, nil
+	case agtSendArray, agtSendPath:
+		count, err := d.int32()
+		if err != nil {
+			return nil, err
+		}
+		arr := []interface{}{}
+		entities := []Entity{}
+		for i := 0; i < count; i++ {
+			el, err := d.value()
+			if err != nil {
+				return nil, err
+			}
+			if tag == agtSendPath && d.mapper == nil {
+				entity, ok := el.(Entity)
+				if !ok {
+					return nil, &AgeError{msg: "path elements must be vertices and edges"}
+				}
+				entities = append(entities, entity)
+			} else {
+				arr = append(arr, el)
+			}
+		}
+		if tag == agtSendPath && d.mapper != nil {
+			return NewMapPath(arr), nil
+		}
+		if tag == agtSendPath {
+			return NewPath(entities), nil
+		}
+		return arr, nil
+	case agtSendObject, agtSendVertex, agtSendEdge:
+		count, err := d.int32()
+		if err != nil {
+			return nil, err
+		}
+		props := make(map[string]interface{})
+		for i := 0; i < count; i++ {
+			key, err := d.string()
+			if err != nil {
+				return nil, err
+			}
+			props[key], err = d.value()
+			if err != nil {
+				return nil, err
+			}
+		}
+		switch tag {
+		case agtSendVertex:
+			id, idOk := props["id"].(int64)
+			label, labelOk := props["label"].(string)
+			properties, propertiesOk := props["properties"].(map[string]interface{})
+			if !idOk || !labelOk || !propertiesOk {
+				return nil, &AgeError{msg: "improper vertex in agtype"}
+			}
+			if d.mapper != nil {
+				return d.mapped(id, func() (interface{}, error) {
+					return d.mapper.mapVertex(id, label, properties)
+				})
+			}
+			return NewVertex(id, label, properties), nil
+		case agtSendEdge:
+			id, idOk := props["id"].(int64)
+			label, labelOk := props["label"].(string)
+			startId, startIdOk := props["start_id"].(int64)
+			endId, endIdOk := props["end_id"].(int64)
+			properties, propertiesOk := props["properties"].(map[string]interface{})
+			if !idOk || !labelOk || !startIdOk || !endIdOk || !propertiesOk {
+				return nil, &AgeError{msg: "improper edge in agtype"}
+			}
+			if d.mapper != nil {
+				return d.mapped(id, func() (interface{}, error) {
+					return d.mapper.mapEdge(id, label, startId, endId, properties)
+				})
+			}
+			return NewEdge(id, label, startId, endId, properties), nil
+		}
+		return props, nil
+	default:
+		return nil, &AgeError{msg: "unknown agtype binary tag"}
+	}
+}
+
+// mapped returns the mapped vertex or edge of the id, mapping it the first
+// time, the same as the MapperVisitor does for text.
+func (d *binaryDecoder) mapped(id int64, mapFn func() (interface{}, error)) (interface{}, error) {
+	if v, ok := d.mapper.vcache[id]; ok {
+		return v, nil
+	}
+	v, err := mapFn()
+	if err != nil {
+		return nil, err
+	}
+	d.mapper.vcache[id] = v
+	return v, nil
+}
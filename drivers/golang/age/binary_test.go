@@ -0,0 +1,89 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+package age
+
+import (
+	"encoding/hex"
+	"math/big"
+	"reflect"
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+)
+
+func TestBinaryParsing(t *testing.T) {
+	unmarshaler := NewAGUnmarshaler()
+
+	decode := func(hexStr string) Entity {
+		data, err := hex.DecodeString(hexStr)
+		assert.Nil(t, err)
+		entity, err := unmarshaler.UnmarshalBinary(data)
+		assert.Nil(t, err)
+		return entity
+	}
+
+	assert.Equal(t, int64(1), decode("0131").(*SimpleEntity).AsInt64())
+	assert.Equal(t, int64(1), decode("02020000000000000001").(*SimpleEntity).AsInt64())
+
+	bf, _ := new(big.Float).SetString("1.5")
+	assert.Equal(t, bf, decode("020400000003312e35").(*SimpleEntity).AsBigFloat())
+
+	m := decode("020700000002000000016106000000030501000100000001780000000162033ff8000000000000").(*SimpleEntity).AsMap()
+	assert.Equal(t, []interface{}{true, nil, "x"}, m["a"])
+	assert.Equal(t, 1.5, m["b"])
+
+	v := decode("020800000003000000026964020000000000000001000000056c6162656c0100000001760000000a70726f706572746965730700000000").(*Vertex)
+	assert.Equal(t, int64(1), v.Id())
+	assert.Equal(t, "v", v.Label())
+	assert.Equal(t, 0, len(v.Props()))
+
+	_, err := unmarshaler.UnmarshalBinary([]byte{2, 99})
+	assert.NotNil(t, err)
+
+	// a vertex with a string id is an error, not a panic
+	data, _ := hex.DecodeString("020800000003000000026964010000000131" +
+		"000000056c6162656c0100000001760000000a70726f706572746965730700000000")
+	_, err = unmarshaler.UnmarshalBinary(data)
+	assert.NotNil(t, err)
+}
+
+func TestBinaryScanning(t *testing.T) {
+	unmarshaler := NewAGUnmarshaler()
+
+	// text results are parsed as text
+	entity, err := unmarshalBytes(unmarshaler, []byte("1"))
+	assert.Nil(t, err)
+	assert.Equal(t, int64(1), entity.(*SimpleEntity).AsInt64())
+
+	// a Person vertex, {"name": "Joe"}, in binary
+	data, _ := hex.DecodeString("02080000000300000002696402000000000000000100000005" +
+		"6c6162656c0100000006506572736f6e0000000a70726f706572746965730700000001" +
+		"000000046e616d6501000000034a6f65")
+
+	entity, err = unmarshalBytes(unmarshaler, data)
+	assert.Nil(t, err)
+	assert.Equal(t, "Person", entity.(*Vertex).Label())
+
+	mapper := NewAGMapper(nil)
+	mapper.PutType("Person", reflect.TypeOf(VPerson{}))
+
+	entity, err = unmarshalBytes(mapper, data)
+	assert.Nil(t, err)
+	assert.Equal(t, "Joe", entity.(*SimpleEntity).Value().(VPerson).Name)
+}
@@ -35,6 +35,7 @@ const MinInt = -MaxInt - 1
 
 type Unmarshaller interface {
 	unmarshal(text string) (Entity, error)
+	UnmarshalBinary(data []byte) (Entity, error)
 }
 
 type AGUnmarshaler struct {
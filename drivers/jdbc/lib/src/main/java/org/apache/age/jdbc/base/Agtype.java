@@ -19,10 +19,12 @@
 
 package org.apache.age.jdbc.base;
 
+import java.nio.charset.StandardCharsets;
 import java.sql.SQLException;
 import org.apache.age.jdbc.base.type.AgtypeAnnotation;
 import org.apache.age.jdbc.base.type.AgtypeList;
 import org.apache.age.jdbc.base.type.AgtypeMap;
+import org.postgresql.util.PGBinaryObject;
 import org.postgresql.util.PGobject;
 import org.postgresql.util.PSQLException;
 import org.postgresql.util.PSQLState;
@@ -45,7 +47,7 @@ import org.postgresql.util.PSQLState;
  * <li>{@link AgtypeMap}</li>
  * </ul>
  */
-public class Agtype extends PGobject implements Cloneable {
+public class Agtype extends PGobject implements PGBinaryObject, Cloneable {
 
     private Object obj;
 
@@ -94,6 +96,43 @@ public class Agtype extends PGobject implements Cloneable {
         super.setValue(value);
     }
 
+    /**
+     * Parses an Agtype value received in the binary format. {@inheritDoc}
+     *
+     * @param bytes  Binary representation of Agtype value.
+     * @param offset Offset of the value in bytes.
+     * @throws SQLException throws if the bytes cannot be parsed to a valid Agtype.
+     * @see AgtypeUtil#parseBinary(byte[], int)
+     */
+    @Override
+    public void setByteValue(byte[] bytes, int offset) throws SQLException {
+        try {
+            obj = AgtypeUtil.parseBinary(bytes, offset);
+        } catch (Exception e) {
+            throw new PSQLException("Parsing AgType failed", PSQLState.DATA_ERROR, e);
+        }
+
+        /* the text representation is built from obj when it is asked for */
+        value = null;
+    }
+
+    /**
+     * Agtype values are sent to the server as text, prefixed with the version number of the text
+     * format. {@inheritDoc}
+     */
+    @Override
+    public int lengthInBytes() {
+        return 1 + getValue().getBytes(StandardCharsets.UTF_8).length;
+    }
+
+    @Override
+    public void toBytes(byte[] bytes, int offset) {
+        byte[] text = getValue().getBytes(StandardCharsets.UTF_8);
+
+        bytes[offset] = 1;
+        System.arraycopy(text, 0, bytes, offset + 1, text.length);
+    }
+
     /**
      * Returns the value stored in Agtype as a String. Attempts to perform an implicit conversion of
      * types stored as non-strings values.
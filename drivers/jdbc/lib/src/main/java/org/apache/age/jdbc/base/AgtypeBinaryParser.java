@@ -0,0 +1,131 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+package org.apache.age.jdbc.base;
+
+import java.nio.BufferUnderflowException;
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
+import org.apache.age.jdbc.AgtypeUnrecognizedList;
+import org.apache.age.jdbc.AgtypeUnrecognizedMap;
+
+/**
+ * Decodes Agtype values received in the binary format. See drivers/README for the format. Values
+ * are decoded to the same objects as their text, vertices and edges to annotated maps and paths to
+ * annotated lists.
+ */
+final class AgtypeBinaryParser {
+
+    private static final int VERSION_TEXT = 1;
+    private static final int VERSION_BINARY = 2;
+
+    private static final int NULL = 0;
+    private static final int STRING = 1;
+    private static final int INTEGER = 2;
+    private static final int FLOAT = 3;
+    private static final int NUMERIC = 4;
+    private static final int BOOL = 5;
+    private static final int ARRAY = 6;
+    private static final int OBJECT = 7;
+    private static final int VERTEX = 8;
+    private static final int EDGE = 9;
+    private static final int PATH = 10;
+
+    private AgtypeBinaryParser() {
+    }
+
+    static Object parse(byte[] bytes, int offset) throws IllegalStateException {
+        ByteBuffer buffer = ByteBuffer.wrap(bytes, offset, bytes.length - offset);
+
+        try {
+            int version = buffer.get();
+            if (version == VERSION_TEXT) {
+                return AgtypeUtil.parse(new String(bytes, offset + 1, bytes.length - offset - 1,
+                    StandardCharsets.UTF_8));
+            }
+            if (version != VERSION_BINARY) {
+                throw new IllegalStateException("unsupported agtype version number " + version);
+            }
+
+            Object value = parseValue(buffer);
+            if (buffer.hasRemaining()) {
+                throw new IllegalStateException("improper binary format in agtype");
+            }
+            return value;
+        } catch (BufferUnderflowException e) {
+            throw new IllegalStateException("insufficient data left in agtype", e);
+        }
+    }
+
+    private static String parseString(ByteBuffer buffer) {
+        byte[] bytes = new byte[buffer.getInt()];
+        buffer.get(bytes);
+        return new String(bytes, StandardCharsets.UTF_8);
+    }
+
+    private static Object parseValue(ByteBuffer buffer) {
+        int tag = buffer.get();
+
+        switch (tag) {
+            case NULL:
+                return null;
+            case STRING:
+                return parseString(buffer);
+            case INTEGER:
+                return buffer.getLong();
+            case FLOAT:
+                return buffer.getDouble();
+            case NUMERIC:
+                /* the text parser reads numerics as doubles too */
+                return Double.parseDouble(parseString(buffer));
+            case BOOL:
+                return buffer.get() != 0;
+            case ARRAY:
+            case PATH: {
+                AgtypeUnrecognizedList list = new AgtypeUnrecognizedList();
+                int count = buffer.getInt();
+                for (int i = 0; i < count; i++) {
+                    list.add(parseValue(buffer));
+                }
+                if (tag == PATH) {
+                    list.setAnnotation("path");
+                }
+                return list;
+            }
+            case OBJECT:
+            case VERTEX:
+            case EDGE: {
+                AgtypeUnrecognizedMap map = new AgtypeUnrecognizedMap();
+                int count = buffer.getInt();
+                for (int i = 0; i < count; i++) {
+                    String key = parseString(buffer);
+                    map.put(key, parseValue(buffer));
+                }
+                if (tag == VERTEX) {
+                    map.setAnnotation("vertex");
+                } else if (tag == EDGE) {
+                    map.setAnnotation("edge");
+                }
+                return map;
+            }
+            default:
+                throw new IllegalStateException("unknown agtype binary tag " + tag);
+        }
+    }
+}
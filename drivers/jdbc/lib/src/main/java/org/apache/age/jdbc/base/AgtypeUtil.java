@@ -298,6 +298,18 @@ public class AgtypeUtil {
         return new AgtypeListBuilder();
     }
 
+    /**
+     * Converts an Agtype value received in the binary format into it's non-serialized value.
+     *
+     * @param bytes  Binary Agtype value to be parsed.
+     * @param offset Offset of the value in bytes.
+     * @return Parsed object that can be stored in {@link Agtype}
+     * @throws IllegalStateException if the value cannot be parsed into an Agtype.
+     */
+    public static Object parseBinary(byte[] bytes, int offset) throws IllegalStateException {
+        return AgtypeBinaryParser.parse(bytes, offset);
+    }
+
     /**
      * Converts a serialized Agtype value into it's non-serialized value.
      *
@@ -143,4 +143,42 @@ class AgtypeUtilTest {
     AgtypeMap agObject = (AgtypeMap) AgtypeUtil.parse("{}");
     assertEquals(0, agObject.size());
   }
+
+  private static byte[] hex(String hex) {
+    byte[] bytes = new byte[hex.length() / 2];
+    for (int i = 0; i < bytes.length; i++) {
+      bytes[i] = (byte) Integer.parseInt(hex.substring(i * 2, i * 2 + 2), 16);
+    }
+    return bytes;
+  }
+
+  @Test
+  void parseBinary() {
+    assertEquals(1L, AgtypeUtil.parseBinary(hex("0131"), 0));
+    assertEquals(1L, AgtypeUtil.parseBinary(hex("02020000000000000001"), 0));
+    assertEquals(1.5, AgtypeUtil.parseBinary(hex("020400000003312e35"), 0));
+
+    AgtypeMap agObject = (AgtypeMap) AgtypeUtil.parseBinary(hex(
+        "020700000002000000016106000000030501000100000001780000000162033ff8000000000000"), 0);
+    assertEquals(2, agObject.size());
+    assertEquals(1.5, agObject.getDouble("b"));
+    AgtypeList agArray = agObject.getList("a");
+    assertTrue(agArray.getBoolean(0));
+    assertNull(agArray.getObject(1));
+    assertEquals("x", agArray.getString(2));
+
+    AgtypeUnrecognizedMap vertex = (AgtypeUnrecognizedMap) AgtypeUtil.parseBinary(hex(
+        "020800000003000000026964020000000000000001000000056c6162656c0100000001760000000a"
+            + "70726f706572746965730700000000"), 0);
+    assertEquals("vertex", vertex.getAnnotation());
+    assertEquals(1L, vertex.getLong("id"));
+    assertEquals("v", vertex.getString("label"));
+  }
+
+  @Test
+  void parseInvalidBinary() {
+    assertThrows(IllegalStateException.class, () -> AgtypeUtil.parseBinary(hex("0263"), 0));
+    assertThrows(IllegalStateException.class, () -> AgtypeUtil.parseBinary(hex("0202"), 0));
+    assertThrows(IllegalStateException.class, () -> AgtypeUtil.parseBinary(hex("030000"), 0));
+  }
 }
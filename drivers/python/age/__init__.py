@@ -17,7 +17,7 @@ import psycopg.conninfo as conninfo
 from . import age
 from .age import *
 from .models import *
-from .builder import ResultHandler, DummyResultHandler, parseAgeValue, newResultHandler
+from .builder import ResultHandler, DummyResultHandler, parseAgeValue, parseAgeBinaryValue, newResultHandler
 from . import VERSION 
 
 def version():
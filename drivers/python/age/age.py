@@ -20,7 +20,7 @@ from psycopg.adapt import Loader
 from psycopg import sql
 from psycopg.client_cursor import ClientCursor
 from .exceptions import *
-from .builder import parseAgeValue
+from .builder import parseAgeValue, parseAgeBinaryValue
 
 
 _EXCEPTION_NoConnection = NoConnection()
@@ -44,6 +44,13 @@ class AgeLoader(psycopg.adapt.Loader):
         return parseAgeValue(data_bytes.decode('utf-8'))
 
 
+class AgeBinaryLoader(psycopg.adapt.Loader):
+    format = psycopg.pq.Format.BINARY
+
+    def load(self, data: bytes | bytearray | memoryview) -> Any | None:
+        return parseAgeBinaryValue(data)
+
+
 def setUpAge(conn:psycopg.connection, graphName:str, load_from_plugins:bool=False):
     with conn.cursor() as cursor:
         if load_from_plugins:
@@ -60,6 +67,7 @@ def setUpAge(conn:psycopg.connection, graphName:str, load_from_plugins:bool=Fals
 
         conn.adapters.register_loader(ag_info.oid, AgeLoader)
         conn.adapters.register_loader(ag_info.array_oid, AgeLoader)
+        conn.adapters.register_loader(ag_info.oid, AgeBinaryLoader)
 
         # Check graph exists
         if graphName != None:
@@ -21,6 +21,7 @@ from .exceptions import *
 from antlr4 import InputStream, CommonTokenStream, ParserRuleContext
 from antlr4.tree.Tree import TerminalNode
 from decimal import Decimal
+import struct
 
 resultHandler = None
 
@@ -208,3 +209,92 @@ class ResultVisitor(AgtypeVisitor):
             return path
 
         return ctx.accept(self)
+
+
+# agtype binary send/recv format, see drivers/README
+AGT_SEND_VERSION_TEXT = 1
+AGT_SEND_VERSION_BINARY = 2
+
+AGT_SEND_NULL = 0
+AGT_SEND_STRING = 1
+AGT_SEND_INTEGER = 2
+AGT_SEND_FLOAT = 3
+AGT_SEND_NUMERIC = 4
+AGT_SEND_BOOL = 5
+AGT_SEND_ARRAY = 6
+AGT_SEND_OBJECT = 7
+AGT_SEND_VERTEX = 8
+AGT_SEND_EDGE = 9
+AGT_SEND_PATH = 10
+
+def parseAgeBinaryValue(data, cursor=None):
+    if data is None:
+        return None
+
+    data = bytes(data)
+    try:
+        if data[0] == AGT_SEND_VERSION_TEXT:
+            return parseAgeValue(data[1:].decode('utf-8'))
+        if data[0] != AGT_SEND_VERSION_BINARY:
+            raise ValueError("unsupported agtype version number %d" % data[0])
+
+        value, pos = _decodeBinaryValue(data, 1)
+        if pos != len(data):
+            raise ValueError("improper binary format in agtype")
+        return value
+    except AGTypeError:
+        raise
+    except Exception as ex:
+        raise AGTypeError(data, ex)
+
+
+def _decodeBinaryString(data, pos):
+    (length,) = struct.unpack_from('>i', data, pos)
+    pos += 4
+    return data[pos:pos + length].decode('utf-8'), pos + length
+
+
+def _decodeBinaryValue(data, pos):
+    tag = data[pos]
+    pos += 1
+
+    if tag == AGT_SEND_NULL:
+        return None, pos
+    elif tag == AGT_SEND_STRING:
+        return _decodeBinaryString(data, pos)
+    elif tag == AGT_SEND_INTEGER:
+        return struct.unpack_from('>q', data, pos)[0], pos + 8
+    elif tag == AGT_SEND_FLOAT:
+        return struct.unpack_from('>d', data, pos)[0], pos + 8
+    elif tag == AGT_SEND_NUMERIC:
+        numStr, pos = _decodeBinaryString(data, pos)
+        return Decimal(numStr), pos
+    elif tag == AGT_SEND_BOOL:
+        return data[pos] != 0, pos + 1
+    elif tag in (AGT_SEND_ARRAY, AGT_SEND_PATH):
+        (count,) = struct.unpack_from('>i', data, pos)
+        pos += 4
+        li = list()
+        for i in range(count):
+            val, pos = _decodeBinaryValue(data, pos)
+            li.append(val)
+        if tag == AGT_SEND_PATH:
+            return Path(li), pos
+        return li, pos
+    elif tag in (AGT_SEND_OBJECT, AGT_SEND_VERTEX, AGT_SEND_EDGE):
+        (count,) = struct.unpack_from('>i', data, pos)
+        pos += 4
+        obj = dict()
+        for i in range(count):
+            name, pos = _decodeBinaryString(data, pos)
+            obj[name], pos = _decodeBinaryValue(data, pos)
+        if tag == AGT_SEND_VERTEX:
+            return Vertex(obj["id"], obj["label"], obj["properties"]), pos
+        if tag == AGT_SEND_EDGE:
+            edge = Edge(obj["id"], obj["label"], obj["properties"])
+            edge.start_id = obj["start_id"]
+            edge.end_id = obj["end_id"]
+            return edge, pos
+        return obj, pos
+
+    raise ValueError("unknown agtype binary tag %d" % tag)
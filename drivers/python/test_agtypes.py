@@ -128,5 +128,28 @@ class TestAgtype(unittest.TestCase):
         self.assertEqual(vertexEnd["name"],  "Joe")
 
 
+    def test_binary(self):
+
+        print("\nTesting Binary Parsing. Result : ",  end='')
+
+        self.assertEqual(age.parseAgeBinaryValue(bytes.fromhex("0131")), 1)
+        self.assertEqual(age.parseAgeBinaryValue(
+            bytes.fromhex("02020000000000000001")), 1)
+        self.assertEqual(age.parseAgeBinaryValue(
+            bytes.fromhex("020400000003312e35")), Decimal("1.5"))
+
+        mapVal = age.parseAgeBinaryValue(bytes.fromhex(
+            "020700000002000000016106000000030501000100000001780000000162033ff8000000000000"))
+        self.assertEqual(mapVal, {"a": [True, None, "x"], "b": 1.5})
+
+        vertex = age.parseAgeBinaryValue(bytes.fromhex(
+            "020800000003000000026964020000000000000001000000056c6162656c0100000001760000000a70726f706572746965730700000000"))
+        self.assertEqual(vertex.id,  1)
+        self.assertEqual(vertex.label,  "v")
+        self.assertEqual(vertex.properties,  {})
+
+        with self.assertRaises(age.AGTypeError):
+            age.parseAgeBinaryValue(bytes.fromhex("0263"))
+
 if __name__ == '__main__':
     unittest.main()
@@ -124,11 +124,49 @@ SELECT * FROM ag_graph_1._ag_label_edge;
 -- there should be warning messages
 SELECT * FROM cypher('ag_graph_1', $$ RETURN graph_stats('ag_graph_1') $$) AS (result agtype);
 
+-- graph versioning
+SET age.enable_graph_versioning = on;
+SELECT * FROM cypher('ag_graph_3', $$ MATCH (u) RETURN vertex_stats(u) $$) AS (result agtype);
+-- our own writes must invalidate the context
+SELECT * FROM cypher('ag_graph_3', $$ MATCH (u:vertex3) CREATE (u)-[:knows]->(u) $$) AS (result agtype);
+SELECT * FROM cypher('ag_graph_3', $$ MATCH (u) RETURN vertex_stats(u) $$) AS (result agtype);
+SELECT * FROM cypher('ag_graph_3', $$ MATCH ()-[e]->() DELETE e $$) AS (result agtype);
+SELECT * FROM cypher('ag_graph_3', $$ MATCH (u) RETURN vertex_stats(u) $$) AS (result agtype);
+-- as must rolled back ones
+BEGIN;
+SELECT * FROM cypher('ag_graph_3', $$ MATCH (u:vertex3) CREATE (u)-[:knows]->(u) $$) AS (result agtype);
+SELECT * FROM cypher('ag_graph_3', $$ MATCH (u) RETURN vertex_stats(u) $$) AS (result agtype);
+ROLLBACK;
+SELECT * FROM cypher('ag_graph_3', $$ MATCH (u) RETURN vertex_stats(u) $$) AS (result agtype);
+-- plain SQL changes are tracked by the label's change triggers
+INSERT INTO ag_graph_3.knows (start_id, end_id) VALUES ('844424930131969', '844424930131969');
+SELECT * FROM cypher('ag_graph_3', $$ MATCH (u) RETURN vertex_stats(u) $$) AS (result agtype);
+DELETE FROM ag_graph_3.knows;
+SELECT * FROM cypher('ag_graph_3', $$ MATCH (u) RETURN vertex_stats(u) $$) AS (result agtype);
+RESET age.enable_graph_versioning;
+-- load the label tables with parallel workers
+SET age.global_graph_load_workers = 2;
+SELECT * FROM cypher('ag_graph_3', $$ RETURN delete_global_graphs('ag_graph_3') $$) AS (result agtype);
+SELECT * FROM cypher('ag_graph_3', $$ MATCH (u) RETURN vertex_stats(u) $$) AS (result agtype);
+RESET age.global_graph_load_workers;
+-- export the vertices and edges of a label as typed columns
+SELECT * FROM create_graph('ag_graph_4');
+SELECT * FROM cypher('ag_graph_4', $$ CREATE (:person {name: 'Alice', age: 30, score: 1.5, active: true})-[:knows {since: 2001}]->(:person {name: 'Bob', age: 40, score: 2}) $$) AS (result agtype);
+SELECT * FROM age_export_label('ag_graph_4', 'person')
+    AS (id graphid, name text, age bigint, score float8, active boolean);
+SELECT * FROM age_export_label('ag_graph_4', 'knows')
+    AS (id graphid, start_id graphid, end_id graphid, since integer, properties agtype);
+-- properties of another type are errors
+SELECT * FROM age_export_label('ag_graph_4', 'person') AS (id graphid, name numeric);
+SELECT * FROM age_export_label('ag_graph_4', 'person') AS (id graphid, born date);
+SELECT * FROM age_export_label('ag_graph_4', 'nobody') AS (id graphid);
+
 --drop graphs
 
 SELECT * FROM drop_graph('ag_graph_1', true);
 SELECT * FROM drop_graph('ag_graph_2', true);
 SELECT * FROM drop_graph('ag_graph_3', true);
+SELECT * FROM drop_graph('ag_graph_4', true);
 -----------------------------------------------------------------------------------------------------------------------------
 --
 -- End of tests
@@ -808,6 +808,12 @@ SELECT agtype_access_operator('{"bool":false, "int":3, "float":3.14}', 'null');
 SELECT agtype_access_operator('{"bool":false, "int":3, "float":3.14}', 'true');
 SELECT agtype_access_operator('{"bool":false, "int":3, "float":3.14}', '2');
 SELECT agtype_access_operator('{"bool":false, "int":3, "float":3.14}', '2.0');
+-- constant key paths
+SELECT agtype_access_operator('{"a":{"b":{"c":1}}, "d":2}', '"a"', '"b"', '"c"');
+SELECT agtype_access_operator('{"a":{"b":1}}', '"a"', '"x"');
+SELECT agtype_access_operator('{"a":1}', '"a"', '"b"');
+SELECT agtype_access_operator(NULL, '"a"');
+SELECT agtype_access_operator(_agtype_build_vertex('1'::graphid, $$v$$, agtype_build_map('n', agtype_build_map('m', 'x'))), '"n"', '"m"');
 
 -- Test duplicate keys and null value
 -- expected: only the latest key, among duplicates, will be kept; and null will be removed
@@ -1121,6 +1127,17 @@ SELECT * FROM cypher('issue_2243', $$
     RETURN 9223372036854775807::integer % 9223372036854775807::numeric
   $$ ) as (result agtype);
 
+--
+-- agtype binary send, as text and in the binary form
+--
+SELECT agtype_send('1'::agtype);
+SET age.enable_agtype_binary_send = on;
+SELECT agtype_send('1'::agtype);
+SELECT agtype_send('{"a": [true, null, "x"], "b": 1.5}'::agtype);
+SELECT agtype_send('{"id": 1, "label": "v", "properties": {}}::vertex'::agtype);
+SELECT agtype_send('1.5::numeric'::agtype);
+RESET age.enable_agtype_binary_send;
+
 --
 -- Cleanup
 --
@@ -56,6 +56,68 @@ SELECT * FROM cypher(NULL, NULL) AS (result agtype);
 SELECT * FROM cypher() AS (result agtype);
 SELECT * FROM cypher(NULL) AS (result agtype);
 
+--
+-- property statistics
+--
+SELECT * FROM create_graph('analyze_stats');
+SELECT * FROM cypher('analyze_stats', $$ UNWIND range(1, 900) AS i CREATE (:person {country: 'US', age: i % 100}) $$) AS (result agtype);
+SELECT * FROM cypher('analyze_stats', $$ UNWIND range(1, 100) AS i CREATE (:person {country: 'NL', age: i % 100}) $$) AS (result agtype);
+ANALYZE analyze_stats.person;
+CREATE FUNCTION estimated_rows(query text) RETURNS integer LANGUAGE plpgsql AS $$
+DECLARE
+    plan json;
+BEGIN
+    EXECUTE 'EXPLAIN (FORMAT JSON) ' || query INTO plan;
+    RETURN (plan->0->'Plan'->>'Plan Rows')::integer;
+END
+$$;
+-- the estimates use the statistics of the keys
+SELECT estimated_rows($$ SELECT * FROM cypher('analyze_stats', $q$ MATCH (n:person {country: 'NL'}) RETURN n $q$) AS (n agtype) $$);
+SELECT estimated_rows($$ SELECT * FROM cypher('analyze_stats', $q$ MATCH (n:person {country: 'US'}) RETURN n $q$) AS (n agtype) $$);
+SELECT estimated_rows($$ SELECT * FROM cypher('analyze_stats', $q$ MATCH (n:person {country: 'FR'}) RETURN n $q$) AS (n agtype) $$);
+SELECT estimated_rows($$ SELECT * FROM cypher('analyze_stats', $q$ MATCH (n:person) WHERE n.age = 42 RETURN n $q$) AS (n agtype) $$);
+SELECT estimated_rows($$ SELECT * FROM cypher('analyze_stats', $q$ MATCH (n:person) WHERE n.age < 10 RETURN n $q$) AS (n agtype) $$);
+SELECT estimated_rows($$ SELECT * FROM cypher('analyze_stats', $q$ MATCH (n:person) WHERE 95 <= n.age RETURN n $q$) AS (n agtype) $$);
+SELECT estimated_rows($$ SELECT * FROM analyze_stats.person WHERE properties ? 'country'::text $$);
+SELECT estimated_rows($$ SELECT * FROM analyze_stats.person WHERE properties -> 'age'::text > '89'::agtype $$);
+-- keys past the statistics target are rarer than the rarest kept key
+CREATE TABLE analyze_keys (properties agtype);
+ALTER TABLE analyze_keys ALTER COLUMN properties SET STATISTICS 2;
+INSERT INTO analyze_keys SELECT agtype_build_map('a'::text, i, 'b'::text, i) FROM generate_series(1, 98) AS i;
+INSERT INTO analyze_keys SELECT agtype_build_map('b'::text, i) FROM generate_series(1, 100) AS i;
+INSERT INTO analyze_keys SELECT agtype_build_map('a'::text, i, 'b'::text, i, 'c'::text, i) FROM generate_series(1, 2) AS i;
+ANALYZE analyze_keys;
+SELECT estimated_rows($$ SELECT * FROM analyze_keys WHERE properties ? 'a'::text $$);
+SELECT estimated_rows($$ SELECT * FROM analyze_keys WHERE properties ? 'c'::text $$);
+DROP TABLE analyze_keys;
+-- the fractions of the keys already count the NULL rows
+CREATE TABLE analyze_nulls (properties agtype);
+INSERT INTO analyze_nulls SELECT agtype_build_map('a'::text, 1) FROM generate_series(1, 100);
+INSERT INTO analyze_nulls SELECT NULL FROM generate_series(1, 100);
+ANALYZE analyze_nulls;
+SELECT estimated_rows($$ SELECT * FROM analyze_nulls WHERE properties @> '{"a": 1}'::agtype $$);
+SELECT estimated_rows($$ SELECT * FROM analyze_nulls WHERE properties @> '{}'::agtype $$);
+DROP TABLE analyze_nulls;
+DROP FUNCTION estimated_rows;
+SELECT * FROM drop_graph('analyze_stats', true);
+
+--
+-- join order of large patterns
+--
+SELECT * FROM create_graph('join_order');
+SELECT * FROM cypher('join_order', $$ UNWIND range(1, 10) AS i CREATE (:node {i: i}) $$) AS (result agtype);
+SELECT * FROM cypher('join_order', $$ MATCH (a:node), (b:node) WHERE b.i = a.i + 1 CREATE (a)-[:next]->(b) $$) AS (result agtype);
+ANALYZE join_order.node;
+ANALYZE join_order.next;
+-- the pattern has more relations than geqo_threshold
+SELECT * FROM cypher('join_order', $$ MATCH (a:node {i: 2})-[:next]->()-[:next]->()-[:next]->()-[:next]->()-[:next]->()-[:next]->(b) RETURN b.i $$) AS (result agtype);
+SELECT * FROM cypher('join_order', $$ MATCH (a:node)-[:next]->()-[:next]->()-[:next]->()-[:next]->()-[:next]->()-[:next]->(b) RETURN a.i, b.i ORDER BY a.i $$) AS (a agtype, b agtype);
+SET age.enable_graph_join_search = off;
+SELECT * FROM cypher('join_order', $$ MATCH (a:node {i: 2})-[:next]->()-[:next]->()-[:next]->()-[:next]->()-[:next]->()-[:next]->(b) RETURN b.i $$) AS (result agtype);
+SELECT * FROM cypher('join_order', $$ MATCH (a:node)-[:next]->()-[:next]->()-[:next]->()-[:next]->()-[:next]->()-[:next]->(b) RETURN a.i, b.i ORDER BY a.i $$) AS (a agtype, b agtype);
+RESET age.enable_graph_join_search;
+SELECT * FROM drop_graph('join_order', true);
+
 -- drop graphs
 SELECT * FROM drop_graph('analyze', true);
 
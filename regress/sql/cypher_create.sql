@@ -475,6 +475,41 @@ SELECT * FROM cypher('cypher_create', $$
   CREATE (n), (m) WITH n AS r CREATE (m) RETURN m
 $$) as (m agtype);
 
+--
+-- Terminal CREATE and MERGE clauses write their entities in batches
+--
+SELECT create_graph('create_batch');
+
+SELECT * FROM cypher('create_batch', $$
+  UNWIND range(1, 2500) AS i CREATE (:batch {i: i})-[:linked]->(:batch {i: -i})
+$$) as (a agtype);
+
+SELECT * FROM cypher('create_batch', $$
+  MATCH (n:batch) RETURN count(n)
+$$) as (count agtype);
+
+SELECT * FROM cypher('create_batch', $$
+  MATCH (n:batch) RETURN sum(n.i)
+$$) as (sum agtype);
+
+SELECT * FROM cypher('create_batch', $$
+  MATCH (a:batch)-[:linked]->(b:batch) WHERE a.i = -b.i RETURN count(*)
+$$) as (count agtype);
+
+SELECT * FROM cypher('create_batch', $$
+  MATCH (n:batch) WHERE n.i > 0 MERGE (n)-[:linked]->(:batch {i: 0})
+$$) as (a agtype);
+
+SELECT * FROM cypher('create_batch', $$
+  MATCH (n:batch) RETURN count(n)
+$$) as (count agtype);
+
+SELECT * FROM cypher('create_batch', $$
+  MATCH (a:batch)-[:linked]->(b:batch {i: 0}) WHERE a.i > 0 RETURN count(*)
+$$) as (count agtype);
+
+SELECT drop_graph('create_batch', true);
+
 --
 -- Clean up
 --
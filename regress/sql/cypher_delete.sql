@@ -302,6 +302,37 @@ SELECT id as "expected: 0 rows"              FROM setdelete._ag_label_edge;
 -- clean up
 SELECT drop_graph('setdelete', true);
 
+--
+-- DETACH DELETE through the start_id and end_id indexes
+--
+SELECT create_graph('detach_index');
+SELECT * FROM cypher('detach_index', $$ CREATE (a:v {name: 'a'})-[:e]->(b:v {name: 'b'})-[:e]->(c:v {name: 'c'}), (b)-[:e]->(b), (c)-[:e]->(a) $$) AS (a agtype);
+-- make the edge table scans look expensive, so the indexes are probed
+SET seq_page_cost = 1000;
+SELECT * FROM cypher('detach_index', $$ MATCH (n:v {name: 'b'}) DETACH DELETE n $$) AS (a agtype);
+-- only c->a should be left
+SELECT * FROM cypher('detach_index', $$ MATCH (n)-[e]->(m) RETURN n.name, m.name $$) AS (n agtype, m agtype);
+-- should error
+SELECT * FROM cypher('detach_index', $$ MATCH (n:v {name: 'a'}) DELETE n $$) AS (a agtype);
+RESET seq_page_cost;
+SELECT drop_graph('detach_index', true);
+
+--
+-- A terminal DELETE deletes its entities together, each one only once
+--
+SELECT create_graph('delete_batch');
+SELECT * FROM cypher('delete_batch', $$ CREATE (:hub) $$) AS (a agtype);
+SELECT * FROM cypher('delete_batch', $$ MATCH (h:hub) UNWIND range(1, 200) AS i CREATE (:v {i: i})-[:e]->(h) $$) AS (a agtype);
+-- the hub is matched once per edge, its edges are gone before it is checked
+SELECT * FROM cypher('delete_batch', $$ MATCH (:v)-[e:e]->(h:hub) DELETE e, h $$) AS (a agtype);
+SELECT * FROM cypher('delete_batch', $$ MATCH (n) RETURN count(n) $$) AS (a agtype);
+SELECT * FROM cypher('delete_batch', $$ MATCH ()-[e]->() RETURN count(e) $$) AS (a agtype);
+SELECT * FROM cypher('delete_batch', $$ MATCH (a:v), (b:v) WHERE b.i = a.i + 1 CREATE (a)-[:e]->(b) $$) AS (a agtype);
+SELECT * FROM cypher('delete_batch', $$ MATCH (n:v) WHERE n.i % 2 = 0 DETACH DELETE n $$) AS (a agtype);
+SELECT * FROM cypher('delete_batch', $$ MATCH (n) RETURN count(n) $$) AS (a agtype);
+SELECT * FROM cypher('delete_batch', $$ MATCH ()-[e]->() RETURN count(e) $$) AS (a agtype);
+SELECT drop_graph('delete_batch', true);
+
 --
 -- Clean up
 --
@@ -1437,6 +1437,13 @@ SELECT count(*) FROM cypher('test_enable_containment', $$ MATCH p=(x:Customer)-[
 SELECT * FROM cypher('test_enable_containment', $$ EXPLAIN (costs off) MATCH (x:Customer)-[:bought ={store: 'Amazon', addr:{city: 'Vancouver', street: 30}}]->(y:Product) RETURN 0 $$) as (a agtype);
 SELECT * FROM cypher('test_enable_containment', $$ EXPLAIN (costs off) MATCH (x:Customer ={school: { name: 'XYZ College',program: { major: 'Psyc', degree: 'BSc'} },phone: [ 123456789, 987654321, 456987123 ]}) RETURN 0 $$) as (a agtype);
 
+--
+-- Property access on an entity from a previous clause reads its properties
+-- column, instead of building the whole entity first
+--
+SELECT * FROM cypher('test_enable_containment', $$ EXPLAIN (costs off) MATCH (x:Customer) WITH x WHERE x.name = 'Bob' RETURN 0 $$) as (a agtype);
+SELECT * FROM cypher('test_enable_containment', $$ MATCH (x:Customer) WITH x WHERE x.name = 'Bob' RETURN x.name, x.school.name $$) as (a agtype, b agtype);
+
 --
 -- Clean up
 --
@@ -785,6 +785,21 @@ SELECT * FROM cypher('issue_1907', $$ MERGE (a {name: 'Test Node A'})-[r:RELATED
 -- should return properties added
 SELECT * FROM cypher('issue_1907', $$ MATCH ()-[r]->() RETURN r $$) AS (r agtype);
 
+--
+-- MERGE finds the paths it already created through a hashtable
+--
+SELECT * FROM create_graph('merge_dedup');
+SELECT * FROM cypher('merge_dedup', $$ UNWIND range(1, 3000) AS i
+                                       MERGE (:dedup {k: i % 7})-[:rel]->(:dedup {k: i % 3}) $$) AS (a agtype);
+-- should return 42 and 21
+SELECT * FROM cypher('merge_dedup', $$ MATCH (n:dedup) RETURN count(n) $$) AS (count agtype);
+SELECT * FROM cypher('merge_dedup', $$ MATCH ()-[e:rel]->() RETURN count(e) $$) AS (count agtype);
+-- should not create anything new
+SELECT * FROM cypher('merge_dedup', $$ UNWIND range(1, 3000) AS i
+                                       MERGE (:dedup {k: i % 7})-[:rel]->(:dedup {k: i % 3}) $$) AS (a agtype);
+SELECT * FROM cypher('merge_dedup', $$ MATCH (n:dedup) RETURN count(n) $$) AS (count agtype);
+SELECT drop_graph('merge_dedup', true);
+
 --
 -- clean up graphs
 --
@@ -78,6 +78,18 @@ SELECT count(edges) FROM start_and_end_points, age_vle( '"cypher_vle"'::agtype,
 SELECT * FROM cypher('cypher_vle', $$MATCH (u:begin)-[*]->(v:end) RETURN count(*) $$) AS (e agtype);
 SELECT * FROM cypher('cypher_vle', $$MATCH (u:begin)-[*..]->(v:end) RETURN count(*) $$) AS (e agtype);
 SELECT * FROM cypher('cypher_vle', $$MATCH (u:begin)-[*0..]->(v:end) RETURN count(*) $$) AS (e agtype);
+
+-- The same, walking the CSR adjacency of the global graph
+SET age.enable_graph_csr = on;
+SELECT * FROM cypher('cypher_vle', $$ RETURN delete_global_graphs('cypher_vle') $$) AS (result agtype);
+-- should find 400
+SELECT * FROM cypher('cypher_vle', $$MATCH (u:begin)-[*]->(v:end) RETURN count(*) $$) AS (e agtype);
+-- should be 7092
+SELECT count(edges) FROM start_and_end_points, age_vle( '"cypher_vle"'::agtype, start_vertex, end_vertex, '{"id": 1111111111111111, "label": "", "end_id": 2222222222222222, "start_id": 333333333333333, "properties": {}}::edge'::agtype, '1'::agtype, 'null'::agtype, '0'::agtype) group by ctid;
+-- should match 1
+SELECT count(edges) FROM start_and_end_points, age_vle( '"cypher_vle"'::agtype, start_vertex, end_vertex, '{"id": 1111111111111111, "label": "edge", "end_id": 2222222222222222, "start_id": 333333333333333, "properties": {}}::edge'::agtype, '1'::agtype, 'null'::agtype, '1'::agtype);
+RESET age.enable_graph_csr;
+SELECT * FROM cypher('cypher_vle', $$ RETURN delete_global_graphs('cypher_vle') $$) AS (result agtype);
 SELECT * FROM cypher('cypher_vle', $$MATCH (u:begin)-[*1..]->(v:end) RETURN count(*) $$) AS (e agtype);
 SELECT * FROM cypher('cypher_vle', $$MATCH (u:begin)-[*1..200]->(v:end) RETURN count(*) $$) AS (e agtype);
 -- Each should find 2
@@ -119,6 +131,29 @@ SELECT * FROM cypher('cypher_vle', $$MATCH p=(u:begin)<-[*]-(v:end) RETURN p $$)
 SELECT * FROM cypher('cypher_vle', $$MATCH p=(u:begin)<-[e*]-(v:end) RETURN p $$) AS (e agtype);
 SELECT * FROM cypher('cypher_vle', $$MATCH p=(u:begin)<-[e*]-(v:end) RETURN e $$) AS (e agtype);
 SELECT * FROM cypher('cypher_vle', $$MATCH p=(:begin)<-[*]-()<-[]-(:end) RETURN p $$) AS (e agtype);
+-- shortestPath and allShortestPaths, searching from both ends
+-- should be 3
+SELECT * FROM cypher('cypher_vle', $$MATCH (u:begin), (v:end) MATCH p = shortestPath((u)-[*]->(v)) RETURN length(p) $$) AS (e agtype);
+-- should find 2, one for each first edge
+SELECT * FROM cypher('cypher_vle', $$MATCH (u:begin), (v:end) MATCH p = allShortestPaths((u)-[*]->(v)) RETURN relationships(p)[0].name AS rel ORDER BY rel $$) AS (e agtype);
+-- should find 1 of length 3
+SELECT * FROM cypher('cypher_vle', $$MATCH (u:begin), (v:end) MATCH p = allShortestPaths((u)<-[*]-(v)) RETURN length(p) $$) AS (e agtype);
+-- should find 1 of length 2
+SELECT * FROM cypher('cypher_vle', $$MATCH (u:begin), (v:end) MATCH p = allShortestPaths((u)-[*]-(v)) RETURN length(p) $$) AS (e agtype);
+-- should be 4, only the main edges
+SELECT * FROM cypher('cypher_vle', $$MATCH (u:begin), (v:end) MATCH p = shortestPath((u)-[:edge*]->(v)) RETURN length(p) $$) AS (e agtype);
+-- should be 2
+SELECT * FROM cypher('cypher_vle', $$MATCH (u:begin), (v:end) MATCH p = shortestPath((u)-[* {packages: [1,3,5,7]}]-(v)) RETURN length(p) $$) AS (e agtype);
+-- should find 0
+SELECT * FROM cypher('cypher_vle', $$MATCH (u:begin), (v:end) MATCH p = shortestPath((u)-[* {packages: [1,3,5,7]}]->(v)) RETURN length(p) $$) AS (e agtype);
+-- should be 4, searching from the start vertex only
+SELECT * FROM cypher('cypher_vle', $$MATCH p = shortestPath((u:begin)-[:edge*]->(v:end)) RETURN length(p) $$) AS (e agtype);
+-- should find 1, 1, 2, 2
+SELECT * FROM cypher('cypher_vle', $$MATCH (u:begin) MATCH p = allShortestPaths((u)-[*..2]->(v)) RETURN length(p) AS len ORDER BY len $$) AS (e agtype);
+-- should find 0, 1
+SELECT * FROM cypher('cypher_vle', $$MATCH (u:begin) MATCH p = shortestPath((u)-[*0..1]->(v)) RETURN length(p) AS len ORDER BY len $$) AS (e agtype);
+-- should fail
+SELECT * FROM cypher('cypher_vle', $$MATCH (u:begin), (v:end) MATCH p = shortestPath((u)-[*2..]->(v)) RETURN p $$) AS (e agtype);
 -- Each should return 31
 SELECT count(*) FROM cypher('cypher_vle', $$ MATCH ()-[e1]->(v)-[e2]->() RETURN e1,e2 $$) AS (e1 agtype, e2 agtype);
 SELECT count(*) FROM cypher('cypher_vle', $$
@@ -328,8 +363,49 @@ SELECT * FROM cypher('access',$$ MATCH ()-[e*]->() RETURN e[0].id, e[1].id $$) a
 SELECT * FROM cypher('access',$$ MATCH ()-[e*]->() RETURN e[0].arry, e[1].arry $$) as (results_1st agtype, results_2nd agtype);
 SELECT * FROM cypher('access',$$ MATCH ()-[e*]->() RETURN e[0].arry[2], e[1].arry[2] $$) as (results_1st agtype, results_2nd agtype);
 
+-- The same, with the properties loaded lazily
+SET age.enable_lazy_graph_properties = on;
+SELECT * FROM cypher('access', $$ RETURN delete_global_graphs('access') $$) AS (result agtype);
+SELECT * FROM cypher('access',$$ MATCH ()-[e*]->() RETURN properties(e[0]), properties(e[1]) $$) as (prop_1st agtype, prop_2nd agtype);
+RESET age.enable_lazy_graph_properties;
+SELECT * FROM cypher('access', $$ RETURN delete_global_graphs('access') $$) AS (result agtype);
+
 SELECT drop_graph('access', true);
 
+-- weighted shortest paths
+SELECT create_graph('weighted');
+SELECT * FROM cypher('weighted', $$ CREATE (a {name: 'a', pos: [0, 0]}), (b {name: 'b', pos: [2, 2]}),
+                                           (c {name: 'c', pos: [1, 0]}), (d {name: 'd', pos: [3, 0]}),
+                                           (a)-[:road {cost: 4}]->(b), (a)-[:road {cost: 1}]->(c),
+                                           (c)-[:road {cost: 2.0}]->(b), (b)-[:road {cost: 5}]->(d),
+                                           (c)-[:road {cost: 8}]->(d), (a)-[:road {cost: 10}]->(d) $$) AS (result agtype);
+CREATE TABLE weighted_points AS SELECT * FROM cypher('weighted', $$ MATCH (a {name: 'a'}), (d {name: 'd'}) RETURN a, d $$) AS (a agtype, d agtype);
+-- should be 3 and 8.0
+SELECT age_length(path) AS length, cost FROM weighted_points, age_weighted_shortest_path('"weighted"'::agtype, a, d, '{"id": 1111111111111111, "label": "road", "end_id": 2222222222222222, "start_id": 333333333333333, "properties": {}}::edge'::agtype, '1'::agtype, '"cost"'::agtype, 'null'::agtype);
+-- the same path using A* over the vertex coordinates
+SELECT age_length(path) AS length, cost FROM weighted_points, age_weighted_shortest_path('"weighted"'::agtype, a, d, '{"id": 1111111111111111, "label": "road", "end_id": 2222222222222222, "start_id": 333333333333333, "properties": {}}::edge'::agtype, '1'::agtype, '"cost"'::agtype, '"pos"'::agtype);
+-- should be 0 rows
+SELECT age_length(path) AS length, cost FROM weighted_points, age_weighted_shortest_path('"weighted"'::agtype, d, a, '{"id": 1111111111111111, "label": "road", "end_id": 2222222222222222, "start_id": 333333333333333, "properties": {}}::edge'::agtype, '1'::agtype, '"cost"'::agtype, 'null'::agtype);
+-- should be 3 and 8.0
+SELECT age_length(path) AS length, cost FROM weighted_points, age_weighted_shortest_path('"weighted"'::agtype, d, a, '{"id": 1111111111111111, "label": "road", "end_id": 2222222222222222, "start_id": 333333333333333, "properties": {}}::edge'::agtype, '0'::agtype, '"cost"'::agtype, 'null'::agtype);
+-- should be 1 and 10.0
+SELECT age_length(path) AS length, cost FROM weighted_points, age_weighted_shortest_path('"weighted"'::agtype, a, d, '{"id": 1111111111111111, "label": "", "end_id": 2222222222222222, "start_id": 333333333333333, "properties": {"cost": 10}}::edge'::agtype, '1'::agtype, '"cost"'::agtype, 'null'::agtype);
+-- without an end vertex, every reachable vertex in order of cost
+SELECT age_length(path) AS length, cost FROM weighted_points, age_weighted_shortest_path('"weighted"'::agtype, a, NULL, '{"id": 1111111111111111, "label": "road", "end_id": 2222222222222222, "start_id": 333333333333333, "properties": {}}::edge'::agtype, '1'::agtype, '"cost"'::agtype, 'null'::agtype);
+-- should error
+SELECT age_length(path) AS length, cost FROM weighted_points, age_weighted_shortest_path('"weighted"'::agtype, a, d, '{"id": 1111111111111111, "label": "road", "end_id": 2222222222222222, "start_id": 333333333333333, "properties": {}}::edge'::agtype, '1'::agtype, '"length"'::agtype, 'null'::agtype);
+SELECT age_length(path) AS length, cost FROM weighted_points, age_weighted_shortest_path('"weighted"'::agtype, a, NULL, '{"id": 1111111111111111, "label": "road", "end_id": 2222222222222222, "start_id": 333333333333333, "properties": {}}::edge'::agtype, '1'::agtype, '"cost"'::agtype, '"pos"'::agtype);
+
+-- an admissible, but inconsistent, heuristic should still find the cheapest path, 3 and 5.0
+SELECT * FROM cypher('weighted', $$ CREATE (s {name: 's', h: 0}), (n {name: 'n', h: 4}), (m {name: 'm', h: 0}), (t {name: 't', h: 0}),
+                                           (s)-[:road {cost: 1}]->(n), (n)-[:road {cost: 1}]->(m),
+                                           (s)-[:road {cost: 3}]->(m), (m)-[:road {cost: 3}]->(t) $$) AS (result agtype);
+CREATE TABLE inconsistent_points AS SELECT * FROM cypher('weighted', $$ MATCH (s {name: 's'}), (t {name: 't'}) RETURN s, t $$) AS (s agtype, t agtype);
+SELECT age_length(path) AS length, cost FROM inconsistent_points, age_weighted_shortest_path('"weighted"'::agtype, s, t, '{"id": 1111111111111111, "label": "road", "end_id": 2222222222222222, "start_id": 333333333333333, "properties": {}}::edge'::agtype, '1'::agtype, '"cost"'::agtype, '"h"'::agtype);
+DROP TABLE inconsistent_points;
+DROP TABLE weighted_points;
+SELECT drop_graph('weighted', true);
+
 -- issue 1043
 SELECT create_graph('issue_1043');
 SELECT * FROM cypher('issue_1043', $$ CREATE (n)-[:KNOWS {n:'hello'}]->({n:'hello'}) $$) as (a agtype);
@@ -357,6 +433,41 @@ SELECT * FROM cypher('issue_1910', $$ MATCH (n) WHERE EXISTS((n)-[*2..2]-({name:
 
 SELECT drop_graph('issue_1910', true);
 
+-- VLE keeps the query out of parallel workers
+SELECT create_graph('vle_parallel');
+SELECT * FROM cypher('vle_parallel', $$ UNWIND range(1, 5) AS i CREATE (:v {i: i}) $$) AS (a agtype);
+SELECT * FROM cypher('vle_parallel', $$ MATCH (a:v), (b:v) WHERE b.i = a.i + 1 CREATE (a)-[:e]->(b) $$) AS (a agtype);
+SET debug_parallel_query = on;
+SELECT * FROM cypher('vle_parallel', $$ MATCH (a:v)-[*1..3]->(b:v) RETURN count(*) $$) AS (c agtype);
+SELECT * FROM cypher('vle_parallel', $$ MATCH (a:v)-[*1..3]->(b:v) RETURN a.i, count(b) ORDER BY a.i $$) AS (i agtype, c agtype);
+RESET debug_parallel_query;
+SELECT drop_graph('vle_parallel', true);
+
+-- VLE reachability mode
+SELECT create_graph('vle_reach');
+SELECT * FROM cypher('vle_reach', $$ UNWIND range(0, 11) AS i CREATE (:r {i: i}) $$) AS (a agtype);
+SELECT * FROM cypher('vle_reach', $$ MATCH (a:r), (b:r) WHERE b.i = a.i + 1 CREATE (a)-[:e]->(b), (a)-[:e]->(b) $$) AS (a agtype);
+SELECT * FROM cypher('vle_reach', $$ MATCH (a:r {i: 3}), (b:r {i: 0}) CREATE (a)-[:e]->(b) $$) AS (a agtype);
+-- each vertex once, however many paths lead to it
+SELECT * FROM cypher('vle_reach', $$ MATCH (a:r {i: 0})-[*]->(b) RETURN count(DISTINCT b) $$) AS (c agtype);
+SELECT * FROM cypher('vle_reach', $$ MATCH (a:r {i: 0})-[*0..2]->(b) RETURN DISTINCT b.i ORDER BY b.i $$) AS (i agtype);
+SELECT * FROM cypher('vle_reach', $$ MATCH (a:r {i: 0})-[*1..2]->(b) RETURN DISTINCT b.i ORDER BY b.i $$) AS (i agtype);
+-- the start vertex is reachable through the cycle
+SELECT * FROM cypher('vle_reach', $$ MATCH (a:r {i: 0})-[*1..4]->(b) RETURN DISTINCT b.i ORDER BY b.i $$) AS (i agtype);
+SELECT * FROM cypher('vle_reach', $$ MATCH (a)-[*1..2]->(b:r {i: 0}) RETURN DISTINCT a.i ORDER BY a.i $$) AS (i agtype);
+SELECT * FROM cypher('vle_reach', $$ MATCH (a:r)-[*]->(b) WHERE a.i >= 9 RETURN a.i, count(DISTINCT b) ORDER BY a.i $$) AS (i agtype, c agtype);
+-- undirected, a minimal length of 1 needs the paths
+SELECT * FROM cypher('vle_reach', $$ MATCH (a:r {i: 5})-[*1..3]-(b) RETURN DISTINCT b.i ORDER BY b.i $$) AS (i agtype);
+SELECT * FROM cypher('vle_reach', $$ MATCH (a:r {i: 5})-[*0..2]-(b) RETURN DISTINCT b.i ORDER BY b.i $$) AS (i agtype);
+CREATE TABLE reach_points AS SELECT * FROM cypher('vle_reach', $$ MATCH (a:r {i: 0}) RETURN a $$) AS (a agtype);
+-- should be 12
+SELECT count(*) FROM reach_points, age_vle_reachable('"vle_reach"'::agtype, a, NULL, '{"id": 1111111111111111, "label": "e", "end_id": 2222222222222222, "start_id": 333333333333333, "properties": {}}::edge'::agtype, '1'::agtype, NULL, '1'::agtype, '1'::agtype);
+-- should fail
+SELECT count(*) FROM reach_points, age_vle_reachable('"vle_reach"'::agtype, a, NULL, '{"id": 1111111111111111, "label": "e", "end_id": 2222222222222222, "start_id": 333333333333333, "properties": {}}::edge'::agtype, '1'::agtype, NULL, '0'::agtype, '1'::agtype);
+SELECT count(*) FROM reach_points, age_vle_reachable('"vle_reach"'::agtype, a, NULL, '{"id": 1111111111111111, "label": "e", "end_id": 2222222222222222, "start_id": 333333333333333, "properties": {}}::edge'::agtype, '2'::agtype, NULL, '1'::agtype, '1'::agtype);
+DROP TABLE reach_points;
+SELECT drop_graph('vle_reach', true);
+
 --
 -- Clean up
 --
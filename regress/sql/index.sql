@@ -204,6 +204,19 @@ SELECT COUNT(*) FROM cypher('cypher_index', $$
     RETURN e
 $$) as (n agtype);
 
+-- the Cypher Expand node probes the index on end_id for each country
+SET age.enable_expand = ON;
+SET enable_mergejoin = OFF;
+SET enable_hashjoin = OFF;
+SET enable_nestloop = OFF;
+SELECT COUNT(*) FROM cypher_index."Country" a JOIN cypher_index.has_city e ON e.end_id = a.id;
+EXPLAIN (costs off) SELECT COUNT(*) FROM cypher_index."Country" a JOIN cypher_index.has_city e ON e.end_id = a.id;
+SELECT COUNT(*) FROM cypher('cypher_index', $$
+    MATCH (a:Country)<-[e:has_city]-()
+    RETURN e
+$$) as (n agtype);
+RESET age.enable_expand;
+
 SET enable_mergejoin = ON;
 SET enable_hashjoin = ON;
 SET enable_nestloop = ON;
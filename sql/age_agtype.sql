@@ -57,11 +57,83 @@ RETURNS NULL ON NULL INPUT
 PARALLEL SAFE
 AS 'MODULE_PATHNAME';
 
+-- statistics and selectivity estimation functions
+CREATE FUNCTION ag_catalog.agtype_typanalyze(internal)
+    RETURNS boolean
+    LANGUAGE c
+    STRICT
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION ag_catalog.agtype_eqsel(internal, oid, internal, integer)
+    RETURNS float8
+    LANGUAGE c
+    STABLE
+STRICT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION ag_catalog.agtype_neqsel(internal, oid, internal, integer)
+    RETURNS float8
+    LANGUAGE c
+    STABLE
+STRICT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION ag_catalog.agtype_ltsel(internal, oid, internal, integer)
+    RETURNS float8
+    LANGUAGE c
+    STABLE
+STRICT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION ag_catalog.agtype_lesel(internal, oid, internal, integer)
+    RETURNS float8
+    LANGUAGE c
+    STABLE
+STRICT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION ag_catalog.agtype_gtsel(internal, oid, internal, integer)
+    RETURNS float8
+    LANGUAGE c
+    STABLE
+STRICT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION ag_catalog.agtype_gesel(internal, oid, internal, integer)
+    RETURNS float8
+    LANGUAGE c
+    STABLE
+STRICT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION ag_catalog.agtype_contsel(internal, oid, internal, integer)
+    RETURNS float8
+    LANGUAGE c
+    STABLE
+STRICT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION ag_catalog.agtype_existssel(internal, oid, internal, integer)
+    RETURNS float8
+    LANGUAGE c
+    STABLE
+STRICT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
 CREATE TYPE agtype (
   INPUT = ag_catalog.agtype_in,
   OUTPUT = ag_catalog.agtype_out,
   SEND = ag_catalog.agtype_send,
   RECEIVE = ag_catalog.agtype_recv,
+  ANALYZE = ag_catalog.agtype_typanalyze,
   LIKE = jsonb
 );
 
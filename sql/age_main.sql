@@ -135,6 +135,17 @@ CREATE FUNCTION ag_catalog.load_labels_from_file(graph_name name,
     LANGUAGE c
     AS 'MODULE_PATHNAME';
 
+--
+-- Exports the vertices or edges of a label, as the columns of the column
+-- definition list. The id, start_id, end_id, and properties columns are those
+-- of the label table, any other column is the property of the same name.
+--
+CREATE FUNCTION ag_catalog.age_export_label(graph_name name, label_name name)
+    RETURNS SETOF record
+    LANGUAGE c
+    STABLE
+    AS 'MODULE_PATHNAME';
+
 CREATE FUNCTION ag_catalog.load_edges_from_file(graph_name name,
                                                 label_name name,
                                                 file_path text,
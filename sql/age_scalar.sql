@@ -69,12 +69,22 @@ RETURNS NULL ON NULL INPUT
 PARALLEL SAFE
 AS 'MODULE_PATHNAME';
 
+-- planner support for age_properties
+CREATE FUNCTION ag_catalog.age_properties_support(internal)
+    RETURNS internal
+    LANGUAGE c
+    IMMUTABLE
+STRICT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
 CREATE FUNCTION ag_catalog.age_properties(agtype)
     RETURNS agtype
     LANGUAGE c
     IMMUTABLE
 RETURNS NULL ON NULL INPUT
 PARALLEL SAFE
+SUPPORT ag_catalog.age_properties_support
 AS 'MODULE_PATHNAME';
 
 CREATE FUNCTION ag_catalog.age_startnode(agtype, agtype)
@@ -145,6 +145,15 @@ CREATE OPERATOR #>> (
 -- agtype - access operators
 --
 
+-- planner support for agtype_access_operator
+CREATE FUNCTION ag_catalog.agtype_access_operator_support(internal)
+    RETURNS internal
+    LANGUAGE c
+    IMMUTABLE
+STRICT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
 -- for series of `map.key` and `container[expr]`
 CREATE FUNCTION ag_catalog.agtype_access_operator(VARIADIC agtype[])
     RETURNS agtype
@@ -152,6 +161,7 @@ CREATE FUNCTION ag_catalog.agtype_access_operator(VARIADIC agtype[])
     IMMUTABLE
 RETURNS NULL ON NULL INPUT
 PARALLEL SAFE
+SUPPORT ag_catalog.agtype_access_operator_support
 AS 'MODULE_PATHNAME';
 
 CREATE FUNCTION ag_catalog.agtype_access_slice(agtype, agtype, agtype)
@@ -35,7 +35,7 @@ CREATE OPERATOR = (
   RIGHTARG = agtype,
   COMMUTATOR = =,
   NEGATOR = <>,
-  RESTRICT = eqsel,
+  RESTRICT = ag_catalog.agtype_eqsel,
   JOIN = eqjoinsel,
   HASHES
 );
@@ -270,7 +270,7 @@ CREATE OPERATOR <> (
   RIGHTARG = agtype,
   COMMUTATOR = <>,
   NEGATOR = =,
-  RESTRICT = neqsel,
+  RESTRICT = ag_catalog.agtype_neqsel,
   JOIN = neqjoinsel
 );
 
@@ -504,7 +504,7 @@ CREATE OPERATOR < (
   RIGHTARG = agtype,
   COMMUTATOR = >,
   NEGATOR = >=,
-  RESTRICT = scalarltsel,
+  RESTRICT = ag_catalog.agtype_ltsel,
   JOIN = scalarltjoinsel
 );
 
@@ -738,7 +738,7 @@ CREATE OPERATOR > (
   RIGHTARG = agtype,
   COMMUTATOR = <,
   NEGATOR = <=,
-  RESTRICT = scalargtsel,
+  RESTRICT = ag_catalog.agtype_gtsel,
   JOIN = scalargtjoinsel
 );
 
@@ -972,7 +972,7 @@ CREATE OPERATOR <= (
   RIGHTARG = agtype,
   COMMUTATOR = >=,
   NEGATOR = >,
-  RESTRICT = scalarlesel,
+  RESTRICT = ag_catalog.agtype_lesel,
   JOIN = scalarlejoinsel
 );
 
@@ -1206,7 +1206,7 @@ CREATE OPERATOR >= (
   RIGHTARG = agtype,
   COMMUTATOR = <=,
   NEGATOR = <,
-  RESTRICT = scalargesel,
+  RESTRICT = ag_catalog.agtype_gesel,
   JOIN = scalargejoinsel
 );
 
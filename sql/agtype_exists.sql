@@ -32,7 +32,7 @@ CREATE OPERATOR ? (
   LEFTARG = agtype,
   RIGHTARG = text,
   FUNCTION = ag_catalog.agtype_exists,
-  RESTRICT = matchingsel,
+  RESTRICT = ag_catalog.agtype_existssel,
   JOIN = matchingjoinsel
 );
 
@@ -48,7 +48,7 @@ CREATE OPERATOR ? (
   LEFTARG = agtype,
   RIGHTARG = agtype,
   FUNCTION = ag_catalog.agtype_exists_agtype,
-  RESTRICT = matchingsel,
+  RESTRICT = ag_catalog.agtype_existssel,
   JOIN = matchingjoinsel
 );
 
@@ -33,7 +33,7 @@ CREATE OPERATOR @> (
   RIGHTARG = agtype,
   FUNCTION = ag_catalog.agtype_contains,
   COMMUTATOR = '<@',
-  RESTRICT = matchingsel,
+  RESTRICT = ag_catalog.agtype_contsel,
   JOIN = matchingjoinsel
 );
 
@@ -67,7 +67,7 @@ CREATE OPERATOR @>> (
   RIGHTARG = agtype,
   FUNCTION = ag_catalog.agtype_contains_top_level,
   COMMUTATOR = '<<@',
-  RESTRICT = matchingsel,
+  RESTRICT = ag_catalog.agtype_contsel,
   JOIN = matchingjoinsel
 );
 
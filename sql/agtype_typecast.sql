@@ -77,7 +77,7 @@ CREATE FUNCTION ag_catalog.age_vle(IN agtype, IN agtype, IN agtype, IN agtype,
 LANGUAGE C
 STABLE
 CALLED ON NULL INPUT
-PARALLEL UNSAFE -- might be safe
+PARALLEL UNSAFE -- each worker would load its own global graph context
 AS 'MODULE_PATHNAME';
 
 -- This is an overloaded function definition to allow for the VLE local context
@@ -89,7 +89,45 @@ CREATE FUNCTION ag_catalog.age_vle(IN agtype, IN agtype, IN agtype, IN agtype,
 LANGUAGE C
 STABLE
 CALLED ON NULL INPUT
-PARALLEL UNSAFE -- might be safe
+PARALLEL UNSAFE -- each worker would load its own global graph context
+AS 'MODULE_PATHNAME';
+
+-- function to find the shortest path(s) for shortestPath and allShortestPaths
+CREATE FUNCTION ag_catalog.age_vle_shortest_path(IN agtype, IN agtype, IN agtype,
+                                                 IN agtype, IN agtype, IN agtype,
+                                                 IN agtype, IN agtype,
+                                                 OUT edges agtype)
+    RETURNS SETOF agtype
+LANGUAGE C
+STABLE
+CALLED ON NULL INPUT
+PARALLEL UNSAFE
+AS 'MODULE_PATHNAME';
+
+-- function to find the vertices reachable by a VLE, each only once
+CREATE FUNCTION ag_catalog.age_vle_reachable(IN agtype, IN agtype, IN agtype,
+                                             IN agtype, IN agtype, IN agtype,
+                                             IN agtype, IN agtype,
+                                             OUT edges agtype)
+    RETURNS SETOF agtype
+LANGUAGE C
+STABLE
+CALLED ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+-- function to find the cheapest path(s) over a numeric edge property
+CREATE FUNCTION ag_catalog.age_weighted_shortest_path(IN agtype, IN agtype,
+                                                      IN agtype, IN agtype,
+                                                      IN agtype, IN agtype,
+                                                      IN agtype,
+                                                      OUT path agtype,
+                                                      OUT cost agtype)
+    RETURNS SETOF record
+LANGUAGE C
+STABLE
+CALLED ON NULL INPUT
+PARALLEL UNSAFE
 AS 'MODULE_PATHNAME';
 
 -- function to build an edge for a VLE match
@@ -209,6 +247,11 @@ CREATE FUNCTION ag_catalog.age_delete_global_graphs(agtype)
 PARALLEL SAFE
 AS 'MODULE_PATHNAME';
 
+CREATE FUNCTION ag_catalog.age_graph_change_trigger()
+    RETURNS trigger
+    LANGUAGE c
+AS 'MODULE_PATHNAME';
+
 CREATE FUNCTION ag_catalog.create_complete_graph(graph_name name, nodes int,
                                                  edge_label name,
                                                  node_label name = NULL)
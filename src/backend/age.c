@@ -31,6 +31,8 @@ void _PG_init(void)
 {
     register_ag_nodes();
     set_rel_pathlist_init();
+    join_search_init();
+    set_join_pathlist_init();
     object_access_hook_init();
     process_utility_hook_init();
     post_parse_analyze_init();
@@ -44,5 +46,7 @@ void _PG_fini(void)
     post_parse_analyze_fini();
     process_utility_hook_fini();
     object_access_hook_fini();
+    set_join_pathlist_fini();
+    join_search_fini();
     set_rel_pathlist_fini();
 }
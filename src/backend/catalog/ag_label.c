@@ -21,9 +21,11 @@
 
 #include "access/genam.h"
 #include "catalog/indexing.h"
+#include "catalog/pg_am_d.h"
 #include "nodes/makefuncs.h"
 #include "utils/builtins.h"
 #include "utils/lsyscache.h"
+#include "utils/rel.h"
 
 #include "catalog/ag_graph.h"
 #include "catalog/ag_label.h"
@@ -342,3 +344,38 @@ List *get_all_edge_labels_per_graph(EState *estate, Oid graph_oid)
 
     return labels;
 }
+
+/*
+ * Returns the oid of a btree index on the label table whose leading column is
+ * attnum, or InvalidOid if there isn't one. The label tables get one on id,
+ * and edge label tables on start_id and end_id, when they are created, but
+ * they may have been dropped since.
+ */
+Oid get_label_column_index(Relation label_relation, AttrNumber attnum)
+{
+    List *indexes = NIL;
+    ListCell *lc = NULL;
+    Oid index_oid = InvalidOid;
+
+    indexes = RelationGetIndexList(label_relation);
+    foreach (lc, indexes)
+    {
+        Relation index = index_open(lfirst_oid(lc), AccessShareLock);
+
+        if (index->rd_rel->relam == BTREE_AM_OID &&
+            index->rd_index->indnkeyatts > 0 &&
+            index->rd_index->indkey.values[0] == attnum)
+        {
+            index_oid = lfirst_oid(lc);
+        }
+        index_close(index, AccessShareLock);
+
+        if (OidIsValid(index_oid))
+        {
+            break;
+        }
+    }
+    list_free(indexes);
+
+    return index_oid;
+}
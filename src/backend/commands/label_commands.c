@@ -22,6 +22,7 @@
 #include "access/xact.h"
 #include "catalog/namespace.h"
 #include "catalog/pg_class_d.h"
+#include "catalog/pg_trigger.h"
 #include "commands/defrem.h"
 #include "commands/sequence.h"
 #include "commands/tablecmds.h"
@@ -38,6 +39,7 @@
 #include "catalog/ag_label.h"
 #include "commands/label_commands.h"
 #include "utils/ag_cache.h"
+#include "utils/age_global_graph.h"
 #include "utils/name_validation.h"
 
 /*
@@ -83,6 +85,9 @@ static void create_index_on_column(char *schema_name,
                                    char *rel_name,
                                    char *colname,
                                    bool unique);
+static void create_trigger_for_label(char *schema_name, char *rel_name,
+                                     char *trigger_name, bool row,
+                                     int16 events);
 
 PG_FUNCTION_INFO_V1(age_is_valid_label_name);
 
@@ -432,6 +437,13 @@ static void create_table_for_label(char *graph_name, char *label_name,
         create_index_on_column(schema_name, rel_name, "start_id", false);
         create_index_on_column(schema_name, rel_name, "end_id", false);
     }
+
+    /* track plain SQL changes, for the global graph contexts */
+    create_trigger_for_label(schema_name, rel_name, "_ag_graph_changes", true,
+                             TRIGGER_TYPE_INSERT | TRIGGER_TYPE_UPDATE |
+                             TRIGGER_TYPE_DELETE);
+    create_trigger_for_label(schema_name, rel_name, "_ag_graph_truncate", false,
+                             TRIGGER_TYPE_TRUNCATE);
 }
 
 static void create_index_on_column(char *schema_name,
@@ -486,6 +498,47 @@ static void create_index_on_column(char *schema_name,
                    NULL);
 }
 
+/*
+ * CREATE TRIGGER `trigger_name` AFTER `events` ON `schema_name`.`rel_name`
+ * FOR EACH ROW|STATEMENT EXECUTE FUNCTION ag_catalog.age_graph_change_trigger()
+ */
+static void create_trigger_for_label(char *schema_name, char *rel_name,
+                                     char *trigger_name, bool row,
+                                     int16 events)
+{
+    CreateTrigStmt *trigger_stmt;
+    PlannedStmt *trigger_wrapper;
+
+    trigger_stmt = makeNode(CreateTrigStmt);
+    trigger_stmt->replace = false;
+    trigger_stmt->isconstraint = false;
+    trigger_stmt->trigname = trigger_name;
+    trigger_stmt->relation = makeRangeVar(schema_name, rel_name, -1);
+    trigger_stmt->funcname = list_make2(makeString("ag_catalog"),
+                                        makeString("age_graph_change_trigger"));
+    trigger_stmt->args = NIL;
+    trigger_stmt->row = row;
+    trigger_stmt->timing = TRIGGER_TYPE_AFTER;
+    trigger_stmt->events = events;
+    trigger_stmt->columns = NIL;
+    trigger_stmt->whenClause = NULL;
+    trigger_stmt->transitionRels = NIL;
+    trigger_stmt->deferrable = false;
+    trigger_stmt->initdeferred = false;
+    trigger_stmt->constrrel = NULL;
+
+    trigger_wrapper = makeNode(PlannedStmt);
+    trigger_wrapper->commandType = CMD_UTILITY;
+    trigger_wrapper->canSetTag = false;
+    trigger_wrapper->utilityStmt = (Node *)trigger_stmt;
+    trigger_wrapper->stmt_location = -1;
+    trigger_wrapper->stmt_len = 0;
+
+    ProcessUtility(trigger_wrapper, "(generated CREATE TRIGGER command)", false,
+                   PROCESS_UTILITY_SUBCOMMAND, NULL, NULL, None_Receiver,
+                   NULL);
+}
+
 /* 
  * CREATE TABLE `schema_name`.`rel_name` (
  * "id" graphid PRIMARY KEY DEFAULT "ag_catalog"."_graphid"(...),
@@ -895,6 +948,9 @@ Datum drop_label(PG_FUNCTION_ARGS)
                         label_name_str)));
     }
 
+    /* any global graph context holding this label is no longer valid */
+    mark_graph_modified(graph_oid);
+
     /* build qualified name */
     qname = list_make2(makeString(schema_name), makeString(rel_name));
 
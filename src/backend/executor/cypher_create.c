@@ -41,6 +41,9 @@ static Datum create_vertex(cypher_create_custom_scan_state *css,
 
 static void process_pattern(cypher_create_custom_scan_state *css);
 
+static void insert_created_entity(cypher_create_custom_scan_state *css,
+                                  cypher_target_node *node);
+
 
 const CustomExecMethods cypher_create_exec_methods = {CREATE_SCAN_STATE_NAME,
                                                       begin_cypher_create,
@@ -245,6 +248,9 @@ static TupleTableSlot *exec_cypher_create(CustomScanState *node)
         return NULL;
     }
 
+    /* write out what a terminal CREATE buffered before moving on */
+    flush_entity_insert_buffers(css->insert_buffers, estate);
+
     /* update the current command Id */
     CommandCounterIncrement();
 
@@ -269,6 +275,9 @@ static void end_cypher_create(CustomScanState *node)
 
     ExecEndNode(node->ss.ps.lefttree);
 
+    free_entity_insert_buffers(css->insert_buffers);
+    css->insert_buffers = NIL;
+
     foreach (lc, css->pattern)
     {
         cypher_create_path *path = lfirst(lc);
@@ -322,6 +331,7 @@ Node *create_cypher_create_plan_state(CustomScan *cscan)
     cypher_css->pattern = target_nodes->paths;
     cypher_css->flags = target_nodes->flags;
     cypher_css->graph_oid = target_nodes->graph_oid;
+    cypher_css->insert_buffers = NIL;
 
     cypher_css->css.ss.ps.type = T_CustomScanState;
     cypher_css->css.methods = &cypher_create_exec_methods;
@@ -413,7 +423,7 @@ static void create_edge(cypher_create_custom_scan_state *css,
         scanTupleSlot->tts_isnull[node->prop_attr_num];
 
     /* Insert the new edge */
-    insert_entity_tuple(resultRelInfo, elemTupleSlot, estate);
+    insert_created_entity(css, node);
 
     /* restore the old result relation info */
     estate->es_result_relations = old_estate_es_result_relations;
@@ -500,7 +510,7 @@ static Datum create_vertex(cypher_create_custom_scan_state *css,
             scanTupleSlot->tts_isnull[node->prop_attr_num];
 
         /* Insert the new vertex */
-        insert_entity_tuple(resultRelInfo, elemTupleSlot, estate);
+        insert_created_entity(css, node);
 
         /* restore the old result relation info */
         estate->es_result_relations = old_estate_es_result_relations;
@@ -611,3 +621,27 @@ static Datum create_vertex(cypher_create_custom_scan_state *css,
     return id;
 }
 
+/*
+ * Insert the entity in the node's element slot. A terminal CREATE doesn't
+ * return its entities, so they are buffered per label and written in batches.
+ * Otherwise, they are inserted right away.
+ */
+static void insert_created_entity(cypher_create_custom_scan_state *css,
+                                  cypher_target_node *node)
+{
+    EState *estate = css->css.ss.ps.state;
+
+    if (CYPHER_CLAUSE_IS_TERMINAL(css->flags))
+    {
+        entity_insert_buffer *buffer;
+
+        buffer = get_entity_insert_buffer(&css->insert_buffers,
+                                          node->resultRelInfo, estate);
+        buffer_entity_tuple(buffer, node->elemTupleSlot, estate,
+                            GetCurrentCommandId(true));
+    }
+    else
+    {
+        insert_entity_tuple(node->resultRelInfo, node->elemTupleSlot, estate);
+    }
+}
@@ -19,8 +19,11 @@
 
 #include "postgres.h"
 
+#include "access/genam.h"
 #include "common/hashfn.h"
+#include "lib/qunique.h"
 #include "miscadmin.h"
+#include "optimizer/cost.h"
 #include "storage/bufmgr.h"
 #include "utils/acl.h"
 #include "utils/rls.h"
@@ -28,6 +31,16 @@
 #include "catalog/ag_label.h"
 #include "executor/cypher_executor.h"
 #include "executor/cypher_utils.h"
+#include "utils/age_global_graph.h"
+
+/* TIDs of the entities of one label that are waiting to be deleted */
+typedef struct delete_batch
+{
+    ResultRelInfo *resultRelInfo;
+    ItemPointerData *tids;
+    int num_tids;
+    int max_tids;
+} delete_batch;
 
 static void begin_cypher_delete(CustomScanState *node, EState *estate,
                                 int eflags);
@@ -38,11 +51,24 @@ static void rescan_cypher_delete(CustomScanState *node);
 static void process_delete_list(CustomScanState *node);
 
 static void check_for_connected_edges(CustomScanState *node);
+static bool use_connected_edge_indexes(Relation rel, long num_vertices,
+                                       Oid start_id_index, Oid end_id_index);
+static void process_connected_edge(cypher_delete_custom_scan_state *css,
+                                   ResultRelInfo *resultRelInfo,
+                                   TupleTableSlot *slot, HeapTuple tuple,
+                                   char *label_name, bool rls_enabled,
+                                   List *qualExprs, ExprContext *econtext);
 static agtype_value *extract_entity(CustomScanState *node,
                                     TupleTableSlot *scanTupleSlot,
                                     int entity_position);
 static void delete_entity(EState *estate, ResultRelInfo *resultRelInfo,
                           HeapTuple tuple);
+static bool delete_entity_tuple(EState *estate, ResultRelInfo *resultRelInfo,
+                                HeapTuple tuple);
+static void add_to_delete_batch(cypher_delete_custom_scan_state *css,
+                                ResultRelInfo *resultRelInfo, ItemPointer tid);
+static void flush_delete_batches(cypher_delete_custom_scan_state *css);
+static int compare_tids(const void *a, const void *b);
 
 const CustomExecMethods cypher_delete_exec_methods = {DELETE_SCAN_STATE_NAME,
                                                       begin_cypher_delete,
@@ -110,6 +136,9 @@ static void begin_cypher_delete(CustomScanState *node, EState *estate,
                                       DELETE_VERTEX_HTAB_SIZE, &hashctl,
                                       HASH_ELEM | HASH_FUNCTION);
 
+    /* init the per label cache */
+    css->label_cache = create_entity_rel_cache(estate);
+
     /*
      * Postgres does not assign the es_output_cid in queries that do
      * not write to disk, ie: SELECT commands. We need the command id
@@ -161,6 +190,9 @@ static TupleTableSlot *exec_cypher_delete(CustomScanState *node)
             process_delete_list(node);
         }
 
+        /* delete everything that was collected, in physical order */
+        flush_delete_batches(css);
+
         return NULL;
     }
     else
@@ -192,9 +224,16 @@ static TupleTableSlot *exec_cypher_delete(CustomScanState *node)
  */
 static void end_cypher_delete(CustomScanState *node)
 {
+    cypher_delete_custom_scan_state *css =
+        (cypher_delete_custom_scan_state *)node;
+
     check_for_connected_edges(node);
 
-    hash_destroy(((cypher_delete_custom_scan_state *)node)->vertex_id_htab);
+    hash_destroy(css->vertex_id_htab);
+
+    /* close the label tables and their indices */
+    destroy_entity_rel_cache(css->label_cache);
+    css->label_cache = NULL;
 
     ExecEndNode(node->ss.ps.lefttree);
 }
@@ -276,10 +315,30 @@ static agtype_value *extract_entity(CustomScanState *node,
 
 /*
  * Try and delete the entity that is describe by the HeapTuple in the table
- * described by the resultRelInfo.
+ * described by the resultRelInfo, and make the delete visible.
  */
 static void delete_entity(EState *estate, ResultRelInfo *resultRelInfo,
                           HeapTuple tuple)
+{
+    if (delete_entity_tuple(estate, resultRelInfo, tuple))
+    {
+        /* increment the command counter */
+        CommandCounterIncrement();
+
+        /* Update command id in estate */
+        estate->es_snapshot->curcid = GetCurrentCommandId(false);
+        estate->es_output_cid = GetCurrentCommandId(false);
+    }
+}
+
+/*
+ * Helper function to lock and delete the tuple at tuple->t_self. Only the
+ * t_self of the tuple needs to be set, the lock fills in the rest. Returns
+ * true if the tuple was deleted, it is up to the caller to make the delete
+ * visible.
+ */
+static bool delete_entity_tuple(EState *estate, ResultRelInfo *resultRelInfo,
+                                HeapTuple tuple)
 {
     ResultRelInfo **saved_resultRels;
     LockTupleMode lockmode;
@@ -287,6 +346,7 @@ static void delete_entity(EState *estate, ResultRelInfo *resultRelInfo,
     TM_Result lock_result;
     TM_Result delete_result;
     Buffer buffer;
+    bool deleted = false;
 
     /* Find the physical tuple, this variable is coming from */
     saved_resultRels = estate->es_result_relations;
@@ -320,6 +380,9 @@ static void delete_entity(EState *estate, ResultRelInfo *resultRelInfo,
         switch (delete_result)
         {
         case TM_Ok:
+            /* record the delete for the global graph contexts */
+            record_graph_change(resultRelInfo->ri_RelationDesc,
+                                GRAPH_CHANGE_DELETE, tuple);
             break;
         case TM_SelfModified:
             ereport(
@@ -341,12 +404,8 @@ static void delete_entity(EState *estate, ResultRelInfo *resultRelInfo,
             /* elog never gets here */
             break;
         }
-        /* increment the command counter */
-        CommandCounterIncrement();
 
-        /* Update command id in estate */
-        estate->es_snapshot->curcid = GetCurrentCommandId(false);
-        estate->es_output_cid = GetCurrentCommandId(false);
+        deleted = true;
     }
     else if (lock_result != TM_Invisible && lock_result != TM_SelfModified)
     {
@@ -359,6 +418,114 @@ static void delete_entity(EState *estate, ResultRelInfo *resultRelInfo,
     ReleaseBuffer(buffer);
 
     estate->es_result_relations = saved_resultRels;
+
+    return deleted;
+}
+
+/*
+ * Helper function to queue the entity at tid for deletion by
+ * flush_delete_batches.
+ */
+static void add_to_delete_batch(cypher_delete_custom_scan_state *css,
+                                ResultRelInfo *resultRelInfo, ItemPointer tid)
+{
+    EState *estate = css->css.ss.ps.state;
+    delete_batch *batch = NULL;
+    ListCell *lc;
+
+    foreach (lc, css->delete_batches)
+    {
+        delete_batch *b = lfirst(lc);
+
+        if (b->resultRelInfo == resultRelInfo)
+        {
+            batch = b;
+            break;
+        }
+    }
+
+    if (batch == NULL)
+    {
+        MemoryContext oldcxt = MemoryContextSwitchTo(estate->es_query_cxt);
+
+        batch = palloc(sizeof(delete_batch));
+        batch->resultRelInfo = resultRelInfo;
+        batch->max_tids = 1024;
+        batch->num_tids = 0;
+        batch->tids = palloc(sizeof(ItemPointerData) * batch->max_tids);
+
+        css->delete_batches = lappend(css->delete_batches, batch);
+
+        MemoryContextSwitchTo(oldcxt);
+    }
+    else if (batch->num_tids == batch->max_tids)
+    {
+        batch->max_tids *= 2;
+        batch->tids = repalloc_huge(batch->tids,
+                                    sizeof(ItemPointerData) * batch->max_tids);
+    }
+
+    ItemPointerCopy(tid, &batch->tids[batch->num_tids++]);
+}
+
+/*
+ * Deletes the entities queued by add_to_delete_batch. The TIDs of each label
+ * are sorted first, so the table is visited in physical order, each page once,
+ * and an entity that was queued more than once is deleted only once. All of
+ * the deletes share one command id, made visible once at the end.
+ */
+static void flush_delete_batches(cypher_delete_custom_scan_state *css)
+{
+    EState *estate = css->css.ss.ps.state;
+    bool deleted = false;
+    ListCell *lc;
+
+    foreach (lc, css->delete_batches)
+    {
+        delete_batch *batch = lfirst(lc);
+        size_t num_tids;
+        size_t i;
+
+        if (batch->num_tids == 0)
+        {
+            continue;
+        }
+
+        qsort(batch->tids, batch->num_tids, sizeof(ItemPointerData),
+              compare_tids);
+        num_tids = qunique(batch->tids, batch->num_tids,
+                           sizeof(ItemPointerData), compare_tids);
+
+        for (i = 0; i < num_tids; i++)
+        {
+            HeapTupleData tuple;
+
+            tuple.t_self = batch->tids[i];
+
+            if (delete_entity_tuple(estate, batch->resultRelInfo, &tuple))
+            {
+                deleted = true;
+            }
+        }
+
+        batch->num_tids = 0;
+    }
+
+    if (deleted)
+    {
+        /* increment the command counter */
+        CommandCounterIncrement();
+
+        /* Update command id in estate */
+        estate->es_snapshot->curcid = GetCurrentCommandId(false);
+        estate->es_output_cid = GetCurrentCommandId(false);
+    }
+}
+
+/* qsort and qunique comparator for ItemPointerData */
+static int compare_tids(const void *a, const void *b)
+{
+    return ItemPointerCompare((ItemPointer)a, (ItemPointer)b);
 }
 
 /*
@@ -373,29 +540,16 @@ static void process_delete_list(CustomScanState *node)
     ExprContext *econtext = css->css.ss.ps.ps_ExprContext;
     TupleTableSlot *scanTupleSlot = econtext->ecxt_scantuple;
     EState *estate = node->ss.ps.state;
-    HTAB *qual_cache = NULL;
-    HASHCTL hashctl;
-
-    /* Hash table for caching compiled security quals per label */
-    MemSet(&hashctl, 0, sizeof(hashctl));
-    hashctl.keysize = sizeof(Oid);
-    hashctl.entrysize = sizeof(RLSCacheEntry);
-    hashctl.hcxt = CurrentMemoryContext;
-    qual_cache = hash_create("delete_qual_cache", 8, &hashctl,
-                             HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
 
     foreach(lc, css->delete_data->delete_items)
     {
         cypher_delete_item *item;
         agtype_value *original_entity_value, *id, *label;
-        ScanKeyData scan_keys[1];
-        TableScanDesc scan_desc;
-        ResultRelInfo *resultRelInfo;
+        entity_rel_cache_entry *entry;
         HeapTuple heap_tuple;
         char *label_name;
         Integer *pos;
         int entity_position;
-        Oid relid;
 
         item = lfirst(lc);
 
@@ -413,41 +567,18 @@ static void process_delete_list(CustomScanState *node)
         label = GET_AGTYPE_VALUE_OBJECT_VALUE(original_entity_value, "label");
         label_name = pnstrdup(label->val.string.val, label->val.string.len);
 
-        resultRelInfo = create_entity_result_rel_info(estate, css->delete_data->graph_name, label_name);
-        relid = RelationGetRelid(resultRelInfo->ri_RelationDesc);
-
-        /*
-         * Setup the scan key to require the id field on-disc to match the
-         * entity's graphid.
-         */
-        if (original_entity_value->type == AGTV_VERTEX)
-        {
-            ScanKeyInit(&scan_keys[0], Anum_ag_label_vertex_table_id,
-                        BTEqualStrategyNumber, F_GRAPHIDEQ,
-                        GRAPHID_GET_DATUM(id->val.int_value));
-        }
-        else if (original_entity_value->type == AGTV_EDGE)
-        {
-            ScanKeyInit(&scan_keys[0], Anum_ag_label_edge_table_id,
-                        BTEqualStrategyNumber, F_GRAPHIDEQ,
-                        GRAPHID_GET_DATUM(id->val.int_value));
-        }
-        else
-        {
-            ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-                    errmsg("DELETE clause can only delete vertices and edges")));
-        }
+        /* get the result relation and the rest of the label's state */
+        entry = get_entity_rel_cache_entry(css->label_cache, node,
+                                           css->delete_data->graph_name,
+                                           label_name, CMD_DELETE);
 
         /*
-         * Setup the scan description, with the correct snapshot and scan keys.
+         * Retrieve the tuple, with the correct snapshot, through the label's
+         * index on id. The id is the first column of vertex and edge tables.
          */
         estate->es_snapshot->curcid = GetCurrentCommandId(false);
         estate->es_output_cid = GetCurrentCommandId(false);
-        scan_desc = table_beginscan(resultRelInfo->ri_RelationDesc,
-                                    estate->es_snapshot, 1, scan_keys);
-
-        /* Retrieve the tuple. */
-        heap_tuple = heap_getnext(scan_desc, ForwardScanDirection);
+        heap_tuple = fetch_entity_tuple(estate, entry, id->val.int_value);
 
         /*
          * If the heap tuple still exists (It wasn't deleted after this variable
@@ -456,38 +587,23 @@ static void process_delete_list(CustomScanState *node)
          */
         if (!HeapTupleIsValid(heap_tuple))
         {
-            table_endscan(scan_desc);
-            destroy_entity_result_rel_info(resultRelInfo);
-
             continue;
         }
 
         /* Check RLS security quals (USING policy) before delete */
-        if (check_enable_rls(relid, InvalidOid, true) == RLS_ENABLED)
+        if (entry->rls_enabled)
         {
-            RLSCacheEntry *entry;
-            bool found;
-
-            /* Get cached security quals and slot for this label */
-            entry = hash_search(qual_cache, &relid, HASH_ENTER, &found);
-            if (!found)
-            {
-                entry->qualExprs = setup_security_quals(resultRelInfo, estate,
-                                                        node, CMD_DELETE);
-                entry->slot = ExecInitExtraTupleSlot(
-                    estate, RelationGetDescr(resultRelInfo->ri_RelationDesc),
-                    &TTSOpsHeapTuple);
-                entry->withCheckOptions = NIL;
-                entry->withCheckOptionExprs = NIL;
-            }
+            bool should_delete;
 
-            ExecStoreHeapTuple(heap_tuple, entry->slot, false);
+            ExecStoreHeapTuple(heap_tuple, entry->rls_slot, false);
+            should_delete = check_security_quals(entry->qualExprs,
+                                                 entry->rls_slot, econtext);
+            ExecClearTuple(entry->rls_slot);
 
             /* Silently skip if USING policy filters out this row */
-            if (!check_security_quals(entry->qualExprs, entry->slot, econtext))
+            if (!should_delete)
             {
-                table_endscan(scan_desc);
-                destroy_entity_result_rel_info(resultRelInfo);
+                heap_freetuple(heap_tuple);
                 continue;
             }
         }
@@ -504,22 +620,31 @@ static void process_delete_list(CustomScanState *node)
                         HASH_ENTER, &found);
         }
 
-        /* At this point, we are ready to delete the node/vertex. */
-        delete_entity(estate, resultRelInfo, heap_tuple);
+        /*
+         * At this point, we are ready to delete the node/vertex. A terminal
+         * DELETE only queues it, the queued entities are deleted together
+         * once the subtree is exhausted.
+         */
+        if (CYPHER_CLAUSE_IS_TERMINAL(css->flags))
+        {
+            add_to_delete_batch(css, entry->resultRelInfo,
+                                &heap_tuple->t_self);
+        }
+        else
+        {
+            delete_entity(estate, entry->resultRelInfo, heap_tuple);
+        }
 
-        /* Close the scan and the relation. */
-        table_endscan(scan_desc);
-        destroy_entity_result_rel_info(resultRelInfo);
+        heap_freetuple(heap_tuple);
     }
-
-    /* Clean up the cache */
-    hash_destroy(qual_cache);
 }
 
 /*
- * Scans the edge tables and checks if the deleted vertices are connected to
- * any edge(s). For DETACH DELETE, the connected edges are deleted. Otherwise,
- * an error is thrown.
+ * Finds the edges connected to the deleted vertices, either by scanning each
+ * edge table or by probing its start_id and end_id indexes, whichever is
+ * expected to be cheaper. For DETACH DELETE, the connected edges are queued
+ * and deleted together, in physical order, once all of them are found.
+ * Otherwise, an error is thrown.
  */
 static void check_for_connected_edges(CustomScanState *node)
 {
@@ -528,127 +653,222 @@ static void check_for_connected_edges(CustomScanState *node)
         (cypher_delete_custom_scan_state *)node;
     EState *estate = css->css.ss.ps.state;
     char *graph_name = css->delete_data->graph_name;
+    long num_vertices = hash_get_num_entries(css->vertex_id_htab);
+
+    /* if no vertices were deleted, there can't be any connected edges */
+    if (num_vertices == 0)
+    {
+        return;
+    }
 
     /* scans each label from css->edge_labels */
     foreach (lc, css->edge_labels)
     {
         char *label_name = lfirst(lc);
+        entity_rel_cache_entry *entry;
         ResultRelInfo *resultRelInfo;
-        TableScanDesc scan_desc;
-        HeapTuple tuple;
         TupleTableSlot *slot;
-        Oid relid;
-        bool rls_enabled = false;
-        List *qualExprs = NIL;
-        ExprContext *econtext = NULL;
-
-        resultRelInfo = create_entity_result_rel_info(estate, graph_name,
-                                                      label_name);
-        relid = RelationGetRelid(resultRelInfo->ri_RelationDesc);
-        estate->es_snapshot->curcid = GetCurrentCommandId(false);
-        estate->es_output_cid = GetCurrentCommandId(false);
-        scan_desc = table_beginscan(resultRelInfo->ri_RelationDesc,
-                                    estate->es_snapshot, 0, NULL);
-        slot = ExecInitExtraTupleSlot(
-            estate, RelationGetDescr(resultRelInfo->ri_RelationDesc),
-            &TTSOpsHeapTuple);
+        Oid start_id_index;
+        Oid end_id_index;
+        bool rls_enabled;
+        List *qualExprs;
+        ExprContext *econtext = css->css.ss.ps.ps_ExprContext;
 
         /*
-         * For DETACH DELETE with RLS enabled, compile the security qual
-         * expressions once per label for efficient evaluation.
+         * The label's state is shared with the deletes of its edges, and has
+         * the security quals compiled once per label when RLS is enabled.
          */
-        if (css->delete_data->detach)
+        entry = get_entity_rel_cache_entry(css->label_cache, node, graph_name,
+                                           label_name, CMD_DELETE);
+        resultRelInfo = entry->resultRelInfo;
+        slot = entry->slot;
+        rls_enabled = entry->rls_enabled;
+        qualExprs = entry->qualExprs;
+        estate->es_snapshot->curcid = GetCurrentCommandId(false);
+        estate->es_output_cid = GetCurrentCommandId(false);
+
+        start_id_index = get_label_column_index(resultRelInfo->ri_RelationDesc,
+                                                Anum_ag_label_edge_table_start_id);
+        end_id_index = get_label_column_index(resultRelInfo->ri_RelationDesc,
+                                              Anum_ag_label_edge_table_end_id);
+
+        if (use_connected_edge_indexes(resultRelInfo->ri_RelationDesc,
+                                       num_vertices, start_id_index,
+                                       end_id_index))
         {
-            /* Setup RLS security quals for this label */
-            if (check_enable_rls(relid, InvalidOid, true) == RLS_ENABLED)
+            HASH_SEQ_STATUS hash_seq;
+            graphid *vertex_id;
+            AttrNumber attnums[2] = {Anum_ag_label_edge_table_start_id,
+                                     Anum_ag_label_edge_table_end_id};
+            Oid index_oids[2] = {start_id_index, end_id_index};
+
+            /* probe the start_id and end_id indexes for each vertex */
+            hash_seq_init(&hash_seq, css->vertex_id_htab);
+            while ((vertex_id = hash_seq_search(&hash_seq)) != NULL)
             {
-                rls_enabled = true;
-                econtext = css->css.ss.ps.ps_ExprContext;
-                qualExprs = setup_security_quals(resultRelInfo, estate, node,
-                                                 CMD_DELETE);
-            }
-        }
+                int i;
 
-        /* for each row */
-        while (true)
-        {
-            graphid startid;
-            graphid endid;
-            bool isNull;
-            bool found_startid = false;
-            bool found_endid = false;
+                for (i = 0; i < 2; i++)
+                {
+                    ScanKeyData scan_keys[1];
+                    SysScanDesc scan_desc;
+                    HeapTuple tuple;
+
+                    ScanKeyInit(&scan_keys[0], attnums[i],
+                                BTEqualStrategyNumber, F_GRAPHIDEQ,
+                                GRAPHID_GET_DATUM(*vertex_id));
+                    scan_desc = systable_beginscan(
+                        resultRelInfo->ri_RelationDesc, index_oids[i], true,
+                        estate->es_snapshot, 1, scan_keys);
+
+                    while ((tuple = systable_getnext(scan_desc)) != NULL)
+                    {
+                        ExecStoreHeapTuple(tuple, slot, false);
 
-            tuple = heap_getnext(scan_desc, ForwardScanDirection);
+                        process_connected_edge(css, resultRelInfo, slot, tuple,
+                                               label_name, rls_enabled,
+                                               qualExprs, econtext);
+                    }
 
-            /* no more tuples to process, break and scan the next label. */
-            if (!HeapTupleIsValid(tuple))
-            {
-                break;
+                    systable_endscan(scan_desc);
+                }
             }
+        }
+        else
+        {
+            TableScanDesc scan_desc;
+            HeapTuple tuple;
 
-            ExecStoreHeapTuple(tuple, slot, false);
-
-            startid = GRAPHID_GET_DATUM(slot_getattr(
-                slot, Anum_ag_label_edge_table_start_id, &isNull));
-            endid = GRAPHID_GET_DATUM(
-                slot_getattr(slot, Anum_ag_label_edge_table_end_id, &isNull));
-
-            hash_search(css->vertex_id_htab, (void *)&startid, HASH_FIND,
-                        &found_startid);
+            scan_desc = table_beginscan(resultRelInfo->ri_RelationDesc,
+                                        estate->es_snapshot, 0, NULL);
 
-            if (!found_startid)
+            /* for each row */
+            while (true)
             {
-                hash_search(css->vertex_id_htab, (void *)&endid, HASH_FIND,
-                            &found_endid);
-            }
+                graphid startid;
+                graphid endid;
+                bool isNull;
+                bool found_startid = false;
+                bool found_endid = false;
 
-            if (found_startid || found_endid)
-            {
-                if (css->delete_data->detach)
+                tuple = heap_getnext(scan_desc, ForwardScanDirection);
+
+                /* no more tuples to process, break and scan the next label. */
+                if (!HeapTupleIsValid(tuple))
                 {
-                    AclResult aclresult;
+                    break;
+                }
 
-                    /* Check that the user has DELETE permission on the edge table */
-                    aclresult = pg_class_aclcheck(relid, GetUserId(), ACL_DELETE);
-                    if (aclresult != ACLCHECK_OK)
-                    {
-                        aclcheck_error(aclresult, OBJECT_TABLE, label_name);
-                    }
+                ExecStoreHeapTuple(tuple, slot, false);
 
-                    /* Check RLS security quals (USING policy) before delete */
-                    if (rls_enabled)
-                    {
-                        /*
-                         * For DETACH DELETE, error out if edge RLS check fails.
-                         * Unlike normal DELETE which silently skips, we cannot
-                         * silently skip edges here as it would leave dangling
-                         * edges pointing to deleted vertices.
-                         */
-                        if (!check_security_quals(qualExprs, slot, econtext))
-                        {
-                            ereport(ERROR,
-                                    (errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
-                                     errmsg("cannot delete edge due to row-level security policy on \"%s\"",
-                                            label_name),
-                                     errhint("DETACH DELETE requires permission to delete all connected edges.")));
-                        }
-                    }
+                startid = GRAPHID_GET_DATUM(slot_getattr(
+                    slot, Anum_ag_label_edge_table_start_id, &isNull));
+                endid = GRAPHID_GET_DATUM(slot_getattr(
+                    slot, Anum_ag_label_edge_table_end_id, &isNull));
 
-                    delete_entity(estate, resultRelInfo, tuple);
+                hash_search(css->vertex_id_htab, (void *)&startid, HASH_FIND,
+                            &found_startid);
+
+                if (!found_startid)
+                {
+                    hash_search(css->vertex_id_htab, (void *)&endid, HASH_FIND,
+                                &found_endid);
                 }
-                else
+
+                if (found_startid || found_endid)
                 {
-                    ereport(
-                        ERROR,
-                        (errcode(ERRCODE_INTERNAL_ERROR),
-                         errmsg(
-                             "Cannot delete a vertex that has edge(s). "
-                             "Delete the edge(s) first, or try DETACH DELETE.")));
+                    process_connected_edge(css, resultRelInfo, slot, tuple,
+                                           label_name, rls_enabled, qualExprs,
+                                           econtext);
                 }
             }
+
+            table_endscan(scan_desc);
         }
 
-        table_endscan(scan_desc);
-        destroy_entity_result_rel_info(resultRelInfo);
+        ExecClearTuple(slot);
+    }
+
+    flush_delete_batches(css);
+}
+
+/*
+ * Helper function to decide whether the edges connected to the deleted
+ * vertices are found by probing the label's start_id and end_id indexes, or by
+ * scanning the whole label table. Each vertex costs a probe of both indexes,
+ * a few random page reads each, against reading every page of the table once.
+ * Few deleted vertices favor the probes, many favor the scan.
+ */
+static bool use_connected_edge_indexes(Relation rel, long num_vertices,
+                                       Oid start_id_index, Oid end_id_index)
+{
+    double probe_cost;
+    double scan_cost;
+
+    /* both indexes are needed to find all of the connected edges */
+    if (!OidIsValid(start_id_index) || !OidIsValid(end_id_index))
+    {
+        return false;
+    }
+
+    probe_cost = (double)num_vertices * 2 * DELETE_INDEX_PROBE_PAGES *
+                 random_page_cost;
+    scan_cost = (double)RelationGetNumberOfBlocks(rel) * seq_page_cost;
+
+    return probe_cost < scan_cost;
+}
+
+/*
+ * Helper function to process an edge connected to a deleted vertex. For DETACH
+ * DELETE the edge is queued for deletion, otherwise it is an error.
+ */
+static void process_connected_edge(cypher_delete_custom_scan_state *css,
+                                   ResultRelInfo *resultRelInfo,
+                                   TupleTableSlot *slot, HeapTuple tuple,
+                                   char *label_name, bool rls_enabled,
+                                   List *qualExprs, ExprContext *econtext)
+{
+    if (css->delete_data->detach)
+    {
+        AclResult aclresult;
+
+        /* Check that the user has DELETE permission on the edge table */
+        aclresult = pg_class_aclcheck(
+            RelationGetRelid(resultRelInfo->ri_RelationDesc), GetUserId(),
+            ACL_DELETE);
+        if (aclresult != ACLCHECK_OK)
+        {
+            aclcheck_error(aclresult, OBJECT_TABLE, label_name);
+        }
+
+        /* Check RLS security quals (USING policy) before delete */
+        if (rls_enabled)
+        {
+            /*
+             * For DETACH DELETE, error out if edge RLS check fails.
+             * Unlike normal DELETE which silently skips, we cannot
+             * silently skip edges here as it would leave dangling
+             * edges pointing to deleted vertices.
+             */
+            if (!check_security_quals(qualExprs, slot, econtext))
+            {
+                ereport(ERROR,
+                        (errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+                         errmsg("cannot delete edge due to row-level security policy on \"%s\"",
+                                label_name),
+                         errhint("DETACH DELETE requires permission to delete all connected edges.")));
+            }
+        }
+
+        add_to_delete_batch(css, resultRelInfo, &tuple->t_self);
+    }
+    else
+    {
+        ereport(
+            ERROR,
+            (errcode(ERRCODE_INTERNAL_ERROR),
+             errmsg(
+                 "Cannot delete a vertex that has edge(s). "
+                 "Delete the edge(s) first, or try DETACH DELETE.")));
     }
 }
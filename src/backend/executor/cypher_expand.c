@@ -0,0 +1,350 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "postgres.h"
+
+#include "access/tableam.h"
+#include "commands/explain.h"
+#include "executor/executor.h"
+#include "miscadmin.h"
+#include "storage/bufmgr.h"
+#include "utils/lsyscache.h"
+
+#include "executor/cypher_executor.h"
+#include "executor/cypher_utils.h"
+#include "utils/graphid.h"
+
+/* how many TIDs ahead of the one being fetched are prefetched */
+#define EXPAND_PREFETCH_DISTANCE 16
+#define EXPAND_INITIAL_TIDS 64
+
+static void begin_cypher_expand(CustomScanState *node, EState *estate,
+                                int eflags);
+static TupleTableSlot *exec_cypher_expand(CustomScanState *node);
+static void end_cypher_expand(CustomScanState *node);
+static void rescan_cypher_expand(CustomScanState *node);
+static void explain_cypher_expand(CustomScanState *node, List *ancestors,
+                                  ExplainState *es);
+
+static bool fetch_next_outer(cypher_expand_custom_scan_state *css);
+static bool fetch_next_edge(cypher_expand_custom_scan_state *css);
+static void store_scan_tuple(cypher_expand_custom_scan_state *css,
+                             TupleTableSlot *edge_slot);
+static void prefetch_edges(cypher_expand_custom_scan_state *css);
+static int compare_tids(const void *a, const void *b);
+
+const CustomExecMethods cypher_expand_exec_methods = {EXPAND_SCAN_STATE_NAME,
+                                                      begin_cypher_expand,
+                                                      exec_cypher_expand,
+                                                      end_cypher_expand,
+                                                      rescan_cypher_expand,
+                                                      NULL,
+                                                      NULL,
+                                                      NULL,
+                                                      NULL,
+                                                      NULL,
+                                                      NULL,
+                                                      NULL,
+                                                      explain_cypher_expand};
+
+static void begin_cypher_expand(CustomScanState *node, EState *estate,
+                                int eflags)
+{
+    cypher_expand_custom_scan_state *css =
+        (cypher_expand_custom_scan_state *)node;
+    Plan *subplan;
+
+    Assert(list_length(css->cs->custom_plans) == 1);
+
+    subplan = linitial(css->cs->custom_plans);
+    node->ss.ps.lefttree = ExecInitNode(subplan, estate, eflags);
+
+    /* the key is evaluated on the scan tuple, holding just the outer row */
+    css->key_expr = ExecInitExpr(linitial(css->cs->custom_exprs),
+                                 (PlanState *)node);
+
+    /* the label table is locked already, it is in the range table */
+    css->rel = table_open(css->relid, AccessShareLock);
+    css->index_rel = index_open(css->index_oid, AccessShareLock);
+
+    css->index_scan = index_beginscan(css->rel, css->index_rel,
+                                      estate->es_snapshot, 1, 0);
+    css->fetch = table_index_fetch_begin(css->rel);
+    css->edge_slot = table_slot_create(css->rel, &estate->es_tupleTable);
+
+    css->max_tids = EXPAND_INITIAL_TIDS;
+    css->tids = palloc(sizeof(ItemPointerData) * css->max_tids);
+    css->ntids = 0;
+    css->next_tid = 0;
+    css->next_prefetch = 0;
+    css->last_prefetched = InvalidBlockNumber;
+    css->call_again = false;
+}
+
+/*
+ * Returns the next outer row joined with one of its edges. The edges of an
+ * outer row are all found first, with one probe of the index, and then read
+ * from the heap in physical order.
+ */
+static TupleTableSlot *exec_cypher_expand(CustomScanState *node)
+{
+    cypher_expand_custom_scan_state *css =
+        (cypher_expand_custom_scan_state *)node;
+    ExprContext *econtext = node->ss.ps.ps_ExprContext;
+
+    for (;;)
+    {
+        CHECK_FOR_INTERRUPTS();
+
+        /* when the edges of the outer row are done, move to the next row */
+        if (css->next_tid >= css->ntids)
+        {
+            if (!fetch_next_outer(css))
+                return NULL;
+
+            continue;
+        }
+
+        /* skip the edges that are not visible to the snapshot */
+        if (!fetch_next_edge(css))
+            continue;
+
+        ResetExprContext(econtext);
+        store_scan_tuple(css, css->edge_slot);
+        econtext->ecxt_scantuple = node->ss.ss_ScanTupleSlot;
+
+        if (ExecQual(node->ss.ps.qual, econtext))
+        {
+            if (node->ss.ps.ps_ProjInfo == NULL)
+                return node->ss.ss_ScanTupleSlot;
+
+            return ExecProject(node->ss.ps.ps_ProjInfo);
+        }
+
+        InstrCountFiltered1(node, 1);
+    }
+}
+
+/*
+ * Helper function to get the next outer row and collect the TIDs of its
+ * edges. Returns false when there are no more outer rows.
+ */
+static bool fetch_next_outer(cypher_expand_custom_scan_state *css)
+{
+    ExprContext *econtext = css->css.ss.ps.ps_ExprContext;
+    ScanKeyData scan_key;
+    ItemPointer tid;
+    Datum key;
+    bool isnull;
+
+    css->outer_slot = ExecProcNode(css->css.ss.ps.lefttree);
+    if (TupIsNull(css->outer_slot))
+    {
+        css->outer_slot = NULL;
+        return false;
+    }
+
+    css->ntids = 0;
+    css->next_tid = 0;
+    css->next_prefetch = 0;
+    css->last_prefetched = InvalidBlockNumber;
+    css->call_again = false;
+
+    ResetExprContext(econtext);
+    store_scan_tuple(css, NULL);
+    econtext->ecxt_scantuple = css->css.ss.ss_ScanTupleSlot;
+
+    key = ExecEvalExprSwitchContext(css->key_expr, econtext, &isnull);
+
+    /* a NULL key has no edges */
+    if (isnull)
+        return true;
+
+    /* the scan key is for the first, and only, column of the index */
+    ScanKeyInit(&scan_key, 1, BTEqualStrategyNumber, F_GRAPHIDEQ, key);
+    index_rescan(css->index_scan, &scan_key, 1, NULL, 0);
+
+    while ((tid = index_getnext_tid(css->index_scan,
+                                    ForwardScanDirection)) != NULL)
+    {
+        if (css->ntids == css->max_tids)
+        {
+            css->max_tids *= 2;
+            css->tids = repalloc(css->tids,
+                                 sizeof(ItemPointerData) * css->max_tids);
+        }
+
+        css->tids[css->ntids++] = *tid;
+    }
+
+    if (css->ntids > 1)
+        qsort(css->tids, css->ntids, sizeof(ItemPointerData), compare_tids);
+
+    return true;
+}
+
+/*
+ * Helper function to fetch the edge of the next TID into the edge slot.
+ * Returns false if that edge is not visible.
+ */
+static bool fetch_next_edge(cypher_expand_custom_scan_state *css)
+{
+    EState *estate = css->css.ss.ps.state;
+    bool all_dead = false;
+    bool found;
+
+    prefetch_edges(css);
+
+    found = table_index_fetch_tuple(css->fetch, &css->tids[css->next_tid],
+                                    estate->es_snapshot, css->edge_slot,
+                                    &css->call_again, &all_dead);
+
+    /* a non-MVCC snapshot may see more than one tuple of a HOT chain */
+    if (!css->call_again)
+        css->next_tid++;
+
+    return found;
+}
+
+/*
+ * Helper function to store the outer row, followed by the edge, into the scan
+ * tuple. If there is no edge, its columns are NULL.
+ */
+static void store_scan_tuple(cypher_expand_custom_scan_state *css,
+                             TupleTableSlot *edge_slot)
+{
+    TupleTableSlot *scan_slot = css->css.ss.ss_ScanTupleSlot;
+    int natts = scan_slot->tts_tupleDescriptor->natts;
+    int i;
+
+    ExecClearTuple(scan_slot);
+
+    slot_getallattrs(css->outer_slot);
+    memcpy(scan_slot->tts_values, css->outer_slot->tts_values,
+           sizeof(Datum) * css->outer_natts);
+    memcpy(scan_slot->tts_isnull, css->outer_slot->tts_isnull,
+           sizeof(bool) * css->outer_natts);
+
+    if (edge_slot != NULL)
+        slot_getallattrs(edge_slot);
+
+    for (i = css->outer_natts; i < natts; i++)
+    {
+        if (edge_slot == NULL)
+        {
+            scan_slot->tts_values[i] = (Datum)0;
+            scan_slot->tts_isnull[i] = true;
+        }
+        else
+        {
+            scan_slot->tts_values[i] =
+                edge_slot->tts_values[i - css->outer_natts];
+            scan_slot->tts_isnull[i] =
+                edge_slot->tts_isnull[i - css->outer_natts];
+        }
+    }
+
+    ExecStoreVirtualTuple(scan_slot);
+}
+
+/*
+ * Helper function to prefetch the heap blocks of the TIDs up to
+ * EXPAND_PREFETCH_DISTANCE ahead of the next one. As the TIDs are sorted,
+ * consecutive edges on the same block are prefetched once.
+ */
+static void prefetch_edges(cypher_expand_custom_scan_state *css)
+{
+    while (css->next_prefetch < css->ntids &&
+           css->next_prefetch < css->next_tid + EXPAND_PREFETCH_DISTANCE)
+    {
+        BlockNumber block =
+            ItemPointerGetBlockNumber(&css->tids[css->next_prefetch]);
+
+        if (block != css->last_prefetched)
+        {
+            PrefetchBuffer(css->rel, MAIN_FORKNUM, block);
+            css->last_prefetched = block;
+        }
+
+        css->next_prefetch++;
+    }
+}
+
+static int compare_tids(const void *a, const void *b)
+{
+    return ItemPointerCompare((ItemPointer)a, (ItemPointer)b);
+}
+
+static void end_cypher_expand(CustomScanState *node)
+{
+    cypher_expand_custom_scan_state *css =
+        (cypher_expand_custom_scan_state *)node;
+
+    ExecEndNode(node->ss.ps.lefttree);
+
+    ExecClearTuple(css->edge_slot);
+    table_index_fetch_end(css->fetch);
+    index_endscan(css->index_scan);
+
+    index_close(css->index_rel, AccessShareLock);
+    table_close(css->rel, AccessShareLock);
+}
+
+static void rescan_cypher_expand(CustomScanState *node)
+{
+    cypher_expand_custom_scan_state *css =
+        (cypher_expand_custom_scan_state *)node;
+
+    css->outer_slot = NULL;
+    css->ntids = 0;
+    css->next_tid = 0;
+    css->next_prefetch = 0;
+    css->call_again = false;
+
+    /* a changed parameter makes the child rescan on its next ExecProcNode */
+    if (node->ss.ps.lefttree->chgParam == NULL)
+        ExecReScan(node->ss.ps.lefttree);
+}
+
+static void explain_cypher_expand(CustomScanState *node, List *ancestors,
+                                  ExplainState *es)
+{
+    cypher_expand_custom_scan_state *css =
+        (cypher_expand_custom_scan_state *)node;
+
+    ExplainPropertyText("Edge Index", get_rel_name(css->index_oid), es);
+}
+
+Node *create_cypher_expand_plan_state(CustomScan *cscan)
+{
+    cypher_expand_custom_scan_state *cypher_css =
+        palloc0(sizeof(cypher_expand_custom_scan_state));
+    List *oids = linitial(cscan->custom_private);
+
+    cypher_css->cs = cscan;
+
+    cypher_css->relid = linitial_oid(oids);
+    cypher_css->index_oid = lsecond_oid(oids);
+    cypher_css->outer_natts = linitial_int(lsecond(cscan->custom_private));
+
+    cypher_css->css.ss.ps.type = T_CustomScanState;
+    cypher_css->css.methods = &cypher_expand_exec_methods;
+
+    return (Node *)cypher_css;
+}
@@ -19,6 +19,7 @@
 
 #include "postgres.h"
 
+#include "common/hashfn.h"
 #include "utils/datum.h"
 #include "utils/rls.h"
 
@@ -59,6 +60,16 @@ typedef struct created_path
     struct path_entry **entry;  /* path_entry array for this link */
 } created_path;
 
+/*
+ * The following structure is the entry of the created paths hashtable. The
+ * paths are hashed by hash_path and the ones sharing a hash are chained.
+ */
+typedef struct created_path_bucket
+{
+    uint32 hash;                /* hash key, the hash of the paths */
+    created_path *paths;        /* linked list of the paths with this hash */
+} created_path_bucket;
+
 static void begin_cypher_merge(CustomScanState *node, EState *estate,
                                int eflags);
 static TupleTableSlot *exec_cypher_merge(CustomScanState *node);
@@ -79,6 +90,10 @@ static bool check_path(cypher_merge_custom_scan_state *css,
 static void process_path(cypher_merge_custom_scan_state *css,
                          path_entry **path_array, bool should_insert);
 static void mark_tts_isnull(TupleTableSlot *slot);
+static void insert_merged_entity(cypher_merge_custom_scan_state *css,
+                                 ResultRelInfo *resultRelInfo,
+                                 TupleTableSlot *elemTupleSlot,
+                                 CommandId cid);
 
 const CustomExecMethods cypher_merge_exec_methods = {MERGE_SCAN_STATE_NAME,
                                                      begin_cypher_merge,
@@ -91,8 +106,10 @@ const CustomExecMethods cypher_merge_exec_methods = {MERGE_SCAN_STATE_NAME,
 static path_entry **prebuild_path(CustomScanState *node);
 static bool compare_2_paths(path_entry **lhs, path_entry **rhs,
                             int path_length);
+static uint32 hash_path(path_entry **path_array, int path_length);
 static path_entry **find_duplicate_path(CustomScanState *node,
                                         path_entry **path_array);
+static void add_created_path(CustomScanState *node, path_entry **path_array);
 static void free_path_entry_array(path_entry **path_array, int length);
 
 /*
@@ -106,7 +123,7 @@ static void begin_cypher_merge(CustomScanState *node, EState *estate,
         (cypher_merge_custom_scan_state *)node;
     ListCell *lc = NULL;
     Plan *subplan = NULL;
-    css->created_paths_list = NULL;
+    css->created_paths = NULL;
 
     Assert(list_length(css->cs->custom_plans) == 1);
 
@@ -205,6 +222,34 @@ static void begin_cypher_merge(CustomScanState *node, EState *estate,
     /* store the currentCommandId for this instance */
     css->base_currentCommandId = GetCurrentCommandId(false);
 
+    /*
+     * A terminal MERGE with a previous clause checks the paths it created
+     * through created_paths, not the tables. So, what it creates can be
+     * buffered and written in batches.
+     */
+    css->buffer_inserts = CYPHER_CLAUSE_HAS_PREVIOUS_CLAUSE(css->flags) &&
+                          CYPHER_CLAUSE_IS_TERMINAL(css->flags);
+    css->insert_buffers = NIL;
+
+    /*
+     * When there is a previous clause, MERGE keeps the paths it created in a
+     * hashtable to find the rows that need a path it already created.
+     */
+    if (CYPHER_CLAUSE_HAS_PREVIOUS_CLAUSE(css->flags))
+    {
+        HASHCTL hashctl;
+
+        MemSet(&hashctl, 0, sizeof(hashctl));
+        hashctl.keysize = sizeof(uint32);
+        hashctl.entrysize = sizeof(created_path_bucket);
+        hashctl.hcxt = estate->es_query_cxt;
+
+        css->created_paths = hash_create("cypher merge created paths", 1024,
+                                         &hashctl,
+                                         HASH_ELEM | HASH_BLOBS |
+                                         HASH_CONTEXT);
+    }
+
     Increment_Estate_CommandId(estate);
 }
 
@@ -521,36 +566,63 @@ static bool compare_2_paths(path_entry **lhs, path_entry **rhs, int path_length)
     return true;
 }
 
-/* helper function to find a duplicate path in the created_paths_list */
+/*
+ * Helper function to hash a path. Paths that compare_2_paths finds equal
+ * hash the same, as the hash uses the same fields the comparison does.
+ */
+static uint32 hash_path(path_entry **path_array, int path_length)
+{
+    uint32 hash = 0;
+    int i;
+
+    for (i = 0; i < path_length; i++)
+    {
+        path_entry *entry = path_array[i];
+
+        /* actual vertices are only compared by their IDs */
+        if (entry->actual)
+        {
+            hash = hash_combine(hash, hash_bytes((unsigned char *)&entry->id,
+                                                 sizeof(graphid)));
+            continue;
+        }
+
+        hash = hash_combine(hash, murmurhash32(entry->label));
+        hash = hash_combine(hash, murmurhash32((uint32)entry->direction));
+        hash = hash_combine(hash, entry->dih);
+    }
+
+    return hash;
+}
+
+/* helper function to find a duplicate path in the created paths hashtable */
 static path_entry **find_duplicate_path(CustomScanState *node,
-                                         path_entry **path_array)
+                                        path_entry **path_array)
 {
     cypher_merge_custom_scan_state *css =
         (cypher_merge_custom_scan_state *)node;
     int path_length = list_length(css->path->target_nodes);
+    created_path_bucket *bucket;
+    created_path *curr_path;
+    uint32 hash;
 
-    /* if the list is NULL just return NULL */
-    if (css->created_paths_list == NULL)
+    hash = hash_path(path_array, path_length);
+    bucket = hash_search(css->created_paths, &hash, HASH_FIND, NULL);
+
+    /* if there is no bucket, there is no path with this hash */
+    if (bucket == NULL)
     {
         return NULL;
     }
-    /* otherwise, check to see if the path already exists */
-    else
-    {
-        /* set to the top of the list */
-        created_path *curr_path = css->created_paths_list;
 
-        /* iterate through our list of created paths */
-        while (curr_path != NULL)
+    /* iterate through the paths with the same hash */
+    for (curr_path = bucket->paths; curr_path != NULL;
+         curr_path = curr_path->next)
+    {
+        /* if we have found the entry, return it */
+        if (compare_2_paths(path_array, curr_path->entry, path_length))
         {
-            /* if we have found the entry, return it */
-            if (compare_2_paths(path_array, curr_path->entry, path_length))
-            {
-                return curr_path->entry;
-            }
-
-            /* otherwise, get the next path */
-            curr_path = curr_path->next;
+            return curr_path->entry;
         }
     }
 
@@ -558,6 +630,32 @@ static path_entry **find_duplicate_path(CustomScanState *node,
     return NULL;
 }
 
+/* helper function to add a path to the created paths hashtable */
+static void add_created_path(CustomScanState *node, path_entry **path_array)
+{
+    cypher_merge_custom_scan_state *css =
+        (cypher_merge_custom_scan_state *)node;
+    int path_length = list_length(css->path->target_nodes);
+    created_path_bucket *bucket;
+    created_path *new_path;
+    uint32 hash;
+    bool found;
+
+    hash = hash_path(path_array, path_length);
+    bucket = hash_search(css->created_paths, &hash, HASH_ENTER, &found);
+
+    if (!found)
+    {
+        bucket->paths = NULL;
+    }
+
+    /* push the path onto the bucket's list */
+    new_path = palloc0(sizeof(created_path));
+    new_path->next = bucket->paths;
+    new_path->entry = path_array;
+    bucket->paths = new_path;
+}
+
 /*
  * Function that is called mid-execution. This function will call
  * its subtree in the execution tree, and depending on the results
@@ -665,15 +763,8 @@ static TupleTableSlot *exec_cypher_merge(CustomScanState *node)
                 /* otherwise, we need to insert the new, prebuilt, path */
                 else
                 {
-                    created_path *new_path = palloc0(sizeof(created_path));
-
-                    /* build the next linked list entry for our created_paths */
-                    new_path = palloc0(sizeof(created_path));
-                    new_path->next = css->created_paths_list;
-                    new_path->entry = prebuilt_path_array;
-
-                    /* we need to push our prebuilt path onto the list */
-                    css->created_paths_list = new_path;
+                    /* we need to add our prebuilt path to the created paths */
+                    add_created_path(node, prebuilt_path_array);
 
                     /*
                      * We need to pass in the prebuilt path so that it can get
@@ -685,6 +776,9 @@ static TupleTableSlot *exec_cypher_merge(CustomScanState *node)
 
         } while (terminal);
 
+        /* write out what was buffered before moving on */
+        flush_entity_insert_buffers(css->insert_buffers, estate);
+
         /* if this was a terminal MERGE just return NULL */
         if (terminal)
         {
@@ -874,6 +968,9 @@ static void end_cypher_merge(CustomScanState *node)
 
     ExecEndNode(node->ss.ps.lefttree);
 
+    free_entity_insert_buffers(css->insert_buffers);
+    css->insert_buffers = NIL;
+
     foreach (lc, path->target_nodes)
     {
         cypher_target_node *cypher_node = (cypher_target_node *)lfirst(lc);
@@ -891,24 +988,37 @@ static void end_cypher_merge(CustomScanState *node)
                     RowExclusiveLock);
     }
 
-    /* free up our created paths lists */
-    while (css->created_paths_list != NULL)
+    /* free up our created paths */
+    if (css->created_paths != NULL)
     {
-        created_path *next = css->created_paths_list->next;
-        path_entry **entry = css->created_paths_list->entry;
+        HASH_SEQ_STATUS hash_seq;
+        created_path_bucket *bucket;
 
-        /* free up the path array elements */
-        free_path_entry_array(entry, path_length);
+        hash_seq_init(&hash_seq, css->created_paths);
 
-        /* free up the array container */
-        pfree_if_not_null(entry);
+        while ((bucket = hash_seq_search(&hash_seq)) != NULL)
+        {
+            while (bucket->paths != NULL)
+            {
+                created_path *next = bucket->paths->next;
+                path_entry **entry = bucket->paths->entry;
 
-        /* free up the created_path container */
-        pfree_if_not_null(css->created_paths_list);
+                /* free up the path array elements */
+                free_path_entry_array(entry, path_length);
 
-        css->created_paths_list = next;
-    }
+                /* free up the array container */
+                pfree_if_not_null(entry);
 
+                /* free up the created_path container */
+                pfree_if_not_null(bucket->paths);
+
+                bucket->paths = next;
+            }
+        }
+
+        hash_destroy(css->created_paths);
+        css->created_paths = NULL;
+    }
 }
 
 /*
@@ -960,6 +1070,31 @@ Node *create_cypher_merge_plan_state(CustomScan *cscan)
     return (Node *)cypher_css;
 }
 
+/*
+ * Insert the entity in the element slot with the passed cid, buffering it
+ * when this MERGE writes its entities in batches.
+ */
+static void insert_merged_entity(cypher_merge_custom_scan_state *css,
+                                 ResultRelInfo *resultRelInfo,
+                                 TupleTableSlot *elemTupleSlot,
+                                 CommandId cid)
+{
+    EState *estate = css->css.ss.ps.state;
+
+    if (css->buffer_inserts)
+    {
+        entity_insert_buffer *buffer;
+
+        buffer = get_entity_insert_buffer(&css->insert_buffers, resultRelInfo,
+                                          estate);
+        buffer_entity_tuple(buffer, elemTupleSlot, estate, cid);
+    }
+    else
+    {
+        insert_entity_tuple_cid(resultRelInfo, elemTupleSlot, estate, cid);
+    }
+}
+
 /*
  * Creates the vertex entity, returns the vertex's id in case the caller is
  * the create_edge function.
@@ -1097,7 +1232,8 @@ static Datum merge_vertex(cypher_merge_custom_scan_state *css,
         if (should_insert &&
             css->base_currentCommandId == GetCurrentCommandId(false))
         {
-            insert_entity_tuple(resultRelInfo, elemTupleSlot, estate);
+            insert_merged_entity(css, resultRelInfo, elemTupleSlot,
+                                 GetCurrentCommandId(true));
 
             /*
              * Increment the currentCommandId since we processed an update. We
@@ -1109,8 +1245,8 @@ static Datum merge_vertex(cypher_merge_custom_scan_state *css,
         }
         else if (should_insert)
         {
-            insert_entity_tuple_cid(resultRelInfo, elemTupleSlot, estate,
-                                    css->base_currentCommandId);
+            insert_merged_entity(css, resultRelInfo, elemTupleSlot,
+                                 css->base_currentCommandId);
         }
 
         /* restore the old result relation info */
@@ -1436,7 +1572,8 @@ static void merge_edge(cypher_merge_custom_scan_state *css,
     if (should_insert &&
         css->base_currentCommandId == GetCurrentCommandId(false))
     {
-        insert_entity_tuple(resultRelInfo, elemTupleSlot, estate);
+        insert_merged_entity(css, resultRelInfo, elemTupleSlot,
+                             GetCurrentCommandId(true));
 
         /*
          * Increment the currentCommandId since we processed an update. We
@@ -1448,8 +1585,8 @@ static void merge_edge(cypher_merge_custom_scan_state *css,
     }
     else if (should_insert)
     {
-        insert_entity_tuple_cid(resultRelInfo, elemTupleSlot, estate,
-                                    css->base_currentCommandId);
+        insert_merged_entity(css, resultRelInfo, elemTupleSlot,
+                             css->base_currentCommandId);
     }
 
     /* restore the old result relation info */
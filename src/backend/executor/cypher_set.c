@@ -26,6 +26,7 @@
 
 #include "executor/cypher_executor.h"
 #include "executor/cypher_utils.h"
+#include "utils/age_global_graph.h"
 
 static void begin_cypher_set(CustomScanState *node, EState *estate,
                                 int eflags);
@@ -77,6 +78,9 @@ static void begin_cypher_set(CustomScanState *node, EState *estate,
         ExecAssignProjectionInfo(&node->ss.ps, tupdesc);
     }
 
+    /* init the per label cache */
+    css->label_cache = create_entity_rel_cache(estate);
+
     /*
      * Postgres does not assign the es_output_cid in queries that do
      * not write to disk, ie: SELECT commands. We need the command id
@@ -116,7 +120,6 @@ static HeapTuple update_entity_tuple(ResultRelInfo *resultRelInfo,
 
     if (lock_result == TM_Ok)
     {
-        ExecOpenIndices(resultRelInfo, false);
         ExecStoreVirtualTuple(elemTupleSlot);
         tuple = ExecFetchSlotHeapTuple(elemTupleSlot, true, NULL);
         tuple->t_self = old_tuple->t_self;
@@ -151,7 +154,6 @@ static HeapTuple update_entity_tuple(ResultRelInfo *resultRelInfo,
                          errmsg("tuple to be updated was already modified")));
             }
 
-            ExecCloseIndices(resultRelInfo);
             estate->es_result_relations = saved_resultRels;
 
             return tuple;
@@ -170,7 +172,9 @@ static HeapTuple update_entity_tuple(ResultRelInfo *resultRelInfo,
                                 (update_indexes == TU_Summarizing));
         }
 
-        ExecCloseIndices(resultRelInfo);
+        /* record the update for the global graph contexts */
+        record_graph_change(resultRelInfo->ri_RelationDesc,
+                            GRAPH_CHANGE_UPDATE, tuple);
     }
     else if (lock_result == TM_SelfModified)
     {
@@ -365,20 +369,10 @@ static void process_update_list(CustomScanState *node)
     EState *estate = css->css.ss.ps.state;
     int *luindex = NULL;
     int lidx = 0;
-    HTAB *qual_cache = NULL;
-    HASHCTL hashctl;
 
     /* allocate an array to hold the last update index of each 'entity' */
     luindex = palloc0(sizeof(int) * scanTupleSlot->tts_nvalid);
 
-    /* Hash table for caching compiled security quals per label */
-    MemSet(&hashctl, 0, sizeof(hashctl));
-    hashctl.keysize = sizeof(Oid);
-    hashctl.entrysize = sizeof(RLSCacheEntry);
-    hashctl.hcxt = CurrentMemoryContext;
-    qual_cache = hash_create("update_qual_cache", 8, &hashctl,
-                             HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
-
     /*
      * Iterate through the SET items list and store the loop index of each
      * 'entity' update. As there is only one entry for each entity, this will
@@ -413,9 +407,7 @@ static void process_update_list(CustomScanState *node)
         agtype *original_entity;
         agtype *new_property_value;
         TupleTableSlot *slot;
-        ResultRelInfo *resultRelInfo;
-        ScanKeyData scan_keys[1];
-        TableScanDesc scan_desc;
+        entity_rel_cache_entry *entry;
         bool remove_property;
         char *label_name;
         cypher_update_item *update_item;
@@ -519,44 +511,12 @@ static void process_update_list(CustomScanState *node)
             }
         }
 
-        resultRelInfo = create_entity_result_rel_info(
-            estate, css->set_list->graph_name, label_name);
-
-        slot = ExecInitExtraTupleSlot(
-            estate, RelationGetDescr(resultRelInfo->ri_RelationDesc),
-            &TTSOpsHeapTuple);
-
-        /* Setup RLS policies if RLS is enabled */
-        if (check_enable_rls(resultRelInfo->ri_RelationDesc->rd_id,
-                             InvalidOid, true) == RLS_ENABLED)
-        {
-            Oid relid = RelationGetRelid(resultRelInfo->ri_RelationDesc);
-            RLSCacheEntry *entry;
-            bool found;
-
-            /* Get cached RLS state for this label, or set it up */
-            entry = hash_search(qual_cache, &relid, HASH_ENTER, &found);
-            if (!found)
-            {
-                /* Setup WITH CHECK policies */
-                setup_wcos(resultRelInfo, estate, node, CMD_UPDATE);
-                entry->withCheckOptions = resultRelInfo->ri_WithCheckOptions;
-                entry->withCheckOptionExprs = resultRelInfo->ri_WithCheckOptionExprs;
-
-                /* Setup security quals */
-                entry->qualExprs = setup_security_quals(resultRelInfo, estate,
-                                                        node, CMD_UPDATE);
-                entry->slot = ExecInitExtraTupleSlot(
-                    estate, RelationGetDescr(resultRelInfo->ri_RelationDesc),
-                    &TTSOpsHeapTuple);
-            }
-            else
-            {
-                /* Use cached WCOs */
-                resultRelInfo->ri_WithCheckOptions = entry->withCheckOptions;
-                resultRelInfo->ri_WithCheckOptionExprs = entry->withCheckOptionExprs;
-            }
-        }
+        /* get the result relation and the rest of the label's state */
+        entry = get_entity_rel_cache_entry(css->label_cache, node,
+                                           css->set_list->graph_name,
+                                           label_name, CMD_UPDATE);
+        slot = entry->slot;
+        ExecClearTuple(slot);
 
         /*
          *  Now that we have the updated properties, create a either a vertex or
@@ -612,20 +572,8 @@ static void process_update_list(CustomScanState *node)
 
         if (luindex[update_item->entity_position - 1] == lidx)
         {
-            /*
-             * Setup the scan key to require the id field on-disc to match the
-             * entity's graphid.
-             */
-            ScanKeyInit(&scan_keys[0], 1, BTEqualStrategyNumber, F_GRAPHIDEQ,
-                        GRAPHID_GET_DATUM(id->val.int_value));
-            /*
-             * Setup the scan description, with the correct snapshot and scan
-             * keys.
-             */
-            scan_desc = table_beginscan(resultRelInfo->ri_RelationDesc,
-                                        estate->es_snapshot, 1, scan_keys);
             /* Retrieve the tuple. */
-            heap_tuple = heap_getnext(scan_desc, ForwardScanDirection);
+            heap_tuple = fetch_entity_tuple(estate, entry, id->val.int_value);
 
             /*
              * If the heap tuple still exists (It wasn't deleted between the
@@ -634,52 +582,34 @@ static void process_update_list(CustomScanState *node)
             if (HeapTupleIsValid(heap_tuple))
             {
                 bool should_update = true;
-                Oid relid = RelationGetRelid(resultRelInfo->ri_RelationDesc);
 
                 /* Check RLS security quals (USING policy) before update */
-                if (check_enable_rls(relid, InvalidOid, true) == RLS_ENABLED)
+                if (entry->rls_enabled)
                 {
-                    RLSCacheEntry *entry;
-
-                    /* Entry was already created earlier when setting up WCOs */
-                    entry = hash_search(qual_cache, &relid, HASH_FIND, NULL);
-                    if (!entry)
-                    {
-                        ereport(ERROR,
-                                (errcode(ERRCODE_INTERNAL_ERROR),
-                                 errmsg("missing RLS cache entry for relation %u",
-                                        relid)));
-                    }
-
-                    ExecStoreHeapTuple(heap_tuple, entry->slot, false);
+                    ExecStoreHeapTuple(heap_tuple, entry->rls_slot, false);
                     should_update = check_security_quals(entry->qualExprs,
-                                                         entry->slot,
+                                                         entry->rls_slot,
                                                          econtext);
+                    ExecClearTuple(entry->rls_slot);
                 }
 
                 /* Silently skip if USING policy filters out this row */
                 if (should_update)
                 {
-                    heap_tuple = update_entity_tuple(resultRelInfo, slot, estate,
-                                                     heap_tuple);
+                    update_entity_tuple(entry->resultRelInfo, slot, estate,
+                                        heap_tuple);
                 }
+
+                heap_freetuple(heap_tuple);
             }
-            /* close the ScanDescription */
-            table_endscan(scan_desc);
         }
 
         estate->es_snapshot->curcid = cid;
-        /* close relation */
-        ExecCloseIndices(resultRelInfo);
-        table_close(resultRelInfo->ri_RelationDesc, RowExclusiveLock);
 
         /* increment loop index */
         lidx++;
     }
 
-    /* Clean up the cache */
-    hash_destroy(qual_cache);
-
     /* free our lookup array */
     pfree_if_not_null(luindex);
 }
@@ -733,6 +663,12 @@ static TupleTableSlot *exec_cypher_set(CustomScanState *node)
 
 static void end_cypher_set(CustomScanState *node)
 {
+    cypher_set_custom_scan_state *css = (cypher_set_custom_scan_state *)node;
+
+    /* close the label tables and their indices */
+    destroy_entity_rel_cache(css->label_cache);
+    css->label_cache = NULL;
+
     ExecEndNode(node->ss.ps.lefttree);
 }
 
@@ -24,6 +24,7 @@
 
 #include "postgres.h"
 
+#include "access/genam.h"
 #include "executor/executor.h"
 #include "miscadmin.h"
 #include "nodes/makefuncs.h"
@@ -37,6 +38,7 @@
 #include "commands/label_commands.h"
 #include "executor/cypher_utils.h"
 #include "utils/ag_cache.h"
+#include "utils/age_global_graph.h"
 
 /* RLS helper function declarations */
 static void get_policies_for_relation(Relation relation, CmdType cmd,
@@ -128,6 +130,138 @@ void destroy_entity_result_rel_info(ResultRelInfo *result_rel_info)
     table_close(result_rel_info->ri_RelationDesc, RowExclusiveLock);
 }
 
+/*
+ * Create the hashtable that holds the entity_rel_cache_entry of each label a
+ * clause modifies. It lives in the query's memory context.
+ */
+HTAB *create_entity_rel_cache(EState *estate)
+{
+    HASHCTL hashctl;
+
+    MemSet(&hashctl, 0, sizeof(hashctl));
+    hashctl.keysize = NAMEDATALEN;
+    hashctl.entrysize = sizeof(entity_rel_cache_entry);
+    hashctl.hcxt = estate->es_query_cxt;
+
+    return hash_create(ENTITY_REL_CACHE_NAME, ENTITY_REL_CACHE_SIZE, &hashctl,
+                       HASH_ELEM | HASH_STRINGS | HASH_CONTEXT);
+}
+
+/*
+ * Returns the state needed to modify the entities of a label, setting it up
+ * the first time the label is seen. This opens the label table and its
+ * indices, finds the index on id, and sets up the RLS policies for the
+ * command, only once per label for the whole query instead of once per
+ * modified entity.
+ */
+entity_rel_cache_entry *get_entity_rel_cache_entry(HTAB *label_cache,
+                                                   CustomScanState *node,
+                                                   char *graph_name,
+                                                   char *label_name,
+                                                   CmdType cmd)
+{
+    EState *estate = node->ss.ps.state;
+    entity_rel_cache_entry *entry;
+    ResultRelInfo *resultRelInfo;
+    MemoryContext oldctx;
+    bool found;
+
+    entry = hash_search(label_cache, label_name, HASH_ENTER, &found);
+    if (found)
+    {
+        return entry;
+    }
+
+    /* the state needs to live as long as the query */
+    oldctx = MemoryContextSwitchTo(estate->es_query_cxt);
+
+    resultRelInfo = create_entity_result_rel_info(estate, graph_name,
+                                                  label_name);
+
+    entry->resultRelInfo = resultRelInfo;
+    entry->slot = ExecInitExtraTupleSlot(
+        estate, RelationGetDescr(resultRelInfo->ri_RelationDesc),
+        &TTSOpsHeapTuple);
+    entry->id_index = get_label_column_index(resultRelInfo->ri_RelationDesc,
+                                             Anum_ag_label_vertex_table_id);
+    entry->rls_enabled = false;
+    entry->qualExprs = NIL;
+    entry->rls_slot = NULL;
+
+    /* Setup RLS policies if RLS is enabled */
+    if (check_enable_rls(RelationGetRelid(resultRelInfo->ri_RelationDesc),
+                         InvalidOid, true) == RLS_ENABLED)
+    {
+        entry->rls_enabled = true;
+
+        /* Setup WITH CHECK policies, only updates check the new tuples */
+        if (cmd == CMD_UPDATE)
+        {
+            setup_wcos(resultRelInfo, estate, node, cmd);
+        }
+
+        /* Setup security quals */
+        entry->qualExprs = setup_security_quals(resultRelInfo, estate, node,
+                                                cmd);
+        entry->rls_slot = ExecInitExtraTupleSlot(
+            estate, RelationGetDescr(resultRelInfo->ri_RelationDesc),
+            &TTSOpsHeapTuple);
+    }
+
+    MemoryContextSwitchTo(oldctx);
+
+    return entry;
+}
+
+/* close the label tables and their indices, and destroy the hashtable */
+void destroy_entity_rel_cache(HTAB *label_cache)
+{
+    HASH_SEQ_STATUS hash_seq;
+    entity_rel_cache_entry *entry;
+
+    hash_seq_init(&hash_seq, label_cache);
+    while ((entry = hash_seq_search(&hash_seq)) != NULL)
+    {
+        destroy_entity_result_rel_info(entry->resultRelInfo);
+    }
+
+    hash_destroy(label_cache);
+}
+
+/*
+ * Fetches the current version of an entity's tuple, through the label's index
+ * on id when it has one. The id is the first column of both vertex and edge
+ * label tables. The tuple returned is a copy, as updates and deletes lock it,
+ * and it is NULL if the entity no longer exists.
+ */
+HeapTuple fetch_entity_tuple(EState *estate, entity_rel_cache_entry *entry,
+                             graphid id)
+{
+    Relation rel = entry->resultRelInfo->ri_RelationDesc;
+    ScanKeyData scan_keys[1];
+    SysScanDesc scan_desc;
+    HeapTuple tuple;
+
+    /*
+     * Setup the scan key to require the id field on-disc to match the
+     * entity's graphid.
+     */
+    ScanKeyInit(&scan_keys[0], Anum_ag_label_vertex_table_id,
+                BTEqualStrategyNumber, F_GRAPHIDEQ, GRAPHID_GET_DATUM(id));
+
+    scan_desc = systable_beginscan(rel, entry->id_index,
+                                   OidIsValid(entry->id_index),
+                                   estate->es_snapshot, 1, scan_keys);
+    tuple = systable_getnext(scan_desc);
+    if (HeapTupleIsValid(tuple))
+    {
+        tuple = heap_copytuple(tuple);
+    }
+    systable_endscan(scan_desc);
+
+    return tuple;
+}
+
 TupleTableSlot *populate_vertex_tts(
     TupleTableSlot *elemTupleSlot, agtype_value *id, agtype_value *properties)
 {
@@ -198,15 +332,17 @@ TupleTableSlot *populate_edge_tts(
 
 /*
  * Find out if the entity still exists. This is for 'implicit' deletion
- * of an entity.
+ * of an entity. The label's id index is probed, when it has one, so this
+ * doesn't need to scan the whole label table.
  */
 bool entity_exists(EState *estate, Oid graph_oid, graphid id)
 {
     label_cache_data *label;
     ScanKeyData scan_keys[1];
-    TableScanDesc scan_desc;
+    SysScanDesc scan_desc;
     HeapTuple tuple;
     Relation rel;
+    Oid index_oid;
     bool result = true;
 
     /*
@@ -215,14 +351,19 @@ bool entity_exists(EState *estate, Oid graph_oid, graphid id)
      */
     label = search_label_graph_oid_cache(graph_oid, GET_LABEL_ID(id));
 
-    /* Setup the scan key to be the graphid */
-    ScanKeyInit(&scan_keys[0], 1, BTEqualStrategyNumber,
-                F_GRAPHIDEQ, GRAPHID_GET_DATUM(id));
+    /*
+     * Setup the scan key to be the graphid. The id is the first column of
+     * both vertex and edge label tables.
+     */
+    ScanKeyInit(&scan_keys[0], Anum_ag_label_vertex_table_id,
+                BTEqualStrategyNumber, F_GRAPHIDEQ, GRAPHID_GET_DATUM(id));
 
     rel = table_open(label->relation, RowExclusiveLock);
-    scan_desc = table_beginscan(rel, estate->es_snapshot, 1, scan_keys);
+    index_oid = get_label_column_index(rel, Anum_ag_label_vertex_table_id);
+    scan_desc = systable_beginscan(rel, index_oid, OidIsValid(index_oid),
+                                   estate->es_snapshot, 1, scan_keys);
 
-    tuple = heap_getnext(scan_desc, ForwardScanDirection);
+    tuple = systable_getnext(scan_desc);
 
     /*
      * If a single tuple was returned, the tuple is still valid, otherwise'
@@ -233,7 +374,7 @@ bool entity_exists(EState *estate, Oid graph_oid, graphid id)
         result = false;
     }
 
-    table_endscan(scan_desc);
+    systable_endscan(scan_desc);
     table_close(rel, RowExclusiveLock);
 
     return result;
@@ -295,9 +436,189 @@ HeapTuple insert_entity_tuple_cid(ResultRelInfo *resultRelInfo,
                               false, false, NULL, NIL, false);
     }
 
+    /* Record the insert for the global graph contexts */
+    record_graph_change(resultRelInfo->ri_RelationDesc, GRAPH_CHANGE_INSERT,
+                        tuple);
+
     return tuple;
 }
 
+/*
+ * Find the insert buffer for the result relation's label in the list of
+ * buffers, creating it when the label doesn't have one yet. Result relations
+ * of the same label share a buffer. The buffers live in the query's memory
+ * context.
+ */
+entity_insert_buffer *get_entity_insert_buffer(List **buffers,
+                                               ResultRelInfo *resultRelInfo,
+                                               EState *estate)
+{
+    entity_insert_buffer *buffer;
+    MemoryContext oldcxt;
+    ListCell *lc;
+    int i;
+
+    foreach (lc, *buffers)
+    {
+        buffer = lfirst(lc);
+
+        if (RelationGetRelid(buffer->resultRelInfo->ri_RelationDesc) ==
+            RelationGetRelid(resultRelInfo->ri_RelationDesc))
+        {
+            return buffer;
+        }
+    }
+
+    oldcxt = MemoryContextSwitchTo(estate->es_query_cxt);
+
+    buffer = palloc0(sizeof(entity_insert_buffer));
+    buffer->resultRelInfo = resultRelInfo;
+    buffer->slots = palloc(sizeof(TupleTableSlot *) *
+                           ENTITY_INSERT_BUFFER_SIZE);
+    buffer->num_tuples = 0;
+    buffer->buffered_bytes = 0;
+    buffer->cid = InvalidCommandId;
+    buffer->bistate = GetBulkInsertState();
+
+    /* the slots are released with the estate's tuple table */
+    for (i = 0; i < ENTITY_INSERT_BUFFER_SIZE; i++)
+    {
+        buffer->slots[i] = table_slot_create(resultRelInfo->ri_RelationDesc,
+                                             &estate->es_tupleTable);
+    }
+
+    *buffers = lappend(*buffers, buffer);
+
+    MemoryContextSwitchTo(oldcxt);
+
+    return buffer;
+}
+
+/*
+ * Add the edge/vertex tuple to the insert buffer. The table's constraints and
+ * RLS WITH CHECK policies are checked right away, so errors are still raised
+ * for the entity that caused them. The buffer is flushed when it is full or
+ * when the tuple needs a different command id than the buffered ones.
+ */
+void buffer_entity_tuple(entity_insert_buffer *buffer,
+                         TupleTableSlot *elemTupleSlot, EState *estate,
+                         CommandId cid)
+{
+    ResultRelInfo *resultRelInfo = buffer->resultRelInfo;
+    TupleTableSlot *slot;
+    HeapTuple tuple;
+
+    ExecStoreVirtualTuple(elemTupleSlot);
+
+    /* Check the constraints of the tuple */
+    if (resultRelInfo->ri_RelationDesc->rd_att->constr != NULL)
+    {
+        ExecConstraints(resultRelInfo, elemTupleSlot, estate);
+    }
+
+    /* Check RLS WITH CHECK policies if configured */
+    if (resultRelInfo->ri_WithCheckOptions != NIL)
+    {
+        ExecWithCheckOptions(WCO_RLS_INSERT_CHECK, resultRelInfo,
+                             elemTupleSlot, estate);
+    }
+
+    if (buffer->num_tuples > 0 && buffer->cid != cid)
+    {
+        flush_entity_insert_buffer(buffer, estate);
+    }
+
+    buffer->cid = cid;
+
+    /* copy the tuple, the element slot is reused for the next entity */
+    slot = buffer->slots[buffer->num_tuples++];
+    ExecCopySlot(slot, elemTupleSlot);
+
+    tuple = ExecFetchSlotHeapTuple(slot, false, NULL);
+    buffer->buffered_bytes += tuple->t_len;
+
+    if (buffer->num_tuples >= ENTITY_INSERT_BUFFER_SIZE ||
+        buffer->buffered_bytes >= ENTITY_INSERT_BUFFER_BYTES)
+    {
+        flush_entity_insert_buffer(buffer, estate);
+    }
+}
+
+/*
+ * Write the buffered tuples into the table and indices.
+ */
+void flush_entity_insert_buffer(entity_insert_buffer *buffer, EState *estate)
+{
+    ResultRelInfo *resultRelInfo = buffer->resultRelInfo;
+    Relation rel = resultRelInfo->ri_RelationDesc;
+    int i;
+
+    if (buffer->num_tuples == 0)
+    {
+        return;
+    }
+
+    /* Insert the tuples */
+    table_multi_insert(rel, buffer->slots, buffer->num_tuples, buffer->cid, 0,
+                       buffer->bistate);
+
+    for (i = 0; i < buffer->num_tuples; i++)
+    {
+        TupleTableSlot *slot = buffer->slots[i];
+
+        /* Insert index entries for the tuple */
+        if (resultRelInfo->ri_NumIndices > 0)
+        {
+            ExecInsertIndexTuples(resultRelInfo, slot, estate, false, false,
+                                  NULL, NIL, false);
+        }
+
+        /* Record the insert for the global graph contexts */
+        record_graph_change(rel, GRAPH_CHANGE_INSERT,
+                            ExecFetchSlotHeapTuple(slot, false, NULL));
+
+        ExecClearTuple(slot);
+    }
+
+    buffer->num_tuples = 0;
+    buffer->buffered_bytes = 0;
+}
+
+/*
+ * Flush every buffer in the list.
+ */
+void flush_entity_insert_buffers(List *buffers, EState *estate)
+{
+    ListCell *lc;
+
+    foreach (lc, buffers)
+    {
+        flush_entity_insert_buffer(lfirst(lc), estate);
+    }
+}
+
+/*
+ * Release the buffers in the list. They must have been flushed already.
+ */
+void free_entity_insert_buffers(List *buffers)
+{
+    ListCell *lc;
+
+    foreach (lc, buffers)
+    {
+        entity_insert_buffer *buffer = lfirst(lc);
+
+        Assert(buffer->num_tuples == 0);
+
+        table_finish_bulk_insert(buffer->resultRelInfo->ri_RelationDesc, 0);
+        FreeBulkInsertState(buffer->bistate);
+        pfree(buffer->slots);
+        pfree(buffer);
+    }
+
+    list_free(buffers);
+}
+
 /*
  * setup_wcos
  *
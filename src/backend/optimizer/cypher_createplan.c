@@ -19,6 +19,10 @@
 
 #include "postgres.h"
 
+#include "nodes/makefuncs.h"
+#include "optimizer/plancat.h"
+#include "optimizer/restrictinfo.h"
+
 #include "executor/cypher_executor.h"
 #include "optimizer/cypher_createplan.h"
 
@@ -30,6 +34,8 @@ const CustomScanMethods cypher_delete_plan_methods = {
     "Cypher Delete", create_cypher_delete_plan_state};
 const CustomScanMethods cypher_merge_plan_methods = {
     "Cypher Merge", create_cypher_merge_plan_state};
+const CustomScanMethods cypher_expand_plan_methods = {
+    "Cypher Expand", create_cypher_expand_plan_state};
 
 Plan *plan_cypher_create_path(PlannerInfo *root, RelOptInfo *rel,
                               CustomPath *best_path, List *tlist,
@@ -238,3 +244,84 @@ Plan *plan_cypher_merge_path(PlannerInfo *root, RelOptInfo *rel,
 
     return (Plan *)cs;
 }
+
+/*
+ * Coverts the Expand path to the expand Plan node. Its scan tuple is the
+ * outer row followed by all columns of the edge, in which the key expression,
+ * the quals, and the targetlist are evaluated.
+ */
+Plan *plan_cypher_expand_path(PlannerInfo *root, RelOptInfo *rel,
+                              CustomPath *best_path, List *tlist,
+                              List *clauses, List *custom_plans)
+{
+    CustomScan *cs;
+    Plan *subplan = linitial(custom_plans);
+    RelOptInfo *innerrel = linitial(best_path->custom_private);
+    IndexOptInfo *index = lsecond(best_path->custom_private);
+    Expr *outer_key = lthird(best_path->custom_private);
+    List *quals = lfourth(best_path->custom_private);
+    List *scan_tlist = NIL;
+    ListCell *lc;
+
+    /* the outer row, in the order of the child plan's targetlist */
+    foreach (lc, subplan->targetlist)
+    {
+        TargetEntry *te = lfirst(lc);
+
+        scan_tlist = lappend(scan_tlist,
+                             makeTargetEntry(copyObject(te->expr),
+                                             list_length(scan_tlist) + 1,
+                                             NULL, false));
+    }
+
+    /* followed by the edge, as stored in its label table */
+    foreach (lc, build_physical_tlist(root, innerrel))
+    {
+        TargetEntry *te = lfirst(lc);
+
+        te->resno = list_length(scan_tlist) + 1;
+        scan_tlist = lappend(scan_tlist, te);
+    }
+
+    cs = makeNode(CustomScan);
+
+    cs->scan.plan.startup_cost = best_path->path.startup_cost;
+    cs->scan.plan.total_cost = best_path->path.total_cost;
+
+    cs->scan.plan.plan_rows = best_path->path.rows;
+    cs->scan.plan.plan_width = 0;
+
+    cs->scan.plan.parallel_aware = best_path->path.parallel_aware;
+    cs->scan.plan.parallel_safe = best_path->path.parallel_safe;
+
+    cs->scan.plan.plan_node_id = 0; /* Set later in set_plan_refs */
+    cs->scan.plan.targetlist = tlist;
+    cs->scan.plan.qual = extract_actual_clauses(quals, false);
+    cs->scan.plan.lefttree = NULL;
+    cs->scan.plan.righttree = NULL;
+    cs->scan.plan.initPlan = NIL;
+
+    cs->scan.plan.extParam = NULL;
+    cs->scan.plan.allParam = NULL;
+
+    /* the edges are read by the node itself, not by a scan of Postgres */
+    cs->scan.scanrelid = 0;
+
+    cs->flags = best_path->flags;
+
+    /* the plan of the outer rows */
+    cs->custom_plans = custom_plans;
+    /* the key, set_plan_refs makes it reference the scan tuple */
+    cs->custom_exprs = list_make1(outer_key);
+    /* the label table and its index, and the width of the outer row */
+    cs->custom_private = list_make2(
+        list_make2_oid(planner_rt_fetch(innerrel->relid, root)->relid,
+                       index->indexoid),
+        list_make1_int(list_length(subplan->targetlist)));
+    cs->custom_scan_tlist = scan_tlist;
+
+    cs->custom_relids = NULL;
+    cs->methods = &cypher_expand_plan_methods;
+
+    return (Plan *)cs;
+}
@@ -19,7 +19,10 @@
 
 #include "postgres.h"
 
+#include <math.h>
+
 #include "nodes/extensible.h"
+#include "optimizer/cost.h"
 
 #include "optimizer/cypher_createplan.h"
 #include "optimizer/cypher_pathnode.h"
@@ -40,6 +43,8 @@ const CustomPathMethods cypher_delete_path_methods = {
     DELETE_PATH_NAME, plan_cypher_delete_path, NULL};
 const CustomPathMethods cypher_merge_path_methods = {
     MERGE_PATH_NAME, plan_cypher_merge_path, NULL};
+const CustomPathMethods cypher_expand_path_methods = {
+    EXPAND_PATH_NAME, plan_cypher_expand_path, NULL};
 
 CustomPath *create_cypher_create_path(PlannerInfo *root, RelOptInfo *rel,
                                       List *custom_private)
@@ -212,6 +217,75 @@ CustomPath *create_cypher_merge_path(PlannerInfo *root, RelOptInfo *rel,
     return cp;
 }
 
+/*
+ * Creates an Expand path, which joins the rows of outer_path with the edges of
+ * innerrel through index, where the key column of the edges equals outer_key.
+ * The quals are the remaining join clauses and the filters of the edges.
+ */
+CustomPath *create_cypher_expand_path(PlannerInfo *root, RelOptInfo *joinrel,
+                                      Path *outer_path, RelOptInfo *innerrel,
+                                      IndexOptInfo *index, Expr *outer_key,
+                                      List *quals)
+{
+    CustomPath *cp;
+    QualCost qual_cost;
+    double edges_fetched;
+    double pages_fetched;
+    Cost probe_cost;
+
+    cp = makeNode(CustomPath);
+
+    cp->path.pathtype = T_CustomScan;
+
+    cp->path.parent = joinrel;
+    cp->path.pathtarget = joinrel->reltarget;
+
+    cp->path.param_info = NULL;
+
+    /* Do not allow parallel methods */
+    cp->path.parallel_aware = false;
+    cp->path.parallel_safe = false;
+    cp->path.parallel_workers = 0;
+
+    cp->path.rows = joinrel->rows;
+
+    /*
+     * Each outer row costs one descent of the index, as in btcostestimate,
+     * and each edge found costs its index entry and its heap tuple. The heap
+     * pages are fetched in physical order for each outer row.
+     */
+    edges_fetched = clamp_row_est(joinrel->rows * innerrel->tuples /
+                                  Max(innerrel->rows, 1.0));
+    pages_fetched = index_pages_fetched(edges_fetched, innerrel->pages,
+                                        (double)index->pages, root);
+    probe_cost = (ceil(log2(Max(index->tuples, 2.0))) + 50.0) *
+                 cpu_operator_cost;
+    cost_qual_eval(&qual_cost, quals, root);
+
+    cp->path.startup_cost = outer_path->startup_cost + qual_cost.startup;
+    cp->path.total_cost = outer_path->total_cost + qual_cost.startup +
+                          outer_path->rows * probe_cost +
+                          pages_fetched * random_page_cost +
+                          edges_fetched * (cpu_index_tuple_cost +
+                                           cpu_tuple_cost +
+                                           qual_cost.per_tuple);
+
+    /* No output ordering, the edges of a vertex come in physical order */
+    cp->path.pathkeys = NULL;
+
+    /* Disable all custom flags for now */
+    cp->flags = 0;
+
+    /* The outer rows are the only child, the edges are read directly */
+    cp->custom_paths = list_make1(outer_path);
+    /* Store what the plan needs, it is only read by plan_cypher_expand_path */
+    cp->custom_private = list_make4(innerrel, index, outer_key, quals);
+    /* Tells Postgres how to turn this path to the correct CustomScan */
+    cp->methods = &cypher_expand_path_methods;
+
+    return cp;
+}
+
 /*
  * Deserializes the merge information and checks if any property
  * expression (prop_expr) contains a SubLink.
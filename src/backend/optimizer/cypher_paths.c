@@ -19,12 +19,22 @@
 
 #include "postgres.h"
 
+#include "access/stratnum.h"
+#include "access/sysattr.h"
+#include "catalog/pg_am_d.h"
+#include "optimizer/geqo.h"
+#include "optimizer/joininfo.h"
+#include "optimizer/optimizer.h"
 #include "optimizer/pathnode.h"
 #include "optimizer/paths.h"
+#include "utils/lsyscache.h"
 
+#include "catalog/ag_label.h"
 #include "optimizer/cypher_pathnode.h"
 #include "optimizer/cypher_paths.h"
+#include "utils/ag_cache.h"
 #include "utils/ag_func.h"
+#include "utils/ag_guc.h"
 
 typedef enum cypher_clause_kind
 {
@@ -36,6 +46,8 @@ typedef enum cypher_clause_kind
 } cypher_clause_kind;
 
 static set_rel_pathlist_hook_type prev_set_rel_pathlist_hook;
+static join_search_hook_type prev_join_search_hook;
+static set_join_pathlist_hook_type prev_set_join_pathlist_hook;
 
 static void set_rel_pathlist(PlannerInfo *root, RelOptInfo *rel, Index rti,
                              RangeTblEntry *rte);
@@ -48,6 +60,23 @@ static void handle_cypher_delete_clause(PlannerInfo *root, RelOptInfo *rel,
                                         Index rti, RangeTblEntry *rte);
 static void handle_cypher_merge_clause(PlannerInfo *root, RelOptInfo *rel,
                                         Index rti, RangeTblEntry *rte);
+static RelOptInfo *join_search(PlannerInfo *root, int levels_needed,
+                               List *initial_rels);
+static bool is_graph_join_problem(PlannerInfo *root, List *initial_rels);
+static RelOptInfo *graph_join_search(PlannerInfo *root, List *initial_rels);
+static RelOptInfo *expand_anchor(PlannerInfo *root, RelOptInfo *anchor,
+                                 List *rels, bool need_joinclause,
+                                 int *expanded);
+static void set_join_pathlist(PlannerInfo *root, RelOptInfo *joinrel,
+                              RelOptInfo *outerrel, RelOptInfo *innerrel,
+                              JoinType jointype, JoinPathExtraData *extra);
+static void add_cypher_expand_path(PlannerInfo *root, RelOptInfo *joinrel,
+                                   RelOptInfo *outerrel, RelOptInfo *innerrel,
+                                   JoinPathExtraData *extra);
+static IndexOptInfo *get_expand_key(RestrictInfo *rinfo,
+                                    RelOptInfo *outerrel,
+                                    RelOptInfo *innerrel, Expr **outer_key);
+static bool references_system_columns(Node *node, Index relid);
 
 void set_rel_pathlist_init(void)
 {
@@ -60,6 +89,28 @@ void set_rel_pathlist_fini(void)
     set_rel_pathlist_hook = prev_set_rel_pathlist_hook;
 }
 
+void join_search_init(void)
+{
+    prev_join_search_hook = join_search_hook;
+    join_search_hook = join_search;
+}
+
+void join_search_fini(void)
+{
+    join_search_hook = prev_join_search_hook;
+}
+
+void set_join_pathlist_init(void)
+{
+    prev_set_join_pathlist_hook = set_join_pathlist_hook;
+    set_join_pathlist_hook = set_join_pathlist;
+}
+
+void set_join_pathlist_fini(void)
+{
+    set_join_pathlist_hook = prev_set_join_pathlist_hook;
+}
+
 static void set_rel_pathlist(PlannerInfo *root, RelOptInfo *rel, Index rti,
                              RangeTblEntry *rte)
 {
@@ -226,3 +277,346 @@ static void handle_cypher_merge_clause(PlannerInfo *root, RelOptInfo *rel,
 
     add_path(rel, (Path *)cp);
 }
+
+/*
+ * Join search for the FROM lists built by MATCH.
+ *
+ * Each hop of a pattern adds an edge and a vertex label table to the FROM
+ * list, so a pattern of six hops already has more relations than
+ * geqo_threshold and PostgreSQL hands it to the genetic optimizer, which
+ * picks a join order more or less at random. For those, the join order is
+ * instead built from the most selective relation, the anchor, expanding it
+ * one relation at a time with the neighbour that keeps the intermediate
+ * result smallest. The size of each expansion is the planner's own join
+ * estimate, which for an edge is its label's average degree, as derived from
+ * the statistics on start_id and end_id.
+ *
+ * Smaller join problems are left to the exhaustive search.
+ */
+static RelOptInfo *join_search(PlannerInfo *root, int levels_needed,
+                               List *initial_rels)
+{
+    if (age_enable_graph_join_search && enable_geqo &&
+        levels_needed >= geqo_threshold &&
+        is_graph_join_problem(root, initial_rels))
+    {
+        int savelength = list_length(root->join_rel_list);
+        struct HTAB *savehash = root->join_rel_hash;
+        RelOptInfo *rel;
+
+        root->join_rel_hash = NULL;
+
+        rel = graph_join_search(root, initial_rels);
+        if (rel != NULL)
+            return rel;
+
+        /*
+         * No valid order was found. Forget the join relations that were built
+         * on the way, so that they are not mistaken for those of the search
+         * below.
+         */
+        root->join_rel_list = list_truncate(root->join_rel_list, savelength);
+        root->join_rel_hash = savehash;
+    }
+
+    if (prev_join_search_hook)
+        return prev_join_search_hook(root, levels_needed, initial_rels);
+    else if (enable_geqo && levels_needed >= geqo_threshold)
+        return geqo(root, levels_needed, initial_rels);
+    else
+        return standard_join_search(root, levels_needed, initial_rels);
+}
+
+/*
+ * Helper function to check if a join problem comes from a graph pattern. It
+ * does if all of its relations are base relations and at least one of them is
+ * a label table.
+ */
+static bool is_graph_join_problem(PlannerInfo *root, List *initial_rels)
+{
+    bool has_label = false;
+    ListCell *lc;
+
+    foreach (lc, initial_rels)
+    {
+        RelOptInfo *rel = lfirst(lc);
+        RangeTblEntry *rte;
+
+        if (rel->reloptkind != RELOPT_BASEREL)
+            return false;
+
+        rte = planner_rt_fetch(rel->relid, root);
+        if (rte->rtekind == RTE_RELATION &&
+            search_label_relation_cache(rte->relid) != NULL)
+            has_label = true;
+    }
+
+    return has_label;
+}
+
+/*
+ * Builds a left-deep join tree from the relation with the fewest rows,
+ * adding the remaining relations one at a time. Returns NULL if the relations
+ * cannot be joined in such an order, which can happen with outer joins.
+ */
+static RelOptInfo *graph_join_search(PlannerInfo *root, List *initial_rels)
+{
+    RelOptInfo *joinrel = NULL;
+    List *rels = list_copy(initial_rels);
+    ListCell *lc;
+
+    /* the anchor is the relation with the fewest rows after its filters */
+    foreach (lc, rels)
+    {
+        RelOptInfo *rel = lfirst(lc);
+
+        if (joinrel == NULL || rel->rows < joinrel->rows)
+            joinrel = rel;
+    }
+    rels = list_delete_ptr(rels, joinrel);
+
+    while (rels != NIL)
+    {
+        RelOptInfo *next;
+        int expanded = -1;
+
+        /* prefer a neighbour, fall back to a cross join if there is none */
+        next = expand_anchor(root, joinrel, rels, true, &expanded);
+        if (next == NULL)
+            next = expand_anchor(root, joinrel, rels, false, &expanded);
+        if (next == NULL)
+        {
+            list_free(rels);
+            return NULL;
+        }
+
+        generate_partitionwise_join_paths(root, next);
+        if (!bms_equal(next->relids, root->all_query_rels))
+            generate_useful_gather_paths(root, next, false);
+        set_cheapest(next);
+
+        joinrel = next;
+        rels = list_delete_nth_cell(rels, expanded);
+    }
+
+    return joinrel;
+}
+
+/*
+ * Helper function to join the anchor with each of the given relations and
+ * return the smallest of the join relations. The position of the relation it
+ * was joined with is returned in expanded. If need_joinclause is set, only
+ * the relations that are connected to the anchor are considered.
+ */
+static RelOptInfo *expand_anchor(PlannerInfo *root, RelOptInfo *anchor,
+                                 List *rels, bool need_joinclause,
+                                 int *expanded)
+{
+    RelOptInfo *best = NULL;
+    ListCell *lc;
+
+    foreach (lc, rels)
+    {
+        RelOptInfo *rel = lfirst(lc);
+        RelOptInfo *joinrel;
+
+        if (need_joinclause &&
+            !have_relevant_joinclause(root, anchor, rel) &&
+            !have_join_order_restriction(root, anchor, rel))
+            continue;
+
+        joinrel = make_join_rel(root, anchor, rel);
+        if (joinrel == NULL || joinrel->pathlist == NIL)
+            continue;
+
+        if (best == NULL || joinrel->rows < best->rows)
+        {
+            best = joinrel;
+            *expanded = foreach_current_index(lc);
+        }
+    }
+
+    return best;
+}
+
+static void set_join_pathlist(PlannerInfo *root, RelOptInfo *joinrel,
+                              RelOptInfo *outerrel, RelOptInfo *innerrel,
+                              JoinType jointype, JoinPathExtraData *extra)
+{
+    if (prev_set_join_pathlist_hook)
+        prev_set_join_pathlist_hook(root, joinrel, outerrel, innerrel,
+                                    jointype, extra);
+
+    if (age_enable_expand && jointype == JOIN_INNER)
+        add_cypher_expand_path(root, joinrel, outerrel, innerrel, extra);
+}
+
+/*
+ * Offers a Cypher Expand path for the join of a stream of vertices, the outer
+ * relation, with the edge label table that is the inner relation, on the
+ * start_id or end_id of the edges. Instead of a generic join, the Expand node
+ * probes the label's index on that column for each outer row.
+ */
+static void add_cypher_expand_path(PlannerInfo *root, RelOptInfo *joinrel,
+                                   RelOptInfo *outerrel, RelOptInfo *innerrel,
+                                   JoinPathExtraData *extra)
+{
+    Path *outer_path = outerrel->cheapest_total_path;
+    RangeTblEntry *rte;
+    label_cache_data *label;
+    RestrictInfo *key_clause = NULL;
+    Expr *outer_key = NULL;
+    IndexOptInfo *index = NULL;
+    List *quals = NIL;
+    ListCell *lc;
+
+    if (innerrel->reloptkind != RELOPT_BASEREL || outer_path == NULL ||
+        !bms_is_empty(PATH_REQ_OUTER(outer_path)) ||
+        !bms_is_empty(innerrel->lateral_relids) ||
+        root->placeholder_list != NIL)
+        return;
+
+    /* the inner relation must be an edge label without sub-labels */
+    rte = planner_rt_fetch(innerrel->relid, root);
+    if (rte->rtekind != RTE_RELATION || rte->inh)
+        return;
+
+    label = search_label_relation_cache(rte->relid);
+    if (label == NULL || label->kind != LABEL_KIND_EDGE)
+        return;
+
+    foreach (lc, extra->restrictlist)
+    {
+        RestrictInfo *rinfo = lfirst(lc);
+
+        if (rinfo->pseudoconstant)
+            return;
+
+        /* the first inner_id = outer_expr clause with an index is the key */
+        if (key_clause == NULL)
+        {
+            index = get_expand_key(rinfo, outerrel, innerrel, &outer_key);
+            if (index != NULL)
+            {
+                key_clause = rinfo;
+                continue;
+            }
+        }
+
+        quals = lappend(quals, rinfo);
+    }
+
+    if (key_clause == NULL)
+        return;
+
+    /* the filters of the edges are evaluated by the Expand node too */
+    foreach (lc, innerrel->baserestrictinfo)
+    {
+        RestrictInfo *rinfo = lfirst(lc);
+
+        /* leave row level security to the regular scans */
+        if (rinfo->security_level > 0 || rinfo->pseudoconstant)
+            return;
+
+        quals = lappend(quals, rinfo);
+    }
+
+    /* the Expand node only returns the user columns of the edges */
+    if (references_system_columns((Node *)joinrel->reltarget->exprs,
+                                  innerrel->relid))
+        return;
+
+    foreach (lc, quals)
+    {
+        RestrictInfo *rinfo = lfirst(lc);
+
+        if (references_system_columns((Node *)rinfo->clause,
+                                      innerrel->relid))
+            return;
+    }
+
+    add_path(joinrel, (Path *)create_cypher_expand_path(root, joinrel,
+                                                        outer_path, innerrel,
+                                                        index, outer_key,
+                                                        quals));
+}
+
+/*
+ * Helper function to check if a join clause can drive an Expand node. It can
+ * if it compares the start_id or end_id of the edges with an expression of the
+ * outer relation, using a btree index on that column. Returns the index, and
+ * the outer expression in outer_key, or NULL if it can't.
+ */
+static IndexOptInfo *get_expand_key(RestrictInfo *rinfo,
+                                    RelOptInfo *outerrel,
+                                    RelOptInfo *innerrel, Expr **outer_key)
+{
+    OpExpr *clause = (OpExpr *)rinfo->clause;
+    Expr *outer_arg;
+    Var *var;
+    ListCell *lc;
+
+    if (!IsA(clause, OpExpr) || list_length(clause->args) != 2)
+        return NULL;
+
+    if (bms_equal(rinfo->right_relids, innerrel->relids) &&
+        bms_is_subset(rinfo->left_relids, outerrel->relids))
+    {
+        outer_arg = linitial(clause->args);
+        var = lsecond(clause->args);
+    }
+    else if (bms_equal(rinfo->left_relids, innerrel->relids) &&
+             bms_is_subset(rinfo->right_relids, outerrel->relids))
+    {
+        var = linitial(clause->args);
+        outer_arg = lsecond(clause->args);
+    }
+    else
+    {
+        return NULL;
+    }
+
+    if (!IsA(var, Var) ||
+        (var->varattno != Anum_ag_label_edge_table_start_id &&
+         var->varattno != Anum_ag_label_edge_table_end_id) ||
+        contain_volatile_functions((Node *)outer_arg))
+        return NULL;
+
+    foreach (lc, innerrel->indexlist)
+    {
+        IndexOptInfo *index = lfirst(lc);
+
+        if (index->relam != BTREE_AM_OID || index->indpred != NIL ||
+            index->indexkeys[0] != var->varattno)
+            continue;
+
+        if (get_op_opfamily_strategy(clause->opno, index->opfamily[0]) ==
+            BTEqualStrategyNumber)
+        {
+            *outer_key = outer_arg;
+            return index;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Helper function to check if an expression uses a system column, or the
+ * whole row, of the given relation.
+ */
+static bool references_system_columns(Node *node, Index relid)
+{
+    Bitmapset *attnos = NULL;
+    int attno = -1;
+
+    pull_varattnos(node, relid, &attnos);
+
+    while ((attno = bms_next_member(attnos, attno)) >= 0)
+    {
+        if (attno + FirstLowInvalidHeapAttributeNumber <= 0)
+            return true;
+    }
+
+    return false;
+}
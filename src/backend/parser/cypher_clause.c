@@ -342,6 +342,10 @@ static ParseNamespaceItem *append_VLE_Func_to_FromClause(cypher_parsestate *cpst
 static void setNamespaceLateralState(List *namespace, bool lateral_only,
                                      bool lateral_ok);
 static bool isa_special_VLE_case(cypher_path *path);
+static bool is_shortest_path_function(cypher_relationship *rel);
+static bool is_reachability_safe_expr(Node *expr, bool *has_distinct_agg);
+static FuncCall *get_reachability_vle(cypher_return *self,
+                                      cypher_clause *prev);
 
 static ParseNamespaceItem *find_pnsi(cypher_parsestate *cpstate, char *varname);
 static bool has_list_comp_or_subquery(Node *expr, void *context);
@@ -2317,10 +2321,21 @@ static Query *transform_cypher_return(cypher_parsestate *cpstate,
     cypher_return *self = (cypher_return *)clause->self;
     Query *query;
     List *groupClause = NIL;
+    FuncCall *vle_func = NULL;
 
     query = makeNode(Query);
     query->commandType = CMD_SELECT;
 
+    /*
+     * If only the vertices reachable by the VLE of the previous MATCH are
+     * used, not the paths to them, switch it to its reachability mode.
+     */
+    vle_func = get_reachability_vle(self, clause->prev);
+    if (vle_func != NULL)
+    {
+        vle_func->funcname = list_make1(makeString("vle_reachable"));
+    }
+
     if (clause->prev)
     {
         transform_prev_cypher_clause(cpstate, clause->prev, true);
@@ -4462,6 +4477,191 @@ static bool isa_special_VLE_case(cypher_path *path)
     return false;
 }
 
+/*
+ * Helper function to check if a VLE relationship was rewritten by the grammar
+ * for shortestPath or allShortestPaths.
+ */
+static bool is_shortest_path_function(cypher_relationship *rel)
+{
+    FuncCall *func = NULL;
+
+    if (rel->varlen == NULL || !IsA(rel->varlen, FuncCall))
+    {
+        return false;
+    }
+
+    func = (FuncCall*)rel->varlen;
+
+    return (list_length(func->funcname) == 1 &&
+            strcmp(strVal(linitial(func->funcname)), "vle_shortest_path") == 0);
+}
+
+/*
+ * Helper function to check if a RETURN expression only uses the values of
+ * variables or their properties. Aggregates of them are allowed if they
+ * discard duplicates, and are flagged in has_distinct_agg.
+ */
+static bool is_reachability_safe_expr(Node *expr, bool *has_distinct_agg)
+{
+    ListCell *lc;
+
+    if (IsA(expr, ColumnRef))
+    {
+        return true;
+    }
+
+    if (IsA(expr, A_Indirection))
+    {
+        A_Indirection *ind = (A_Indirection *)expr;
+
+        if (!IsA(ind->arg, ColumnRef))
+        {
+            return false;
+        }
+
+        foreach (lc, ind->indirection)
+        {
+            if (!IsA(lfirst(lc), String))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    if (IsA(expr, FuncCall))
+    {
+        FuncCall *func = (FuncCall *)expr;
+
+        if (!func->agg_distinct || func->agg_star || func->agg_order != NIL ||
+            func->agg_filter != NULL || func->over != NULL)
+        {
+            return false;
+        }
+
+        foreach (lc, func->args)
+        {
+            Node *arg = lfirst(lc);
+
+            if (IsA(arg, FuncCall) ||
+                !is_reachability_safe_expr(arg, has_distinct_agg))
+            {
+                return false;
+            }
+        }
+
+        *has_distinct_agg = true;
+
+        return true;
+    }
+
+    return false;
+}
+
+/*
+ * Helper function to find the VLE of the MATCH before a RETURN, if the RETURN
+ * only needs the vertices it reaches and not the paths to them. That is when
+ * the MATCH is a single path of one anonymous VLE relationship, without a path
+ * variable, and the RETURN discards duplicates, with DISTINCT or DISTINCT
+ * aggregates, of only variables and their properties. The VLE's lower bound
+ * must be 0 or 1, and 1 only if it is directed. Returns NULL otherwise.
+ */
+static FuncCall *get_reachability_vle(cypher_return *self, cypher_clause *prev)
+{
+    cypher_match *match = NULL;
+    cypher_path *path = NULL;
+    cypher_relationship *rel = NULL;
+    FuncCall *func = NULL;
+    A_Const *lidx = NULL;
+    bool has_distinct_agg = false;
+    ListCell *lc;
+
+    if (prev == NULL || !is_ag_node(prev->self, cypher_match))
+    {
+        return NULL;
+    }
+
+    match = (cypher_match *)prev->self;
+
+    if (match->optional || list_length(match->pattern) != 1 ||
+        !is_ag_node(linitial(match->pattern), cypher_path))
+    {
+        return NULL;
+    }
+
+    path = (cypher_path *)linitial(match->pattern);
+
+    if (path->var_name != NULL || list_length(path->path) != 3)
+    {
+        return NULL;
+    }
+
+    rel = (cypher_relationship *)lsecond(path->path);
+
+    if (rel->name != NULL || rel->varlen == NULL ||
+        !IsA(rel->varlen, FuncCall))
+    {
+        return NULL;
+    }
+
+    func = (FuncCall *)rel->varlen;
+
+    if (list_length(func->funcname) != 1 ||
+        strcmp(strVal(linitial(func->funcname)), "vle") != 0)
+    {
+        return NULL;
+    }
+
+    /* the lower bound is the 4th argument, NULL means 1 */
+    if (!IsA(list_nth(func->args, 3), A_Const))
+    {
+        return NULL;
+    }
+
+    lidx = (A_Const *)list_nth(func->args, 3);
+
+    if (!lidx->isnull &&
+        (nodeTag(&lidx->val) != T_Integer ||
+         (intVal(&lidx->val) != 0 && intVal(&lidx->val) != 1)))
+    {
+        return NULL;
+    }
+
+    if ((lidx->isnull || intVal(&lidx->val) == 1) &&
+        rel->dir == CYPHER_REL_DIR_NONE)
+    {
+        return NULL;
+    }
+
+    foreach (lc, self->items)
+    {
+        ResTarget *item = lfirst(lc);
+
+        if (!is_reachability_safe_expr(item->val, &has_distinct_agg))
+        {
+            return NULL;
+        }
+    }
+
+    foreach (lc, self->order_by)
+    {
+        SortBy *sort_by = lfirst(lc);
+
+        if (!is_reachability_safe_expr(sort_by->node, &has_distinct_agg))
+        {
+            return NULL;
+        }
+    }
+
+    if (!self->distinct && !has_distinct_agg)
+    {
+        return NULL;
+    }
+
+    return func;
+}
+
 static bool path_check_valid_label(cypher_path *path,
                                    cypher_parsestate *cpstate)
 {
@@ -4837,6 +5037,28 @@ static List *transform_match_entities(cypher_parsestate *cpstate, Query *query,
                     cr->fields = list_make1(linitial(cr->fields));
                 }
 
+                /*
+                 * The shortest path function can search from both ends if the
+                 * end vertex was created in a preceding clause. Otherwise, it
+                 * is left as NULL and the end vertex is matched by the join.
+                 */
+                if (is_shortest_path_function(rel))
+                {
+                    FuncCall *func = (FuncCall*)rel->varlen;
+                    cypher_node *next_node = lfirst(lnext(path->path, lc));
+
+                    if (next_node->name != NULL &&
+                        colNameToVar(pstate, next_node->name, false,
+                                     next_node->location) != NULL)
+                    {
+                        ColumnRef *cr = makeNode(ColumnRef);
+
+                        cr->fields = list_make1(makeString(next_node->name));
+                        cr->location = next_node->location;
+                        lsecond(func->args) = cr;
+                    }
+                }
+
                 /* make a transform entity for the vle */
                 vle_entity = transform_VLE_edge_entity(cpstate, rel, query);
 
@@ -2054,6 +2054,8 @@ static Node *transform_FuncCall(cypher_parsestate *cpstate, FuncCall *fn)
                 (strcmp("startNode", name) == 0 ||
                 strcmp("endNode", name) == 0 ||
                 strcmp("vle", name) == 0 ||
+                strcmp("vle_shortest_path", name) == 0 ||
+                strcmp("vle_reachable", name) == 0 ||
                 strcmp("vertex_stats", name) == 0))
             {
                 char *graph_name = cpstate->graph_name;
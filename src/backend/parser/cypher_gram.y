@@ -149,7 +149,7 @@
 
 /* pattern */
 %type <list> pattern simple_path_opt_parens simple_path
-%type <node> path anonymous_path
+%type <node> path anonymous_path shortest_path
              path_node path_relationship path_relationship_body
              properties_opt
 %type <string> label_opt
@@ -268,6 +268,8 @@ static cypher_relationship *build_VLE_relation(List *left_arg,
                                                Node *right_arg,
                                                int left_arg_location,
                                                int cr_location);
+static List *build_shortest_path(char *function_name, List *path,
+                                 int location, ag_scanner_t scanner);
 /* comparison */
 static bool is_A_Expr_a_comparison_operation(cypher_comparison_aexpr *a);
 static Node *build_comparison_expression(Node *left_grammar_node,
@@ -1247,7 +1249,38 @@ path:
 
             $$ = (Node *)p;
         }
+    | shortest_path
+    | var_name '=' shortest_path /* named shortest path */
+        {
+            cypher_path *p;
+
+            p = (cypher_path *)$3;
+            p->var_name = $1;
+            p->parsed_var_name = $1;
+            p->location = @1;
 
+            $$ = (Node *)p;
+        }
+    ;
+
+/*
+ * shortestPath((u)-[*]-(v)) and allShortestPaths((u)-[*]-(v)). The path must
+ * be a single VLE relationship, which is rewritten to use the shortest path
+ * function instead of the exhaustive vle function.
+ */
+shortest_path:
+    symbolic_name '(' simple_path ')'
+        {
+            cypher_path *n;
+
+            n = make_ag_node(cypher_path);
+            n->path = build_shortest_path($1, $3, @1, scanner);
+            n->var_name = NULL;
+            n->parsed_var_name = NULL;
+            n->location = @1;
+
+            $$ = (Node *)n;
+        }
     ;
 
 anonymous_path:
@@ -3268,6 +3301,79 @@ static cypher_relationship *build_VLE_relation(List *left_arg,
     return cr;
 }
 
+/*
+ * Helper function to rewrite the VLE relation of a shortestPath or
+ * allShortestPaths path to use the shortest path function. The VLE function's
+ * unique number argument is replaced with the mode, 0 for one shortest path and
+ * 1 for all shortest paths. The start vertex always needs a variable, so that
+ * the search has a source. The end vertex is passed as NULL and is filled in
+ * during the transform phase, if it is available.
+ */
+static List *build_shortest_path(char *function_name, List *path,
+                                 int location, ag_scanner_t scanner)
+{
+    cypher_relationship *cr = NULL;
+    cypher_node *cnl = NULL;
+    FuncCall *func = NULL;
+    int mode = 0;
+
+    if (pg_strcasecmp(function_name, "shortestpath") == 0)
+    {
+        mode = 0;
+    }
+    else if (pg_strcasecmp(function_name, "allshortestpaths") == 0)
+    {
+        mode = 1;
+    }
+    else
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_SYNTAX_ERROR),
+                 errmsg("function %s is not a path function", function_name),
+                 errhint("Only shortestPath and allShortestPaths are supported."),
+                 ag_scanner_errposition(location, scanner)));
+    }
+
+    /* the path must be (u)-[*]-(v) */
+    if (list_length(path) == 3)
+    {
+        cr = (cypher_relationship *)lsecond(path);
+    }
+
+    if (cr == NULL || cr->varlen == NULL)
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_SYNTAX_ERROR),
+                 errmsg("%s requires a pattern containing a single variable length relationship",
+                        function_name),
+                 ag_scanner_errposition(location, scanner)));
+    }
+
+    func = (FuncCall *)cr->varlen;
+    cnl = (cypher_node *)linitial(path);
+
+    /* the search needs a start vertex */
+    if (cnl->name == NULL)
+    {
+        ColumnRef *cref = makeNode(ColumnRef);
+
+        cnl->name = create_unique_name(AGE_DEFAULT_PREFIX"vle_function_start_var");
+        cref->fields = list_make2(makeString(cnl->name), makeString("id"));
+        cref->location = location;
+        linitial(func->args) = cref;
+    }
+
+    /* the end vertex is resolved in the transform phase */
+    lsecond(func->args) = make_null_const(-1);
+
+    /* replace the unique number with the mode */
+    llast(func->args) = make_int_const(mode, -1);
+
+    func->funcname = list_make1(makeString("vle_shortest_path"));
+
+    return path;
+}
+
 /* helper function to build a list_comprehension grammar node */
 static Node *build_list_comprehension_node(Node *var, Node *expr,
                                            Node *where, Node *mapping_expr,
@@ -19,15 +19,38 @@
 
 #include "postgres.h"
 
+#include "access/genam.h"
 #include "access/heapam.h"
+#include "access/parallel.h"
+#include "access/transam.h"
+#include "access/xact.h"
 #include "catalog/namespace.h"
 #include "common/hashfn.h"
 #include "commands/label_commands.h"
+#include "commands/trigger.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "port/atomics.h"
+#include "storage/bufmgr.h"
+#include "storage/dsm_registry.h"
+#include "storage/latch.h"
+#include "storage/lwlock.h"
+#include "storage/proc.h"
+#include "storage/procarray.h"
+#include "storage/shm_mq.h"
+#include "storage/shm_toc.h"
+#include "utils/acl.h"
+#include "utils/builtins.h"
 #include "utils/datum.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
+#include "utils/numeric.h"
+#include "utils/rls.h"
 #include "utils/snapmgr.h"
 
+#include "utils/ag_cache.h"
+#include "utils/ag_guc.h"
 #include "utils/age_global_graph.h"
 #include "catalog/ag_graph.h"
 #include "catalog/ag_label.h"
@@ -39,6 +62,15 @@
 #define EDGE_HTAB_NAME "Edge to vertex mapping " /* the graph name to follow */
 #define VERTEX_HTAB_INITIAL_SIZE 1000000
 #define EDGE_HTAB_INITIAL_SIZE 1000000
+#define GRAPH_VERSIONS_NAME "age_graph_versions"
+#define GRAPH_VERSIONS_MAX_ENTRIES 1024
+#define GRAPH_VERSIONS_MAX_PREPARED 8
+#define GRAPH_CHANGE_LOG_SIZE 16384
+#define GRAPH_LOAD_KEY_SHARED UINT64CONST(0xA6E0000000000001)
+#define GRAPH_LOAD_KEY_QUEUES UINT64CONST(0xA6E0000000000002)
+#define GRAPH_LOAD_QUEUE_SIZE (1024 * 1024)
+#define GRAPH_LOAD_BATCH_SIZE (64 * 1024)
+#define GRAPH_CHANGE_MAX_PENDING (GRAPH_CHANGE_LOG_SIZE / 4)
 
 /* internal data structures implementation */
 
@@ -50,7 +82,9 @@ typedef struct vertex_entry
     ListGraphId *edges_out;        /* List of exiting edges graphids (int64) */
     ListGraphId *edges_self;       /* List of selfloop edges graphids (int64) */
     Oid vertex_label_table_oid;    /* the label table oid */
-    Datum vertex_properties;       /* datum property value */
+    Datum vertex_properties;       /* datum property value, 0 if not loaded */
+    ItemPointerData tid;           /* tuple the vertex was loaded from */
+    int64 csr_index;               /* index into the CSR arrays, -1 if none */
 } vertex_entry;
 
 /* edge entry for the edge_hashtable */
@@ -58,15 +92,37 @@ typedef struct edge_entry
 {
     graphid edge_id;               /* edge id, it is also the hash key */
     Oid edge_label_table_oid;      /* the label table oid */
-    Datum edge_properties;         /* datum property value */
+    Datum edge_properties;         /* datum property value, 0 if not loaded */
+    ItemPointerData tid;           /* tuple the edge was loaded from */
     graphid start_vertex_id;       /* start vertex */
     graphid end_vertex_id;         /* end vertex */
 } edge_entry;
 
+/*
+ * Compressed sparse row (CSR) adjacency of a frozen GRAPH global context. Each
+ * vertex has a dense index, and its edges of each kind are stored contiguously
+ * from edges[offsets[index]] up to, but not including, edges[offsets[index + 1]].
+ * The edges are in the same order as in the vertex's edge lists.
+ */
+typedef struct GRAPH_global_csr
+{
+    int64 num_vertices;            /* number of indexed vertices */
+    int64 *out_offsets;            /* offsets into out_edges, per vertex */
+    int64 *in_offsets;             /* offsets into in_edges, per vertex */
+    int64 *self_offsets;           /* offsets into self_edges, per vertex */
+    graph_csr_edge *out_edges;     /* exiting edges of all vertices */
+    graph_csr_edge *in_edges;      /* entering edges of all vertices */
+    graph_csr_edge *self_edges;    /* selfloop edges of all vertices */
+} GRAPH_global_csr;
+
 /*
  * GRAPH global context per graph. They are chained together via next.
  * Be aware that the global pointer will point to the root BUT that
  * the root will change as new graphs are added to the top.
+ *
+ * NOTE: Each backend still builds its own context, only the graph versions
+ * that decide when it is stale are shared. Building the adjacency once, in a
+ * DSA segment attached read-only by every backend, is a separate follow-up.
  */
 typedef struct GRAPH_global_context
 {
@@ -77,69 +133,1715 @@ typedef struct GRAPH_global_context
     TransactionId xmin;            /* transaction ids for this graph */
     TransactionId xmax;
     CommandId curcid;              /* currentCommandId graph was created with */
+    struct graph_version_entry *version_entry; /* shared version entry */
+    uint64 graph_version;          /* shared graph version, 0 if not used */
     int64 num_loaded_vertices;     /* number of loaded vertices in this graph */
     int64 num_loaded_edges;        /* number of loaded edges in this graph */
-    ListGraphId *vertices;         /* vertices for vertex hashtable cleanup */
-    ListGraphId *edges;            /* edges for edge hashtable cleanup */
+    ListGraphId *vertices;         /* all vertices in the vertex hashtable */
+    GRAPH_global_csr *csr;         /* CSR adjacency, NULL if not built */
     struct GRAPH_global_context *next; /* next graph */
 } GRAPH_global_context;
 
-/* container for GRAPH_global_context and its mutex */
-typedef struct GRAPH_global_context_container
+/* container for GRAPH_global_context and its mutex */
+typedef struct GRAPH_global_context_container
+{
+    /* head of the list */
+    GRAPH_global_context *contexts;
+
+    /* mutex to protect the list */
+    pthread_mutex_t mutex_lock;
+} GRAPH_global_context_container;
+
+/* global variable to hold the per process GRAPH global contexts */
+static GRAPH_global_context_container global_graph_contexts_container = {0};
+
+/* shared graph version entry, one per graph */
+typedef struct graph_version_entry
+{
+    Oid graph_oid;                 /* graph oid, InvalidOid if the slot is free */
+    pg_atomic_uint64 version;      /* version of the last committed change */
+    pg_atomic_uint32 in_flight;    /* committing transactions not published */
+    uint64 first_version;          /* version the entry was created with */
+    FullTransactionId first_next_xid; /* next xid when it was created */
+    /* prepared transactions that modified the graph, not yet finished */
+    TransactionId prepared_xids[GRAPH_VERSIONS_MAX_PREPARED];
+} graph_version_entry;
+
+/*
+ * A change to one vertex or edge of a graph. Changes are published in batches,
+ * one per graph per committed transaction, which move the graph's version from
+ * from_version to to_version.
+ */
+typedef struct graph_change_record
+{
+    Oid graph_oid;                 /* graph the change belongs to */
+    Oid label_relid;               /* label table of the entity */
+    char label_kind;               /* LABEL_KIND_VERTEX or LABEL_KIND_EDGE */
+    char change_kind;              /* graph_change_kind */
+    bool batch_start;              /* first change of its batch */
+    uint64 from_version;           /* graph version the batch applies to */
+    uint64 to_version;             /* graph version after the batch */
+    TransactionId xid;             /* transaction that made the batch */
+    FullTransactionId next_xid;    /* next xid when the batch was published */
+    graphid id;                    /* vertex or edge id */
+    graphid start_id;              /* edge start vertex id */
+    graphid end_id;                /* edge end vertex id */
+} graph_change_record;
+
+/*
+ * Shared table of graph versions. It lives in a named DSM segment so that it
+ * does not require AGE to be in shared_preload_libraries. The lock protects
+ * the assignment of the graph_oid slots and the change log, the versions
+ * themselves are atomics. The change log is a ring buffer, so contexts that
+ * fall too far behind will need to be reloaded. The contexts themselves are
+ * not shared, their adjacency is made of backend local pointers.
+ */
+typedef struct graph_version_table
+{
+    LWLock lock;                   /* protects the slots and the change log */
+    int tranche_id;                /* tranche id for the lock */
+    pg_atomic_uint64 next_version; /* source of the version numbers */
+    graph_version_entry entries[GRAPH_VERSIONS_MAX_ENTRIES];
+    uint64 change_log_next;        /* number of changes ever written */
+    graph_change_record change_log[GRAPH_CHANGE_LOG_SIZE];
+} graph_version_table;
+
+/*
+ * State shared with the parallel workers that load the label tables. Each
+ * worker claims label tables, by their index, until there are none left.
+ */
+typedef struct graph_load_shared
+{
+    char label_type;               /* LABEL_TYPE_VERTEX or LABEL_TYPE_EDGE */
+    bool lazy_properties;          /* leave out the properties */
+    int num_labels;                /* number of label tables */
+    pg_atomic_uint32 next_label;   /* index of the next unclaimed label */
+    Oid label_relids[FLEXIBLE_ARRAY_MEMBER]; /* the label tables */
+} graph_load_shared;
+
+/*
+ * A vertex or an edge sent by a parallel load worker. Records are sent in
+ * batches, each one followed by its properties_size bytes of properties.
+ */
+typedef struct graph_load_record
+{
+    graphid id;                    /* vertex or edge id */
+    graphid start_id;              /* edge start vertex id */
+    graphid end_id;                /* edge end vertex id */
+    ItemPointerData tid;           /* tuple the entity was loaded from */
+    int32 label_index;             /* index of its label table */
+    uint32 properties_size;        /* size of the properties, 0 if left out */
+} graph_load_record;
+
+/* what an output column of age_export_label is filled with */
+typedef enum export_column_kind
+{
+    EXPORT_COLUMN_ID,
+    EXPORT_COLUMN_START_ID,
+    EXPORT_COLUMN_END_ID,
+    EXPORT_COLUMN_PROPERTIES,
+    EXPORT_COLUMN_PROPERTY
+} export_column_kind;
+
+/* an output column of age_export_label and the property key it is read from */
+typedef struct export_column
+{
+    export_column_kind kind;
+    Oid type;
+    agtype_value key;
+} export_column;
+
+/* this backend's pointer to the shared graph versions table */
+static graph_version_table *graph_versions = NULL;
+
+/* graphs modified by the current transaction, in TopTransactionContext */
+static List *modified_graph_oids = NIL;
+
+/* changes made by the current transaction, in TopTransactionContext */
+static graph_change_record *pending_changes = NULL;
+static int num_pending_changes = 0;
+static int max_pending_changes = 0;
+/* set if changes couldn't be tracked, forcing a reload of the graphs */
+static bool pending_changes_overflow = false;
+
+/* version entries of the graphs whose commit is in flight */
+static List *in_flight_entries = NIL;
+/* xid of the committing transaction, for its published batches */
+static TransactionId committing_xid = InvalidTransactionId;
+/* version entries of the graphs marked with our prepared xid */
+static List *prepared_entries = NIL;
+/* graphs dropped by the current transaction, in TopTransactionContext */
+static List *released_graph_oids = NIL;
+
+/* whether the transaction callbacks have been registered */
+static bool graph_version_callbacks_registered = false;
+
+/* declarations */
+/* GRAPH global context functions */
+static bool free_specific_GRAPH_global_context(GRAPH_global_context *ggctx);
+static bool delete_specific_GRAPH_global_contexts(char *graph_name);
+static bool delete_GRAPH_global_contexts(void);
+static void create_GRAPH_global_hashtables(GRAPH_global_context *ggctx);
+static void load_GRAPH_global_hashtables(GRAPH_global_context *ggctx);
+static void load_vertex_hashtable(GRAPH_global_context *ggctx);
+static void load_edge_hashtable(GRAPH_global_context *ggctx);
+static bool parallel_load_labels(GRAPH_global_context *ggctx,
+                                 char label_type);
+static void insert_loaded_entities(GRAPH_global_context *ggctx,
+                                   char label_type, Oid *label_relids,
+                                   char **label_names, char *data,
+                                   Size nbytes);
+static void send_label_entities(graph_load_shared *shared, int label_index,
+                                shm_mq_handle *mqh, StringInfo buf);
+static void freeze_GRAPH_global_hashtables(GRAPH_global_context *ggctx);
+static void build_GRAPH_global_csr(GRAPH_global_context *ggctx);
+static int64 fill_GRAPH_global_csr_edges(GRAPH_global_context *ggctx,
+                                         ListGraphId *edges, graphid vertex_id,
+                                         graph_csr_edge *csr_edges,
+                                         int64 offset);
+static void free_GRAPH_global_csr(GRAPH_global_csr *csr);
+static List *get_ag_labels_names(Snapshot snapshot, Oid graph_oid,
+                                 char label_type);
+static bool insert_edge_entry(GRAPH_global_context *ggctx, graphid edge_id,
+                              Datum edge_properties, graphid start_vertex_id,
+                              graphid end_vertex_id, Oid edge_label_table_oid,
+                              ItemPointer tid);
+static bool insert_vertex_edge(GRAPH_global_context *ggctx,
+                               graphid start_vertex_id, graphid end_vertex_id,
+                               graphid edge_id, char *edge_label_name);
+static bool insert_vertex_entry(GRAPH_global_context *ggctx, graphid vertex_id,
+                                Oid vertex_label_table_oid,
+                                Datum vertex_properties, ItemPointer tid);
+static bool fetch_entity_properties(Oid label_relid, char label_kind,
+                                    graphid id, graphid start_id,
+                                    ItemPointer tid, MemoryContext resultctx,
+                                    Datum *properties);
+static Datum copy_entity_properties(Datum properties, MemoryContext resultctx);
+static Datum fetch_lazy_properties(Oid label_relid, char label_kind,
+                                   graphid id, graphid start_id,
+                                   ItemPointer tid);
+/* graph version functions */
+static void init_graph_version_table(void *ptr);
+static graph_version_table *get_graph_version_table(void);
+static graph_version_entry *find_graph_version_entry(graph_version_table *table,
+                                                     Oid graph_oid);
+static graph_version_entry *get_graph_version_entry(Oid graph_oid,
+                                                    bool create);
+static void graph_version_xact_callback(XactEvent event, void *arg);
+static void graph_version_subxact_callback(SubXactEvent event,
+                                           SubTransactionId mySubid,
+                                           SubTransactionId parentSubid,
+                                           void *arg);
+static void register_graph_version_callbacks(void);
+static void add_graph_change(Oid graph_oid, Oid label_relid, char label_kind,
+                             graph_change_kind kind, graphid id,
+                             graphid start_id, graphid end_id);
+static void release_graph_versions(void);
+static void mark_graph_changes_in_flight(void);
+static void clear_graph_changes_in_flight(void);
+static void mark_graph_changes_prepared(void);
+static void clear_graph_changes_prepared(void);
+static bool has_prepared_graph_changes(graph_version_entry *entry);
+static bool resolve_prepared_graph_changes(graph_version_entry *entry,
+                                           Oid graph_oid);
+static void write_graph_reload_batch(graph_version_table *table,
+                                     Oid graph_oid, uint64 from_version,
+                                     uint64 to_version, TransactionId xid,
+                                     FullTransactionId next_xid);
+static void publish_graph_changes(void);
+static void reset_graph_changes(void);
+static uint64 get_snapshot_graph_version(graph_version_table *table,
+                                         graph_version_entry *entry,
+                                         Oid graph_oid, uint64 version,
+                                         Snapshot snapshot);
+/* incremental maintenance functions */
+static bool refresh_GRAPH_global_context(GRAPH_global_context *ggctx);
+static void apply_graph_change(GRAPH_global_context *ggctx,
+                               graph_change_record *gcr,
+                               MemoryContext scanctx);
+static bool fetch_graph_change_properties(graph_change_record *gcr,
+                                          MemoryContext scanctx,
+                                          ItemPointer tid, Datum *properties);
+static void upsert_vertex_entry(GRAPH_global_context *ggctx,
+                                graph_change_record *gcr,
+                                MemoryContext scanctx);
+static void upsert_edge_entry(GRAPH_global_context *ggctx,
+                              graph_change_record *gcr,
+                              MemoryContext scanctx);
+static void remove_vertex_entry(GRAPH_global_context *ggctx,
+                                graphid vertex_id);
+static void remove_edge_entry(GRAPH_global_context *ggctx, graphid edge_id);
+static void get_entity_ids(TupleDesc tupdesc, HeapTuple tuple,
+                           char label_kind, graphid *id, graphid *start_id,
+                           graphid *end_id);
+/* export functions */
+static export_column *get_export_columns(TupleDesc tupdesc, char label_kind);
+static Datum export_property_datum(export_column *column, char *label_name,
+                                   agtype_value *value);
+/* definitions */
+
+/*
+ * Initialization callback for the shared graph versions table. It is called
+ * only once, by the first backend to attach to the named DSM segment.
+ */
+static void init_graph_version_table(void *ptr)
+{
+    graph_version_table *table = (graph_version_table *)ptr;
+    int i;
+
+    table->tranche_id = LWLockNewTrancheId();
+    LWLockInitialize(&table->lock, table->tranche_id);
+
+    /* version 0 is reserved to mean "no version" */
+    pg_atomic_init_u64(&table->next_version, 1);
+
+    for (i = 0; i < GRAPH_VERSIONS_MAX_ENTRIES; i++)
+    {
+        table->entries[i].graph_oid = InvalidOid;
+        pg_atomic_init_u64(&table->entries[i].version, 0);
+        pg_atomic_init_u32(&table->entries[i].in_flight, 0);
+        MemSet(table->entries[i].prepared_xids, 0,
+               sizeof(table->entries[i].prepared_xids));
+    }
+
+    table->change_log_next = 0;
+    MemSet(table->change_log, 0, sizeof(table->change_log));
+}
+
+/*
+ * Helper function to attach to, creating if needed, the shared graph versions
+ * table. It can error out, so it should not be called from the commit path.
+ */
+static graph_version_table *get_graph_version_table(void)
+{
+    bool found = false;
+
+    if (graph_versions == NULL)
+    {
+        graph_versions = GetNamedDSMSegment(GRAPH_VERSIONS_NAME,
+                                            sizeof(graph_version_table),
+                                            init_graph_version_table, &found);
+        LWLockRegisterTranche(graph_versions->tranche_id, GRAPH_VERSIONS_NAME);
+    }
+
+    return graph_versions;
+}
+
+/*
+ * Helper function to find the shared version entry for a graph. If create is
+ * true and the graph doesn't have an entry, one is assigned with a new
+ * version. Returns NULL if there isn't an entry or the table is full.
+ *
+ * NOTE: The table must already be attached.
+ */
+static graph_version_entry *get_graph_version_entry(Oid graph_oid,
+                                                    bool create)
+{
+    graph_version_table *table = graph_versions;
+    graph_version_entry *entry = NULL;
+    graph_version_entry *free_entry = NULL;
+    int i;
+
+    Assert(table != NULL);
+
+    LWLockAcquire(&table->lock, LW_SHARED);
+    entry = find_graph_version_entry(table, graph_oid);
+    LWLockRelease(&table->lock);
+
+    if (entry != NULL || !create)
+    {
+        return entry;
+    }
+
+    /* recheck under the exclusive lock, someone may have beaten us to it */
+    LWLockAcquire(&table->lock, LW_EXCLUSIVE);
+    for (i = 0; i < GRAPH_VERSIONS_MAX_ENTRIES; i++)
+    {
+        if (table->entries[i].graph_oid == graph_oid)
+        {
+            LWLockRelease(&table->lock);
+            return &table->entries[i];
+        }
+        if (free_entry == NULL && table->entries[i].graph_oid == InvalidOid)
+        {
+            free_entry = &table->entries[i];
+        }
+    }
+
+    /*
+     * Versions are drawn from a single global counter, so no value is ever
+     * stored twice. This allows a context to keep a pointer to its entry,
+     * even if the entry is later released and reused by another graph.
+     */
+    if (free_entry != NULL)
+    {
+        free_entry->first_version =
+            pg_atomic_fetch_add_u64(&table->next_version, 1);
+        free_entry->first_next_xid = ReadNextFullTransactionId();
+        MemSet(free_entry->prepared_xids, 0,
+               sizeof(free_entry->prepared_xids));
+        pg_atomic_write_u64(&free_entry->version, free_entry->first_version);
+        free_entry->graph_oid = graph_oid;
+    }
+    LWLockRelease(&table->lock);
+
+    return free_entry;
+}
+
+/*
+ * Helper function to find the version entry for a graph, without locking.
+ *
+ * NOTE: The caller must hold the table's lock.
+ */
+static graph_version_entry *find_graph_version_entry(graph_version_table *table,
+                                                     Oid graph_oid)
+{
+    int i;
+
+    for (i = 0; i < GRAPH_VERSIONS_MAX_ENTRIES; i++)
+    {
+        if (table->entries[i].graph_oid == graph_oid)
+        {
+            return &table->entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Transaction callback for the graph versions. The commit event happens after
+ * the transaction is visible to other backends, so a backend that sees the new
+ * version will also see the changes. In between, the graphs are marked as
+ * having a commit in flight. A prepared transaction can be committed by any
+ * backend, without these callbacks, so its graphs are marked with its xid
+ * instead. On abort, there is nothing to publish.
+ */
+static void graph_version_xact_callback(XactEvent event, void *arg)
+{
+    switch (event)
+    {
+    case XACT_EVENT_PRE_COMMIT:
+        if (modified_graph_oids != NIL)
+        {
+            mark_graph_changes_in_flight();
+        }
+        break;
+    case XACT_EVENT_COMMIT:
+        if (modified_graph_oids != NIL)
+        {
+            publish_graph_changes();
+        }
+        if (released_graph_oids != NIL)
+        {
+            release_graph_versions();
+        }
+        reset_graph_changes();
+        break;
+    case XACT_EVENT_PRE_PREPARE:
+        if (modified_graph_oids != NIL)
+        {
+            mark_graph_changes_prepared();
+        }
+        break;
+    case XACT_EVENT_ABORT:
+        /* everything is gone with the TopTransactionContext */
+        clear_graph_changes_in_flight();
+        clear_graph_changes_prepared();
+        reset_graph_changes();
+        break;
+    case XACT_EVENT_PREPARE:
+        /*
+         * The prepared marks stay, until the transaction is seen finished. The
+         * entries of the graphs it drops are kept, they are only a stale slot.
+         */
+        reset_graph_changes();
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+ * Subtransaction callback for the graph changes. The pending changes don't
+ * know which subtransaction made them, so a rollback to a savepoint forces the
+ * affected graphs to be reloaded.
+ */
+static void graph_version_subxact_callback(SubXactEvent event,
+                                           SubTransactionId mySubid,
+                                           SubTransactionId parentSubid,
+                                           void *arg)
+{
+    if (event == SUBXACT_EVENT_ABORT_SUB && modified_graph_oids != NIL)
+    {
+        pending_changes_overflow = true;
+    }
+}
+
+/*
+ * Helper function to mark the graphs modified by the current transaction as
+ * having a commit in flight. It is called before the transaction becomes
+ * visible, so that other backends don't trust a graph's version while our
+ * changes may be visible to them, but aren't published yet.
+ *
+ * NOTE: The table was attached when the graphs were first modified.
+ */
+static void mark_graph_changes_in_flight(void)
+{
+    graph_version_table *table = graph_versions;
+    MemoryContext oldctx = NULL;
+    ListCell *lc;
+
+    committing_xid = GetTopTransactionIdIfAny();
+
+    oldctx = MemoryContextSwitchTo(TopTransactionContext);
+    LWLockAcquire(&table->lock, LW_SHARED);
+
+    foreach (lc, modified_graph_oids)
+    {
+        graph_version_entry *entry = NULL;
+
+        entry = find_graph_version_entry(table, lfirst_oid(lc));
+        if (entry == NULL)
+        {
+            continue;
+        }
+
+        /* remember the entry first, so it is always cleared */
+        in_flight_entries = lappend(in_flight_entries, entry);
+        pg_atomic_fetch_add_u32(&entry->in_flight, 1);
+    }
+
+    LWLockRelease(&table->lock);
+    MemoryContextSwitchTo(oldctx);
+}
+
+/* helper function to clear the in flight marks of the current transaction */
+static void clear_graph_changes_in_flight(void)
+{
+    ListCell *lc;
+
+    foreach (lc, in_flight_entries)
+    {
+        graph_version_entry *entry = lfirst(lc);
+
+        pg_atomic_fetch_sub_u32(&entry->in_flight, 1);
+    }
+
+    in_flight_entries = NIL;
+}
+
+/*
+ * Helper function to mark the graphs modified by the current transaction with
+ * its xid, as it is being prepared. Until the prepared transaction is seen to
+ * have finished, the versions of those graphs can't be trusted.
+ *
+ * NOTE: The table was attached when the graphs were first modified.
+ */
+static void mark_graph_changes_prepared(void)
+{
+    graph_version_table *table = graph_versions;
+    MemoryContext oldctx = NULL;
+    TransactionId xid;
+    ListCell *lc;
+
+    xid = GetTopTransactionIdIfAny();
+    if (!TransactionIdIsValid(xid))
+    {
+        return;
+    }
+    committing_xid = xid;
+
+    oldctx = MemoryContextSwitchTo(TopTransactionContext);
+    LWLockAcquire(&table->lock, LW_EXCLUSIVE);
+
+    foreach (lc, modified_graph_oids)
+    {
+        graph_version_entry *entry = NULL;
+        int i;
+
+        entry = find_graph_version_entry(table, lfirst_oid(lc));
+        if (entry == NULL)
+        {
+            continue;
+        }
+
+        for (i = 0; i < GRAPH_VERSIONS_MAX_PREPARED; i++)
+        {
+            if (!TransactionIdIsValid(entry->prepared_xids[i]))
+            {
+                break;
+            }
+        }
+
+        if (i == GRAPH_VERSIONS_MAX_PREPARED)
+        {
+            LWLockRelease(&table->lock);
+
+            ereport(ERROR,
+                    (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                     errmsg("too many prepared transactions have modified the same graph")));
+        }
+
+        /* remember the entry first, so it is always cleared */
+        prepared_entries = lappend(prepared_entries, entry);
+        entry->prepared_xids[i] = xid;
+    }
+
+    LWLockRelease(&table->lock);
+    MemoryContextSwitchTo(oldctx);
+}
+
+/*
+ * Helper function to clear the prepared marks of the current transaction, if
+ * it fails to be prepared.
+ */
+static void clear_graph_changes_prepared(void)
+{
+    graph_version_table *table = graph_versions;
+    ListCell *lc;
+
+    if (prepared_entries == NIL)
+    {
+        return;
+    }
+
+    LWLockAcquire(&table->lock, LW_EXCLUSIVE);
+
+    foreach (lc, prepared_entries)
+    {
+        graph_version_entry *entry = lfirst(lc);
+        int i;
+
+        for (i = 0; i < GRAPH_VERSIONS_MAX_PREPARED; i++)
+        {
+            if (entry->prepared_xids[i] == committing_xid)
+            {
+                entry->prepared_xids[i] = InvalidTransactionId;
+            }
+        }
+    }
+
+    LWLockRelease(&table->lock);
+
+    prepared_entries = NIL;
+}
+
+/*
+ * Helper function to see if a graph has been modified by a prepared
+ * transaction that hasn't been seen to finish. It doesn't lock the table, so
+ * it is only a hint, resolve_prepared_graph_changes is the authority.
+ */
+static bool has_prepared_graph_changes(graph_version_entry *entry)
+{
+    int i;
+
+    for (i = 0; i < GRAPH_VERSIONS_MAX_PREPARED; i++)
+    {
+        if (TransactionIdIsValid(entry->prepared_xids[i]))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Helper function to resolve the prepared transactions that modified a graph.
+ * The changes of a prepared transaction aren't tracked. So, once it has
+ * finished, its mark is replaced by a reload batch, which moves the graph's
+ * version. Returns true if any of them is still in progress, in which case the
+ * graph's version can't be trusted yet.
+ */
+static bool resolve_prepared_graph_changes(graph_version_entry *entry,
+                                           Oid graph_oid)
+{
+    graph_version_table *table = graph_versions;
+    TransactionId xids[GRAPH_VERSIONS_MAX_PREPARED];
+    FullTransactionId next_xid;
+    bool in_progress = false;
+    bool finished = false;
+    int i;
+    int j;
+
+    LWLockAcquire(&table->lock, LW_SHARED);
+    if (entry->graph_oid != graph_oid)
+    {
+        LWLockRelease(&table->lock);
+        return false;
+    }
+    memcpy(xids, entry->prepared_xids, sizeof(xids));
+    LWLockRelease(&table->lock);
+
+    for (i = 0; i < GRAPH_VERSIONS_MAX_PREPARED; i++)
+    {
+        if (!TransactionIdIsValid(xids[i]))
+        {
+            continue;
+        }
+
+        if (TransactionIdIsInProgress(xids[i]))
+        {
+            in_progress = true;
+            xids[i] = InvalidTransactionId;
+        }
+        else
+        {
+            finished = true;
+        }
+    }
+
+    if (!finished)
+    {
+        return in_progress;
+    }
+
+    /* they have finished, so any snapshot taken from now on sees them */
+    next_xid = ReadNextFullTransactionId();
+
+    LWLockAcquire(&table->lock, LW_EXCLUSIVE);
+
+    for (i = 0; i < GRAPH_VERSIONS_MAX_PREPARED &&
+                entry->graph_oid == graph_oid; i++)
+    {
+        if (!TransactionIdIsValid(xids[i]))
+        {
+            continue;
+        }
+
+        /* someone else may have resolved it already */
+        for (j = 0; j < GRAPH_VERSIONS_MAX_PREPARED; j++)
+        {
+            uint64 from_version;
+            uint64 to_version;
+
+            if (entry->prepared_xids[j] != xids[i])
+            {
+                continue;
+            }
+
+            from_version = pg_atomic_read_u64(&entry->version);
+            to_version = pg_atomic_fetch_add_u64(&table->next_version, 1);
+            write_graph_reload_batch(table, graph_oid, from_version,
+                                     to_version, xids[i], next_xid);
+            pg_atomic_write_u64(&entry->version, to_version);
+
+            /* the version must have moved before the mark is gone */
+            pg_write_barrier();
+            entry->prepared_xids[j] = InvalidTransactionId;
+        }
+    }
+
+    LWLockRelease(&table->lock);
+
+    return in_progress;
+}
+
+/*
+ * Helper function to write a batch of a single reload record to the change
+ * log. The caller moves the graph's version.
+ *
+ * NOTE: The caller must hold the table's lock exclusively.
+ */
+static void write_graph_reload_batch(graph_version_table *table,
+                                     Oid graph_oid, uint64 from_version,
+                                     uint64 to_version, TransactionId xid,
+                                     FullTransactionId next_xid)
+{
+    graph_change_record *gcr = NULL;
+
+    gcr = &table->change_log[table->change_log_next % GRAPH_CHANGE_LOG_SIZE];
+    MemSet(gcr, 0, sizeof(graph_change_record));
+    gcr->graph_oid = graph_oid;
+    gcr->change_kind = GRAPH_CHANGE_RELOAD;
+    gcr->batch_start = true;
+    gcr->from_version = from_version;
+    gcr->to_version = to_version;
+    gcr->xid = xid;
+    gcr->next_xid = next_xid;
+    table->change_log_next++;
+}
+
+/*
+ * Helper function to publish the current transaction's changes, one batch per
+ * modified graph, and to move the versions of those graphs. It is called from
+ * the commit callback, so it must not error out.
+ *
+ * NOTE: The table was attached when the graphs were first modified.
+ */
+static void publish_graph_changes(void)
+{
+    graph_version_table *table = graph_versions;
+    FullTransactionId next_xid;
+    ListCell *lc;
+
+    /* our transaction is visible, so any snapshot taken from now on sees it */
+    next_xid = ReadNextFullTransactionId();
+
+    LWLockAcquire(&table->lock, LW_EXCLUSIVE);
+
+    foreach (lc, modified_graph_oids)
+    {
+        Oid graph_oid = lfirst_oid(lc);
+        graph_version_entry *entry = NULL;
+        uint64 from_version;
+        uint64 to_version;
+        bool reload = pending_changes_overflow;
+        bool batch_start = true;
+        int num_changes = 0;
+        int i;
+
+        /*
+         * If the graph doesn't have an entry, then no backend holds a context
+         * stamped with its version. Any entry created after this point will
+         * see our changes.
+         */
+        entry = find_graph_version_entry(table, graph_oid);
+        if (entry == NULL)
+        {
+            continue;
+        }
+
+        from_version = pg_atomic_read_u64(&entry->version);
+        to_version = pg_atomic_fetch_add_u64(&table->next_version, 1);
+
+        /* count this graph's changes, and see if any are untracked */
+        for (i = 0; i < num_pending_changes && !reload; i++)
+        {
+            if (pending_changes[i].graph_oid == graph_oid)
+            {
+                reload = (pending_changes[i].change_kind ==
+                          GRAPH_CHANGE_RELOAD);
+                num_changes++;
+            }
+        }
+
+        /* write the batch, or a single reload record */
+        if (reload || num_changes == 0)
+        {
+            write_graph_reload_batch(table, graph_oid, from_version,
+                                     to_version, committing_xid, next_xid);
+        }
+        else
+        {
+            for (i = 0; i < num_pending_changes; i++)
+            {
+                graph_change_record *gcr = NULL;
+
+                if (pending_changes[i].graph_oid != graph_oid)
+                {
+                    continue;
+                }
+
+                gcr = &table->change_log[table->change_log_next %
+                                         GRAPH_CHANGE_LOG_SIZE];
+                *gcr = pending_changes[i];
+                gcr->batch_start = batch_start;
+                gcr->from_version = from_version;
+                gcr->to_version = to_version;
+                gcr->xid = committing_xid;
+                gcr->next_xid = next_xid;
+                table->change_log_next++;
+
+                batch_start = false;
+            }
+        }
+
+        pg_atomic_write_u64(&entry->version, to_version);
+    }
+
+    /* the versions have moved, so our commit is no longer in flight */
+    clear_graph_changes_in_flight();
+
+    LWLockRelease(&table->lock);
+}
+
+/* helper function to reset the current transaction's graph changes */
+static void reset_graph_changes(void)
+{
+    /* the memory is owned by the TopTransactionContext */
+    modified_graph_oids = NIL;
+    pending_changes = NULL;
+    num_pending_changes = 0;
+    max_pending_changes = 0;
+    pending_changes_overflow = false;
+    in_flight_entries = NIL;
+    committing_xid = InvalidTransactionId;
+    prepared_entries = NIL;
+    released_graph_oids = NIL;
+}
+
+/*
+ * Helper function to register the transaction callbacks for the graph
+ * versions, the first time they are needed.
+ */
+static void register_graph_version_callbacks(void)
+{
+    if (!graph_version_callbacks_registered)
+    {
+        RegisterXactCallback(graph_version_xact_callback, NULL);
+        RegisterSubXactCallback(graph_version_subxact_callback, NULL);
+        graph_version_callbacks_registered = true;
+    }
+}
+
+/*
+ * Helper function to add a change to the current transaction's pending
+ * changes. For the rest of the transaction, contexts for the graph fall back
+ * to the snapshot based validity, as they may see our own changes.
+ */
+static void add_graph_change(Oid graph_oid, Oid label_relid, char label_kind,
+                             graph_change_kind kind, graphid id,
+                             graphid start_id, graphid end_id)
+{
+    graph_change_record *gcr = NULL;
+    MemoryContext oldctx = NULL;
+
+    register_graph_version_callbacks();
+
+    oldctx = MemoryContextSwitchTo(TopTransactionContext);
+
+    if (!list_member_oid(modified_graph_oids, graph_oid))
+    {
+        /* attach now, the commit callback can't afford to error out */
+        get_graph_version_table();
+
+        modified_graph_oids = lappend_oid(modified_graph_oids, graph_oid);
+    }
+
+    /* past this many changes, a reload is cheaper than replaying them */
+    if (pending_changes_overflow ||
+        num_pending_changes >= GRAPH_CHANGE_MAX_PENDING)
+    {
+        pending_changes_overflow = true;
+        MemoryContextSwitchTo(oldctx);
+        return;
+    }
+
+    /* grow the pending changes array, if needed */
+    if (num_pending_changes >= max_pending_changes)
+    {
+        max_pending_changes = (max_pending_changes == 0) ?
+                              64 : max_pending_changes * 2;
+
+        if (pending_changes == NULL)
+        {
+            pending_changes = palloc(sizeof(graph_change_record) *
+                                     max_pending_changes);
+        }
+        else
+        {
+            pending_changes = repalloc(pending_changes,
+                                       sizeof(graph_change_record) *
+                                       max_pending_changes);
+        }
+    }
+
+    gcr = &pending_changes[num_pending_changes++];
+    MemSet(gcr, 0, sizeof(graph_change_record));
+    gcr->graph_oid = graph_oid;
+    gcr->label_relid = label_relid;
+    gcr->label_kind = label_kind;
+    gcr->change_kind = kind;
+    gcr->id = id;
+    gcr->start_id = start_id;
+    gcr->end_id = end_id;
+
+    MemoryContextSwitchTo(oldctx);
+}
+
+/*
+ * Function to record a change to a vertex or an edge tuple of a label table.
+ * It needs to be called by anything that writes to a graph's label tables. The
+ * changes are published when the transaction commits and are used to bring
+ * the global graph contexts of other backends up to date.
+ */
+void record_graph_change(Relation label_relation, graph_change_kind kind,
+                         HeapTuple tuple)
+{
+    label_cache_data *label = NULL;
+    Oid relid = RelationGetRelid(label_relation);
+    graphid id;
+    graphid start_id;
+    graphid end_id;
+
+    label = search_label_relation_cache(relid);
+    if (label == NULL)
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_WRONG_OBJECT_TYPE),
+                 errmsg("relation \"%s\" is not a label table",
+                        RelationGetRelationName(label_relation))));
+    }
+
+    get_entity_ids(RelationGetDescr(label_relation), tuple, label->kind, &id,
+                   &start_id, &end_id);
+
+    add_graph_change(label->graph, relid, label->kind, kind, id, start_id,
+                     end_id);
+}
+
+/*
+ * Function to mark a graph as modified by the current transaction, in a way
+ * that isn't tracked per entity. For example, bulk loads and dropped labels.
+ * The global graph contexts for the graph will need to be reloaded.
+ */
+void mark_graph_modified(Oid graph_oid)
+{
+    add_graph_change(graph_oid, InvalidOid, '\0', GRAPH_CHANGE_RELOAD, 0, 0,
+                     0);
+}
+
+/*
+ * Function to release the shared version entry of a graph that is being
+ * dropped. The entry is released when the transaction commits, so a rolled
+ * back drop leaves it alone. Any context still stamped with its version will
+ * see a mismatch.
+ */
+void release_graph_version(Oid graph_oid)
+{
+    MemoryContext oldctx = NULL;
+
+    register_graph_version_callbacks();
+
+    /* attach now, the commit callback can't afford to error out */
+    get_graph_version_table();
+
+    oldctx = MemoryContextSwitchTo(TopTransactionContext);
+    released_graph_oids = list_append_unique_oid(released_graph_oids,
+                                                 graph_oid);
+    MemoryContextSwitchTo(oldctx);
+}
+
+/*
+ * Helper function to release the version entries of the graphs dropped by the
+ * committed transaction. A drop rolled back to a savepoint is still released,
+ * which only forces the graph's contexts to be reloaded.
+ *
+ * NOTE: The table was attached when the graphs were dropped.
+ */
+static void release_graph_versions(void)
+{
+    graph_version_table *table = graph_versions;
+    ListCell *lc;
+
+    LWLockAcquire(&table->lock, LW_EXCLUSIVE);
+    foreach (lc, released_graph_oids)
+    {
+        Oid graph_oid = lfirst_oid(lc);
+        int i;
+
+        for (i = 0; i < GRAPH_VERSIONS_MAX_ENTRIES; i++)
+        {
+            if (table->entries[i].graph_oid == graph_oid)
+            {
+                table->entries[i].graph_oid = InvalidOid;
+                pg_atomic_write_u64(&table->entries[i].version, 0);
+                break;
+            }
+        }
+    }
+    LWLockRelease(&table->lock);
+}
+
+/*
+ * Helper function to find the newest version of a graph, up to the version
+ * passed, whose changes are all visible to the snapshot. A batch is visible if
+ * its transaction had completed as of the snapshot. Once a batch is found that
+ * was published before the snapshot was taken, the batches before it are all
+ * visible too. Returns 0 if this can't be determined, for example, if the
+ * batches have already been overwritten in the change log.
+ *
+ * NOTE: The caller must hold the table's lock.
+ */
+static uint64 get_snapshot_graph_version(graph_version_table *table,
+                                         graph_version_entry *entry,
+                                         Oid graph_oid, uint64 version,
+                                         Snapshot snapshot)
+{
+    uint64 visible_version = version;
+    uint64 oldest;
+    uint64 pos;
+
+    /* the entry may have been released and reused by another graph */
+    if (entry->graph_oid != graph_oid)
+    {
+        return 0;
+    }
+
+    oldest = (table->change_log_next > GRAPH_CHANGE_LOG_SIZE) ?
+             table->change_log_next - GRAPH_CHANGE_LOG_SIZE : 0;
+
+    /* follow the chain of batches back from the version, newest first */
+    for (pos = table->change_log_next;
+         pos > oldest && version != entry->first_version; pos--)
+    {
+        graph_change_record *gcr = NULL;
+
+        gcr = &table->change_log[(pos - 1) % GRAPH_CHANGE_LOG_SIZE];
+
+        if (gcr->graph_oid != graph_oid || !gcr->batch_start ||
+            gcr->to_version != version)
+        {
+            continue;
+        }
+
+        if (TransactionIdPrecedes(XidFromFullTransactionId(gcr->next_xid),
+                                  snapshot->xmax))
+        {
+            return visible_version;
+        }
+
+        /* the snapshot can't see this batch, nor anything after it */
+        if (!TransactionIdIsValid(gcr->xid) ||
+            XidInMVCCSnapshot(gcr->xid, snapshot))
+        {
+            visible_version = gcr->from_version;
+        }
+
+        version = gcr->from_version;
+    }
+
+    /*
+     * Changes committed before the entry was created weren't published. So,
+     * the entry itself needs to predate the snapshot.
+     */
+    if (version == entry->first_version &&
+        TransactionIdPrecedes(XidFromFullTransactionId(entry->first_next_xid),
+                              snapshot->xmax))
+    {
+        return visible_version;
+    }
+
+    return 0;
+}
+
+/*
+ * Helper function to bring a versioned GRAPH global context up to date, by
+ * applying the changes published since its version, instead of reloading the
+ * entire graph. The changes are applied with the active snapshot, and only
+ * those of the batches that snapshot can see. It returns false if that isn't
+ * possible. For example, if the changes have already been overwritten in the
+ * change log, or if one of them can't be applied incrementally. In that case,
+ * the context needs to be reloaded.
+ */
+static bool refresh_GRAPH_global_context(GRAPH_global_context *ggctx)
+{
+    graph_version_table *table = graph_versions;
+    graph_version_entry *entry = ggctx->version_entry;
+    Snapshot snapshot = GetActiveSnapshot();
+    graph_change_record *changes = NULL;
+    MemoryContext scanctx = NULL;
+    uint64 current_version;
+    uint64 latest_version;
+    uint64 target_version;
+    uint64 pos;
+    int num_changes = 0;
+    int max_changes = 0;
+    bool collecting = false;
+    bool reached_target = false;
+    bool reload = false;
+    int i;
+
+    /*
+     * Only versioned contexts, outside of a writing transaction, qualify. For
+     * the same reasons as when the context is built, transaction snapshots
+     * and parallel queries are left out.
+     */
+    if (!age_enable_graph_versioning || ggctx->graph_version == 0 ||
+        IsolationUsesXactSnapshot() || IsInParallelMode() ||
+        list_member_oid(modified_graph_oids, ggctx->graph_oid))
+    {
+        return false;
+    }
+
+    /* a finished prepared transaction leaves a reload batch behind */
+    if (resolve_prepared_graph_changes(entry, ggctx->graph_oid))
+    {
+        return false;
+    }
+
+    LWLockAcquire(&table->lock, LW_SHARED);
+
+    /*
+     * A commit in flight may be visible to our snapshot, without its changes
+     * being in the change log yet.
+     */
+    if (pg_atomic_read_u32(&entry->in_flight) != 0)
+    {
+        LWLockRelease(&table->lock);
+        return false;
+    }
+
+    /* the context will be stamped with the version our snapshot can see */
+    latest_version = pg_atomic_read_u64(&entry->version);
+    target_version = get_snapshot_graph_version(table, entry, ggctx->graph_oid,
+                                                latest_version, snapshot);
+    current_version = ggctx->graph_version;
+    reached_target = (current_version == target_version);
+
+    /*
+     * Follow the chain of batches from our version, oldest first. A batch is
+     * only followed from its first record, so a batch that was partially
+     * overwritten is never applied. The batches our snapshot can't see are
+     * followed, but not applied. They will be applied by a later refresh, as
+     * the context's version won't go past them.
+     */
+    pos = (table->change_log_next > GRAPH_CHANGE_LOG_SIZE) ?
+          table->change_log_next - GRAPH_CHANGE_LOG_SIZE : 0;
+    for (; pos < table->change_log_next && target_version != 0; pos++)
+    {
+        graph_change_record *gcr = NULL;
+
+        gcr = &table->change_log[pos % GRAPH_CHANGE_LOG_SIZE];
+
+        if (gcr->graph_oid != ggctx->graph_oid)
+        {
+            continue;
+        }
+
+        if (gcr->batch_start)
+        {
+            collecting = (gcr->from_version == current_version);
+            if (collecting)
+            {
+                current_version = gcr->to_version;
+                reached_target |= (current_version == target_version);
+                collecting = (TransactionIdIsValid(gcr->xid) &&
+                              !XidInMVCCSnapshot(gcr->xid, snapshot));
+            }
+        }
+
+        if (!collecting)
+        {
+            continue;
+        }
+
+        if (gcr->change_kind == GRAPH_CHANGE_RELOAD)
+        {
+            reload = true;
+            break;
+        }
+
+        /* grow the changes array, if needed */
+        if (num_changes >= max_changes)
+        {
+            max_changes = (max_changes == 0) ? 64 : max_changes * 2;
+            changes = (changes == NULL) ?
+                palloc(sizeof(graph_change_record) * max_changes) :
+                repalloc(changes, sizeof(graph_change_record) * max_changes);
+        }
+        changes[num_changes++] = *gcr;
+    }
+
+    LWLockRelease(&table->lock);
+
+    /* if we couldn't reach the latest version, we need to reload */
+    if (reload || target_version == 0 || !reached_target ||
+        current_version != latest_version)
+    {
+        pfree_if_not_null(changes);
+        return false;
+    }
+
+    /*
+     * Unstamp the context while it is being modified. If there is an error,
+     * it will just be seen as invalid, and reloaded.
+     */
+    ggctx->graph_version = 0;
+
+    /* the scans need their own memory, the context is in TopMemoryContext */
+    scanctx = AllocSetContextCreate(CurrentMemoryContext,
+                                    "GRAPH global context refresh",
+                                    ALLOCSET_DEFAULT_SIZES);
+
+    for (i = 0; i < num_changes; i++)
+    {
+        apply_graph_change(ggctx, &changes[i], scanctx);
+    }
+
+    MemoryContextDelete(scanctx);
+    pfree_if_not_null(changes);
+
+    /* restamp the context */
+    ggctx->graph_version = target_version;
+    ggctx->xmin = snapshot->xmin;
+    ggctx->xmax = snapshot->xmax;
+    ggctx->curcid = snapshot->curcid;
+
+    return true;
+}
+
+/*
+ * Helper function to apply one change to a GRAPH global context. The changes
+ * are applied against the label tables as the active snapshot sees them, so
+ * they need to be idempotent. An entity that no longer exists will be removed
+ * by a later change.
+ */
+static void apply_graph_change(GRAPH_global_context *ggctx,
+                               graph_change_record *gcr,
+                               MemoryContext scanctx)
+{
+    switch (gcr->change_kind)
+    {
+    case GRAPH_CHANGE_INSERT:
+    case GRAPH_CHANGE_UPDATE:
+        if (gcr->label_kind == LABEL_KIND_VERTEX)
+        {
+            upsert_vertex_entry(ggctx, gcr, scanctx);
+        }
+        else
+        {
+            upsert_edge_entry(ggctx, gcr, scanctx);
+        }
+        break;
+    case GRAPH_CHANGE_DELETE:
+        if (gcr->label_kind == LABEL_KIND_VERTEX)
+        {
+            remove_vertex_entry(ggctx, gcr->id);
+        }
+        else
+        {
+            remove_edge_entry(ggctx, gcr->id);
+        }
+        break;
+    default:
+        elog(ERROR, "apply_graph_change: unexpected change kind %d",
+             gcr->change_kind);
+    }
+}
+
+/*
+ * Helper function to fetch the current properties of the entity described by
+ * the graph change. The scan is done in scanctx, which is reset afterwards, and
+ * the properties are copied into the CurrentMemoryContext.
+ */
+static bool fetch_graph_change_properties(graph_change_record *gcr,
+                                          MemoryContext scanctx,
+                                          ItemPointer tid, Datum *properties)
+{
+    MemoryContext oldctx = NULL;
+    bool found = false;
+
+    oldctx = MemoryContextSwitchTo(scanctx);
+    found = fetch_entity_properties(gcr->label_relid, gcr->label_kind, gcr->id,
+                                    gcr->start_id, tid, oldctx, properties);
+    MemoryContextSwitchTo(oldctx);
+    MemoryContextReset(scanctx);
+
+    return found;
+}
+
+/* helper function to insert, or update, a vertex from a graph change */
+static void upsert_vertex_entry(GRAPH_global_context *ggctx,
+                                graph_change_record *gcr,
+                                MemoryContext scanctx)
+{
+    vertex_entry *ve = NULL;
+    ItemPointerData tid;
+    Datum properties;
+
+    /* if it doesn't exist anymore, a later change will remove it */
+    ItemPointerSetInvalid(&tid);
+    if (!fetch_graph_change_properties(gcr, scanctx, &tid, &properties))
+    {
+        return;
+    }
+
+    ve = get_vertex_entry(ggctx, gcr->id);
+    if (ve != NULL)
+    {
+        pfree_if_not_null(DatumGetPointer(ve->vertex_properties));
+        ve->vertex_properties = properties;
+        ve->tid = tid;
+        return;
+    }
+
+    insert_vertex_entry(ggctx, gcr->id, gcr->label_relid, properties, &tid);
+}
+
+/* helper function to insert, or update, an edge from a graph change */
+static void upsert_edge_entry(GRAPH_global_context *ggctx,
+                              graph_change_record *gcr,
+                              MemoryContext scanctx)
+{
+    edge_entry *ee = NULL;
+    ItemPointerData tid;
+    Datum properties;
+
+    /* if it doesn't exist anymore, a later change will remove it */
+    ItemPointerSetInvalid(&tid);
+    if (!fetch_graph_change_properties(gcr, scanctx, &tid, &properties))
+    {
+        return;
+    }
+
+    /* the edge may not be there, so don't use get_edge_entry */
+    ee = (edge_entry *)hash_search(ggctx->edge_hashtable, (void *)&gcr->id,
+                                   HASH_FIND, NULL);
+    if (ee != NULL)
+    {
+        pfree_if_not_null(DatumGetPointer(ee->edge_properties));
+        ee->edge_properties = properties;
+        ee->tid = tid;
+        return;
+    }
+
+    /*
+     * If either vertex is missing, the edge is dangling as of now. Either a
+     * later change will fix it, or a reload would have ignored it too.
+     */
+    if (get_vertex_entry(ggctx, gcr->start_id) == NULL ||
+        get_vertex_entry(ggctx, gcr->end_id) == NULL)
+    {
+        pfree_if_not_null(DatumGetPointer(properties));
+        return;
+    }
+
+    insert_edge_entry(ggctx, gcr->id, properties, gcr->start_id, gcr->end_id,
+                      gcr->label_relid, &tid);
+    insert_vertex_edge(ggctx, gcr->start_id, gcr->end_id, gcr->id, NULL);
+}
+
+/*
+ * Helper function to remove a vertex from a GRAPH global context. Any edges
+ * still attached to it are detached from their other vertices, leaving them
+ * dangling, as a reload would. Note that removing the vertex from the vertices
+ * list needs to walk that list.
+ */
+static void remove_vertex_entry(GRAPH_global_context *ggctx,
+                                graphid vertex_id)
+{
+    vertex_entry *ve = NULL;
+    GraphIdNode *curr = NULL;
+
+    ve = get_vertex_entry(ggctx, vertex_id);
+    if (ve == NULL)
+    {
+        return;
+    }
+
+    /* detach the exiting edges from their end vertices */
+    curr = (ve->edges_out != NULL) ? get_list_head(ve->edges_out) : NULL;
+    while (curr != NULL)
+    {
+        edge_entry *ee = get_edge_entry(ggctx, get_graphid(curr));
+        vertex_entry *other = NULL;
+
+        other = (ee != NULL) ? get_vertex_entry(ggctx, ee->end_vertex_id) :
+                               NULL;
+        if (other != NULL)
+        {
+            remove_graphid(other->edges_in, ee->edge_id);
+        }
+        curr = next_GraphIdNode(curr);
+    }
+
+    /* detach the entering edges from their start vertices */
+    curr = (ve->edges_in != NULL) ? get_list_head(ve->edges_in) : NULL;
+    while (curr != NULL)
+    {
+        edge_entry *ee = get_edge_entry(ggctx, get_graphid(curr));
+        vertex_entry *other = NULL;
+
+        other = (ee != NULL) ? get_vertex_entry(ggctx, ee->start_vertex_id) :
+                               NULL;
+        if (other != NULL)
+        {
+            remove_graphid(other->edges_out, ee->edge_id);
+        }
+        curr = next_GraphIdNode(curr);
+    }
+
+    /* free the vertex's edge lists and properties */
+    free_ListGraphId(ve->edges_in);
+    free_ListGraphId(ve->edges_out);
+    free_ListGraphId(ve->edges_self);
+    pfree_if_not_null(DatumGetPointer(ve->vertex_properties));
+
+    remove_graphid(ggctx->vertices, vertex_id);
+    hash_search(ggctx->vertex_hashtable, (void *)&vertex_id, HASH_REMOVE,
+                NULL);
+    ggctx->num_loaded_vertices--;
+}
+
+/* helper function to remove an edge from a GRAPH global context */
+static void remove_edge_entry(GRAPH_global_context *ggctx, graphid edge_id)
+{
+    edge_entry *ee = NULL;
+    vertex_entry *ve = NULL;
+
+    /* the edge may already be gone, so don't use get_edge_entry */
+    ee = (edge_entry *)hash_search(ggctx->edge_hashtable, (void *)&edge_id,
+                                   HASH_FIND, NULL);
+    if (ee == NULL)
+    {
+        return;
+    }
+
+    /* detach it from its vertices, if they are still there */
+    if (ee->start_vertex_id == ee->end_vertex_id)
+    {
+        ve = get_vertex_entry(ggctx, ee->start_vertex_id);
+        if (ve != NULL)
+        {
+            remove_graphid(ve->edges_self, edge_id);
+        }
+    }
+    else
+    {
+        ve = get_vertex_entry(ggctx, ee->start_vertex_id);
+        if (ve != NULL)
+        {
+            remove_graphid(ve->edges_out, edge_id);
+        }
+        ve = get_vertex_entry(ggctx, ee->end_vertex_id);
+        if (ve != NULL)
+        {
+            remove_graphid(ve->edges_in, edge_id);
+        }
+    }
+
+    pfree_if_not_null(DatumGetPointer(ee->edge_properties));
+
+    hash_search(ggctx->edge_hashtable, (void *)&edge_id, HASH_REMOVE, NULL);
+    ggctx->num_loaded_edges--;
+}
+
+/* helper function to get the graphids of a vertex or an edge tuple */
+static void get_entity_ids(TupleDesc tupdesc, HeapTuple tuple,
+                           char label_kind, graphid *id, graphid *start_id,
+                           graphid *end_id)
+{
+    *id = DatumGetInt64(column_get_datum(tupdesc, tuple, vertex_tuple_id,
+                                         "id", GRAPHIDOID, true));
+    *start_id = 0;
+    *end_id = 0;
+
+    if (label_kind == LABEL_KIND_EDGE)
+    {
+        *start_id = DatumGetInt64(column_get_datum(tupdesc, tuple,
+                                                   edge_tuple_start_id,
+                                                   "start_id", GRAPHIDOID,
+                                                   true));
+        *end_id = DatumGetInt64(column_get_datum(tupdesc, tuple,
+                                                 edge_tuple_end_id, "end_id",
+                                                 GRAPHIDOID, true));
+    }
+}
+
+/*
+ * Helper function to fetch the current properties of a vertex or an edge,
+ * using the active snapshot. If tid is valid, the tuple there is tried first.
+ * Otherwise, or if it isn't the entity anymore, vertices are found through the
+ * id index and edges through the start_id index, when they exist. On success,
+ * tid is set to the tuple found. The properties are detoasted and copied into
+ * resultctx, the rest of the work is done in the CurrentMemoryContext. It
+ * returns false if the entity doesn't exist.
+ */
+static bool fetch_entity_properties(Oid label_relid, char label_kind,
+                                    graphid id, graphid start_id,
+                                    ItemPointer tid, MemoryContext resultctx,
+                                    Datum *properties)
+{
+    Relation rel = NULL;
+    SysScanDesc scan_desc = NULL;
+    ScanKeyData scan_keys[1];
+    TupleDesc tupdesc = NULL;
+    HeapTuple tuple = NULL;
+    Oid index_oid = InvalidOid;
+    AttrNumber attnum;
+    AttrNumber properties_attnum;
+    bool found = false;
+
+    /* the label may have been dropped since */
+    rel = try_table_open(label_relid, AccessShareLock);
+    if (rel == NULL)
+    {
+        return false;
+    }
+
+    tupdesc = RelationGetDescr(rel);
+    properties_attnum = (label_kind == LABEL_KIND_VERTEX) ?
+                        vertex_tuple_properties : edge_tuple_properties;
+
+    /* try the tuple we already know about first */
+    if (tid != NULL && ItemPointerIsValid(tid))
+    {
+        HeapTupleData tuple_data;
+        Buffer buffer;
+
+        tuple_data.t_self = *tid;
+        if (heap_fetch(rel, GetActiveSnapshot(), &tuple_data, &buffer, false))
+        {
+            graphid tuple_id;
+            graphid tuple_start_id;
+            graphid tuple_end_id;
+
+            get_entity_ids(tupdesc, &tuple_data, label_kind, &tuple_id,
+                           &tuple_start_id, &tuple_end_id);
+            if (tuple_id == id)
+            {
+                Datum props = column_get_datum(tupdesc, &tuple_data,
+                                               properties_attnum, "properties",
+                                               AGTYPEOID, true);
+
+                *properties = copy_entity_properties(props, resultctx);
+                found = true;
+            }
+            ReleaseBuffer(buffer);
+        }
+
+        if (found)
+        {
+            table_close(rel, AccessShareLock);
+            return true;
+        }
+    }
+
+    /* vertices are keyed by id, edges by start_id */
+    attnum = (label_kind == LABEL_KIND_VERTEX) ?
+             Anum_ag_label_vertex_table_id : Anum_ag_label_edge_table_start_id;
+    ScanKeyInit(&scan_keys[0], attnum, BTEqualStrategyNumber, F_GRAPHIDEQ,
+                GRAPHID_GET_DATUM((label_kind == LABEL_KIND_VERTEX) ?
+                                  id : start_id));
+
+    /* use a btree index on that column, if there is one */
+    index_oid = get_label_column_index(rel, attnum);
+
+    scan_desc = systable_beginscan(rel, index_oid, OidIsValid(index_oid),
+                                   GetActiveSnapshot(), 1, scan_keys);
+
+    while ((tuple = systable_getnext(scan_desc)) != NULL)
+    {
+        graphid tuple_id;
+        graphid tuple_start_id;
+        graphid tuple_end_id;
+        Datum props;
+
+        get_entity_ids(tupdesc, tuple, label_kind, &tuple_id, &tuple_start_id,
+                       &tuple_end_id);
+        if (tuple_id != id)
+        {
+            continue;
+        }
+
+        props = column_get_datum(tupdesc, tuple, properties_attnum,
+                                 "properties", AGTYPEOID, true);
+        *properties = copy_entity_properties(props, resultctx);
+        if (tid != NULL)
+        {
+            *tid = tuple->t_self;
+        }
+
+        found = true;
+        break;
+    }
+
+    systable_endscan(scan_desc);
+    table_close(rel, AccessShareLock);
+
+    return found;
+}
+
+/*
+ * Helper function to copy a properties datum into resultctx. The copy is
+ * detoasted, so it doesn't depend on the label table anymore.
+ */
+static Datum copy_entity_properties(Datum properties, MemoryContext resultctx)
+{
+    MemoryContext oldctx = MemoryContextSwitchTo(resultctx);
+    Datum copy;
+
+    copy = PointerGetDatum(PG_DETOAST_DATUM_COPY(properties));
+    MemoryContextSwitchTo(oldctx);
+
+    return copy;
+}
+
+/*
+ * Helper function to fetch the properties of a vertex or an edge that were left
+ * out by a lazy load. They are kept with the GRAPH global contexts, in the
+ * TopMemoryContext, so they are only fetched once.
+ */
+static Datum fetch_lazy_properties(Oid label_relid, char label_kind,
+                                   graphid id, graphid start_id,
+                                   ItemPointer tid)
 {
-    /* head of the list */
-    GRAPH_global_context *contexts;
-
-    /* mutex to protect the list */
-    pthread_mutex_t mutex_lock;
-} GRAPH_global_context_container;
+    Datum properties;
 
-/* global variable to hold the per process GRAPH global contexts */
-static GRAPH_global_context_container global_graph_contexts_container = {0};
+    if (!fetch_entity_properties(label_relid, label_kind, id, start_id, tid,
+                                 TopMemoryContext, &properties))
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_DATA_EXCEPTION),
+                 errmsg("%s: [id: %ld, label oid: %d] properties not found",
+                        (label_kind == LABEL_KIND_VERTEX) ? "vertex" : "edge",
+                        id, label_relid)));
+    }
 
-/* declarations */
-/* GRAPH global context functions */
-static bool free_specific_GRAPH_global_context(GRAPH_global_context *ggctx);
-static bool delete_specific_GRAPH_global_contexts(char *graph_name);
-static bool delete_GRAPH_global_contexts(void);
-static void create_GRAPH_global_hashtables(GRAPH_global_context *ggctx);
-static void load_GRAPH_global_hashtables(GRAPH_global_context *ggctx);
-static void load_vertex_hashtable(GRAPH_global_context *ggctx);
-static void load_edge_hashtable(GRAPH_global_context *ggctx);
-static void freeze_GRAPH_global_hashtables(GRAPH_global_context *ggctx);
-static List *get_ag_labels_names(Snapshot snapshot, Oid graph_oid,
-                                 char label_type);
-static bool insert_edge_entry(GRAPH_global_context *ggctx, graphid edge_id,
-                              Datum edge_properties, graphid start_vertex_id,
-                              graphid end_vertex_id, Oid edge_label_table_oid);
-static bool insert_vertex_edge(GRAPH_global_context *ggctx,
-                               graphid start_vertex_id, graphid end_vertex_id,
-                               graphid edge_id, char *edge_label_name);
-static bool insert_vertex_entry(GRAPH_global_context *ggctx, graphid vertex_id,
-                                Oid vertex_label_table_oid,
-                                Datum vertex_properties);
-/* definitions */
+    return properties;
+}
 
 /*
  * Helper function to determine validity of the passed GRAPH_global_context.
  * This is based off of the current active snapshot, to see if the graph could
- * have been modified. Ideally, we should find a way to more accurately know
- * whether the particular graph was modified.
+ * have been modified. If the context was built with a shared graph version,
+ * it also stays valid across snapshots, for as long as the graph's version
+ * hasn't moved and the current transaction hasn't modified the graph.
  */
 bool is_ggctx_invalid(GRAPH_global_context *ggctx)
 {
     Snapshot snap = GetActiveSnapshot();
+    uint64 version = 0;
+
+    /*
+     * If the transaction ids (xmin or xmax) or currentCommandId (curcid) are
+     * the same, then the graph can't have been updated. This also keeps the
+     * context stable for the duration of a command, as it may be in use.
+     */
+    if (ggctx->xmin == snap->xmin &&
+        ggctx->xmax == snap->xmax &&
+        ggctx->curcid == snap->curcid)
+    {
+        return false;
+    }
+
+    /* otherwise, without a graph version, the context is no longer valid */
+    if (!age_enable_graph_versioning || ggctx->graph_version == 0 ||
+        IsolationUsesXactSnapshot() ||
+        list_member_oid(modified_graph_oids, ggctx->graph_oid))
+    {
+        return true;
+    }
 
     /*
-     * If the transaction ids (xmin or xmax) or currentCommandId (curcid) have
-     * changed, then we have a graph that was updated. This means that the
-     * global context for this graph is no longer valid.
+     * A transaction that has committed, but not yet published its changes,
+     * may be visible to this snapshot without having moved the version. The
+     * same goes for a prepared transaction.
      */
-    return (ggctx->xmin != snap->xmin ||
-            ggctx->xmax != snap->xmax ||
-            ggctx->curcid != snap->curcid);
+    if (pg_atomic_read_u32(&ggctx->version_entry->in_flight) != 0 ||
+        has_prepared_graph_changes(ggctx->version_entry))
+    {
+        return true;
+    }
+    pg_read_barrier();
+
+    version = pg_atomic_read_u64(&ggctx->version_entry->version);
+    if (ggctx->graph_version != version)
+    {
+        return true;
+    }
 
+    /* the graph is unchanged, so move the context forward to this snapshot */
+    ggctx->xmin = snap->xmin;
+    ggctx->xmax = snap->xmax;
+    ggctx->curcid = snap->curcid;
+
+    return false;
 }
+
 /*
  * Helper function to create the global vertex and edge hashtables. One
  * hashtable will hold the vertex, its edges (both incoming and exiting) as a
@@ -252,7 +1954,8 @@ static List *get_ag_labels_names(Snapshot snapshot, Oid graph_oid,
  */
 static bool insert_edge_entry(GRAPH_global_context *ggctx, graphid edge_id,
                               Datum edge_properties, graphid start_vertex_id,
-                              graphid end_vertex_id, Oid edge_label_table_oid)
+                              graphid end_vertex_id, Oid edge_label_table_oid,
+                              ItemPointer tid)
 {
     edge_entry *ee = NULL;
     bool found = false;
@@ -301,9 +2004,15 @@ static bool insert_edge_entry(GRAPH_global_context *ggctx, graphid edge_id,
     ee->start_vertex_id = start_vertex_id;
     ee->end_vertex_id = end_vertex_id;
     ee->edge_label_table_oid = edge_label_table_oid;
-
-    /* we also need to store the edge id for clean up of edge property datums */
-    ggctx->edges = append_graphid(ggctx->edges, edge_id);
+    /* set the tuple it came from, if known, for fetching the properties */
+    if (tid != NULL)
+    {
+        ee->tid = *tid;
+    }
+    else
+    {
+        ItemPointerSetInvalid(&ee->tid);
+    }
 
     /* increment the number of loaded edges */
     ggctx->num_loaded_edges++;
@@ -317,7 +2026,7 @@ static bool insert_edge_entry(GRAPH_global_context *ggctx, graphid edge_id,
  */
 static bool insert_vertex_entry(GRAPH_global_context *ggctx, graphid vertex_id,
                                 Oid vertex_label_table_oid,
-                                Datum vertex_properties)
+                                Datum vertex_properties, ItemPointer tid)
 {
     vertex_entry *ve = NULL;
     bool found = false;
@@ -361,10 +2070,21 @@ static bool insert_vertex_entry(GRAPH_global_context *ggctx, graphid vertex_id,
     ve->vertex_label_table_oid = vertex_label_table_oid;
     /* set the datum vertex properties */
     ve->vertex_properties = vertex_properties;
+    /* set the tuple it came from, if known, for fetching the properties */
+    if (tid != NULL)
+    {
+        ve->tid = *tid;
+    }
+    else
+    {
+        ItemPointerSetInvalid(&ve->tid);
+    }
     /* set the NIL edge list */
     ve->edges_in = NULL;
     ve->edges_out = NULL;
     ve->edges_self = NULL;
+    /* it isn't in the CSR arrays until they are built */
+    ve->csr_index = -1;
 
     /* we also need to store the vertex id for clean up of vertex lists */
     ggctx->vertices = append_graphid(ggctx->vertices, vertex_id);
@@ -522,16 +2242,25 @@ static void load_vertex_hashtable(GRAPH_global_context *ggctx)
             /* get the vertex id */
             vertex_id = DatumGetInt64(column_get_datum(tupdesc, tuple, 0, "id",
                                                        GRAPHIDOID, true));
-            /* get the vertex properties datum */
-            vertex_properties = column_get_datum(tupdesc, tuple, 1,
-                                                 "properties", AGTYPEOID, true);
-            /* we need to make a copy of the properties datum */
-            vertex_properties = datumCopy(vertex_properties, false, -1);
+            /* lazy loads leave the properties to be fetched when used */
+            if (age_enable_lazy_graph_properties)
+            {
+                vertex_properties = (Datum) 0;
+            }
+            else
+            {
+                /* get the vertex properties datum */
+                vertex_properties = column_get_datum(tupdesc, tuple, 1,
+                                                     "properties", AGTYPEOID,
+                                                     true);
+                /* we need to make a copy of the properties datum */
+                vertex_properties = datumCopy(vertex_properties, false, -1);
+            }
 
             /* insert vertex into vertex hashtable */
             inserted = insert_vertex_entry(ggctx, vertex_id,
                                            vertex_label_table_oid,
-                                           vertex_properties);
+                                           vertex_properties, &tuple->t_self);
 
             /* warn if there is a duplicate */
             if (!inserted)
@@ -554,15 +2283,407 @@ static void load_vertex_hashtable(GRAPH_global_context *ggctx)
  */
 static void load_GRAPH_global_hashtables(GRAPH_global_context *ggctx)
 {
+    bool use_workers = false;
+
     /* initialize statistics */
     ggctx->num_loaded_vertices = 0;
     ggctx->num_loaded_edges = 0;
 
-    /* insert all of our vertices */
-    load_vertex_hashtable(ggctx);
+    /* workers can't launch workers of their own */
+    use_workers = (age_global_graph_load_workers > 0 && !IsInParallelMode());
+
+    /*
+     * Insert all of our vertices, then all of our edges. If the workers can't
+     * be launched, fall back to loading them ourselves.
+     */
+    if (!use_workers || !parallel_load_labels(ggctx, LABEL_TYPE_VERTEX))
+    {
+        load_vertex_hashtable(ggctx);
+    }
+
+    if (!use_workers || !parallel_load_labels(ggctx, LABEL_TYPE_EDGE))
+    {
+        load_edge_hashtable(ggctx);
+    }
+}
+
+/*
+ * Helper function to load the vertex, or edge, label tables of a graph with
+ * parallel workers. The hashtables and edge lists are built with pointers into
+ * this backend's memory, so they can't be built by the workers. Instead, the
+ * workers scan the label tables and send the entities to us, through a message
+ * queue per worker, and we insert them. It returns false, having loaded
+ * nothing, if no workers could be launched.
+ *
+ * NOTE: The order in which the entities are loaded isn't deterministic.
+ */
+static bool parallel_load_labels(GRAPH_global_context *ggctx,
+                                 char label_type)
+{
+    ParallelContext *pcxt = NULL;
+    graph_load_shared *shared = NULL;
+    shm_mq_handle **mqhs = NULL;
+    List *label_names = NIL;
+    Oid *label_relids = NULL;
+    char **label_name_array = NULL;
+    char *queues = NULL;
+    bool *detached = NULL;
+    Oid graph_namespace_oid;
+    Size shared_size;
+    ListCell *lc;
+    int num_labels;
+    int num_workers;
+    int num_active;
+    int i;
+
+    /* get the label tables to load */
+    graph_namespace_oid = get_namespace_oid(ggctx->graph_name, false);
+    label_names = get_ag_labels_names(GetActiveSnapshot(), ggctx->graph_oid,
+                                      label_type);
+    num_labels = list_length(label_names);
+    if (num_labels == 0)
+    {
+        return true;
+    }
+
+    label_relids = palloc(sizeof(Oid) * num_labels);
+    label_name_array = palloc(sizeof(char *) * num_labels);
+    i = 0;
+    foreach (lc, label_names)
+    {
+        label_name_array[i] = lfirst(lc);
+        label_relids[i] = get_relname_relid(label_name_array[i],
+                                            graph_namespace_oid);
+        i++;
+    }
+
+    /* there is no point in having more workers than label tables */
+    num_workers = Min(age_global_graph_load_workers, num_labels);
+
+    EnterParallelMode();
+    pcxt = CreateParallelContext("age", "age_global_graph_load_main",
+                                 num_workers);
+
+    shared_size = add_size(offsetof(graph_load_shared, label_relids),
+                           mul_size(sizeof(Oid), num_labels));
+    shm_toc_estimate_chunk(&pcxt->estimator, shared_size);
+    shm_toc_estimate_chunk(&pcxt->estimator,
+                           mul_size(GRAPH_LOAD_QUEUE_SIZE, num_workers));
+    shm_toc_estimate_keys(&pcxt->estimator, 2);
+
+    InitializeParallelDSM(pcxt);
+
+    /* without a DSM segment, there won't be any workers */
+    if (pcxt->seg == NULL)
+    {
+        DestroyParallelContext(pcxt);
+        ExitParallelMode();
+        pfree(label_relids);
+        pfree(label_name_array);
+        return false;
+    }
+
+    /* set up the shared state */
+    shared = shm_toc_allocate(pcxt->toc, shared_size);
+    shared->label_type = label_type;
+    shared->lazy_properties = age_enable_lazy_graph_properties;
+    shared->num_labels = num_labels;
+    pg_atomic_init_u32(&shared->next_label, 0);
+    memcpy(shared->label_relids, label_relids, sizeof(Oid) * num_labels);
+    shm_toc_insert(pcxt->toc, GRAPH_LOAD_KEY_SHARED, shared);
+
+    /* set up a message queue per worker, we are the receiver */
+    queues = shm_toc_allocate(pcxt->toc,
+                              mul_size(GRAPH_LOAD_QUEUE_SIZE, num_workers));
+    for (i = 0; i < num_workers; i++)
+    {
+        shm_mq *mq = shm_mq_create(queues + (i * GRAPH_LOAD_QUEUE_SIZE),
+                                   GRAPH_LOAD_QUEUE_SIZE);
+
+        shm_mq_set_receiver(mq, MyProc);
+    }
+    shm_toc_insert(pcxt->toc, GRAPH_LOAD_KEY_QUEUES, queues);
+
+    LaunchParallelWorkers(pcxt);
+
+    /* if no workers were launched, nothing was claimed either */
+    if (pcxt->nworkers_launched == 0)
+    {
+        WaitForParallelWorkersToFinish(pcxt);
+        DestroyParallelContext(pcxt);
+        ExitParallelMode();
+        pfree(label_relids);
+        pfree(label_name_array);
+        return false;
+    }
+
+    /* attach to the queues of the launched workers */
+    num_active = pcxt->nworkers_launched;
+    mqhs = palloc(sizeof(shm_mq_handle *) * num_active);
+    detached = palloc0(sizeof(bool) * num_active);
+    for (i = 0; i < num_active; i++)
+    {
+        shm_mq *mq = (shm_mq *)(queues + (i * GRAPH_LOAD_QUEUE_SIZE));
+
+        mqhs[i] = shm_mq_attach(mq, pcxt->seg, pcxt->worker[i].bgwhandle);
+    }
+
+    /* insert the batches as they come, until all of the workers are done */
+    while (num_active > 0)
+    {
+        bool received = false;
+
+        for (i = 0; i < pcxt->nworkers_launched; i++)
+        {
+            shm_mq_result result;
+            Size nbytes;
+            void *data;
+
+            if (detached[i])
+            {
+                continue;
+            }
+
+            result = shm_mq_receive(mqhs[i], &nbytes, &data, true);
+            if (result == SHM_MQ_WOULD_BLOCK)
+            {
+                continue;
+            }
+            if (result == SHM_MQ_DETACHED)
+            {
+                detached[i] = true;
+                num_active--;
+                continue;
+            }
+
+            insert_loaded_entities(ggctx, label_type, label_relids,
+                                   label_name_array, data, nbytes);
+            received = true;
+        }
+
+        /* wait for more, worker errors are reported from in here too */
+        if (!received && num_active > 0)
+        {
+            (void) WaitLatch(MyLatch, WL_LATCH_SET | WL_EXIT_ON_PM_DEATH, -1,
+                             WAIT_EVENT_MESSAGE_QUEUE_RECEIVE);
+            ResetLatch(MyLatch);
+            CHECK_FOR_INTERRUPTS();
+        }
+    }
+
+    /* this will also report any error from the workers */
+    WaitForParallelWorkersToFinish(pcxt);
+
+    for (i = 0; i < pcxt->nworkers_launched; i++)
+    {
+        shm_mq_detach(mqhs[i]);
+    }
+
+    DestroyParallelContext(pcxt);
+    ExitParallelMode();
+
+    pfree(mqhs);
+    pfree(detached);
+    pfree(label_relids);
+    pfree(label_name_array);
+
+    return true;
+}
+
+/*
+ * Helper function to insert a batch of vertices, or edges, sent by a parallel
+ * load worker. The properties are copied into the CurrentMemoryContext.
+ */
+static void insert_loaded_entities(GRAPH_global_context *ggctx,
+                                   char label_type, Oid *label_relids,
+                                   char **label_names, char *data,
+                                   Size nbytes)
+{
+    Size offset = 0;
+
+    while (offset < nbytes)
+    {
+        graph_load_record record;
+        Datum properties = (Datum) 0;
+        bool inserted = false;
+
+        /* the batch isn't aligned for us, so copy the record out */
+        memcpy(&record, data + offset, sizeof(graph_load_record));
+        offset += sizeof(graph_load_record);
+
+        if (record.properties_size > 0)
+        {
+            char *props = palloc(record.properties_size);
+
+            memcpy(props, data + offset, record.properties_size);
+            offset += record.properties_size;
+            properties = PointerGetDatum(props);
+        }
+
+        if (label_type == LABEL_TYPE_VERTEX)
+        {
+            inserted = insert_vertex_entry(ggctx, record.id,
+                                           label_relids[record.label_index],
+                                           properties, &record.tid);
+            if (!inserted)
+            {
+                 pfree_if_not_null(DatumGetPointer(properties));
+                 ereport(WARNING,
+                         (errcode(ERRCODE_DATA_EXCEPTION),
+                          errmsg("ignored duplicate vertex")));
+            }
+            continue;
+        }
+
+        inserted = insert_edge_entry(ggctx, record.id, properties,
+                                     record.start_id, record.end_id,
+                                     label_relids[record.label_index],
+                                     &record.tid);
+        if (!inserted)
+        {
+             pfree_if_not_null(DatumGetPointer(properties));
+             ereport(WARNING,
+                     (errcode(ERRCODE_DATA_EXCEPTION),
+                      errmsg("ignored duplicate edge")));
+        }
+
+        inserted = insert_vertex_edge(ggctx, record.start_id, record.end_id,
+                                      record.id,
+                                      label_names[record.label_index]);
+        if (!inserted)
+        {
+             ereport(WARNING,
+                     (errcode(ERRCODE_DATA_EXCEPTION),
+                      errmsg("ignored malformed or dangling edge")));
+        }
+    }
+}
+
+/*
+ * Helper function for the parallel load workers, to scan a label table and
+ * send its entities to the leader, in batches.
+ */
+static void send_label_entities(graph_load_shared *shared, int label_index,
+                                shm_mq_handle *mqh, StringInfo buf)
+{
+    Relation label_relation;
+    TableScanDesc scan_desc;
+    TupleDesc tupdesc;
+    HeapTuple tuple;
+    AttrNumber properties_attnum;
+    int natts;
+
+    /* open the relation (table) and begin the scan */
+    label_relation = table_open(shared->label_relids[label_index], ShareLock);
+    scan_desc = table_beginscan(label_relation, GetActiveSnapshot(), 0, NULL);
+    tupdesc = RelationGetDescr(label_relation);
+
+    /* bail if the number of columns differs */
+    natts = (shared->label_type == LABEL_TYPE_VERTEX) ? 2 : 4;
+    if (tupdesc->natts != natts)
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_UNDEFINED_TABLE),
+                 errmsg("Invalid number of attributes for %s",
+                        RelationGetRelationName(label_relation))));
+    }
+    properties_attnum = (shared->label_type == LABEL_TYPE_VERTEX) ?
+                        vertex_tuple_properties : edge_tuple_properties;
+
+    while ((tuple = heap_getnext(scan_desc, ForwardScanDirection)) != NULL)
+    {
+        graph_load_record record;
+        struct varlena *properties = NULL;
+        Datum props = (Datum) 0;
+
+        get_entity_ids(tupdesc, tuple, shared->label_type, &record.id,
+                       &record.start_id, &record.end_id);
+        record.tid = tuple->t_self;
+        record.label_index = label_index;
+        record.properties_size = 0;
+
+        /* the properties need to be sent whole, they won't be detoasted */
+        if (!shared->lazy_properties)
+        {
+            props = column_get_datum(tupdesc, tuple, properties_attnum,
+                                     "properties", AGTYPEOID, true);
+            properties = PG_DETOAST_DATUM(props);
+            record.properties_size = VARSIZE(properties);
+        }
+
+        appendBinaryStringInfo(buf, (char *)&record,
+                               sizeof(graph_load_record));
+        if (properties != NULL)
+        {
+            appendBinaryStringInfo(buf, (char *)properties,
+                                   record.properties_size);
+
+            /* free it if it was detoasted */
+            if ((Pointer)properties != DatumGetPointer(props))
+            {
+                pfree(properties);
+            }
+        }
+
+        /* send full batches */
+        if (buf->len >= GRAPH_LOAD_BATCH_SIZE)
+        {
+            if (shm_mq_send(mqh, buf->len, buf->data, false, true) !=
+                SHM_MQ_SUCCESS)
+            {
+                /* the leader is gone, there is no point in going on */
+                break;
+            }
+            resetStringInfo(buf);
+        }
+    }
+
+    /* end the scan and close the relation */
+    table_endscan(scan_desc);
+    table_close(label_relation, ShareLock);
+}
+
+/*
+ * Entry point of the parallel load workers. Each worker claims label tables
+ * until there are none left, and sends their entities to the leader.
+ */
+void age_global_graph_load_main(dsm_segment *seg, shm_toc *toc)
+{
+    graph_load_shared *shared = NULL;
+    shm_mq_handle *mqh = NULL;
+    shm_mq *mq = NULL;
+    char *queues = NULL;
+    StringInfoData buf;
+
+    shared = shm_toc_lookup(toc, GRAPH_LOAD_KEY_SHARED, false);
+    queues = shm_toc_lookup(toc, GRAPH_LOAD_KEY_QUEUES, false);
+
+    /* attach to our queue as its sender */
+    mq = (shm_mq *)(queues + (ParallelWorkerNumber * GRAPH_LOAD_QUEUE_SIZE));
+    shm_mq_set_sender(mq, MyProc);
+    mqh = shm_mq_attach(mq, seg, NULL);
+
+    initStringInfo(&buf);
+
+    for (;;)
+    {
+        uint32 label_index = pg_atomic_fetch_add_u32(&shared->next_label, 1);
+
+        if (label_index >= shared->num_labels)
+        {
+            break;
+        }
+
+        send_label_entities(shared, label_index, mqh, &buf);
+    }
 
-    /* insert all of our edges */
-    load_edge_hashtable(ggctx);
+    /* send what is left */
+    if (buf.len > 0)
+    {
+        (void) shm_mq_send(mqh, buf.len, buf.data, false, true);
+    }
+
+    shm_mq_detach(mqh);
 }
 
 /*
@@ -643,18 +2764,27 @@ static void load_edge_hashtable(GRAPH_global_context *ggctx)
                                                                 2, "end_id",
                                                                 GRAPHIDOID,
                                                                 true));
-            /* get the edge properties datum */
-            edge_properties = column_get_datum(tupdesc, tuple, 3, "properties",
-                                               AGTYPEOID, true);
-
-            /* we need to make a copy of the properties datum */
-            edge_properties = datumCopy(edge_properties, false, -1);
+            /* lazy loads leave the properties to be fetched when used */
+            if (age_enable_lazy_graph_properties)
+            {
+                edge_properties = (Datum) 0;
+            }
+            else
+            {
+                /* get the edge properties datum */
+                edge_properties = column_get_datum(tupdesc, tuple, 3,
+                                                   "properties", AGTYPEOID,
+                                                   true);
+                /* we need to make a copy of the properties datum */
+                edge_properties = datumCopy(edge_properties, false, -1);
+            }
 
             /* insert edge into edge hashtable */
             inserted = insert_edge_entry(ggctx, edge_id, edge_properties,
                                          edge_vertex_start_id,
                                          edge_vertex_end_id,
-                                         edge_label_table_oid);
+                                         edge_label_table_oid,
+                                         &tuple->t_self);
 
             /* warn if there is a duplicate */
             if (!inserted)
@@ -676,21 +2806,155 @@ static void load_edge_hashtable(GRAPH_global_context *ggctx)
             }
         }
 
-        /* end the scan and close the relation */
-        table_endscan(scan_desc);
-        table_close(graph_edge_label, ShareLock);
+        /* end the scan and close the relation */
+        table_endscan(scan_desc);
+        table_close(graph_edge_label, ShareLock);
+    }
+}
+
+/*
+ * Helper function to freeze the GRAPH global hashtables from additional
+ * inserts. This may, or may not, be useful. Currently, these hashtables are
+ * only seen by the creating process and only for reading.
+ */
+static void freeze_GRAPH_global_hashtables(GRAPH_global_context *ggctx)
+{
+    hash_freeze(ggctx->vertex_hashtable);
+    hash_freeze(ggctx->edge_hashtable);
+}
+
+/*
+ * Helper function to build the CSR adjacency of a frozen GRAPH global context.
+ * The vertices are indexed in the order of the vertices list. Each edge is
+ * stored along with the vertex on its other end, and its label, so that they
+ * can be used without an edge hashtable lookup.
+ *
+ * NOTE: The context must not be modified afterwards.
+ */
+static void build_GRAPH_global_csr(GRAPH_global_context *ggctx)
+{
+    GRAPH_global_csr *csr = NULL;
+    GraphIdNode *curr_vertex = NULL;
+    int64 num_out = 0;
+    int64 num_in = 0;
+    int64 num_self = 0;
+    int64 index = 0;
+
+    csr = palloc0(sizeof(GRAPH_global_csr));
+    csr->num_vertices = get_list_size(ggctx->vertices);
+
+    /* index the vertices and count their edges */
+    curr_vertex = (ggctx->vertices != NULL) ? get_list_head(ggctx->vertices) :
+                                              NULL;
+    while (curr_vertex != NULL)
+    {
+        vertex_entry *ve = get_vertex_entry(ggctx, get_graphid(curr_vertex));
+
+        ve->csr_index = index++;
+        num_out += get_list_size(ve->edges_out);
+        num_in += get_list_size(ve->edges_in);
+        num_self += get_list_size(ve->edges_self);
+
+        curr_vertex = next_GraphIdNode(curr_vertex);
+    }
+
+    /* the arrays can easily go past 1GB on large graphs */
+    csr->out_offsets = MemoryContextAllocHuge(CurrentMemoryContext,
+                                              sizeof(int64) *
+                                              (csr->num_vertices + 1));
+    csr->in_offsets = MemoryContextAllocHuge(CurrentMemoryContext,
+                                             sizeof(int64) *
+                                             (csr->num_vertices + 1));
+    csr->self_offsets = MemoryContextAllocHuge(CurrentMemoryContext,
+                                               sizeof(int64) *
+                                               (csr->num_vertices + 1));
+    csr->out_edges = MemoryContextAllocHuge(CurrentMemoryContext,
+                                            sizeof(graph_csr_edge) *
+                                            Max(num_out, 1));
+    csr->in_edges = MemoryContextAllocHuge(CurrentMemoryContext,
+                                           sizeof(graph_csr_edge) *
+                                           Max(num_in, 1));
+    csr->self_edges = MemoryContextAllocHuge(CurrentMemoryContext,
+                                             sizeof(graph_csr_edge) *
+                                             Max(num_self, 1));
+
+    /* fill in the offsets and the edges, in the vertex index order */
+    num_out = 0;
+    num_in = 0;
+    num_self = 0;
+    index = 0;
+    curr_vertex = (ggctx->vertices != NULL) ? get_list_head(ggctx->vertices) :
+                                              NULL;
+    while (curr_vertex != NULL)
+    {
+        graphid vertex_id = get_graphid(curr_vertex);
+        vertex_entry *ve = get_vertex_entry(ggctx, vertex_id);
+
+        csr->out_offsets[index] = num_out;
+        csr->in_offsets[index] = num_in;
+        csr->self_offsets[index] = num_self;
+
+        num_out = fill_GRAPH_global_csr_edges(ggctx, ve->edges_out, vertex_id,
+                                              csr->out_edges, num_out);
+        num_in = fill_GRAPH_global_csr_edges(ggctx, ve->edges_in, vertex_id,
+                                             csr->in_edges, num_in);
+        num_self = fill_GRAPH_global_csr_edges(ggctx, ve->edges_self,
+                                               vertex_id, csr->self_edges,
+                                               num_self);
+
+        index++;
+        curr_vertex = next_GraphIdNode(curr_vertex);
     }
+    csr->out_offsets[index] = num_out;
+    csr->in_offsets[index] = num_in;
+    csr->self_offsets[index] = num_self;
+
+    ggctx->csr = csr;
 }
 
 /*
- * Helper function to freeze the GRAPH global hashtables from additional
- * inserts. This may, or may not, be useful. Currently, these hashtables are
- * only seen by the creating process and only for reading.
+ * Helper function to copy one of a vertex's edge lists into a CSR edge array,
+ * starting at offset. It returns the offset past the last edge copied.
  */
-static void freeze_GRAPH_global_hashtables(GRAPH_global_context *ggctx)
+static int64 fill_GRAPH_global_csr_edges(GRAPH_global_context *ggctx,
+                                         ListGraphId *edges, graphid vertex_id,
+                                         graph_csr_edge *csr_edges,
+                                         int64 offset)
 {
-    hash_freeze(ggctx->vertex_hashtable);
-    hash_freeze(ggctx->edge_hashtable);
+    GraphIdNode *curr_edge = NULL;
+
+    curr_edge = (edges != NULL) ? get_list_head(edges) : NULL;
+    while (curr_edge != NULL)
+    {
+        edge_entry *ee = get_edge_entry(ggctx, get_graphid(curr_edge));
+        graph_csr_edge *ce = &csr_edges[offset++];
+
+        ce->edge_id = ee->edge_id;
+        ce->vertex_id = (ee->start_vertex_id == vertex_id) ?
+                        ee->end_vertex_id : ee->start_vertex_id;
+        ce->edge_label_table_oid = ee->edge_label_table_oid;
+
+        curr_edge = next_GraphIdNode(curr_edge);
+    }
+
+    return offset;
+}
+
+/* helper function to free the CSR adjacency of a GRAPH global context */
+static void free_GRAPH_global_csr(GRAPH_global_csr *csr)
+{
+    if (csr == NULL)
+    {
+        return;
+    }
+
+    pfree(csr->out_offsets);
+    pfree(csr->in_offsets);
+    pfree(csr->self_offsets);
+    pfree(csr->out_edges);
+    pfree(csr->in_edges);
+    pfree(csr->self_edges);
+    pfree(csr);
 }
 
 /*
@@ -700,7 +2964,8 @@ static void freeze_GRAPH_global_hashtables(GRAPH_global_context *ggctx)
 static bool free_specific_GRAPH_global_context(GRAPH_global_context *ggctx)
 {
     GraphIdNode *curr_vertex = NULL;
-    GraphIdNode *curr_edge = NULL;
+    HASH_SEQ_STATUS edge_status;
+    edge_entry *curr_edge = NULL;
 
     /* don't do anything if NULL */
     if (ggctx == NULL)
@@ -757,46 +3022,22 @@ static bool free_specific_GRAPH_global_context(GRAPH_global_context *ggctx)
         curr_vertex = next_vertex;
     }
 
-    /* free the edge properties, starting with the head */
-    curr_edge = peek_stack_head(ggctx->edges);
-    while (curr_edge != NULL)
+    /* free the edge properties, edges may be removed, so walk the hashtable */
+    hash_seq_init(&edge_status, ggctx->edge_hashtable);
+    while ((curr_edge = hash_seq_search(&edge_status)) != NULL)
     {
-        GraphIdNode *next_edge = NULL;
-        edge_entry *value = NULL;
-        bool found = false;
-        graphid edge_id;
-
-        /* get the next edge in the list, if any */
-        next_edge = next_GraphIdNode(curr_edge);
-
-        /* get the current edge id */
-        edge_id = get_graphid(curr_edge);
-
-        /* retrieve the edge entry */
-        value = (edge_entry *)hash_search(ggctx->edge_hashtable,
-                                          (void *)&edge_id, HASH_FIND,
-                                          &found);
-        /* this is bad if it isn't found, but leave that to the caller */
-        if (found == false)
-        {
-            return false;
-        }
-
         /* free the edge's datumCopy properties */
-        pfree_if_not_null(DatumGetPointer(value->edge_properties));
-        value->edge_properties = 0;
-
-        /* move to the next edge */
-        curr_edge = next_edge;
+        pfree_if_not_null(DatumGetPointer(curr_edge->edge_properties));
+        curr_edge->edge_properties = 0;
     }
 
     /* free the vertices list */
     free_ListGraphId(ggctx->vertices);
     ggctx->vertices = NULL;
 
-    /* free the edges list */
-    free_ListGraphId(ggctx->edges);
-    ggctx->edges = NULL;
+    /* free the CSR adjacency, if any */
+    free_GRAPH_global_csr(ggctx->csr);
+    ggctx->csr = NULL;
 
     /* free the hashtables */
     hash_destroy(ggctx->vertex_hashtable);
@@ -852,9 +3093,38 @@ GRAPH_global_context *manage_GRAPH_global_contexts(char *graph_name,
     while (curr_ggctx != NULL)
     {
         GRAPH_global_context *next_ggctx = curr_ggctx->next;
+        volatile bool keep = true;
 
-        /* if the transaction ids have changed, we have an invalid graph */
+        /*
+         * If the transaction ids have changed, we have an invalid graph. But,
+         * a versioned context may instead be brought up to date. This is only
+         * done for the requested graph, so the others are kept for later.
+         */
         if (is_ggctx_invalid(curr_ggctx))
+        {
+            if (curr_ggctx->graph_oid == graph_oid)
+            {
+                PG_TRY();
+                {
+                    keep = refresh_GRAPH_global_context(curr_ggctx);
+                }
+                PG_CATCH();
+                {
+                    /* unlock the mutex so we don't get a deadlock */
+                    pthread_mutex_unlock(&global_graph_contexts_container.mutex_lock);
+
+                    PG_RE_THROW();
+                }
+                PG_END_TRY();
+            }
+            else
+            {
+                keep = (age_enable_graph_versioning &&
+                        curr_ggctx->graph_version != 0);
+            }
+        }
+
+        if (!keep)
         {
             bool success = false;
 
@@ -930,6 +3200,39 @@ GRAPH_global_context *manage_GRAPH_global_contexts(char *graph_name,
     new_ggctx->graph_name = pstrdup(graph_name);
     new_ggctx->graph_oid = graph_oid;
 
+    /*
+     * If graph versioning is enabled, the context is stamped with the newest
+     * version whose changes are all visible to the active snapshot, which the
+     * context is loaded with. The version is read before the load, so any
+     * change committed after that will move the version past ours, leaving
+     * the context stale instead of partially updated. Transaction snapshots
+     * never move, and our own uncommitted changes aren't covered by the
+     * version, so both keep the snapshot based validity. The same goes for
+     * parallel queries, as their workers each build a context of their own.
+     */
+    new_ggctx->version_entry = NULL;
+    new_ggctx->graph_version = 0;
+    if (age_enable_graph_versioning && !IsolationUsesXactSnapshot() &&
+        !IsInParallelMode() &&
+        !list_member_oid(modified_graph_oids, graph_oid))
+    {
+        get_graph_version_table();
+        new_ggctx->version_entry = get_graph_version_entry(graph_oid, true);
+    }
+    if (new_ggctx->version_entry != NULL &&
+        !resolve_prepared_graph_changes(new_ggctx->version_entry, graph_oid))
+    {
+        graph_version_entry *entry = new_ggctx->version_entry;
+        uint64 version;
+
+        LWLockAcquire(&graph_versions->lock, LW_SHARED);
+        version = pg_atomic_read_u64(&entry->version);
+        new_ggctx->graph_version =
+            get_snapshot_graph_version(graph_versions, entry, graph_oid,
+                                       version, GetActiveSnapshot());
+        LWLockRelease(&graph_versions->lock);
+    }
+
     /* set the transaction ids */
     new_ggctx->xmin = GetActiveSnapshot()->xmin;
     new_ggctx->xmax = GetActiveSnapshot()->xmax;
@@ -937,13 +3240,22 @@ GRAPH_global_context *manage_GRAPH_global_contexts(char *graph_name,
 
     /* initialize our vertices list */
     new_ggctx->vertices = NULL;
-    /* initialize our edges list */
-    new_ggctx->edges = NULL;
 
     /* build the hashtables for this graph */
     create_GRAPH_global_hashtables(new_ggctx);
     load_GRAPH_global_hashtables(new_ggctx);
-    freeze_GRAPH_global_hashtables(new_ggctx);
+
+    /* versioned contexts will have changes applied, so can't be frozen */
+    if (new_ggctx->graph_version == 0)
+    {
+        freeze_GRAPH_global_hashtables(new_ggctx);
+
+        /* only frozen contexts can have a CSR adjacency */
+        if (age_enable_graph_csr)
+        {
+            build_GRAPH_global_csr(new_ggctx);
+        }
+    }
 
     /* unlock the global contexts list */
     pthread_mutex_unlock(&global_graph_contexts_container.mutex_lock);
@@ -1174,6 +3486,75 @@ ListGraphId *get_vertex_entry_edges_self(vertex_entry *ve)
     return ve->edges_self;
 }
 
+/* CSR adjacency accessor functions */
+bool has_GRAPH_global_csr(GRAPH_global_context *ggctx)
+{
+    return (ggctx->csr != NULL);
+}
+
+/*
+ * Functions to retrieve the number of vertices in the CSR adjacency and a
+ * vertex's dense index into it, from 0 to that number - 1. The CSR adjacency
+ * must exist.
+ */
+int64 get_GRAPH_global_csr_num_vertices(GRAPH_global_context *ggctx)
+{
+    Assert(ggctx->csr != NULL);
+
+    return ggctx->csr->num_vertices;
+}
+
+int64 get_vertex_entry_csr_index(vertex_entry *ve)
+{
+    Assert(ve->csr_index >= 0);
+
+    return ve->csr_index;
+}
+
+/*
+ * Functions to retrieve a vertex's edges of each kind from the CSR adjacency.
+ * They return a pointer to the first edge, and its number of edges in
+ * num_edges. The CSR adjacency must exist.
+ */
+graph_csr_edge *get_vertex_entry_csr_edges_out(GRAPH_global_context *ggctx,
+                                               vertex_entry *ve,
+                                               int64 *num_edges)
+{
+    GRAPH_global_csr *csr = ggctx->csr;
+
+    Assert(csr != NULL && ve->csr_index >= 0);
+
+    *num_edges = csr->out_offsets[ve->csr_index + 1] -
+                 csr->out_offsets[ve->csr_index];
+    return &csr->out_edges[csr->out_offsets[ve->csr_index]];
+}
+
+graph_csr_edge *get_vertex_entry_csr_edges_in(GRAPH_global_context *ggctx,
+                                              vertex_entry *ve,
+                                              int64 *num_edges)
+{
+    GRAPH_global_csr *csr = ggctx->csr;
+
+    Assert(csr != NULL && ve->csr_index >= 0);
+
+    *num_edges = csr->in_offsets[ve->csr_index + 1] -
+                 csr->in_offsets[ve->csr_index];
+    return &csr->in_edges[csr->in_offsets[ve->csr_index]];
+}
+
+graph_csr_edge *get_vertex_entry_csr_edges_self(GRAPH_global_context *ggctx,
+                                                vertex_entry *ve,
+                                                int64 *num_edges)
+{
+    GRAPH_global_csr *csr = ggctx->csr;
+
+    Assert(csr != NULL && ve->csr_index >= 0);
+
+    *num_edges = csr->self_offsets[ve->csr_index + 1] -
+                 csr->self_offsets[ve->csr_index];
+    return &csr->self_edges[csr->self_offsets[ve->csr_index]];
+}
+
 
 Oid get_vertex_entry_label_table_oid(vertex_entry *ve)
 {
@@ -1182,6 +3563,14 @@ Oid get_vertex_entry_label_table_oid(vertex_entry *ve)
 
 Datum get_vertex_entry_properties(vertex_entry *ve)
 {
+    /* properties left out by a lazy load are fetched on first use */
+    if (ve->vertex_properties == (Datum) 0)
+    {
+        ve->vertex_properties = fetch_lazy_properties(
+            ve->vertex_label_table_oid, LABEL_KIND_VERTEX, ve->vertex_id, 0,
+            &ve->tid);
+    }
+
     return ve->vertex_properties;
 }
 
@@ -1198,6 +3587,14 @@ Oid get_edge_entry_label_table_oid(edge_entry *ee)
 
 Datum get_edge_entry_properties(edge_entry *ee)
 {
+    /* properties left out by a lazy load are fetched on first use */
+    if (ee->edge_properties == (Datum) 0)
+    {
+        ee->edge_properties = fetch_lazy_properties(
+            ee->edge_label_table_oid, LABEL_KIND_EDGE, ee->edge_id,
+            ee->start_vertex_id, &ee->tid);
+    }
+
     return ee->edge_properties;
 }
 
@@ -1450,3 +3847,431 @@ Datum age_graph_stats(PG_FUNCTION_ARGS)
 
     PG_RETURN_POINTER(agtype_value_to_agtype(result.res));
 }
+
+PG_FUNCTION_INFO_V1(age_graph_change_trigger);
+
+/*
+ * Trigger function to record plain SQL changes to a label table, so that the
+ * global graph contexts can be maintained incrementally. Every label table
+ * gets it when created, as an AFTER INSERT OR UPDATE OR DELETE trigger, FOR
+ * EACH ROW. It is also used at the statement level, on TRUNCATE, where it
+ * forces a reload. Cypher writes don't fire triggers and record their changes
+ * themselves.
+ */
+Datum age_graph_change_trigger(PG_FUNCTION_ARGS)
+{
+    TriggerData *trigdata = (TriggerData *)fcinfo->context;
+    Relation rel = NULL;
+    label_cache_data *label = NULL;
+
+    if (!CALLED_AS_TRIGGER(fcinfo))
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_E_R_I_E_TRIGGER_PROTOCOL_VIOLATED),
+                 errmsg("age_graph_change_trigger: not called by trigger manager")));
+    }
+
+    rel = trigdata->tg_relation;
+    label = search_label_relation_cache(RelationGetRelid(rel));
+    if (label == NULL)
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_WRONG_OBJECT_TYPE),
+                 errmsg("relation \"%s\" is not a label table",
+                        RelationGetRelationName(rel))));
+    }
+
+    /* without the rows, the changes can't be tracked individually */
+    if (!TRIGGER_FIRED_FOR_ROW(trigdata->tg_event))
+    {
+        mark_graph_modified(label->graph);
+        PG_RETURN_POINTER(NULL);
+    }
+
+    if (TRIGGER_FIRED_BY_INSERT(trigdata->tg_event))
+    {
+        record_graph_change(rel, GRAPH_CHANGE_INSERT, trigdata->tg_trigtuple);
+    }
+    else if (TRIGGER_FIRED_BY_DELETE(trigdata->tg_event))
+    {
+        record_graph_change(rel, GRAPH_CHANGE_DELETE, trigdata->tg_trigtuple);
+    }
+    else if (TRIGGER_FIRED_BY_UPDATE(trigdata->tg_event))
+    {
+        TupleDesc tupdesc = RelationGetDescr(rel);
+        graphid old_ids[3];
+        graphid new_ids[3];
+
+        get_entity_ids(tupdesc, trigdata->tg_trigtuple, label->kind,
+                       &old_ids[0], &old_ids[1], &old_ids[2]);
+        get_entity_ids(tupdesc, trigdata->tg_newtuple, label->kind,
+                       &new_ids[0], &new_ids[1], &new_ids[2]);
+
+        /* if the ids moved, it is the same as a delete and an insert */
+        if (memcmp(old_ids, new_ids, sizeof(old_ids)) == 0)
+        {
+            record_graph_change(rel, GRAPH_CHANGE_UPDATE,
+                                trigdata->tg_newtuple);
+        }
+        else
+        {
+            record_graph_change(rel, GRAPH_CHANGE_DELETE,
+                                trigdata->tg_trigtuple);
+            record_graph_change(rel, GRAPH_CHANGE_INSERT,
+                                trigdata->tg_newtuple);
+        }
+
+        PG_RETURN_POINTER(trigdata->tg_newtuple);
+    }
+
+    PG_RETURN_POINTER(trigdata->tg_trigtuple);
+}
+
+/*
+ * Helper function to match the columns asked of age_export_label to what
+ * they are filled with. The id, start_id, end_id, and properties columns are
+ * the columns of the label table. Every other column is the property of the
+ * same name, converted to the column's type.
+ */
+static export_column *get_export_columns(TupleDesc tupdesc, char label_kind)
+{
+    export_column *columns;
+    int i;
+
+    columns = palloc0(sizeof(export_column) * tupdesc->natts);
+
+    for (i = 0; i < tupdesc->natts; i++)
+    {
+        Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+        char *name = NameStr(attr->attname);
+        export_column *column = &columns[i];
+
+        column->type = attr->atttypid;
+
+        if (strcmp(name, "id") == 0)
+        {
+            column->kind = EXPORT_COLUMN_ID;
+        }
+        else if (strcmp(name, "start_id") == 0 &&
+                 label_kind == LABEL_KIND_EDGE)
+        {
+            column->kind = EXPORT_COLUMN_START_ID;
+        }
+        else if (strcmp(name, "end_id") == 0 && label_kind == LABEL_KIND_EDGE)
+        {
+            column->kind = EXPORT_COLUMN_END_ID;
+        }
+        else if (strcmp(name, "properties") == 0)
+        {
+            column->kind = EXPORT_COLUMN_PROPERTIES;
+        }
+        else
+        {
+            column->kind = EXPORT_COLUMN_PROPERTY;
+            column->key.type = AGTV_STRING;
+            column->key.val.string.val = name;
+            column->key.val.string.len = strlen(name);
+        }
+
+        /* ids are graphids or their int8 values */
+        if (column->kind == EXPORT_COLUMN_ID ||
+            column->kind == EXPORT_COLUMN_START_ID ||
+            column->kind == EXPORT_COLUMN_END_ID)
+        {
+            if (column->type != GRAPHIDOID && column->type != INT8OID)
+            {
+                ereport(ERROR,
+                        (errcode(ERRCODE_DATATYPE_MISMATCH),
+                         errmsg("column \"%s\" must be of type graphid or bigint",
+                                name)));
+            }
+        }
+        else if (column->kind == EXPORT_COLUMN_PROPERTIES)
+        {
+            if (column->type != AGTYPEOID)
+            {
+                ereport(ERROR,
+                        (errcode(ERRCODE_DATATYPE_MISMATCH),
+                         errmsg("column \"%s\" must be of type agtype",
+                                name)));
+            }
+        }
+        else if (column->type != AGTYPEOID && column->type != TEXTOID &&
+                 column->type != INT8OID && column->type != INT4OID &&
+                 column->type != INT2OID && column->type != FLOAT8OID &&
+                 column->type != NUMERICOID && column->type != BOOLOID)
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                     errmsg("properties cannot be exported as type %s",
+                            format_type_be(column->type)),
+                     errhint("Use agtype, text, bigint, integer, smallint, double precision, numeric, or boolean.")));
+        }
+    }
+
+    return columns;
+}
+
+/*
+ * Helper function to convert a property value to the type of its column. The
+ * value must already be of that type, or a number that converts to it without
+ * loss of range. Anything else means the property doesn't have a consistent
+ * type across the label, which is an error.
+ */
+static Datum export_property_datum(export_column *column, char *label_name,
+                                   agtype_value *value)
+{
+    switch (column->type)
+    {
+    case AGTYPEOID:
+        return AGTYPE_P_GET_DATUM(agtype_value_to_agtype(value));
+    case TEXTOID:
+        if (value->type == AGTV_STRING)
+        {
+            return PointerGetDatum(
+                cstring_to_text_with_len(value->val.string.val,
+                                         value->val.string.len));
+        }
+        break;
+    case INT8OID:
+        if (value->type == AGTV_INTEGER)
+        {
+            return Int64GetDatum(value->val.int_value);
+        }
+        break;
+    case INT4OID:
+        if (value->type == AGTV_INTEGER &&
+            value->val.int_value >= PG_INT32_MIN &&
+            value->val.int_value <= PG_INT32_MAX)
+        {
+            return Int32GetDatum((int32)value->val.int_value);
+        }
+        break;
+    case INT2OID:
+        if (value->type == AGTV_INTEGER &&
+            value->val.int_value >= PG_INT16_MIN &&
+            value->val.int_value <= PG_INT16_MAX)
+        {
+            return Int16GetDatum((int16)value->val.int_value);
+        }
+        break;
+    case FLOAT8OID:
+        if (value->type == AGTV_FLOAT)
+        {
+            return Float8GetDatum(value->val.float_value);
+        }
+        else if (value->type == AGTV_INTEGER)
+        {
+            return Float8GetDatum((float8)value->val.int_value);
+        }
+        break;
+    case NUMERICOID:
+        if (value->type == AGTV_NUMERIC)
+        {
+            return NumericGetDatum(value->val.numeric);
+        }
+        else if (value->type == AGTV_INTEGER)
+        {
+            return NumericGetDatum(int64_to_numeric(value->val.int_value));
+        }
+        else if (value->type == AGTV_FLOAT)
+        {
+            return DirectFunctionCall1(float8_numeric,
+                                       Float8GetDatum(value->val.float_value));
+        }
+        break;
+    case BOOLOID:
+        if (value->type == AGTV_BOOL)
+        {
+            return BoolGetDatum(value->val.boolean);
+        }
+        break;
+    }
+
+    ereport(ERROR,
+            (errcode(ERRCODE_DATATYPE_MISMATCH),
+             errmsg("property \"%s\" of label \"%s\" cannot be exported as type %s",
+                    column->key.val.string.val, label_name,
+                    format_type_be(column->type))));
+
+    /* this is never reached */
+    return (Datum) 0;
+}
+
+PG_FUNCTION_INFO_V1(age_export_label);
+
+/*
+ * Function to export all of the vertices or edges of a label as rows of typed
+ * columns, given by the caller's column definition list. See
+ * get_export_columns for how the columns are filled. A property that is
+ * missing, or null, is exported as NULL. The label table is scanned directly,
+ * like when the GRAPH global hashtables are loaded, and the properties are
+ * read from their binary form, without formatting them as agtype text. The
+ * rows are collected in a tuplestore, which spills to disk past work_mem.
+ */
+Datum age_export_label(PG_FUNCTION_ARGS)
+{
+    ReturnSetInfo *rsi = (ReturnSetInfo *) fcinfo->resultinfo;
+    char *graph_name;
+    char *label_name;
+    Oid graph_oid;
+    label_cache_data *label_data;
+    Oid label_relid;
+    char label_kind;
+    export_column *columns;
+    Relation label_relation;
+    TableScanDesc scan_desc;
+    TupleDesc tupdesc;
+    HeapTuple tuple;
+    MemoryContext tmp_cxt;
+    MemoryContext old_cxt;
+    AclResult aclresult;
+    Datum *values;
+    bool *nulls;
+    int properties_column;
+
+    if (PG_ARGISNULL(0))
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("graph name must not be NULL")));
+    }
+
+    if (PG_ARGISNULL(1))
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("label name must not be NULL")));
+    }
+
+    graph_name = NameStr(*PG_GETARG_NAME(0));
+    label_name = NameStr(*PG_GETARG_NAME(1));
+
+    graph_oid = get_graph_oid(graph_name);
+    if (!OidIsValid(graph_oid))
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_UNDEFINED_SCHEMA),
+                 errmsg("graph \"%s\" does not exist", graph_name)));
+    }
+
+    label_data = search_label_name_graph_cache(label_name, graph_oid);
+    if (label_data == NULL)
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_UNDEFINED_TABLE),
+                 errmsg("label \"%s\" does not exist in graph \"%s\"",
+                        label_name, graph_name)));
+    }
+
+    /* the cache entry may not survive opening the table */
+    label_relid = label_data->relation;
+    label_kind = label_data->kind;
+
+    /* check for SELECT permission on the table */
+    aclresult = pg_class_aclcheck(label_relid, GetUserId(),
+                                  ACL_SELECT);
+    if (aclresult != ACLCHECK_OK)
+    {
+        aclcheck_error(aclresult, OBJECT_TABLE, label_name);
+    }
+
+    /* the scan below doesn't apply the policies */
+    if (check_enable_rls(label_relid, InvalidOid, true) ==
+        RLS_ENABLED)
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("export is not supported with row-level security"),
+                 errhint("Use a Cypher MATCH query instead.")));
+    }
+
+    InitMaterializedSRF(fcinfo, MAT_SRF_USE_EXPECTED_DESC | MAT_SRF_BLESS);
+
+    columns = get_export_columns(rsi->setDesc, label_kind);
+    values = palloc(sizeof(Datum) * rsi->setDesc->natts);
+    nulls = palloc(sizeof(bool) * rsi->setDesc->natts);
+
+    tmp_cxt = AllocSetContextCreate(CurrentMemoryContext,
+                                    "age_export_label temporary cxt",
+                                    ALLOCSET_DEFAULT_SIZES);
+
+    /* open the relation (table) and begin the scan */
+    label_relation = table_open(label_relid, AccessShareLock);
+    scan_desc = table_beginscan(label_relation, GetActiveSnapshot(), 0, NULL);
+    tupdesc = RelationGetDescr(label_relation);
+    properties_column = (label_kind == LABEL_KIND_EDGE) ?
+                        edge_tuple_properties : vertex_tuple_properties;
+
+    while ((tuple = heap_getnext(scan_desc, ForwardScanDirection)) != NULL)
+    {
+        graphid id;
+        graphid start_id;
+        graphid end_id;
+        agtype *properties;
+        int i;
+
+        /* use the tmp context so we can clean up after each tuple is done */
+        old_cxt = MemoryContextSwitchTo(tmp_cxt);
+
+        get_entity_ids(tupdesc, tuple, label_kind, &id, &start_id,
+                       &end_id);
+        properties = DATUM_GET_AGTYPE_P(column_get_datum(tupdesc, tuple,
+                                                         properties_column,
+                                                         "properties",
+                                                         AGTYPEOID, true));
+
+        for (i = 0; i < rsi->setDesc->natts; i++)
+        {
+            export_column *column = &columns[i];
+            agtype_value *value;
+
+            nulls[i] = false;
+
+            switch (column->kind)
+            {
+            case EXPORT_COLUMN_ID:
+                values[i] = GRAPHID_GET_DATUM(id);
+                break;
+            case EXPORT_COLUMN_START_ID:
+                values[i] = GRAPHID_GET_DATUM(start_id);
+                break;
+            case EXPORT_COLUMN_END_ID:
+                values[i] = GRAPHID_GET_DATUM(end_id);
+                break;
+            case EXPORT_COLUMN_PROPERTIES:
+                values[i] = AGTYPE_P_GET_DATUM(properties);
+                break;
+            case EXPORT_COLUMN_PROPERTY:
+                value = find_agtype_value_from_container(&properties->root,
+                                                         AGT_FOBJECT,
+                                                         &column->key);
+                if (value == NULL || value->type == AGTV_NULL)
+                {
+                    values[i] = (Datum) 0;
+                    nulls[i] = true;
+                }
+                else
+                {
+                    values[i] = export_property_datum(column, label_name,
+                                                      value);
+                }
+                break;
+            }
+        }
+
+        tuplestore_putvalues(rsi->setResult, rsi->setDesc, values, nulls);
+
+        /* clean up and switch back */
+        MemoryContextSwitchTo(old_cxt);
+        MemoryContextReset(tmp_cxt);
+    }
+
+    /* end the scan and close the relation */
+    table_endscan(scan_desc);
+    table_close(label_relation, AccessShareLock);
+
+    MemoryContextDelete(tmp_cxt);
+
+    PG_RETURN_NULL();
+}
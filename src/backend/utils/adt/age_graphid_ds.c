@@ -79,15 +79,25 @@ GraphIdNode *peek_stack_tail(ListGraphId *stack)
     return stack->tail;
 }
 
-/* return a reference to the head entry of a list */
+/* return a reference to the head entry of a list, or NULL if it is NULL */
 GraphIdNode *get_list_head(ListGraphId *list)
 {
+    if (list == NULL)
+    {
+        return NULL;
+    }
+
     return list->head;
 }
 
-/* get the size of the passed list */
+/* get the size of the passed list, or 0 if it is NULL */
 int64 get_list_size(ListGraphId *list)
 {
+    if (list == NULL)
+    {
+        return 0;
+    }
+
     return list->size;
 }
 
@@ -126,6 +136,53 @@ ListGraphId *append_graphid(ListGraphId *container, graphid id)
     return container;
 }
 
+/*
+ * Helper function to remove the first entry matching the graphid from a
+ * ListGraphId container. It returns true if an entry was removed. Note that
+ * this needs to walk the list.
+ */
+bool remove_graphid(ListGraphId *container, graphid id)
+{
+    GraphIdNode *prev_node = NULL;
+    GraphIdNode *curr_node = NULL;
+
+    /* nothing to remove from a NULL container */
+    if (container == NULL)
+    {
+        return false;
+    }
+
+    curr_node = container->head;
+    while (curr_node != NULL)
+    {
+        if (curr_node->id == id)
+        {
+            /* unlink the node, fixing up the head and tail as needed */
+            if (prev_node == NULL)
+            {
+                container->head = curr_node->next;
+            }
+            else
+            {
+                prev_node->next = curr_node->next;
+            }
+            if (container->tail == curr_node)
+            {
+                container->tail = prev_node;
+            }
+            container->size--;
+
+            pfree(curr_node);
+            return true;
+        }
+
+        prev_node = curr_node;
+        curr_node = curr_node->next;
+    }
+
+    return false;
+}
+
 /* free (delete) a ListGraphId list */
 void free_ListGraphId(ListGraphId *container)
 {
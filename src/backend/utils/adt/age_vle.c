@@ -19,9 +19,14 @@
 
 #include "postgres.h"
 
+#include "access/htup_details.h"
 #include "common/hashfn.h"
 #include "funcapi.h"
+#include "lib/pairingheap.h"
+#include "miscadmin.h"
 #include "utils/datum.h"
+#include "utils/float.h"
+#include "utils/fmgrprotos.h"
 #include "utils/lsyscache.h"
 
 #include "utils/age_vle.h"
@@ -32,21 +37,40 @@
 /* defines */
 #define GET_GRAPHID_ARRAY_FROM_CONTAINER(vpc) \
             (graphid *) (&vpc->graphid_array_data)
-#define EDGE_STATE_HTAB_NAME "Edge state "
-#define EDGE_STATE_HTAB_INITIAL_SIZE 100000
+#define EDGE_STATE_HTAB_INITIAL_SIZE 1024
 #define EXISTS_HTAB_NAME "known edges"
 #define EXISTS_HTAB_NAME_INITIAL_SIZE 1000
+#define SHORTEST_PATH_HTAB_INITIAL_SIZE 1000
+#define WEIGHTED_PATH_HTAB_INITIAL_SIZE 1000
+#define REACHABILITY_HTAB_INITIAL_SIZE 1000
 #define MAXIMUM_NUMBER_OF_CACHED_LOCAL_CONTEXTS 5
 
 /* edge state entry for the edge_state_hashtable */
 typedef struct edge_state_entry
 {
     graphid edge_id;               /* edge id, it is also the hash key */
+    char status;                   /* hash status, used by simplehash */
     bool used_in_path;             /* like visited but more descriptive */
     bool has_been_matched;         /* have we checked for a  match */
     bool matched;                  /* is it a match */
 } edge_state_entry;
 
+/*
+ * The edge states are probed for every edge the dfs looks at, including the
+ * check for whether it is already in the path. So, they are kept in an open
+ * addressing hashtable, edge_state_hash, rather than a dynahash.
+ */
+#define SH_PREFIX edge_state
+#define SH_ELEMENT_TYPE edge_state_entry
+#define SH_KEY_TYPE graphid
+#define SH_KEY edge_id
+#define SH_HASH_KEY(tb, key) murmurhash64((uint64) (key))
+#define SH_EQUAL(tb, a, b) ((a) == (b))
+#define SH_SCOPE static inline
+#define SH_DECLARE
+#define SH_DEFINE
+#include "lib/simplehash.h"
+
 /*
  * VLE_path_function is an enum for the path function to use. This currently can
  * be one of two possibilities - where the target vertex is provided and where
@@ -61,6 +85,21 @@ typedef enum
     VLE_FUNCTION_NONE
 } VLE_path_function;
 
+/* the edge and vertex that lead to a vertex, one hop closer to the root */
+typedef struct shortest_path_parent
+{
+    graphid edge_id;               /* edge traversed to reach the vertex */
+    graphid vertex_id;             /* vertex the edge was traversed from */
+} shortest_path_parent;
+
+/* visited vertex entry for one side of the shortest path search */
+typedef struct shortest_path_entry
+{
+    graphid vertex_id;             /* vertex id, it is also the hash key */
+    int64 depth;                   /* number of hops from this side's root */
+    List *parents;                 /* list of shortest_path_parent */
+} shortest_path_entry;
+
 /* VLE local context per each unique age_vle function activation */
 typedef struct VLE_local_context
 {
@@ -78,7 +117,7 @@ typedef struct VLE_local_context
     int64 uidx;                    /* upper (end) bound index */
     bool uidx_infinite;            /* flag if the upper bound is omitted */
     cypher_rel_dir edge_direction; /* the direction of the edge */
-    HTAB *edge_state_hashtable;    /* local state hashtable for our edges */
+    edge_state_hash *edge_state_hashtable; /* local state for our edges */
     ListGraphId *dfs_vertex_stack; /* dfs stack for vertices */
     ListGraphId *dfs_edge_stack;   /* dfs stack for edges */
     ListGraphId *dfs_path_stack;   /* dfs stack containing the path */
@@ -90,6 +129,87 @@ typedef struct VLE_local_context
     bool is_dirty;                 /* is this VLE context reusable */
 } VLE_local_context;
 
+/* state for a bidirectional breadth first shortest path search */
+typedef struct shortest_path_search
+{
+    VLE_local_context *vlelctx;    /* VLE local context with the constraints */
+    HTAB *forward;                 /* vertices visited from the start vertex */
+    HTAB *backward;                /* vertices visited from the end vertex */
+    bool all_paths;                /* find all shortest paths, or just one */
+    graphid *path;                 /* path being built */
+    int64 path_size;               /* number of vertices and edges in path */
+    int64 meet_index;              /* where the 2 searches meet in path */
+    List *paths;                   /* found VLE_path_containers */
+    HTAB *visiting;                /* side being expanded */
+    ListGraphId *next_frontier;    /* next frontier of the side being expanded */
+    int64 depth;                   /* depth of the next frontier */
+} shortest_path_search;
+
+/*
+ * State for a level synchronous breadth first reachability search. Each vertex
+ * is visited once, so only the current level is kept, not the paths to it.
+ */
+typedef struct reachability_search
+{
+    VLE_local_context *vlelctx;    /* VLE local context with the constraints */
+    bool forward;                  /* search from the start or the end vertex */
+    bool use_out;                  /* follow the outgoing edges */
+    bool use_in;                   /* follow the incoming edges */
+    graphid root_id;               /* vertex the search is rooted at */
+    bits8 *visited_bitmap;         /* visited vertices by CSR index, or NULL */
+    int64 visited_bitmap_size;     /* size of the visited bitmap in bytes */
+    HTAB *visited;                 /* visited vertex ids, without a CSR */
+    ListGraphId *level_vertices;   /* vertices first reached at depth */
+    ListGraphId *level_edges;      /* edges they were first reached through */
+    GraphIdNode *next_vertex;      /* next vertex of the level to return */
+    GraphIdNode *next_edge;        /* edge of the next vertex to return */
+    int64 depth;                   /* depth of the current level */
+    bool root_pending;             /* is the zero length path still to return */
+    bool done;                     /* is the search finished */
+} reachability_search;
+
+/*
+ * Called for each edge that satisfies the VLE edge constraints, with the vertex
+ * it was reached from and the vertex on its other end.
+ */
+typedef void (*matching_edge_visitor)(void *arg, graphid vertex_id,
+                                      graphid edge_id,
+                                      graphid next_vertex_id);
+
+/* reached vertex entry for the weighted path search */
+typedef struct weighted_path_entry
+{
+    graphid vertex_id;             /* vertex id, it is also the hash key */
+    float8 cost;                   /* cheapest known cost from the start */
+    float8 heuristic;              /* estimated cost to the end vertex */
+    graphid parent_edge_id;        /* last edge of the cheapest known path */
+    graphid parent_vertex_id;      /* vertex that edge was traversed from */
+    int64 hops;                    /* number of edges in that path */
+    bool settled;                  /* have its edges been relaxed */
+} weighted_path_entry;
+
+/* priority queue node for the weighted path search */
+typedef struct weighted_path_queue_node
+{
+    pairingheap_node ph_node;
+    graphid vertex_id;             /* vertex to settle */
+    float8 cost;                   /* its cost when it was queued */
+    float8 estimate;               /* cost plus the heuristic */
+} weighted_path_queue_node;
+
+/* state for a Dijkstra, or A*, weighted path search */
+typedef struct weighted_path_search
+{
+    VLE_local_context *vlelctx;    /* VLE local context with the constraints */
+    char *weight_key;              /* edge property holding the weight */
+    char *heuristic_key;           /* vertex property for A*, or NULL */
+    agtype_value *end_heuristic;   /* end vertex's heuristic property */
+    HTAB *visited;                 /* weighted_path_entry per reached vertex */
+    pairingheap *queue;            /* queued vertices, cheapest first */
+    weighted_path_entry *current;  /* vertex being settled */
+    bool done;                     /* is the search finished */
+} weighted_path_search;
+
 /*
  * Container to hold the graphid array that contains one valid path. This
  * structure will allow it to be easily passed as an AGTYPE pointer. The
@@ -114,8 +234,12 @@ static VLE_local_context *global_vle_local_contexts = NULL;
 /* agtype functions */
 static bool is_an_edge_match(VLE_local_context *vlelctx, edge_entry *ee);
 /* VLE local context functions */
+static graphid get_vertex_id_argument(agtype *agt_arg, char *arg_name);
+static void set_VLE_edge_prototype(VLE_local_context *vlelctx,
+                                   agtype *agt_edge_prototype);
 static VLE_local_context *build_local_vle_context(FunctionCallInfo fcinfo,
-                                                  FuncCallContext *funcctx);
+                                                  FuncCallContext *funcctx,
+                                                  bool cacheable);
 static void create_VLE_local_state_hashtable(VLE_local_context *vlelctx);
 static void free_VLE_local_context(VLE_local_context *vlelctx);
 /* VLE graph traversal functions */
@@ -128,14 +252,72 @@ static bool dfs_find_a_path_from(VLE_local_context *vlelctx);
 static bool do_vsid_and_veid_exist(VLE_local_context *vlelctx);
 static void add_valid_vertex_edges(VLE_local_context *vlelctx,
                                    graphid vertex_id);
+static void add_valid_vertex_edge(VLE_local_context *vlelctx, vertex_entry *ve,
+                                  graphid edge_id, Oid edge_label_table_oid);
 static graphid get_next_vertex(VLE_local_context *vlelctx, edge_entry *ee);
-static bool is_edge_in_path(VLE_local_context *vlelctx, graphid edge_id);
 /* VLE path and edge building functions */
 static VLE_path_container *create_VLE_path_container(int64 path_size);
 static VLE_path_container *build_VLE_path_container(VLE_local_context *vlelctx);
 static VLE_path_container *build_VLE_zero_container(VLE_local_context *vlelctx);
 static agtype_value *build_path(VLE_path_container *vpc);
 static agtype_value *build_edge_list(VLE_path_container *vpc);
+/* edge matching functions */
+static bool is_a_matching_edge(VLE_local_context *vlelctx, graphid edge_id,
+                               Oid edge_label_table_oid);
+static void visit_matching_vertex_edges(VLE_local_context *vlelctx,
+                                        vertex_entry *ve, bool use_out,
+                                        bool use_in,
+                                        matching_edge_visitor visitor,
+                                        void *arg);
+/* shortest path functions */
+static List *find_shortest_paths(VLE_local_context *vlelctx, bool all_paths);
+static HTAB *create_shortest_path_hashtable(const char *name);
+static shortest_path_entry *add_shortest_path_root(HTAB *visited,
+                                                   graphid vertex_id);
+static ListGraphId *expand_shortest_path_frontier(shortest_path_search *sps,
+                                                  HTAB *visited,
+                                                  ListGraphId *frontier,
+                                                  bool forward, int64 depth);
+static void visit_shortest_path_vertex(void *arg, graphid parent_vertex_id,
+                                       graphid edge_id, graphid vertex_id);
+static void collect_shortest_paths(shortest_path_search *sps,
+                                   graphid meet_vertex_id);
+static void fill_shortest_path_to_start(shortest_path_search *sps,
+                                        graphid vertex_id, int64 index);
+static void fill_shortest_path_to_end(shortest_path_search *sps,
+                                      graphid vertex_id, int64 index);
+static reachability_search *build_reachability_search(VLE_local_context *vlelctx);
+static void start_reachability_root(reachability_search *rs,
+                                    graphid root_id);
+static bool mark_reachability_visited(reachability_search *rs,
+                                      graphid vertex_id);
+static void visit_reachability_vertex(void *arg, graphid vertex_id,
+                                      graphid edge_id,
+                                      graphid next_vertex_id);
+static bool get_matching_selfloop(VLE_local_context *vlelctx, vertex_entry *ve,
+                                  graphid *edge_id);
+static bool expand_reachability_level(reachability_search *rs);
+static bool next_reachable_vertex(reachability_search *rs,
+                                  graphid *vertex_id, graphid *edge_id);
+static VLE_path_container *build_reachability_container(reachability_search *rs,
+                                                        graphid vertex_id,
+                                                        graphid edge_id);
+/* weighted path functions */
+static weighted_path_search *build_weighted_path_search(FunctionCallInfo fcinfo);
+static int weighted_path_queue_cmp(const pairingheap_node *a,
+                                   const pairingheap_node *b, void *arg);
+static agtype_value *get_entity_property(Datum properties, char *key);
+static bool get_agtype_value_float8(agtype_value *agtv, float8 *result);
+static float8 get_edge_weight(weighted_path_search *wps, graphid edge_id);
+static float8 get_vertex_heuristic(weighted_path_search *wps,
+                                   graphid vertex_id);
+static void queue_weighted_path_vertex(weighted_path_search *wps,
+                                       weighted_path_entry *wpe);
+static void relax_weighted_path_edge(void *arg, graphid vertex_id,
+                                     graphid edge_id, graphid next_vertex_id);
+static weighted_path_entry *settle_weighted_path_vertex(weighted_path_search *wps);
+static VLE_path_container *build_weighted_path_container(weighted_path_search *wps,
+                                                         weighted_path_entry *wpe);
 /* VLE_local_context cache management */
 static VLE_local_context *get_cached_VLE_local_context(int64 vle_node_id);
 static void cache_VLE_local_context(VLE_local_context *vlelctx);
@@ -289,37 +471,16 @@ static void cache_VLE_local_context(VLE_local_context *vlelctx)
     global_vle_local_contexts = vlelctx;
 }
 
-/* helper function to create the local VLE edge state hashtable. */
+/*
+ * Helper function to create the local VLE edge state hashtable. It is created
+ * in the current memory context, which is the context the VLE local context
+ * itself lives in, and it grows as needed.
+ */
 static void create_VLE_local_state_hashtable(VLE_local_context *vlelctx)
 {
-    HASHCTL edge_state_ctl;
-    char *graph_name = NULL;
-    char *eshn = NULL;
-    int glen;
-    int elen;
-
-    /* get the graph name and length */
-    graph_name = vlelctx->graph_name;
-    glen = strlen(graph_name);
-    /* get the edge state htab name length */
-    elen = strlen(EDGE_STATE_HTAB_NAME);
-    /* allocate the space and build the name */
-    eshn = palloc0(elen + glen + 1);
-    /* copy in the name */
-    strcpy(eshn, EDGE_STATE_HTAB_NAME);
-    /* add in the graph name */
-    eshn = strncat(eshn, graph_name, glen);
-
-    /* initialize the edge state hashtable */
-    MemSet(&edge_state_ctl, 0, sizeof(edge_state_ctl));
-    edge_state_ctl.keysize = sizeof(int64);
-    edge_state_ctl.entrysize = sizeof(edge_state_entry);
-    edge_state_ctl.hash = tag_hash;
-    vlelctx->edge_state_hashtable = hash_create(eshn,
-                                                EDGE_STATE_HTAB_INITIAL_SIZE,
-                                                &edge_state_ctl,
-                                                HASH_ELEM | HASH_FUNCTION);
-    pfree_if_not_null(eshn);
+    vlelctx->edge_state_hashtable =
+        edge_state_create(CurrentMemoryContext, EDGE_STATE_HTAB_INITIAL_SIZE,
+                          NULL);
 }
 
 /*
@@ -364,6 +525,15 @@ static bool is_an_edge_match(VLE_local_context *vlelctx, edge_entry *ee)
         return false;
     }
 
+    /*
+     * If there aren't any property constraints, the label matched, and we are
+     * done. This also avoids fetching properties that were loaded lazily.
+     */
+    if (num_edge_property_constraints == 0)
+    {
+        return true;
+    }
+
     /* get our edge's properties */
     edge_property = DATUM_GET_AGTYPE_P(get_edge_entry_properties(ee));
     /* get the containers */
@@ -419,8 +589,8 @@ static bool is_an_edge_match(VLE_local_context *vlelctx, edge_entry *ee)
  *
  * Currently, the only structures that needs to be freed are the edge state
  * hashtable and the dfs stacks (vertex, edge, and path). The hashtable is easy
- * because hash_create packages everything into its own memory context. So, you
- * only need to do a destroy.
+ * because it is just its entry array and header. So, you only need to do a
+ * destroy.
  */
 static void free_VLE_local_context(VLE_local_context *vlelctx)
 {
@@ -445,8 +615,11 @@ static void free_VLE_local_context(VLE_local_context *vlelctx)
     }
 
     /* we need to free our state hashtable */
-    hash_destroy(vlelctx->edge_state_hashtable);
-    vlelctx->edge_state_hashtable = NULL;
+    if (vlelctx->edge_state_hashtable != NULL)
+    {
+        edge_state_destroy(vlelctx->edge_state_hashtable);
+        vlelctx->edge_state_hashtable = NULL;
+    }
 
     /*
      * We need to free the contents of our stacks if the context is not dirty.
@@ -511,20 +684,88 @@ static void load_initial_dfs_stacks(VLE_local_context *vlelctx)
     add_valid_vertex_edges(vlelctx, vlelctx->vsid);
 }
 
+/*
+ * Helper function to get the vertex id from a vertex argument. The argument can
+ * be either a vertex or the integer id of one.
+ */
+static graphid get_vertex_id_argument(agtype *agt_arg, char *arg_name)
+{
+    agtype_value *agtv_temp = NULL;
+
+    agtv_temp = get_agtype_value("age_vle", agt_arg, AGTV_VERTEX, false);
+    if (agtv_temp != NULL && agtv_temp->type == AGTV_VERTEX)
+    {
+        agtv_temp = GET_AGTYPE_VALUE_OBJECT_VALUE(agtv_temp, "id");
+    }
+    else if (agtv_temp == NULL || agtv_temp->type != AGTV_INTEGER)
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("%s vertex argument must be a vertex or the integer id",
+                        arg_name)));
+    }
+
+    return agtv_temp->val.int_value;
+}
+
+/*
+ * Helper function to set the VLE edge's label and property constraints from
+ * the edge prototype built by age_build_vle_match_edge.
+ */
+static void set_VLE_edge_prototype(VLE_local_context *vlelctx,
+                                   agtype *agt_edge_prototype)
+{
+    agtype_value *agtv_temp = NULL;
+    agtype_value *agtv_object = NULL;
+    agtype *agt_edge_property_constraint = NULL;
+    Datum d_edge_property_constraint = 0;
+
+    agtv_temp = get_agtype_value("age_vle", agt_edge_prototype, AGTV_EDGE,
+                                 true);
+
+    /* get the edge prototype's property conditions */
+    agtv_object = GET_AGTYPE_VALUE_OBJECT_VALUE(agtv_temp, "properties");
+    agt_edge_property_constraint = agtype_value_to_agtype(agtv_object);
+
+    /* store the properties as an agtype */
+    vlelctx->edge_property_constraint = agt_edge_property_constraint;
+
+    d_edge_property_constraint = AGTYPE_P_GET_DATUM(agt_edge_property_constraint);
+    vlelctx->edge_property_constraint_datum = d_edge_property_constraint;
+    vlelctx->edge_property_constraint_hash = datum_image_hash(d_edge_property_constraint, false, -1);
+
+    /* get the edge prototype's label name */
+    agtv_temp = GET_AGTYPE_VALUE_OBJECT_VALUE(agtv_temp, "label");
+    if (agtv_temp->type == AGTV_STRING &&
+        agtv_temp->val.string.len != 0)
+    {
+        vlelctx->edge_label_name = pnstrdup(agtv_temp->val.string.val,
+                                            agtv_temp->val.string.len);
+
+        vlelctx->edge_label_name_oid = get_label_relation(vlelctx->edge_label_name,
+                                                          vlelctx->graph_oid);
+    }
+    else
+    {
+        vlelctx->edge_label_name = NULL;
+        vlelctx->edge_label_name_oid = InvalidOid;
+    }
+}
+
 /*
  * Helper function to build the local VLE context. This is also the point
- * where, if necessary, the global GRAPH contexts are created and freed.
+ * where, if necessary, the global GRAPH contexts are created and freed. If
+ * cacheable is false, the eighth argument is not a VLE grammar node id and the
+ * context is not cached.
  */
 static VLE_local_context *build_local_vle_context(FunctionCallInfo fcinfo,
-                                                  FuncCallContext *funcctx)
+                                                  FuncCallContext *funcctx,
+                                                  bool cacheable)
 {
     MemoryContext oldctx = NULL;
     GRAPH_global_context *ggctx = NULL;
     VLE_local_context *vlelctx = NULL;
     agtype_value *agtv_temp = NULL;
-    agtype_value *agtv_object = NULL;
-    agtype *agt_edge_property_constraint = NULL;
-    Datum d_edge_property_constraint = 0;
     char *graph_name = NULL;
     Oid graph_oid = InvalidOid;
     int64 vle_grammar_node_id = 0;
@@ -534,7 +775,7 @@ static VLE_local_context *build_local_vle_context(FunctionCallInfo fcinfo,
      * Get the VLE grammar node id, if it exists. Remember, we overload the
      * age_vle function, for now, for backwards compatibility
      */
-    if (PG_NARGS() == 8)
+    if (PG_NARGS() == 8 && cacheable)
     {
         /* get the VLE grammar node id */
         agtv_temp = get_agtype_value("age_vle", AG_GET_ARG_AGTYPE_P(7),
@@ -567,19 +808,8 @@ static VLE_local_context *build_local_vle_context(FunctionCallInfo fcinfo,
         }
         else
         {
-            agtv_temp = get_agtype_value("age_vle", AG_GET_ARG_AGTYPE_P(1),
-                                         AGTV_VERTEX, false);
-            if (agtv_temp != NULL && agtv_temp->type == AGTV_VERTEX)
-            {
-                agtv_temp = GET_AGTYPE_VALUE_OBJECT_VALUE(agtv_temp, "id");
-            }
-            else if (agtv_temp == NULL || agtv_temp->type != AGTV_INTEGER)
-            {
-                ereport(ERROR,
-                        (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-                         errmsg("start vertex argument must be a vertex or the integer id")));
-            }
-            vlelctx->vsid = agtv_temp->val.int_value;
+            vlelctx->vsid = get_vertex_id_argument(AG_GET_ARG_AGTYPE_P(1),
+                                                 "start");
         }
 
         /* get and update the end vertex id */
@@ -589,19 +819,8 @@ static VLE_local_context *build_local_vle_context(FunctionCallInfo fcinfo,
         }
         else
         {
-            agtv_temp = get_agtype_value("age_vle", AG_GET_ARG_AGTYPE_P(2),
-                                         AGTV_VERTEX, false);
-            if (agtv_temp != NULL && agtv_temp->type == AGTV_VERTEX)
-            {
-                agtv_temp = GET_AGTYPE_VALUE_OBJECT_VALUE(agtv_temp, "id");
-            }
-            else if (agtv_temp == NULL || agtv_temp->type != AGTV_INTEGER)
-            {
-                ereport(ERROR,
-                        (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-                         errmsg("end vertex argument must be a vertex or the integer id")));
-            }
-            vlelctx->veid = agtv_temp->val.int_value;
+            vlelctx->veid = get_vertex_id_argument(AG_GET_ARG_AGTYPE_P(2),
+                                                 "end");
         }
         vlelctx->is_dirty = true;
 
@@ -692,19 +911,7 @@ static VLE_local_context *build_local_vle_context(FunctionCallInfo fcinfo,
     }
     else
     {
-        agtv_temp = get_agtype_value("age_vle", AG_GET_ARG_AGTYPE_P(1),
-                                     AGTV_VERTEX, false);
-        if (agtv_temp != NULL && agtv_temp->type == AGTV_VERTEX)
-        {
-            agtv_temp = GET_AGTYPE_VALUE_OBJECT_VALUE(agtv_temp, "id");
-        }
-        else if (agtv_temp == NULL || agtv_temp->type != AGTV_INTEGER)
-        {
-            ereport(ERROR,
-                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-                     errmsg("start vertex argument must be a vertex or the integer id")));
-        }
-        vlelctx->vsid = agtv_temp->val.int_value;
+        vlelctx->vsid = get_vertex_id_argument(AG_GET_ARG_AGTYPE_P(1), "start");
     }
 
     /*
@@ -725,53 +932,12 @@ static VLE_local_context *build_local_vle_context(FunctionCallInfo fcinfo,
     }
     else
     {
-        agtv_temp = get_agtype_value("age_vle", AG_GET_ARG_AGTYPE_P(2),
-                                     AGTV_VERTEX, false);
-        if (agtv_temp != NULL && agtv_temp->type == AGTV_VERTEX)
-        {
-            agtv_temp = GET_AGTYPE_VALUE_OBJECT_VALUE(agtv_temp, "id");
-        }
-        else if (agtv_temp == NULL || agtv_temp->type != AGTV_INTEGER)
-        {
-            ereport(ERROR,
-                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-                     errmsg("end vertex argument must be a vertex or the integer id")));
-        }
         vlelctx->path_function = VLE_FUNCTION_PATHS_BETWEEN;
-        vlelctx->veid = agtv_temp->val.int_value;
+        vlelctx->veid = get_vertex_id_argument(AG_GET_ARG_AGTYPE_P(2), "end");
     }
 
     /* get the VLE edge prototype */
-    agtv_temp = get_agtype_value("age_vle", AG_GET_ARG_AGTYPE_P(3),
-                                 AGTV_EDGE, true);
-
-    /* get the edge prototype's property conditions */
-    agtv_object = GET_AGTYPE_VALUE_OBJECT_VALUE(agtv_temp, "properties");
-    agt_edge_property_constraint = agtype_value_to_agtype(agtv_object);
-
-    /* store the properties as an agtype */
-    vlelctx->edge_property_constraint = agt_edge_property_constraint;
-
-    d_edge_property_constraint = AGTYPE_P_GET_DATUM(agt_edge_property_constraint);
-    vlelctx->edge_property_constraint_datum = d_edge_property_constraint;
-    vlelctx->edge_property_constraint_hash = datum_image_hash(d_edge_property_constraint, false, -1);
-
-    /* get the edge prototype's label name */
-    agtv_temp = GET_AGTYPE_VALUE_OBJECT_VALUE(agtv_temp, "label");
-    if (agtv_temp->type == AGTV_STRING &&
-        agtv_temp->val.string.len != 0)
-    {
-        vlelctx->edge_label_name = pnstrdup(agtv_temp->val.string.val,
-                                            agtv_temp->val.string.len);
-
-        vlelctx->edge_label_name_oid = get_label_relation(vlelctx->edge_label_name,
-                                                          graph_oid);
-    }
-    else
-    {
-        vlelctx->edge_label_name = NULL;
-        vlelctx->edge_label_name_oid = InvalidOid;
-    }
+    set_VLE_edge_prototype(vlelctx, AG_GET_ARG_AGTYPE_P(3));
 
     /* get the left range index */
     if (PG_ARGISNULL(4) || is_agtype_null(AG_GET_ARG_AGTYPE_P(4)))
@@ -836,6 +1002,9 @@ static VLE_local_context *build_local_vle_context(FunctionCallInfo fcinfo,
 /*
  * Helper function to get the specified edge's state. If it does not find it, it
  * creates and initializes it.
+ *
+ * Note: The entry can move when another edge's state is created, so the
+ *       pointer is only good until then.
  */
 static edge_state_entry *get_edge_state(VLE_local_context *vlelctx,
                                         graphid edge_id)
@@ -844,14 +1013,12 @@ static edge_state_entry *get_edge_state(VLE_local_context *vlelctx,
     bool found = false;
 
     /* retrieve the edge_state_entry from the edge state hashtable */
-    ese = (edge_state_entry *)hash_search(vlelctx->edge_state_hashtable,
-                                          (void *)&edge_id, HASH_ENTER, &found);
+    ese = edge_state_insert(vlelctx->edge_state_hashtable, edge_id, &found);
 
     /* if it isn't found, it needs to be created and initialized */
     if (!found)
     {
-        /* the edge id is also the hash key for resolving collisions */
-        ese->edge_id = edge_id;
+        /* the edge id is already set, it is the hash key */
         ese->used_in_path = false;
         ese->has_been_matched = false;
         ese->matched = false;
@@ -1160,33 +1327,6 @@ static bool dfs_find_a_path_from(VLE_local_context *vlelctx)
     return false;
 }
 
-/*
- * Helper routine to quickly check if an edge_id is in the path stack. It is
- * only meant as a quick check to avoid doing a much more costly hash search for
- * smaller sized lists. But, it is O(n) so it should only be used for small
- * path_stacks and where appropriate.
- */
-static bool is_edge_in_path(VLE_local_context *vlelctx, graphid edge_id)
-{
-    GraphIdNode *edge = NULL;
-
-    /* start at the top of the stack */
-    edge = peek_stack_head(vlelctx->dfs_path_stack);
-
-    /* go through the path stack, return true if we find the edge */
-    while (edge != NULL)
-    {
-        if (get_graphid(edge) == edge_id)
-        {
-            return true;
-        }
-        /* get the next stack element */
-        edge = next_GraphIdNode(edge);
-    }
-    /* we didn't find it if we get here */
-    return false;
-}
-
 /*
  * Helper function to add in valid vertex edges as part of the dfs path
  * algorithm. What constitutes a valid edge is the following -
@@ -1195,18 +1335,20 @@ static bool is_edge_in_path(VLE_local_context *vlelctx, graphid edge_id)
  *     2) Edge is not currently in the path.
  *     3) Edge matches minimum edge properties specified.
  *
+ * If the graph has a CSR adjacency, the edges are walked from its arrays.
+ * Otherwise, they are walked from the vertex's edge lists. Either way, they are
+ * added in the same order.
+ *
  * Note: The vertex must exist.
  */
 static void add_valid_vertex_edges(VLE_local_context *vlelctx,
                                    graphid vertex_id)
 {
-    ListGraphId *vertex_stack = NULL;
-    ListGraphId *edge_stack = NULL;
     ListGraphId *edges = NULL;
     vertex_entry *ve = NULL;
-    GraphIdNode *edge_in = NULL;
-    GraphIdNode *edge_out = NULL;
-    GraphIdNode *edge_self = NULL;
+    GraphIdNode *edge = NULL;
+    bool use_out = false;
+    bool use_in = false;
 
     /* get the vertex entry */
     ve = get_vertex_entry(vlelctx->ggctx, vertex_id);
@@ -1216,127 +1358,150 @@ static void add_valid_vertex_edges(VLE_local_context *vlelctx,
         elog(ERROR, "add_valid_vertex_edges: no vertex found");
     }
 
-    /* point to stacks */
-    vertex_stack = vlelctx->dfs_vertex_stack;
-    edge_stack = vlelctx->dfs_edge_stack;
-
-    /* set to the first edge for each edge list for the specified direction */
-    if (vlelctx->edge_direction == CYPHER_REL_DIR_RIGHT ||
-        vlelctx->edge_direction == CYPHER_REL_DIR_NONE)
-    {
-        edges = get_vertex_entry_edges_out(ve);
-        edge_out = (edges != NULL) ? get_list_head(edges) : NULL;
-    }
-    if (vlelctx->edge_direction == CYPHER_REL_DIR_LEFT ||
-        vlelctx->edge_direction == CYPHER_REL_DIR_NONE)
-    {
-        edges = get_vertex_entry_edges_in(ve);
-        edge_in = (edges != NULL) ? get_list_head(edges) : NULL;
-    }
-    /* set to the first selfloop edge */
-    edges = get_vertex_entry_edges_self(ve);
-    edge_self = (edges != NULL) ? get_list_head(edges) : NULL;
+    /* which edge lists to use for the specified direction */
+    use_out = (vlelctx->edge_direction == CYPHER_REL_DIR_RIGHT ||
+               vlelctx->edge_direction == CYPHER_REL_DIR_NONE);
+    use_in = (vlelctx->edge_direction == CYPHER_REL_DIR_LEFT ||
+              vlelctx->edge_direction == CYPHER_REL_DIR_NONE);
 
-    /* add in valid vertex edges */
-    while (edge_out != NULL || edge_in != NULL || edge_self != NULL)
+    if (has_GRAPH_global_csr(vlelctx->ggctx))
     {
-        edge_entry *ee = NULL;
-        edge_state_entry *ese = NULL;
-        graphid edge_id;
+        graph_csr_edge *csr_edges = NULL;
+        int64 num_edges = 0;
+        int64 i;
 
-        /* get the edge_id from the next available edge*/
-        if (edge_out != NULL)
+        if (use_out)
         {
-            edge_id = get_graphid(edge_out);
+            csr_edges = get_vertex_entry_csr_edges_out(vlelctx->ggctx, ve,
+                                                       &num_edges);
+            for (i = 0; i < num_edges; i++)
+            {
+                add_valid_vertex_edge(vlelctx, ve, csr_edges[i].edge_id,
+                                      csr_edges[i].edge_label_table_oid);
+            }
         }
-        else if (edge_in != NULL)
+        if (use_in)
         {
-            edge_id = get_graphid(edge_in);
+            csr_edges = get_vertex_entry_csr_edges_in(vlelctx->ggctx, ve,
+                                                      &num_edges);
+            for (i = 0; i < num_edges; i++)
+            {
+                add_valid_vertex_edge(vlelctx, ve, csr_edges[i].edge_id,
+                                      csr_edges[i].edge_label_table_oid);
+            }
         }
-        else
+        /* the selfloop edges are always added */
+        csr_edges = get_vertex_entry_csr_edges_self(vlelctx->ggctx, ve,
+                                                    &num_edges);
+        for (i = 0; i < num_edges; i++)
         {
-            edge_id = get_graphid(edge_self);
+            add_valid_vertex_edge(vlelctx, ve, csr_edges[i].edge_id,
+                                  csr_edges[i].edge_label_table_oid);
         }
 
-        /*
-         * This is a fast existence check, relative to the hash search, for when
-         * the path stack is small. If the edge is in the path, we skip it.
-         */
-        if (get_stack_size(vlelctx->dfs_path_stack) < 10 &&
-            is_edge_in_path(vlelctx, edge_id))
+        return;
+    }
+
+    if (use_out)
+    {
+        edges = get_vertex_entry_edges_out(ve);
+        edge = (edges != NULL) ? get_list_head(edges) : NULL;
+        while (edge != NULL)
         {
-            /* set to the next available edge */
-            if (edge_out != NULL)
-            {
-                edge_out = next_GraphIdNode(edge_out);
-            }
-            else if (edge_in != NULL)
-            {
-                edge_in = next_GraphIdNode(edge_in);
-            }
-            else
-            {
-                edge_self = next_GraphIdNode(edge_self);
-            }
-            continue;
+            add_valid_vertex_edge(vlelctx, ve, get_graphid(edge), InvalidOid);
+            edge = next_GraphIdNode(edge);
         }
-
-        /* get the edge entry */
-        ee = get_edge_entry(vlelctx->ggctx, edge_id);
-        /* it better exist */
-        if (ee == NULL)
+    }
+    if (use_in)
+    {
+        edges = get_vertex_entry_edges_in(ve);
+        edge = (edges != NULL) ? get_list_head(edges) : NULL;
+        while (edge != NULL)
         {
-            elog(ERROR, "add_valid_vertex_edges: no edge found");
+            add_valid_vertex_edge(vlelctx, ve, get_graphid(edge), InvalidOid);
+            edge = next_GraphIdNode(edge);
         }
-        /* get its state */
-        ese = get_edge_state(vlelctx, edge_id);
-        /*
-         * Don't add any edges that we have already seen because they will
-         * cause a loop to form.
-         */
-        if (!ese->used_in_path)
+    }
+    /* the selfloop edges are always added */
+    edges = get_vertex_entry_edges_self(ve);
+    edge = (edges != NULL) ? get_list_head(edges) : NULL;
+    while (edge != NULL)
+    {
+        add_valid_vertex_edge(vlelctx, ve, get_graphid(edge), InvalidOid);
+        edge = next_GraphIdNode(edge);
+    }
+}
+
+/*
+ * Helper function to add one edge of a vertex to the dfs stacks, if it is
+ * valid. If the edge's label table oid is known, an edge with the wrong label
+ * is rejected without looking it up in the edge hashtable. Otherwise, pass
+ * InvalidOid.
+ */
+static void add_valid_vertex_edge(VLE_local_context *vlelctx, vertex_entry *ve,
+                                  graphid edge_id, Oid edge_label_table_oid)
+{
+    edge_entry *ee = NULL;
+    edge_state_entry *ese = NULL;
+
+    /* if the label doesn't match, it can't be a match */
+    if (edge_label_table_oid != InvalidOid &&
+        vlelctx->edge_label_name_oid != InvalidOid &&
+        vlelctx->edge_label_name_oid != edge_label_table_oid)
+    {
+        return;
+    }
+
+    /*
+     * Get its state. This one probe tells us both if the edge is in the path
+     * and if it has already been matched.
+     */
+    ese = get_edge_state(vlelctx, edge_id);
+    /*
+     * Don't add any edges that we have already seen because they will
+     * cause a loop to form.
+     */
+    if (!ese->used_in_path)
+    {
+        /* the edge entry is only needed to match it */
+        if (!ese->has_been_matched)
         {
-            /* validate the edge if it hasn't been already */
-            if (!ese->has_been_matched && is_an_edge_match(vlelctx, ee))
-            {
-                ese->has_been_matched = true;
-                ese->matched = true;
-            }
-            else if (!ese->has_been_matched)
-            {
-                ese->has_been_matched = true;
-                ese->matched = false;
-            }
-            /* if it is a match, add it */
-            if (ese->has_been_matched && ese->matched)
+            ee = get_edge_entry(vlelctx->ggctx, edge_id);
+            /* it better exist */
+            if (ee == NULL)
             {
-                /*
-                 * We need to maintain our source vertex for each edge added
-                 * if the edge_direction is CYPHER_REL_DIR_NONE. This is due
-                 * to the edges having a fixed direction and the dfs
-                 * algorithm working strictly through edges. With an
-                 * un-directional VLE edge, you don't know the vertex that
-                 * you just came from. So, we need to store it.
-                 */
-                 if (vlelctx->edge_direction == CYPHER_REL_DIR_NONE)
-                 {
-                     push_graphid_stack(vertex_stack, get_vertex_entry_id(ve));
-                 }
-                 push_graphid_stack(edge_stack, edge_id);
+                elog(ERROR, "add_valid_vertex_edges: no edge found");
             }
         }
-        /* get the next working edge */
-        if (edge_out != NULL)
+
+        /* validate the edge if it hasn't been already */
+        if (!ese->has_been_matched && is_an_edge_match(vlelctx, ee))
         {
-            edge_out = next_GraphIdNode(edge_out);
+            ese->has_been_matched = true;
+            ese->matched = true;
         }
-        else if (edge_in != NULL)
+        else if (!ese->has_been_matched)
         {
-            edge_in = next_GraphIdNode(edge_in);
+            ese->has_been_matched = true;
+            ese->matched = false;
         }
-        else
+        /* if it is a match, add it */
+        if (ese->has_been_matched && ese->matched)
         {
-            edge_self = next_GraphIdNode(edge_self);
+            /*
+             * We need to maintain our source vertex for each edge added
+             * if the edge_direction is CYPHER_REL_DIR_NONE. This is due
+             * to the edges having a fixed direction and the dfs
+             * algorithm working strictly through edges. With an
+             * un-directional VLE edge, you don't know the vertex that
+             * you just came from. So, we need to store it.
+             */
+            if (vlelctx->edge_direction == CYPHER_REL_DIR_NONE)
+            {
+                push_graphid_stack(vlelctx->dfs_vertex_stack,
+                                   get_vertex_entry_id(ve));
+            }
+            push_graphid_stack(vlelctx->dfs_edge_stack, edge_id);
         }
     }
 }
@@ -1731,7 +1896,7 @@ Datum age_vle(PG_FUNCTION_ARGS)
         funcctx = SRF_FIRSTCALL_INIT();
 
         /* build the local vle context */
-        vlelctx = build_local_vle_context(fcinfo, funcctx);
+        vlelctx = build_local_vle_context(fcinfo, funcctx, true);
 
         /*
          * Point the function call context's user pointer to the local VLE
@@ -1872,6 +2037,1611 @@ Datum age_vle(PG_FUNCTION_ARGS)
     }
 }
 
+/*
+ * Helper function to create a hashtable of shortest_path_entry, keyed by
+ * vertex id, for one side of the shortest path search.
+ */
+static HTAB *create_shortest_path_hashtable(const char *name)
+{
+    HASHCTL ctl;
+
+    MemSet(&ctl, 0, sizeof(ctl));
+    ctl.keysize = sizeof(graphid);
+    ctl.entrysize = sizeof(shortest_path_entry);
+    ctl.hcxt = CurrentMemoryContext;
+
+    return hash_create(name, SHORTEST_PATH_HTAB_INITIAL_SIZE, &ctl,
+                       HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+}
+
+/* helper function to add the root vertex of one side of the search */
+static shortest_path_entry *add_shortest_path_root(HTAB *visited,
+                                                   graphid vertex_id)
+{
+    shortest_path_entry *spe = NULL;
+
+    spe = (shortest_path_entry *)hash_search(visited, (void *)&vertex_id,
+                                             HASH_ENTER, NULL);
+    spe->vertex_id = vertex_id;
+    spe->depth = 0;
+    spe->parents = NIL;
+
+    return spe;
+}
+
+/*
+ * Helper function to check if an edge satisfies the VLE edge constraints. The
+ * result is cached in the edge state hashtable, so each edge is only matched
+ * once per search.
+ */
+static bool is_a_matching_edge(VLE_local_context *vlelctx, graphid edge_id,
+                               Oid edge_label_table_oid)
+{
+    edge_state_entry *ese = NULL;
+
+    /* if the label doesn't match, it can't be a match */
+    if (edge_label_table_oid != InvalidOid &&
+        vlelctx->edge_label_name_oid != InvalidOid &&
+        vlelctx->edge_label_name_oid != edge_label_table_oid)
+    {
+        return false;
+    }
+
+    ese = get_edge_state(vlelctx, edge_id);
+
+    if (!ese->has_been_matched)
+    {
+        edge_entry *ee = get_edge_entry(vlelctx->ggctx, edge_id);
+
+        /* it better exist */
+        if (ee == NULL)
+        {
+            elog(ERROR, "is_a_matching_edge: no edge found");
+        }
+
+        ese->matched = is_an_edge_match(vlelctx, ee);
+        ese->has_been_matched = true;
+    }
+
+    return ese->matched;
+}
+
+/*
+ * Helper function to call the visitor for each edge of a vertex that satisfies
+ * the VLE edge constraints, along with the vertex on its other end. The
+ * outgoing edges are followed if use_out is set and the incoming edges if
+ * use_in is set. Selfloops are never followed, as they don't lead anywhere
+ * new.
+ */
+static void visit_matching_vertex_edges(VLE_local_context *vlelctx,
+                                        vertex_entry *ve, bool use_out,
+                                        bool use_in,
+                                        matching_edge_visitor visitor,
+                                        void *arg)
+{
+    GRAPH_global_context *ggctx = vlelctx->ggctx;
+    graphid vertex_id = get_vertex_entry_id(ve);
+
+    if (has_GRAPH_global_csr(ggctx))
+    {
+        graph_csr_edge *csr_edges = NULL;
+        int64 num_edges = 0;
+        int64 i;
+
+        if (use_out)
+        {
+            csr_edges = get_vertex_entry_csr_edges_out(ggctx, ve, &num_edges);
+            for (i = 0; i < num_edges; i++)
+            {
+                if (is_a_matching_edge(vlelctx, csr_edges[i].edge_id,
+                                       csr_edges[i].edge_label_table_oid))
+                {
+                    visitor(arg, vertex_id, csr_edges[i].edge_id,
+                            csr_edges[i].vertex_id);
+                }
+            }
+        }
+        if (use_in)
+        {
+            csr_edges = get_vertex_entry_csr_edges_in(ggctx, ve, &num_edges);
+            for (i = 0; i < num_edges; i++)
+            {
+                if (is_a_matching_edge(vlelctx, csr_edges[i].edge_id,
+                                       csr_edges[i].edge_label_table_oid))
+                {
+                    visitor(arg, vertex_id, csr_edges[i].edge_id,
+                            csr_edges[i].vertex_id);
+                }
+            }
+        }
+
+        return;
+    }
+
+    if (use_out)
+    {
+        GraphIdNode *edge = get_list_head(get_vertex_entry_edges_out(ve));
+
+        for (; edge != NULL; edge = next_GraphIdNode(edge))
+        {
+            graphid edge_id = get_graphid(edge);
+
+            if (is_a_matching_edge(vlelctx, edge_id, InvalidOid))
+            {
+                edge_entry *ee = get_edge_entry(ggctx, edge_id);
+
+                visitor(arg, vertex_id, edge_id,
+                        get_edge_entry_end_vertex_id(ee));
+            }
+        }
+    }
+    if (use_in)
+    {
+        GraphIdNode *edge = get_list_head(get_vertex_entry_edges_in(ve));
+
+        for (; edge != NULL; edge = next_GraphIdNode(edge))
+        {
+            graphid edge_id = get_graphid(edge);
+
+            if (is_a_matching_edge(vlelctx, edge_id, InvalidOid))
+            {
+                edge_entry *ee = get_edge_entry(ggctx, edge_id);
+
+                visitor(arg, vertex_id, edge_id,
+                        get_edge_entry_start_vertex_id(ee));
+            }
+        }
+    }
+}
+
+/*
+ * Helper function to visit a vertex from its parent during a frontier
+ * expansion. Newly found vertices are added to the next frontier. When all
+ * shortest paths are wanted, every parent at the previous depth is kept.
+ * Otherwise, only the first one is.
+ */
+static void visit_shortest_path_vertex(void *arg, graphid parent_vertex_id,
+                                       graphid edge_id, graphid vertex_id)
+{
+    shortest_path_search *sps = (shortest_path_search *)arg;
+    shortest_path_entry *spe = NULL;
+    shortest_path_parent *spp = NULL;
+    bool found = false;
+
+    spe = (shortest_path_entry *)hash_search(sps->visiting, (void *)&vertex_id,
+                                             HASH_ENTER, &found);
+
+    if (!found)
+    {
+        spe->vertex_id = vertex_id;
+        spe->depth = sps->depth;
+        spe->parents = NIL;
+
+        sps->next_frontier = append_graphid(sps->next_frontier, vertex_id);
+    }
+    else if (spe->depth != sps->depth || !sps->all_paths)
+    {
+        return;
+    }
+
+    spp = palloc(sizeof(shortest_path_parent));
+    spp->edge_id = edge_id;
+    spp->vertex_id = parent_vertex_id;
+
+    spe->parents = lappend(spe->parents, spp);
+}
+
+/*
+ * Helper function to expand one side of the search by one hop. The forward
+ * side follows the edges in the VLE edge's direction and the backward side
+ * follows them against it. Returns the next frontier, or NULL if it is empty.
+ */
+static ListGraphId *expand_shortest_path_frontier(shortest_path_search *sps,
+                                                  HTAB *visited,
+                                                  ListGraphId *frontier,
+                                                  bool forward, int64 depth)
+{
+    VLE_local_context *vlelctx = sps->vlelctx;
+    GraphIdNode *node = NULL;
+    bool use_out = false;
+    bool use_in = false;
+
+    /* which edge lists to use for the specified direction and side */
+    use_out = (vlelctx->edge_direction == CYPHER_REL_DIR_NONE ||
+               (vlelctx->edge_direction == CYPHER_REL_DIR_RIGHT && forward) ||
+               (vlelctx->edge_direction == CYPHER_REL_DIR_LEFT && !forward));
+    use_in = (vlelctx->edge_direction == CYPHER_REL_DIR_NONE ||
+              (vlelctx->edge_direction == CYPHER_REL_DIR_LEFT && forward) ||
+              (vlelctx->edge_direction == CYPHER_REL_DIR_RIGHT && !forward));
+
+    sps->visiting = visited;
+    sps->next_frontier = NULL;
+    sps->depth = depth;
+
+    for (node = get_list_head(frontier); node != NULL;
+         node = next_GraphIdNode(node))
+    {
+        vertex_entry *ve = NULL;
+
+        CHECK_FOR_INTERRUPTS();
+
+        ve = get_vertex_entry(vlelctx->ggctx, get_graphid(node));
+        /* there better be a valid vertex */
+        if (ve == NULL)
+        {
+            elog(ERROR, "expand_shortest_path_frontier: no vertex found");
+        }
+
+        visit_matching_vertex_edges(vlelctx, ve, use_out, use_in,
+                                    visit_shortest_path_vertex, sps);
+    }
+
+    return sps->next_frontier;
+}
+
+/*
+ * Helper function to walk the forward parents from the vertex at index back to
+ * the start vertex. Each complete walk continues with the backward parents
+ * from the meeting vertex.
+ */
+static void fill_shortest_path_to_start(shortest_path_search *sps,
+                                        graphid vertex_id, int64 index)
+{
+    shortest_path_entry *spe = NULL;
+    ListCell *lc;
+
+    check_stack_depth();
+
+    spe = (shortest_path_entry *)hash_search(sps->forward, (void *)&vertex_id,
+                                             HASH_FIND, NULL);
+    Assert(spe != NULL);
+
+    sps->path[index] = vertex_id;
+
+    if (spe->depth == 0)
+    {
+        Assert(index == 0);
+
+        fill_shortest_path_to_end(sps, sps->path[sps->meet_index],
+                                  sps->meet_index);
+        return;
+    }
+
+    foreach (lc, spe->parents)
+    {
+        shortest_path_parent *spp = lfirst(lc);
+
+        sps->path[index - 1] = spp->edge_id;
+        fill_shortest_path_to_start(sps, spp->vertex_id, index - 2);
+    }
+}
+
+/*
+ * Helper function to walk the backward parents from the vertex at index to the
+ * end vertex. Each complete walk is a shortest path, which is copied into a
+ * VLE_path_container.
+ */
+static void fill_shortest_path_to_end(shortest_path_search *sps,
+                                      graphid vertex_id, int64 index)
+{
+    shortest_path_entry *spe = NULL;
+    ListCell *lc;
+
+    check_stack_depth();
+
+    sps->path[index] = vertex_id;
+
+    if (index == sps->path_size - 1)
+    {
+        VLE_path_container *vpc = NULL;
+
+        vpc = create_VLE_path_container(sps->path_size);
+        vpc->graph_oid = sps->vlelctx->graph_oid;
+        memcpy(GET_GRAPHID_ARRAY_FROM_CONTAINER(vpc), sps->path,
+               sizeof(graphid) * sps->path_size);
+
+        sps->paths = lappend(sps->paths, vpc);
+        return;
+    }
+
+    spe = (shortest_path_entry *)hash_search(sps->backward, (void *)&vertex_id,
+                                             HASH_FIND, NULL);
+    Assert(spe != NULL);
+
+    foreach (lc, spe->parents)
+    {
+        shortest_path_parent *spp = lfirst(lc);
+
+        sps->path[index + 1] = spp->edge_id;
+        fill_shortest_path_to_end(sps, spp->vertex_id, index + 2);
+    }
+}
+
+/*
+ * Helper function to build the shortest path(s) through the vertex where the
+ * two sides of the search meet. Without a backward side, the meeting vertex is
+ * the end of the path.
+ */
+static void collect_shortest_paths(shortest_path_search *sps,
+                                   graphid meet_vertex_id)
+{
+    shortest_path_entry *spe = NULL;
+    int64 forward_depth = 0;
+    int64 backward_depth = 0;
+
+    spe = (shortest_path_entry *)hash_search(sps->forward,
+                                             (void *)&meet_vertex_id,
+                                             HASH_FIND, NULL);
+    Assert(spe != NULL);
+    forward_depth = spe->depth;
+
+    if (sps->backward != NULL)
+    {
+        spe = (shortest_path_entry *)hash_search(sps->backward,
+                                                 (void *)&meet_vertex_id,
+                                                 HASH_FIND, NULL);
+        Assert(spe != NULL);
+        backward_depth = spe->depth;
+    }
+
+    /* the path size is always 2 times the number of edges plus 1 */
+    sps->path_size = ((forward_depth + backward_depth) * 2) + 1;
+    sps->meet_index = forward_depth * 2;
+    sps->path = palloc(sizeof(graphid) * sps->path_size);
+    sps->path[sps->meet_index] = meet_vertex_id;
+
+    fill_shortest_path_to_start(sps, meet_vertex_id, sps->meet_index);
+
+    pfree(sps->path);
+    sps->path = NULL;
+}
+
+/*
+ * Helper function to find the shortest path(s) from the start vertex with a
+ * breadth first search. If an end vertex was provided, the search is run from
+ * both ends, always expanding the smaller frontier by one hop, until the two
+ * sides meet. The first expansion that reaches a vertex already visited by the
+ * other side determines the shortest path length, and every vertex it reaches
+ * that way lies on a shortest path. Without an end vertex, one (or all)
+ * shortest path(s) to every reachable vertex are returned, in order of length.
+ *
+ * Edges are matched with the same label, property, and direction constraints
+ * as the VLE. The paths are returned as a list of VLE_path_containers.
+ */
+static List *find_shortest_paths(VLE_local_context *vlelctx, bool all_paths)
+{
+    shortest_path_search sps;
+    ListGraphId *forward_frontier = NULL;
+    ListGraphId *backward_frontier = NULL;
+    int64 forward_depth = 0;
+    int64 backward_depth = 0;
+    List *meets = NIL;
+    ListCell *lc;
+
+    MemSet(&sps, 0, sizeof(sps));
+    sps.vlelctx = vlelctx;
+    sps.all_paths = all_paths;
+
+    /* if either end doesn't exist, there won't be anything to find */
+    if (!do_vsid_and_veid_exist(vlelctx))
+    {
+        return NIL;
+    }
+
+    /* the zero length path [*0..x] */
+    if (vlelctx->lidx == 0 &&
+        (vlelctx->path_function == VLE_FUNCTION_PATHS_FROM ||
+         vlelctx->vsid == vlelctx->veid))
+    {
+        sps.paths = lappend(sps.paths, build_VLE_zero_container(vlelctx));
+    }
+
+    /* a vertex doesn't have a shortest path to itself beyond that */
+    if ((vlelctx->path_function == VLE_FUNCTION_PATHS_BETWEEN &&
+         vlelctx->vsid == vlelctx->veid) ||
+        (!vlelctx->uidx_infinite && vlelctx->uidx < 1))
+    {
+        return sps.paths;
+    }
+
+    sps.forward = create_shortest_path_hashtable("shortest path forward");
+    add_shortest_path_root(sps.forward, vlelctx->vsid);
+    forward_frontier = append_graphid(NULL, vlelctx->vsid);
+
+    /* without an end vertex, search out from the start vertex */
+    if (vlelctx->path_function == VLE_FUNCTION_PATHS_FROM)
+    {
+        while (forward_frontier != NULL &&
+               (vlelctx->uidx_infinite || forward_depth < vlelctx->uidx))
+        {
+            ListGraphId *next_frontier = NULL;
+            GraphIdNode *node = NULL;
+
+            forward_depth++;
+            next_frontier = expand_shortest_path_frontier(&sps, sps.forward,
+                                                          forward_frontier,
+                                                          true, forward_depth);
+            free_ListGraphId(forward_frontier);
+            forward_frontier = next_frontier;
+
+            for (node = get_list_head(forward_frontier); node != NULL;
+                 node = next_GraphIdNode(node))
+            {
+                collect_shortest_paths(&sps, get_graphid(node));
+            }
+        }
+
+        free_ListGraphId(forward_frontier);
+        hash_destroy(sps.forward);
+
+        return sps.paths;
+    }
+
+    sps.backward = create_shortest_path_hashtable("shortest path backward");
+    add_shortest_path_root(sps.backward, vlelctx->veid);
+    backward_frontier = append_graphid(NULL, vlelctx->veid);
+
+    while (meets == NIL && forward_frontier != NULL &&
+           backward_frontier != NULL &&
+           (vlelctx->uidx_infinite ||
+            forward_depth + backward_depth < vlelctx->uidx))
+    {
+        ListGraphId *next_frontier = NULL;
+        HTAB *other = NULL;
+        GraphIdNode *node = NULL;
+
+        /* expand the smaller side */
+        if (get_list_size(forward_frontier) <= get_list_size(backward_frontier))
+        {
+            forward_depth++;
+            next_frontier = expand_shortest_path_frontier(&sps, sps.forward,
+                                                          forward_frontier,
+                                                          true, forward_depth);
+            free_ListGraphId(forward_frontier);
+            forward_frontier = next_frontier;
+            other = sps.backward;
+        }
+        else
+        {
+            backward_depth++;
+            next_frontier = expand_shortest_path_frontier(&sps, sps.backward,
+                                                          backward_frontier,
+                                                          false,
+                                                          backward_depth);
+            free_ListGraphId(backward_frontier);
+            backward_frontier = next_frontier;
+            other = sps.forward;
+        }
+
+        /* find where, if anywhere, the two sides meet */
+        for (node = get_list_head(next_frontier); node != NULL;
+             node = next_GraphIdNode(node))
+        {
+            graphid vertex_id = get_graphid(node);
+
+            if (hash_search(other, (void *)&vertex_id, HASH_FIND, NULL) != NULL)
+            {
+                meets = lappend(meets, node);
+            }
+        }
+    }
+
+    foreach (lc, meets)
+    {
+        collect_shortest_paths(&sps, get_graphid(lfirst(lc)));
+
+        /* one is enough for shortestPath */
+        if (!all_paths)
+        {
+            break;
+        }
+    }
+
+    list_free(meets);
+    free_ListGraphId(forward_frontier);
+    free_ListGraphId(backward_frontier);
+    hash_destroy(sps.forward);
+    hash_destroy(sps.backward);
+
+    return sps.paths;
+}
+
+PG_FUNCTION_INFO_V1(age_vle_shortest_path);
+
+/*
+ * SRF for shortestPath and allShortestPaths. It takes the same arguments as
+ * the 7 argument age_vle, plus the mode - 0 for one shortest path and 1 for all
+ * shortest paths. The start vertex is required. All of the paths are found on
+ * the first call and then returned one per call.
+ */
+Datum age_vle_shortest_path(PG_FUNCTION_ARGS)
+{
+    FuncCallContext *funcctx;
+    List *paths = NIL;
+
+    /* Initialization for the first call to the SRF */
+    if (SRF_IS_FIRSTCALL())
+    {
+        VLE_local_context *vlelctx = NULL;
+        agtype_value *agtv_temp = NULL;
+        MemoryContext oldctx;
+        bool all_paths = false;
+
+        /* all of these arguments need to be non NULL */
+        if (PG_ARGISNULL(0) || /* graph name */
+            PG_ARGISNULL(3) || /* edge prototype */
+            PG_ARGISNULL(6) || /* direction */
+            PG_ARGISNULL(7))   /* mode */
+        {
+             ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("age_vle_shortest_path: invalid NULL argument passed")));
+        }
+
+        /* the search needs somewhere to start */
+        if (PG_ARGISNULL(1) || is_agtype_null(AG_GET_ARG_AGTYPE_P(1)))
+        {
+             ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("age_vle_shortest_path: a start vertex is required")));
+        }
+
+        /* get the mode */
+        agtv_temp = get_agtype_value("age_vle_shortest_path",
+                                     AG_GET_ARG_AGTYPE_P(7), AGTV_INTEGER,
+                                     true);
+        all_paths = (agtv_temp->val.int_value == 1);
+
+        /* create a function context for cross-call persistence */
+        funcctx = SRF_FIRSTCALL_INIT();
+
+        /* build the local vle context, it isn't cached */
+        vlelctx = build_local_vle_context(fcinfo, funcctx, false);
+
+        if (vlelctx->lidx > 1)
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                     errmsg("shortest path does not support a minimal length different from 0 or 1")));
+        }
+
+        /* the paths need to survive multiple SRF calls */
+        oldctx = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+        funcctx->user_fctx = find_shortest_paths(vlelctx, all_paths);
+
+        MemoryContextSwitchTo(oldctx);
+
+        /* we are done with the local context */
+        vlelctx->is_dirty = false;
+        free_VLE_local_context(vlelctx);
+    }
+
+    /* stuff done on every call of the function */
+    funcctx = SRF_PERCALL_SETUP();
+
+    paths = (List *)funcctx->user_fctx;
+
+    if (funcctx->call_cntr < list_length(paths))
+    {
+        SRF_RETURN_NEXT(funcctx,
+                        PointerGetDatum(list_nth(paths, funcctx->call_cntr)));
+    }
+
+    SRF_RETURN_DONE(funcctx);
+}
+
+/*
+ * Helper function to build the state of a reachability search. With only an
+ * end vertex, the search runs backward from it. Otherwise, it runs forward
+ * from the start vertex or, with neither, from each vertex in turn.
+ */
+static reachability_search *build_reachability_search(VLE_local_context *vlelctx)
+{
+    GRAPH_global_context *ggctx = vlelctx->ggctx;
+    reachability_search *rs = NULL;
+
+    rs = palloc0(sizeof(reachability_search));
+    rs->vlelctx = vlelctx;
+    rs->forward = (vlelctx->path_function != VLE_FUNCTION_PATHS_TO);
+
+    /* which edge lists to use for the specified direction and side */
+    rs->use_out = (vlelctx->edge_direction == CYPHER_REL_DIR_NONE ||
+                   (vlelctx->edge_direction == CYPHER_REL_DIR_RIGHT &&
+                    rs->forward) ||
+                   (vlelctx->edge_direction == CYPHER_REL_DIR_LEFT &&
+                    !rs->forward));
+    rs->use_in = (vlelctx->edge_direction == CYPHER_REL_DIR_NONE ||
+                  (vlelctx->edge_direction == CYPHER_REL_DIR_LEFT &&
+                   rs->forward) ||
+                  (vlelctx->edge_direction == CYPHER_REL_DIR_RIGHT &&
+                   !rs->forward));
+
+    /* the CSR adjacency numbers the vertices densely, so use a bitmap */
+    if (has_GRAPH_global_csr(ggctx))
+    {
+        int64 num_vertices = get_GRAPH_global_csr_num_vertices(ggctx);
+
+        rs->visited_bitmap_size = (num_vertices + BITS_PER_BYTE - 1) /
+                                  BITS_PER_BYTE;
+        rs->visited_bitmap = palloc0(Max(rs->visited_bitmap_size, 1));
+    }
+
+    /* if either end doesn't exist, there won't be anything to find */
+    if (!do_vsid_and_veid_exist(vlelctx))
+    {
+        rs->done = true;
+        return rs;
+    }
+
+    start_reachability_root(rs, rs->forward ? vlelctx->vsid : vlelctx->veid);
+
+    return rs;
+}
+
+/*
+ * Helper function to (re)start the search from a root vertex. The root is only
+ * marked as visited for a zero lower bound, where it is returned first as the
+ * zero length path. Otherwise, it can still be reached back through a cycle.
+ */
+static void start_reachability_root(reachability_search *rs, graphid root_id)
+{
+    /* forget what was visited from the previous root */
+    if (rs->visited_bitmap != NULL)
+    {
+        MemSet(rs->visited_bitmap, 0, rs->visited_bitmap_size);
+    }
+    else
+    {
+        HASHCTL ctl;
+
+        if (rs->visited != NULL)
+        {
+            hash_destroy(rs->visited);
+        }
+
+        MemSet(&ctl, 0, sizeof(ctl));
+        ctl.keysize = sizeof(graphid);
+        ctl.entrysize = sizeof(graphid);
+        ctl.hcxt = CurrentMemoryContext;
+
+        rs->visited = hash_create("reachability visited",
+                                  REACHABILITY_HTAB_INITIAL_SIZE, &ctl,
+                                  HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+    }
+
+    free_ListGraphId(rs->level_vertices);
+    free_ListGraphId(rs->level_edges);
+
+    /* the root is the only vertex at depth 0 */
+    rs->root_id = root_id;
+    rs->level_vertices = append_graphid(NULL, root_id);
+    rs->level_edges = NULL;
+    rs->next_vertex = NULL;
+    rs->next_edge = NULL;
+    rs->depth = 0;
+
+    rs->root_pending = (rs->vlelctx->lidx == 0);
+    if (rs->root_pending)
+    {
+        mark_reachability_visited(rs, root_id);
+    }
+}
+
+/*
+ * Helper function to mark a vertex as visited. Returns true if it wasn't
+ * already.
+ */
+static bool mark_reachability_visited(reachability_search *rs,
+                                      graphid vertex_id)
+{
+    bool found = false;
+
+    if (rs->visited_bitmap != NULL)
+    {
+        vertex_entry *ve = NULL;
+        int64 index = 0;
+        bits8 mask = 0;
+
+        ve = get_vertex_entry(rs->vlelctx->ggctx, vertex_id);
+        /* there better be a valid vertex */
+        if (ve == NULL)
+        {
+            elog(ERROR, "mark_reachability_visited: no vertex found");
+        }
+
+        index = get_vertex_entry_csr_index(ve);
+        mask = (bits8) (1 << (index % BITS_PER_BYTE));
+
+        if ((rs->visited_bitmap[index / BITS_PER_BYTE] & mask) != 0)
+        {
+            return false;
+        }
+
+        rs->visited_bitmap[index / BITS_PER_BYTE] |= mask;
+
+        return true;
+    }
+
+    hash_search(rs->visited, (void *)&vertex_id, HASH_ENTER, &found);
+
+    return !found;
+}
+
+/*
+ * Helper function to visit a vertex during a level expansion. Newly found
+ * vertices are added to the next level, with the edge they were reached
+ * through.
+ */
+static void visit_reachability_vertex(void *arg, graphid vertex_id,
+                                      graphid edge_id,
+                                      graphid next_vertex_id)
+{
+    reachability_search *rs = (reachability_search *)arg;
+
+    if (mark_reachability_visited(rs, next_vertex_id))
+    {
+        rs->level_vertices = append_graphid(rs->level_vertices,
+                                            next_vertex_id);
+        rs->level_edges = append_graphid(rs->level_edges, edge_id);
+    }
+}
+
+/*
+ * Helper function to find a selfloop of a vertex that satisfies the VLE edge
+ * constraints. If there is one, its id is returned in edge_id.
+ */
+static bool get_matching_selfloop(VLE_local_context *vlelctx, vertex_entry *ve,
+                                  graphid *edge_id)
+{
+    GRAPH_global_context *ggctx = vlelctx->ggctx;
+    GraphIdNode *edge = NULL;
+
+    if (has_GRAPH_global_csr(ggctx))
+    {
+        graph_csr_edge *csr_edges = NULL;
+        int64 num_edges = 0;
+        int64 i;
+
+        csr_edges = get_vertex_entry_csr_edges_self(ggctx, ve, &num_edges);
+        for (i = 0; i < num_edges; i++)
+        {
+            if (is_a_matching_edge(vlelctx, csr_edges[i].edge_id,
+                                   csr_edges[i].edge_label_table_oid))
+            {
+                *edge_id = csr_edges[i].edge_id;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    edge = get_list_head(get_vertex_entry_edges_self(ve));
+    for (; edge != NULL; edge = next_GraphIdNode(edge))
+    {
+        if (is_a_matching_edge(vlelctx, get_graphid(edge), InvalidOid))
+        {
+            *edge_id = get_graphid(edge);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Helper function to replace the current level with the next one, the
+ * vertices first reached one hop further out. Returns false if the upper
+ * bound was reached or if nothing new was.
+ */
+static bool expand_reachability_level(reachability_search *rs)
+{
+    VLE_local_context *vlelctx = rs->vlelctx;
+    ListGraphId *frontier = rs->level_vertices;
+    GraphIdNode *node = NULL;
+
+    free_ListGraphId(rs->level_edges);
+    rs->level_vertices = NULL;
+    rs->level_edges = NULL;
+    rs->next_vertex = NULL;
+    rs->next_edge = NULL;
+
+    if (frontier == NULL ||
+        (!vlelctx->uidx_infinite && rs->depth >= vlelctx->uidx))
+    {
+        free_ListGraphId(frontier);
+        return false;
+    }
+
+    rs->depth++;
+
+    for (node = get_list_head(frontier); node != NULL;
+         node = next_GraphIdNode(node))
+    {
+        vertex_entry *ve = NULL;
+
+        CHECK_FOR_INTERRUPTS();
+
+        ve = get_vertex_entry(vlelctx->ggctx, get_graphid(node));
+        /* there better be a valid vertex */
+        if (ve == NULL)
+        {
+            elog(ERROR, "expand_reachability_level: no vertex found");
+        }
+
+        /* a selfloop can only reach the root, from the root, at depth 1 */
+        if (rs->depth == 1)
+        {
+            graphid edge_id = 0;
+
+            if (get_matching_selfloop(vlelctx, ve, &edge_id))
+            {
+                visit_reachability_vertex(rs, rs->root_id, edge_id,
+                                          rs->root_id);
+            }
+        }
+
+        visit_matching_vertex_edges(vlelctx, ve, rs->use_out, rs->use_in,
+                                    visit_reachability_vertex, rs);
+    }
+
+    free_ListGraphId(frontier);
+
+    rs->next_vertex = get_list_head(rs->level_vertices);
+    rs->next_edge = get_list_head(rs->level_edges);
+
+    return (rs->level_vertices != NULL);
+}
+
+/*
+ * Helper function to get the next reachable vertex, and the edge it was first
+ * reached through. The edge is 0 for the zero length path. Levels are expanded
+ * as they are used up, so only the current one is ever held. Returns false when
+ * there are no more vertices.
+ */
+static bool next_reachable_vertex(reachability_search *rs,
+                                  graphid *vertex_id, graphid *edge_id)
+{
+    VLE_local_context *vlelctx = rs->vlelctx;
+
+    while (!rs->done)
+    {
+        bool found = false;
+
+        if (rs->root_pending)
+        {
+            rs->root_pending = false;
+            *vertex_id = rs->root_id;
+            *edge_id = 0;
+            found = true;
+        }
+        else if (rs->next_vertex != NULL)
+        {
+            *vertex_id = get_graphid(rs->next_vertex);
+            *edge_id = get_graphid(rs->next_edge);
+            rs->next_vertex = next_GraphIdNode(rs->next_vertex);
+            rs->next_edge = next_GraphIdNode(rs->next_edge);
+            found = true;
+        }
+        else if (expand_reachability_level(rs))
+        {
+            continue;
+        }
+        /* without a start or an end vertex, move on to the next start vertex */
+        else if (vlelctx->path_function == VLE_FUNCTION_PATHS_ALL &&
+                 vlelctx->next_vertex != NULL)
+        {
+            start_reachability_root(rs, get_graphid(vlelctx->next_vertex));
+            vlelctx->next_vertex = next_GraphIdNode(vlelctx->next_vertex);
+            continue;
+        }
+        else
+        {
+            rs->done = true;
+            continue;
+        }
+
+        /* with both vertices, only the end vertex is wanted */
+        if (vlelctx->path_function != VLE_FUNCTION_PATHS_BETWEEN)
+        {
+            return true;
+        }
+        if (*vertex_id == vlelctx->veid)
+        {
+            rs->done = true;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Helper function to build the VLE_path_container for a reachable vertex. The
+ * paths aren't kept, so it is just the start vertex, the edge the vertex was
+ * first reached through, and the end vertex. That is all the VLE's terminal
+ * vertices are matched with. The zero length path is just the vertex.
+ */
+static VLE_path_container *build_reachability_container(reachability_search *rs,
+                                                        graphid vertex_id,
+                                                        graphid edge_id)
+{
+    VLE_path_container *vpc = NULL;
+    graphid *graphid_array = NULL;
+
+    vpc = create_VLE_path_container(edge_id == 0 ? 1 : 3);
+
+    /* set the graph_oid */
+    vpc->graph_oid = rs->vlelctx->graph_oid;
+
+    /* get the graphid_array from the container */
+    graphid_array = GET_GRAPHID_ARRAY_FROM_CONTAINER(vpc);
+
+    if (edge_id == 0)
+    {
+        graphid_array[0] = vertex_id;
+    }
+    else
+    {
+        graphid_array[0] = rs->forward ? rs->root_id : vertex_id;
+        graphid_array[1] = edge_id;
+        graphid_array[2] = rs->forward ? vertex_id : rs->root_id;
+    }
+
+    return vpc;
+}
+
+PG_FUNCTION_INFO_V1(age_vle_reachable);
+
+/*
+ * SRF for the reachability mode of the VLE. The transform uses it in place of
+ * age_vle, with the same arguments, when only the terminal vertices of the VLE
+ * are used and duplicates of them are discarded, as in -
+ *
+ *     MATCH (a)-[*1..6]->(b) RETURN DISTINCT b
+ *
+ * Instead of enumerating every path, a level synchronous breadth first search
+ * returns each reachable vertex once, at its minimal depth. The memory used is
+ * bounded by the number of vertices, not paths. Only lower bounds of 0 and 1
+ * are supported, and 1 only for a directed VLE, as anything else depends on
+ * the paths themselves.
+ */
+Datum age_vle_reachable(PG_FUNCTION_ARGS)
+{
+    FuncCallContext *funcctx;
+    reachability_search *rs = NULL;
+    graphid vertex_id = 0;
+    graphid edge_id = 0;
+    bool found = false;
+    MemoryContext oldctx;
+
+    /* Initialization for the first call to the SRF */
+    if (SRF_IS_FIRSTCALL())
+    {
+        VLE_local_context *vlelctx = NULL;
+
+        /* all of these arguments need to be non NULL */
+        if (PG_ARGISNULL(0) || /* graph name */
+            PG_ARGISNULL(3) || /* edge prototype */
+            PG_ARGISNULL(6))   /* direction */
+        {
+             ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("age_vle_reachable: invalid NULL argument passed")));
+        }
+
+        /* create a function context for cross-call persistence */
+        funcctx = SRF_FIRSTCALL_INIT();
+
+        /* build the local vle context, it isn't cached */
+        vlelctx = build_local_vle_context(fcinfo, funcctx, false);
+
+        if (vlelctx->lidx > 1)
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                     errmsg("reachability search does not support a minimal length greater than 1")));
+        }
+        if (vlelctx->lidx == 1 &&
+            vlelctx->edge_direction == CYPHER_REL_DIR_NONE)
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                     errmsg("reachability search requires a directed relationship for a minimal length of 1")));
+        }
+
+        /* the search needs to survive multiple SRF calls */
+        oldctx = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+        funcctx->user_fctx = build_reachability_search(vlelctx);
+
+        MemoryContextSwitchTo(oldctx);
+    }
+
+    /* stuff done on every call of the function */
+    funcctx = SRF_PERCALL_SETUP();
+    rs = (reachability_search *)funcctx->user_fctx;
+
+    /* the search state needs to survive multiple SRF calls */
+    oldctx = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+    found = next_reachable_vertex(rs, &vertex_id, &edge_id);
+
+    MemoryContextSwitchTo(oldctx);
+
+    if (found)
+    {
+        VLE_path_container *vpc = NULL;
+
+        vpc = build_reachability_container(rs, vertex_id, edge_id);
+
+        SRF_RETURN_NEXT(funcctx, PointerGetDatum(vpc));
+    }
+
+    /* we are done with the local context */
+    rs->vlelctx->is_dirty = false;
+    free_VLE_local_context(rs->vlelctx);
+    rs->vlelctx = NULL;
+
+    SRF_RETURN_DONE(funcctx);
+}
+
+/*
+ * Comparator for the weighted path queue. The pairing heap keeps the largest
+ * node first, so the node with the smaller estimate compares as larger.
+ */
+static int weighted_path_queue_cmp(const pairingheap_node *a,
+                                   const pairingheap_node *b, void *arg)
+{
+    const weighted_path_queue_node *wpqa =
+        pairingheap_const_container(weighted_path_queue_node, ph_node, a);
+    const weighted_path_queue_node *wpqb =
+        pairingheap_const_container(weighted_path_queue_node, ph_node, b);
+
+    if (wpqa->estimate < wpqb->estimate)
+    {
+        return 1;
+    }
+    if (wpqa->estimate > wpqb->estimate)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+/* helper function to find a property of a vertex or edge by its key */
+static agtype_value *get_entity_property(Datum properties, char *key)
+{
+    agtype *agt_properties = DATUM_GET_AGTYPE_P(properties);
+    agtype_value agtv_key;
+
+    agtv_key.type = AGTV_STRING;
+    agtv_key.val.string.val = key;
+    agtv_key.val.string.len = strlen(key);
+
+    return find_agtype_value_from_container(&agt_properties->root,
+                                            AGT_FOBJECT, &agtv_key);
+}
+
+/* helper function to convert a numeric agtype_value to a float8 */
+static bool get_agtype_value_float8(agtype_value *agtv, float8 *result)
+{
+    switch (agtv->type)
+    {
+        case AGTV_INTEGER:
+            *result = (float8)agtv->val.int_value;
+            return true;
+
+        case AGTV_FLOAT:
+            *result = agtv->val.float_value;
+            return true;
+
+        case AGTV_NUMERIC:
+            *result = DatumGetFloat8(DirectFunctionCall1(numeric_float8,
+                                     NumericGetDatum(agtv->val.numeric)));
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+/*
+ * Helper function to get the weight of an edge. Dijkstra requires every
+ * weight to be a non-negative number.
+ */
+static float8 get_edge_weight(weighted_path_search *wps, graphid edge_id)
+{
+    edge_entry *ee = NULL;
+    agtype_value *agtv_weight = NULL;
+    float8 weight = 0;
+
+    ee = get_edge_entry(wps->vlelctx->ggctx, edge_id);
+
+    agtv_weight = get_entity_property(get_edge_entry_properties(ee),
+                                      wps->weight_key);
+
+    if (agtv_weight == NULL ||
+        !get_agtype_value_float8(agtv_weight, &weight) ||
+        isnan(weight) || weight < 0)
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("edge property \"%s\" must be a non-negative number",
+                        wps->weight_key)));
+    }
+
+    return weight;
+}
+
+/*
+ * Helper function to get the A* heuristic for a vertex - the estimated cost
+ * from it to the end vertex. The heuristic property is either a number, which
+ * is the estimate itself, or a list of numbers, which are coordinates. For
+ * coordinates, the estimate is the Euclidean distance to the end vertex's
+ * coordinates, which need to be in the same units as the weights. Vertices
+ * without the property are estimated at 0. The estimate must never be more
+ * than the actual cost, or the path found may not be the cheapest one. It
+ * doesn't need to be consistent, as settled vertices are reopened when a
+ * cheaper path to them is found.
+ */
+static float8 get_vertex_heuristic(weighted_path_search *wps,
+                                   graphid vertex_id)
+{
+    vertex_entry *ve = NULL;
+    agtype_value *agtv_heuristic = NULL;
+    agtype_container *agtc_coordinates = NULL;
+    agtype_container *agtc_end_coordinates = NULL;
+    float8 heuristic = 0;
+    uint32 num_coordinates = 0;
+    uint32 i;
+
+    if (wps->heuristic_key == NULL || wps->end_heuristic == NULL)
+    {
+        return 0;
+    }
+
+    ve = get_vertex_entry(wps->vlelctx->ggctx, vertex_id);
+    agtv_heuristic = get_entity_property(get_vertex_entry_properties(ve),
+                                         wps->heuristic_key);
+
+    if (agtv_heuristic == NULL)
+    {
+        return 0;
+    }
+
+    if (get_agtype_value_float8(agtv_heuristic, &heuristic))
+    {
+        return heuristic;
+    }
+
+    if (agtv_heuristic->type != AGTV_BINARY ||
+        wps->end_heuristic->type != AGTV_BINARY ||
+        !AGTYPE_CONTAINER_IS_ARRAY(agtv_heuristic->val.binary.data) ||
+        !AGTYPE_CONTAINER_IS_ARRAY(wps->end_heuristic->val.binary.data))
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("vertex property \"%s\" must be a number or a list of numbers",
+                        wps->heuristic_key)));
+    }
+
+    agtc_coordinates = agtv_heuristic->val.binary.data;
+    agtc_end_coordinates = wps->end_heuristic->val.binary.data;
+    num_coordinates = AGTYPE_CONTAINER_SIZE(agtc_coordinates);
+
+    if (num_coordinates != AGTYPE_CONTAINER_SIZE(agtc_end_coordinates))
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("vertex property \"%s\" must have the same number of coordinates for every vertex",
+                        wps->heuristic_key)));
+    }
+
+    for (i = 0; i < num_coordinates; i++)
+    {
+        float8 coordinate = 0;
+        float8 end_coordinate = 0;
+
+        if (!get_agtype_value_float8(
+                get_ith_agtype_value_from_container(agtc_coordinates, i),
+                &coordinate) ||
+            !get_agtype_value_float8(
+                get_ith_agtype_value_from_container(agtc_end_coordinates, i),
+                &end_coordinate))
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("vertex property \"%s\" must be a number or a list of numbers",
+                            wps->heuristic_key)));
+        }
+
+        heuristic += (coordinate - end_coordinate) *
+                     (coordinate - end_coordinate);
+    }
+
+    return sqrt(heuristic);
+}
+
+/* helper function to add a vertex to the queue at its current cost */
+static void queue_weighted_path_vertex(weighted_path_search *wps,
+                                       weighted_path_entry *wpe)
+{
+    weighted_path_queue_node *wpqn = NULL;
+
+    wpqn = palloc(sizeof(weighted_path_queue_node));
+    wpqn->vertex_id = wpe->vertex_id;
+    wpqn->cost = wpe->cost;
+    wpqn->estimate = wpe->cost + wpe->heuristic;
+
+    pairingheap_add(wps->queue, &wpqn->ph_node);
+}
+
+/*
+ * Helper function to relax an edge out of the vertex being settled. If it
+ * leads to a cheaper path to the vertex on its other end, that vertex is
+ * queued again at the new cost, even if it was already settled. That can only
+ * happen with an inconsistent A* heuristic, never for Dijkstra. Stale queue
+ * nodes are skipped when they come off the queue, instead of being removed
+ * here.
+ */
+static void relax_weighted_path_edge(void *arg, graphid vertex_id,
+                                     graphid edge_id, graphid next_vertex_id)
+{
+    weighted_path_search *wps = (weighted_path_search *)arg;
+    weighted_path_entry *wpe = NULL;
+    float8 cost = 0;
+    bool found = false;
+
+    cost = wps->current->cost + get_edge_weight(wps, edge_id);
+
+    wpe = (weighted_path_entry *)hash_search(wps->visited,
+                                             (void *)&next_vertex_id,
+                                             HASH_ENTER, &found);
+    if (!found)
+    {
+        wpe->vertex_id = next_vertex_id;
+        wpe->cost = get_float8_infinity();
+        wpe->heuristic = get_vertex_heuristic(wps, next_vertex_id);
+        wpe->settled = false;
+    }
+
+    if (cost >= wpe->cost)
+    {
+        return;
+    }
+
+    wpe->cost = cost;
+    wpe->settled = false;
+    wpe->parent_edge_id = edge_id;
+    wpe->parent_vertex_id = vertex_id;
+    wpe->hops = wps->current->hops + 1;
+
+    queue_weighted_path_vertex(wps, wpe);
+}
+
+/*
+ * Helper function to settle the next cheapest vertex and relax its edges.
+ * Returns NULL when there aren't any vertices left to settle.
+ */
+static weighted_path_entry *settle_weighted_path_vertex(weighted_path_search *wps)
+{
+    VLE_local_context *vlelctx = wps->vlelctx;
+    bool use_out = false;
+    bool use_in = false;
+
+    /* which edge lists to use for the specified direction */
+    use_out = (vlelctx->edge_direction == CYPHER_REL_DIR_RIGHT ||
+               vlelctx->edge_direction == CYPHER_REL_DIR_NONE);
+    use_in = (vlelctx->edge_direction == CYPHER_REL_DIR_LEFT ||
+              vlelctx->edge_direction == CYPHER_REL_DIR_NONE);
+
+    while (!pairingheap_is_empty(wps->queue))
+    {
+        weighted_path_queue_node *wpqn = NULL;
+        weighted_path_entry *wpe = NULL;
+        vertex_entry *ve = NULL;
+        float8 cost = 0;
+
+        CHECK_FOR_INTERRUPTS();
+
+        wpqn = pairingheap_container(weighted_path_queue_node, ph_node,
+                                     pairingheap_remove_first(wps->queue));
+        wpe = (weighted_path_entry *)hash_search(wps->visited,
+                                                 (void *)&wpqn->vertex_id,
+                                                 HASH_FIND, NULL);
+        cost = wpqn->cost;
+        pfree(wpqn);
+
+        /* skip stale nodes, a cheaper one was queued after it */
+        if (wpe->settled || cost > wpe->cost)
+        {
+            continue;
+        }
+
+        wpe->settled = true;
+
+        ve = get_vertex_entry(vlelctx->ggctx, wpe->vertex_id);
+        wps->current = wpe;
+        visit_matching_vertex_edges(vlelctx, ve, use_out, use_in,
+                                    relax_weighted_path_edge, wps);
+        wps->current = NULL;
+
+        return wpe;
+    }
+
+    return NULL;
+}
+
+/*
+ * Helper function to build the VLE_path_container for the cheapest path to a
+ * settled vertex, by following its parents back to the start vertex.
+ */
+static VLE_path_container *build_weighted_path_container(weighted_path_search *wps,
+                                                         weighted_path_entry *wpe)
+{
+    VLE_path_container *vpc = NULL;
+    graphid *graphid_array = NULL;
+    int64 index = 0;
+
+    /* the path size is always 2 times the number of edges plus 1 */
+    vpc = create_VLE_path_container((wpe->hops * 2) + 1);
+    vpc->graph_oid = wps->vlelctx->graph_oid;
+    graphid_array = GET_GRAPHID_ARRAY_FROM_CONTAINER(vpc);
+
+    /* fill in the array from the back to the front */
+    index = vpc->graphid_array_size - 1;
+    graphid_array[index] = wpe->vertex_id;
+
+    while (index > 0)
+    {
+        graphid_array[index - 1] = wpe->parent_edge_id;
+
+        wpe = (weighted_path_entry *)hash_search(wps->visited,
+                                                 (void *)&wpe->parent_vertex_id,
+                                                 HASH_FIND, NULL);
+        Assert(wpe != NULL);
+
+        index -= 2;
+        graphid_array[index] = wpe->vertex_id;
+    }
+
+    return vpc;
+}
+
+/*
+ * Helper function to build the weighted path search from the SRF arguments.
+ * The search state, and the local VLE context it uses for the edge
+ * constraints, are created in the current memory context.
+ */
+static weighted_path_search *build_weighted_path_search(FunctionCallInfo fcinfo)
+{
+    weighted_path_search *wps = NULL;
+    VLE_local_context *vlelctx = NULL;
+    weighted_path_entry *wpe = NULL;
+    agtype_value *agtv_temp = NULL;
+    HASHCTL ctl;
+
+    vlelctx = palloc0(sizeof(VLE_local_context));
+
+    /* get the graph name and the global context for it */
+    agtv_temp = get_agtype_value("age_weighted_shortest_path",
+                                 AG_GET_ARG_AGTYPE_P(0), AGTV_STRING, true);
+    vlelctx->graph_name = pnstrdup(agtv_temp->val.string.val,
+                                   agtv_temp->val.string.len);
+    vlelctx->graph_oid = get_graph_oid(vlelctx->graph_name);
+    vlelctx->ggctx = manage_GRAPH_global_contexts(vlelctx->graph_name,
+                                                  vlelctx->graph_oid);
+
+    /* get the start and, optionally, the end vertex */
+    vlelctx->vsid = get_vertex_id_argument(AG_GET_ARG_AGTYPE_P(1), "start");
+    if (PG_ARGISNULL(2) || is_agtype_null(AG_GET_ARG_AGTYPE_P(2)))
+    {
+        vlelctx->path_function = VLE_FUNCTION_PATHS_FROM;
+        vlelctx->veid = 0;
+    }
+    else
+    {
+        vlelctx->path_function = VLE_FUNCTION_PATHS_BETWEEN;
+        vlelctx->veid = get_vertex_id_argument(AG_GET_ARG_AGTYPE_P(2), "end");
+    }
+
+    /* get the edge constraints and the direction */
+    set_VLE_edge_prototype(vlelctx, AG_GET_ARG_AGTYPE_P(3));
+    agtv_temp = get_agtype_value("age_weighted_shortest_path",
+                                 AG_GET_ARG_AGTYPE_P(4), AGTV_INTEGER, true);
+    vlelctx->edge_direction = agtv_temp->val.int_value;
+
+    create_VLE_local_state_hashtable(vlelctx);
+    vlelctx->dfs_vertex_stack = new_graphid_stack();
+    vlelctx->dfs_edge_stack = new_graphid_stack();
+    vlelctx->dfs_path_stack = new_graphid_stack();
+
+    wps = palloc0(sizeof(weighted_path_search));
+    wps->vlelctx = vlelctx;
+
+    /* get the weight property key */
+    agtv_temp = get_agtype_value("age_weighted_shortest_path",
+                                 AG_GET_ARG_AGTYPE_P(5), AGTV_STRING, true);
+    wps->weight_key = pnstrdup(agtv_temp->val.string.val,
+                               agtv_temp->val.string.len);
+
+    /* get the heuristic property key, if there is one */
+    if (!PG_ARGISNULL(6) && !is_agtype_null(AG_GET_ARG_AGTYPE_P(6)))
+    {
+        if (vlelctx->path_function != VLE_FUNCTION_PATHS_BETWEEN)
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("age_weighted_shortest_path: a heuristic requires an end vertex")));
+        }
+
+        agtv_temp = get_agtype_value("age_weighted_shortest_path",
+                                     AG_GET_ARG_AGTYPE_P(6), AGTV_STRING,
+                                     true);
+        wps->heuristic_key = pnstrdup(agtv_temp->val.string.val,
+                                      agtv_temp->val.string.len);
+    }
+
+    /* if either end doesn't exist, there won't be anything to find */
+    if (!do_vsid_and_veid_exist(vlelctx))
+    {
+        wps->done = true;
+        return wps;
+    }
+
+    if (wps->heuristic_key != NULL)
+    {
+        vertex_entry *ve = get_vertex_entry(vlelctx->ggctx, vlelctx->veid);
+
+        wps->end_heuristic = get_entity_property(get_vertex_entry_properties(ve),
+                                                 wps->heuristic_key);
+    }
+
+    MemSet(&ctl, 0, sizeof(ctl));
+    ctl.keysize = sizeof(graphid);
+    ctl.entrysize = sizeof(weighted_path_entry);
+    ctl.hcxt = CurrentMemoryContext;
+    wps->visited = hash_create("weighted path", WEIGHTED_PATH_HTAB_INITIAL_SIZE,
+                               &ctl, HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+    wps->queue = pairingheap_allocate(weighted_path_queue_cmp, NULL);
+
+    /* queue the start vertex */
+    wpe = (weighted_path_entry *)hash_search(wps->visited,
+                                             (void *)&vlelctx->vsid,
+                                             HASH_ENTER, NULL);
+    wpe->vertex_id = vlelctx->vsid;
+    wpe->cost = 0;
+    wpe->heuristic = get_vertex_heuristic(wps, vlelctx->vsid);
+    wpe->hops = 0;
+    wpe->settled = false;
+    queue_weighted_path_vertex(wps, wpe);
+
+    return wps;
+}
+
+PG_FUNCTION_INFO_V1(age_weighted_shortest_path);
+
+/*
+ * SRF to find the cheapest path(s), where the cost of a path is the sum of a
+ * numeric property of its edges. It runs Dijkstra's algorithm over the GRAPH
+ * global context, or A* if a vertex heuristic property is given. The arguments
+ * are -
+ *
+ *     graph name, start vertex, end vertex (or NULL), edge prototype (as built
+ *     by age_build_vle_match_edge), direction, weight property name, and
+ *     heuristic property name (or NULL).
+ *
+ * With an end vertex, it returns the cheapest path to it, if there is one.
+ * Without one, it returns the cheapest path to every other reachable vertex,
+ * in order of cost. Each row is the path and its cost. Vertices are settled
+ * incrementally, so only as much of the graph as is needed is searched.
+ */
+Datum age_weighted_shortest_path(PG_FUNCTION_ARGS)
+{
+    FuncCallContext *funcctx;
+    weighted_path_search *wps = NULL;
+    weighted_path_entry *wpe = NULL;
+    MemoryContext oldctx;
+
+    /* Initialization for the first call to the SRF */
+    if (SRF_IS_FIRSTCALL())
+    {
+        TupleDesc tupdesc;
+
+        /* all of these arguments need to be non NULL */
+        if (PG_ARGISNULL(0) || /* graph name */
+            PG_ARGISNULL(1) || /* start vertex */
+            PG_ARGISNULL(3) || /* edge prototype */
+            PG_ARGISNULL(4) || /* direction */
+            PG_ARGISNULL(5))   /* weight property */
+        {
+             ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("age_weighted_shortest_path: invalid NULL argument passed")));
+        }
+
+        /* create a function context for cross-call persistence */
+        funcctx = SRF_FIRSTCALL_INIT();
+        oldctx = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+        if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                     errmsg("function returning record called in context that cannot accept type record")));
+        }
+        funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+        funcctx->user_fctx = build_weighted_path_search(fcinfo);
+
+        MemoryContextSwitchTo(oldctx);
+    }
+
+    /* stuff done on every call of the function */
+    funcctx = SRF_PERCALL_SETUP();
+    wps = (weighted_path_search *)funcctx->user_fctx;
+
+    /* the search state needs to survive multiple SRF calls */
+    oldctx = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+    while (!wps->done)
+    {
+        wpe = settle_weighted_path_vertex(wps);
+
+        if (wpe == NULL)
+        {
+            wps->done = true;
+        }
+        /* with an end vertex, there is only the path to it */
+        else if (wps->vlelctx->path_function == VLE_FUNCTION_PATHS_BETWEEN)
+        {
+            if (wpe->vertex_id == wps->vlelctx->veid)
+            {
+                wps->done = true;
+                break;
+            }
+        }
+        /* otherwise, every vertex other than the start has one */
+        else if (wpe->vertex_id != wps->vlelctx->vsid)
+        {
+            break;
+        }
+
+        wpe = NULL;
+    }
+
+    MemoryContextSwitchTo(oldctx);
+
+    if (wpe != NULL)
+    {
+        VLE_path_container *vpc = NULL;
+        agtype_value agtv_cost;
+        Datum values[2];
+        bool nulls[2] = {false, false};
+        HeapTuple tuple;
+
+        vpc = build_weighted_path_container(wps, wpe);
+
+        agtv_cost.type = AGTV_FLOAT;
+        agtv_cost.val.float_value = wpe->cost;
+
+        values[0] = AGTYPE_P_GET_DATUM(agt_materialize_vle_path((agtype *)vpc));
+        values[1] = AGTYPE_P_GET_DATUM(agtype_value_to_agtype(&agtv_cost));
+
+        tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+
+        SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+    }
+
+    /* we are done with the local context */
+    free_VLE_local_context(wps->vlelctx);
+    wps->vlelctx = NULL;
+
+    SRF_RETURN_DONE(funcctx);
+}
+
 /*
  * Exposed helper function to make an agtype AGTV_PATH from a
  * VLE_path_container.
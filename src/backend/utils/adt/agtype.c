@@ -37,16 +37,20 @@
 
 #include "access/genam.h"
 #include "access/heapam.h"
+#include "access/xact.h"
 #include "catalog/namespace.h"
 #include "catalog/pg_collation_d.h"
 #include "catalog/pg_operator_d.h"
+#include "common/hashfn.h"
 #include "funcapi.h"
 #include "libpq/pqformat.h"
 #include "miscadmin.h"
 #include "parser/parse_coerce.h"
 #include "nodes/nodes.h"
+#include "nodes/supportnodes.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
+#include "utils/datum.h"
 #include "executor/cypher_utils.h"
 #include "utils/float.h"
 #include "utils/lsyscache.h"
@@ -58,6 +62,41 @@
 #include "utils/agtype_raw.h"
 #include "catalog/ag_graph.h"
 #include "catalog/ag_label.h"
+#include "utils/ag_cache.h"
+#include "utils/ag_func.h"
+#include "utils/ag_guc.h"
+
+/*
+ * agtype send/recv versions. Version 1 is the text form. Version 2 is a
+ * portable binary form, where each value is a tag byte followed by -
+ *
+ *     AGT_SEND_NULL, no data.
+ *     AGT_SEND_STRING, an int32 length and the string.
+ *     AGT_SEND_INTEGER, an int64.
+ *     AGT_SEND_FLOAT, a float8.
+ *     AGT_SEND_NUMERIC, an int32 length and the number as text.
+ *     AGT_SEND_BOOL, a byte, 0 or 1.
+ *     AGT_SEND_ARRAY and AGT_SEND_PATH, an int32 count and the elements.
+ *     AGT_SEND_OBJECT, AGT_SEND_VERTEX, and AGT_SEND_EDGE, an int32 count and
+ *     the pairs, each being a key (an int32 length and the string) and a
+ *     value.
+ *
+ * Integers are in network byte order, and strings in the client encoding.
+ */
+#define AGT_SEND_VERSION_TEXT 1
+#define AGT_SEND_VERSION_BINARY 2
+
+#define AGT_SEND_NULL 0
+#define AGT_SEND_STRING 1
+#define AGT_SEND_INTEGER 2
+#define AGT_SEND_FLOAT 3
+#define AGT_SEND_NUMERIC 4
+#define AGT_SEND_BOOL 5
+#define AGT_SEND_ARRAY 6
+#define AGT_SEND_OBJECT 7
+#define AGT_SEND_VERTEX 8
+#define AGT_SEND_EDGE 9
+#define AGT_SEND_PATH 10
 
 /* State structure for Percentile aggregate functions */
 typedef struct PercentileGroupAggState
@@ -72,6 +111,36 @@ typedef struct PercentileGroupAggState
     bool sort_done;
 } PercentileGroupAggState;
 
+/* number of recently fetched vertices kept for startNode() and endNode() */
+#define VERTEX_CACHE_SIZE 256
+
+/* a slot in the vertex cache, vertex is 0 when the slot is empty */
+typedef struct vertex_cache_entry
+{
+    graphid id;
+    Datum vertex;
+} vertex_cache_entry;
+
+/* per query cache of recently fetched vertices, kept in fn_extra */
+typedef struct vertex_cache
+{
+    Oid graph_oid;        /* graph the vertices are from */
+    Snapshot snapshot;    /* snapshot the vertices were fetched with */
+    CommandId curcid;     /* and its command id */
+    CommandId command_id; /* current command id of the transaction */
+    Oid label_relation;   /* label table last fetched from */
+    Oid index_oid;        /* its index on id, if it has one */
+    vertex_cache_entry entries[VERTEX_CACHE_SIZE];
+} vertex_cache;
+
+/* constant keys of an agtype_access_operator call, kept in fn_extra */
+typedef struct access_key_cache
+{
+    bool is_constant;   /* are all of the keys constant strings? */
+    int num_keys;
+    agtype_value *keys; /* the keys, as AGTV_STRING values */
+} access_key_cache;
+
 typedef enum /* type categories for datum_to_agtype */
 {
     AGT_TYPE_NULL, /* null, so we didn't bother to identify */
@@ -108,6 +177,10 @@ bool is_decimal_needed(char *numstr);
 static void agtype_in_scalar(void *pstate, char *token,
                              agtype_token_type tokentype,
                              char *annotation);
+static void agtype_in_push_scalar(agtype_in_state *state, agtype_value *v);
+static void agtype_send_container(StringInfo buf, agtype_container *container);
+static void agtype_send_value(StringInfo buf, agtype_value *agtv);
+static void agtype_recv_value(agtype_in_state *state, StringInfo buf);
 static void agtype_categorize_type(Oid typoid, agt_type_category *tcategory,
                                    Oid *outfuncoid);
 static void composite_to_agtype(Datum composite, agtype_in_state *result);
@@ -158,9 +231,11 @@ static bool is_object_vertex(agtype_value *agtv);
 static bool is_object_edge(agtype_value *agtv);
 static bool is_array_path(agtype_value *agtv);
 /* graph entity retrieval */
-static Datum get_vertex(const char *graph, const char *vertex_label,
-                        int64 graphid);
-static char *get_label_name(const char *graph_name, graphid element_graphid);
+static label_cache_data *get_label_data(Oid graph_oid, graphid element_graphid);
+static Datum get_vertex(const char *graph, label_cache_data *label_data,
+                        graphid vertex_id, vertex_cache *vcache);
+static Datum get_cached_vertex(FunctionCallInfo fcinfo, const char *graph_name,
+                               graphid vertex_id);
 static float8 get_float_compatible_arg(Datum arg, Oid type, char *funcname,
                                        bool *is_null);
 static Numeric get_numeric_compatible_arg(Datum arg, Oid type, char *funcname,
@@ -181,6 +256,10 @@ static int extract_variadic_args_min(FunctionCallInfo fcinfo,
                                      Datum **args, Oid **types, bool **nulls,
                                      int min_num_args);
 static agtype_value *agtype_build_map_as_agtype_value(FunctionCallInfo fcinfo);
+static access_key_cache *get_access_key_cache(FunctionCallInfo fcinfo);
+static bool access_constant_keys(FunctionCallInfo fcinfo,
+                                 access_key_cache *cache,
+                                 agtype_value **result);
 agtype_value *agtype_composite_to_agtype_value_binary(agtype *a);
 static agtype_value *tostring_helper(Datum arg, Oid type, char *msghdr);
 
@@ -298,10 +377,9 @@ Datum graphid_send(PG_FUNCTION_ARGS)
  * agtype recv function copied from PGs jsonb_recv as agtype is based
  * off of jsonb
  *
- * The type is sent as text in binary mode, so this is almost the same
- * as the input function, but it's prefixed with a version number so we
- * can change the binary format sent in future if necessary. For now,
- * only version 1 is supported.
+ * The type is prefixed with a version number. Version 1 is sent as text,
+ * so this is almost the same as the input function. Version 2 is the binary
+ * form, described with the AGT_SEND_* tags.
  */
 PG_FUNCTION_INFO_V1(agtype_recv);
 
@@ -313,17 +391,33 @@ Datum agtype_recv(PG_FUNCTION_ARGS)
     int nbytes = 0;
     Datum result;
 
-    if (version == 1)
+    if (version == AGT_SEND_VERSION_TEXT)
     {
         str = pq_getmsgtext(buf, buf->len - buf->cursor, &nbytes);
+        result = agtype_from_cstring(str, nbytes);
+    }
+    else if (version == AGT_SEND_VERSION_BINARY)
+    {
+        agtype_in_state state;
+
+        memset(&state, 0, sizeof(state));
+
+        agtype_recv_value(&state, buf);
+
+        if (buf->cursor != buf->len)
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                     errmsg("improper binary format in agtype")));
+        }
+
+        result = AGTYPE_P_GET_DATUM(agtype_value_to_agtype(state.res));
     }
     else
     {
         elog(ERROR, "unsupported agtype version number %d", version);
     }
 
-    result = agtype_from_cstring(str, nbytes);
-
     PG_FREE_IF_COPY(buf, 0);
     pfree_if_not_null(str);
 
@@ -334,7 +428,8 @@ Datum agtype_recv(PG_FUNCTION_ARGS)
  * agtype send function copied from PGs jsonb_send as agtype is based
  * off of jsonb
  *
- * Just send agtype as a version number, then a string of text
+ * Send agtype as a version number, then either a string of text or, if
+ * age.enable_agtype_binary_send is set, the binary form.
  */
 PG_FUNCTION_INFO_V1(agtype_send);
 
@@ -342,22 +437,250 @@ Datum agtype_send(PG_FUNCTION_ARGS)
 {
     agtype *agt = AG_GET_ARG_AGTYPE_P(0);
     StringInfoData buf;
-    StringInfo agtype_text = makeStringInfo();
-    int version = 1;
-
-    (void) agtype_to_cstring(agtype_text, &agt->root, VARSIZE(agt));
 
     pq_begintypsend(&buf);
-    pq_sendint8(&buf, version);
-    pq_sendtext(&buf, agtype_text->data, agtype_text->len);
-    pfree_if_not_null(agtype_text->data);
-    pfree_if_not_null(agtype_text);
+
+    if (age_enable_agtype_binary_send)
+    {
+        pq_sendint8(&buf, AGT_SEND_VERSION_BINARY);
+        agtype_send_container(&buf, &agt->root);
+    }
+    else
+    {
+        StringInfo agtype_text = makeStringInfo();
+
+        (void) agtype_to_cstring(agtype_text, &agt->root, VARSIZE(agt));
+
+        pq_sendint8(&buf, AGT_SEND_VERSION_TEXT);
+        pq_sendtext(&buf, agtype_text->data, agtype_text->len);
+        pfree_if_not_null(agtype_text->data);
+        pfree_if_not_null(agtype_text);
+    }
 
     PG_FREE_IF_COPY(agt, 0);
 
     PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
 }
 
+/*
+ * Helper function to send an agtype container in the binary form. A raw
+ * scalar is sent as just the scalar.
+ */
+static void agtype_send_container(StringInfo buf, agtype_container *container)
+{
+    agtype_iterator *it = agtype_iterator_init(container);
+    agtype_iterator_token tok;
+    agtype_value v;
+
+    while ((tok = agtype_iterator_next(&it, &v, false)) != WAGT_DONE)
+    {
+        switch (tok)
+        {
+        case WAGT_BEGIN_ARRAY:
+            if (!v.val.array.raw_scalar)
+            {
+                pq_sendbyte(buf, AGT_SEND_ARRAY);
+                pq_sendint32(buf, v.val.array.num_elems);
+            }
+            break;
+        case WAGT_BEGIN_OBJECT:
+            pq_sendbyte(buf, AGT_SEND_OBJECT);
+            pq_sendint32(buf, v.val.object.num_pairs);
+            break;
+        case WAGT_KEY:
+            pq_sendcountedtext(buf, v.val.string.val, v.val.string.len);
+            break;
+        case WAGT_VALUE:
+        case WAGT_ELEM:
+            agtype_send_value(buf, &v);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+/*
+ * Helper function to send an agtype_value in the binary form. Vertices, edges,
+ * and paths are deserialized, so they are sent from their pairs or elements.
+ */
+static void agtype_send_value(StringInfo buf, agtype_value *agtv)
+{
+    char *numstr;
+    int i;
+
+    check_stack_depth();
+
+    switch (agtv->type)
+    {
+    case AGTV_NULL:
+        pq_sendbyte(buf, AGT_SEND_NULL);
+        break;
+    case AGTV_STRING:
+        pq_sendbyte(buf, AGT_SEND_STRING);
+        pq_sendcountedtext(buf, agtv->val.string.val, agtv->val.string.len);
+        break;
+    case AGTV_INTEGER:
+        pq_sendbyte(buf, AGT_SEND_INTEGER);
+        pq_sendint64(buf, agtv->val.int_value);
+        break;
+    case AGTV_FLOAT:
+        pq_sendbyte(buf, AGT_SEND_FLOAT);
+        pq_sendfloat8(buf, agtv->val.float_value);
+        break;
+    case AGTV_NUMERIC:
+        numstr = DatumGetCString(DirectFunctionCall1(numeric_out,
+                                     NumericGetDatum(agtv->val.numeric)));
+        pq_sendbyte(buf, AGT_SEND_NUMERIC);
+        pq_sendcountedtext(buf, numstr, strlen(numstr));
+        pfree(numstr);
+        break;
+    case AGTV_BOOL:
+        pq_sendbyte(buf, AGT_SEND_BOOL);
+        pq_sendbyte(buf, agtv->val.boolean ? 1 : 0);
+        break;
+    case AGTV_ARRAY:
+    case AGTV_PATH:
+        pq_sendbyte(buf, (agtv->type == AGTV_PATH) ? AGT_SEND_PATH :
+                                                     AGT_SEND_ARRAY);
+        pq_sendint32(buf, agtv->val.array.num_elems);
+        for (i = 0; i < agtv->val.array.num_elems; i++)
+        {
+            agtype_send_value(buf, &agtv->val.array.elems[i]);
+        }
+        break;
+    case AGTV_OBJECT:
+    case AGTV_VERTEX:
+    case AGTV_EDGE:
+        pq_sendbyte(buf, (agtv->type == AGTV_VERTEX) ? AGT_SEND_VERTEX :
+                         (agtv->type == AGTV_EDGE) ? AGT_SEND_EDGE :
+                                                     AGT_SEND_OBJECT);
+        pq_sendint32(buf, agtv->val.object.num_pairs);
+        for (i = 0; i < agtv->val.object.num_pairs; i++)
+        {
+            agtype_pair *pair = &agtv->val.object.pairs[i];
+
+            pq_sendcountedtext(buf, pair->key.val.string.val,
+                               pair->key.val.string.len);
+            agtype_send_value(buf, &pair->value);
+        }
+        break;
+    case AGTV_BINARY:
+        agtype_send_container(buf, agtv->val.binary.data);
+        break;
+    default:
+        elog(ERROR, "unknown agtype value type: %d", agtv->type);
+        break;
+    }
+}
+
+/*
+ * Helper function to receive a value in the binary form, pushing it into the
+ * state, as the input function does for text. Vertices, edges, and paths are
+ * validated with the same annotations as their text.
+ */
+static void agtype_recv_value(agtype_in_state *state, StringInfo buf)
+{
+    agtype_value v;
+    Datum numd;
+    char *str;
+    int nbytes;
+    int count;
+    int tag;
+    int i;
+
+    check_stack_depth();
+
+    tag = pq_getmsgbyte(buf);
+
+    switch (tag)
+    {
+    case AGT_SEND_NULL:
+        v.type = AGTV_NULL;
+        agtype_in_push_scalar(state, &v);
+        break;
+    case AGT_SEND_STRING:
+        str = pq_getmsgtext(buf, pq_getmsgint(buf, 4), &nbytes);
+        v.type = AGTV_STRING;
+        v.val.string.len = check_string_length(nbytes);
+        v.val.string.val = str;
+        agtype_in_push_scalar(state, &v);
+        break;
+    case AGT_SEND_INTEGER:
+        v.type = AGTV_INTEGER;
+        v.val.int_value = pq_getmsgint64(buf);
+        agtype_in_push_scalar(state, &v);
+        break;
+    case AGT_SEND_FLOAT:
+        v.type = AGTV_FLOAT;
+        v.val.float_value = pq_getmsgfloat8(buf);
+        agtype_in_push_scalar(state, &v);
+        break;
+    case AGT_SEND_NUMERIC:
+        str = pq_getmsgtext(buf, pq_getmsgint(buf, 4), &nbytes);
+        numd = DirectFunctionCall3(numeric_in, CStringGetDatum(str),
+                                   ObjectIdGetDatum(InvalidOid),
+                                   Int32GetDatum(-1));
+        v.type = AGTV_NUMERIC;
+        v.val.numeric = DatumGetNumeric(numd);
+        agtype_in_push_scalar(state, &v);
+        break;
+    case AGT_SEND_BOOL:
+        v.type = AGTV_BOOL;
+        v.val.boolean = (pq_getmsgbyte(buf) != 0);
+        agtype_in_push_scalar(state, &v);
+        break;
+    case AGT_SEND_ARRAY:
+    case AGT_SEND_PATH:
+        count = pq_getmsgint(buf, 4);
+        state->res = push_agtype_value(&state->parse_state, WAGT_BEGIN_ARRAY,
+                                       NULL);
+        for (i = 0; i < count; i++)
+        {
+            agtype_recv_value(state, buf);
+        }
+        state->res = push_agtype_value(&state->parse_state, WAGT_END_ARRAY,
+                                       NULL);
+        if (tag == AGT_SEND_PATH)
+        {
+            agtype_in_agtype_annotation(state, "path");
+        }
+        break;
+    case AGT_SEND_OBJECT:
+    case AGT_SEND_VERTEX:
+    case AGT_SEND_EDGE:
+        count = pq_getmsgint(buf, 4);
+        state->res = push_agtype_value(&state->parse_state, WAGT_BEGIN_OBJECT,
+                                       NULL);
+        for (i = 0; i < count; i++)
+        {
+            str = pq_getmsgtext(buf, pq_getmsgint(buf, 4), &nbytes);
+            v.type = AGTV_STRING;
+            v.val.string.len = check_string_length(nbytes);
+            v.val.string.val = str;
+            state->res = push_agtype_value(&state->parse_state, WAGT_KEY, &v);
+
+            agtype_recv_value(state, buf);
+        }
+        state->res = push_agtype_value(&state->parse_state, WAGT_END_OBJECT,
+                                       NULL);
+        if (tag == AGT_SEND_VERTEX)
+        {
+            agtype_in_agtype_annotation(state, "vertex");
+        }
+        else if (tag == AGT_SEND_EDGE)
+        {
+            agtype_in_agtype_annotation(state, "edge");
+        }
+        break;
+    default:
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("unknown agtype binary tag %d", tag)));
+        break;
+    }
+}
+
 PG_FUNCTION_INFO_V1(agtype_in);
 
 /*
@@ -1066,7 +1389,16 @@ static void agtype_in_scalar(void *pstate, char *token,
         break;
     }
 
-    if (_state->parse_state == NULL)
+    agtype_in_push_scalar(_state, &v);
+}
+
+/*
+ * Helper function to push a scalar into the state, either as a single scalar
+ * or as the next element or value of the enclosing array or object.
+ */
+static void agtype_in_push_scalar(agtype_in_state *state, agtype_value *v)
+{
+    if (state->parse_state == NULL)
     {
         /* single scalar */
         agtype_value va;
@@ -1075,25 +1407,24 @@ static void agtype_in_scalar(void *pstate, char *token,
         va.val.array.raw_scalar = true;
         va.val.array.num_elems = 1;
 
-        _state->res = push_agtype_value(&_state->parse_state, WAGT_BEGIN_ARRAY,
-                                        &va);
-        _state->res = push_agtype_value(&_state->parse_state, WAGT_ELEM, &v);
-        _state->res = push_agtype_value(&_state->parse_state, WAGT_END_ARRAY,
-                                        NULL);
+        state->res = push_agtype_value(&state->parse_state, WAGT_BEGIN_ARRAY,
+                                       &va);
+        state->res = push_agtype_value(&state->parse_state, WAGT_ELEM, v);
+        state->res = push_agtype_value(&state->parse_state, WAGT_END_ARRAY,
+                                       NULL);
     }
     else
     {
-        agtype_value *o = &_state->parse_state->cont_val;
+        agtype_value *o = &state->parse_state->cont_val;
 
         switch (o->type)
         {
         case AGTV_ARRAY:
-            _state->res = push_agtype_value(&_state->parse_state, WAGT_ELEM,
-                                            &v);
+            state->res = push_agtype_value(&state->parse_state, WAGT_ELEM, v);
             break;
         case AGTV_OBJECT:
-            _state->res = push_agtype_value(&_state->parse_state, WAGT_VALUE,
-                                            &v);
+            state->res = push_agtype_value(&state->parse_state, WAGT_VALUE,
+                                           v);
             break;
         default:
             elog(ERROR, "unexpected parent of nested structure");
@@ -4085,6 +4416,192 @@ Datum agtype_array_element_text(PG_FUNCTION_ARGS)
     PG_RETURN_TEXT_P((const void*) retval);
 }
 
+/*
+ * Helper function to get the keys of an agtype_access_operator call, from
+ * fn_extra. On the first call, the expression is checked for keys that are
+ * all constant strings, n.name or n.address.city for example. If so, they
+ * are decoded once and kept for the rest of the query.
+ */
+static access_key_cache *get_access_key_cache(FunctionCallInfo fcinfo)
+{
+    access_key_cache *cache = (access_key_cache *)fcinfo->flinfo->fn_extra;
+    FuncExpr *func_expr;
+    ArrayExpr *array_expr;
+    MemoryContext oldctx;
+    ListCell *lc;
+    int i;
+
+    if (cache != NULL)
+    {
+        return cache;
+    }
+
+    cache = MemoryContextAllocZero(fcinfo->flinfo->fn_mcxt,
+                                   sizeof(access_key_cache));
+    fcinfo->flinfo->fn_extra = cache;
+
+    /* the arguments must be in an ARRAY[] of the container and its keys */
+    func_expr = (FuncExpr *)fcinfo->flinfo->fn_expr;
+    if (func_expr == NULL || !IsA(func_expr, FuncExpr) ||
+        !func_expr->funcvariadic || list_length(func_expr->args) != 1 ||
+        !IsA(linitial(func_expr->args), ArrayExpr))
+    {
+        return cache;
+    }
+
+    array_expr = linitial(func_expr->args);
+    if (list_length(array_expr->elements) < 2)
+    {
+        return cache;
+    }
+
+    /* every key must be a constant string */
+    for_each_from(lc, array_expr->elements, 1)
+    {
+        Const *c = lfirst(lc);
+        agtype *key;
+
+        if (!IsA(c, Const) || c->constisnull || c->consttype != AGTYPEOID)
+        {
+            return cache;
+        }
+
+        key = DATUM_GET_AGTYPE_P(c->constvalue);
+        if (!AGT_ROOT_IS_SCALAR(key) ||
+            get_ith_agtype_value_from_container(&key->root, 0)->type !=
+                AGTV_STRING)
+        {
+            return cache;
+        }
+    }
+
+    oldctx = MemoryContextSwitchTo(fcinfo->flinfo->fn_mcxt);
+
+    cache->num_keys = list_length(array_expr->elements) - 1;
+    cache->keys = palloc(sizeof(agtype_value) * cache->num_keys);
+
+    i = 0;
+    for_each_from(lc, array_expr->elements, 1)
+    {
+        Const *c = lfirst(lc);
+        agtype *key = DATUM_GET_AGTYPE_P(c->constvalue);
+
+        cache->keys[i++] = *get_ith_agtype_value_from_container(&key->root, 0);
+    }
+
+    cache->is_constant = true;
+
+    MemoryContextSwitchTo(oldctx);
+
+    return cache;
+}
+
+/*
+ * Helper function to access constant keys in an object, or in the properties
+ * of a vertex or edge. The container is taken straight from the ARRAY[] and
+ * each key is looked up with its cached value. No argument arrays are built,
+ * and no key is decoded. Returns false, for the general path to handle, if it
+ * meets anything else, such as a NULL container, a VLE path, or an array.
+ * Otherwise, result is the value found, or NULL for a NULL result.
+ */
+static bool access_constant_keys(FunctionCallInfo fcinfo,
+                                 access_key_cache *cache,
+                                 agtype_value **result)
+{
+    ArrayType *array_in;
+    agtype *container;
+    agtype_container *root = NULL;
+    agtype_value *container_value = NULL;
+    int i;
+
+    if (PG_ARGISNULL(0))
+    {
+        return false;
+    }
+
+    /* the keys are never NULL, so a NULL can only be the container */
+    array_in = PG_GETARG_ARRAYTYPE_P(0);
+    if (ARR_NDIM(array_in) != 1 || ARR_HASNULL(array_in) ||
+        ARR_DIMS(array_in)[0] != cache->num_keys + 1)
+    {
+        return false;
+    }
+
+    container = DATUM_GET_AGTYPE_P(PointerGetDatum(ARR_DATA_PTR(array_in)));
+
+    if (AGT_ROOT_IS_BINARY(container))
+    {
+        return false;
+    }
+    else if (AGT_ROOT_IS_SCALAR(container))
+    {
+        container_value = get_ith_agtype_value_from_container(&container->root,
+                                                              0);
+
+        /* get the properties object of a vertex or edge */
+        if (container_value->type == AGTV_VERTEX)
+        {
+            container_value = &container_value->val.object.pairs[2].value;
+        }
+        else if (container_value->type == AGTV_EDGE)
+        {
+            container_value = &container_value->val.object.pairs[4].value;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    else if (AGT_ROOT_IS_OBJECT(container))
+    {
+        root = &container->root;
+    }
+    else
+    {
+        return false;
+    }
+
+    for (i = 0; i < cache->num_keys; i++)
+    {
+        agtype_value *key = &cache->keys[i];
+
+        if (root != NULL)
+        {
+            container_value = find_agtype_value_from_container(root,
+                                                               AGT_FOBJECT,
+                                                               key);
+        }
+        else if (container_value->type == AGTV_OBJECT)
+        {
+            container_value = get_agtype_value_object_value(
+                container_value, key->val.string.val, key->val.string.len);
+        }
+        else
+        {
+            return false;
+        }
+
+        /* for NULL values return NULL */
+        if (container_value == NULL || container_value->type == AGTV_NULL)
+        {
+            *result = NULL;
+            return true;
+        }
+
+        /* the next key needs an object */
+        root = NULL;
+        if (container_value->type == AGTV_BINARY &&
+            AGTYPE_CONTAINER_IS_OBJECT(container_value->val.binary.data))
+        {
+            root = container_value->val.binary.data;
+        }
+    }
+
+    *result = container_value;
+
+    return true;
+}
+
 PG_FUNCTION_INFO_V1(agtype_access_operator);
 /*
  * Execution function for object.property, object["property"],
@@ -4099,8 +4616,24 @@ Datum agtype_access_operator(PG_FUNCTION_ARGS)
     agtype *container = NULL;
     agtype_value *container_value = NULL;
     agtype *result = NULL;
+    access_key_cache *cache = NULL;
     int i = 0;
 
+    /* constant keys in an object can take the fast path */
+    cache = get_access_key_cache(fcinfo);
+    if (cache->is_constant &&
+        access_constant_keys(fcinfo, cache, &container_value))
+    {
+        if (container_value == NULL)
+        {
+            PG_RETURN_NULL();
+        }
+
+        result = agtype_value_to_agtype(container_value);
+
+        return AGTYPE_P_GET_DATUM(result);
+    }
+
     /* extract our args, we need at least 2 */
     nargs = extract_variadic_args_min(fcinfo, 0, true, &args, &types, &nulls,
                                       2);
@@ -4260,6 +4793,97 @@ Datum agtype_access_operator(PG_FUNCTION_ARGS)
     return AGTYPE_P_GET_DATUM(result);
 }
 
+/*
+ * Helper function to find the properties of a vertex or edge that is built,
+ * by _agtype_build_vertex or _agtype_build_edge, from the columns of its label
+ * table. Returns the properties argument of the build, or NULL if the
+ * expression isn't such a build.
+ */
+static Node *get_built_entity_properties(Node *node)
+{
+    FuncExpr *func_expr;
+
+    if (node == NULL || !IsA(node, FuncExpr))
+    {
+        return NULL;
+    }
+
+    func_expr = (FuncExpr *)node;
+
+    if (func_expr->funcid == get_ag_func_oid("_agtype_build_vertex", 3,
+                                             GRAPHIDOID, CSTRINGOID,
+                                             AGTYPEOID))
+    {
+        return lthird(func_expr->args);
+    }
+
+    if (func_expr->funcid == get_ag_func_oid("_agtype_build_edge", 5,
+                                             GRAPHIDOID, GRAPHIDOID,
+                                             GRAPHIDOID, CSTRINGOID,
+                                             AGTYPEOID))
+    {
+        return list_nth(func_expr->args, 4);
+    }
+
+    return NULL;
+}
+
+PG_FUNCTION_INFO_V1(agtype_access_operator_support);
+/*
+ * Planner support function for agtype_access_operator. Accessing a property
+ * of a vertex or edge accesses its properties object. So, when the vertex or
+ * edge is built from its label table's columns, which is how entities from a
+ * previous clause reach this one, the access is rewritten to use the
+ * properties column directly. This skips resolving the label's name and
+ * serializing the whole entity, only for it to be taken apart again.
+ */
+Datum agtype_access_operator_support(PG_FUNCTION_ARGS)
+{
+    Node *rawreq = (Node *)PG_GETARG_POINTER(0);
+    SupportRequestSimplify *req;
+    FuncExpr *func_expr;
+    ArrayExpr *array_expr;
+    Node *properties;
+
+    if (!IsA(rawreq, SupportRequestSimplify))
+    {
+        PG_RETURN_POINTER(NULL);
+    }
+
+    req = (SupportRequestSimplify *)rawreq;
+    func_expr = req->fcall;
+
+    /* the arguments are in an ARRAY[] when the call is variadic */
+    if (!func_expr->funcvariadic || list_length(func_expr->args) != 1 ||
+        !IsA(linitial(func_expr->args), ArrayExpr))
+    {
+        PG_RETURN_POINTER(NULL);
+    }
+
+    array_expr = linitial(func_expr->args);
+
+    /* there must be at least one key to access */
+    if (list_length(array_expr->elements) < 2)
+    {
+        PG_RETURN_POINTER(NULL);
+    }
+
+    properties = get_built_entity_properties(linitial(array_expr->elements));
+    if (properties == NULL)
+    {
+        PG_RETURN_POINTER(NULL);
+    }
+
+    /* replace the entity with its properties */
+    array_expr = copyObject(array_expr);
+    linitial(array_expr->elements) = properties;
+
+    func_expr = copyObject(func_expr);
+    func_expr->args = list_make1(array_expr);
+
+    PG_RETURN_POINTER(func_expr);
+}
+
 PG_FUNCTION_INFO_V1(agtype_access_slice);
 /*
  * Execution function for list slices
@@ -5560,120 +6184,88 @@ Datum column_get_datum(TupleDesc tupdesc, HeapTuple tuple, int column,
 }
 
 /*
- * Function to retrieve a label name, given the graph name and graphid of the
- * node or edge. The function returns a pointer to a duplicated string that
- * needs to be freed when you are finished using it.
+ * Function to retrieve the cached label data, given the graph oid and graphid
+ * of the node or edge.
  */
-static char *get_label_name(const char *graph_name, graphid element_graphid)
+static label_cache_data *get_label_data(Oid graph_oid, graphid element_graphid)
 {
-    ScanKeyData scan_keys[2];
-    Relation ag_label;
-    SysScanDesc scan_desc;
-    HeapTuple tuple;
-    TupleDesc tupdesc;
-    char *result = NULL;
-    bool column_is_null = false;
-    Oid graph_oid = get_graph_oid(graph_name);
-    int32 label_id = get_graphid_label_id(element_graphid);
-
-    /* scankey for first match in ag_label, column 2, graphoid, BTEQ, OidEQ */
-    ScanKeyInit(&scan_keys[0], Anum_ag_label_graph, BTEqualStrategyNumber,
-                F_OIDEQ, ObjectIdGetDatum(graph_oid));
-    /* scankey for second match in ag_label, column 3, label id, BTEQ, Int4EQ */
-    ScanKeyInit(&scan_keys[1], Anum_ag_label_id, BTEqualStrategyNumber,
-                F_INT4EQ, Int32GetDatum(label_id));
-
-    ag_label = table_open(ag_label_relation_id(), ShareLock);
-    scan_desc = systable_beginscan(ag_label, ag_label_graph_oid_index_id(), true,
-                                   NULL, 2, scan_keys);
+    label_cache_data *label_data = NULL;
 
-    tuple = systable_getnext(scan_desc);
-    if (!HeapTupleIsValid(tuple))
+    label_data = search_label_graph_oid_cache(graph_oid,
+                                              get_graphid_label_id(element_graphid));
+    if (label_data == NULL)
     {
         ereport(ERROR,
                 (errcode(ERRCODE_UNDEFINED_SCHEMA),
                  errmsg("graphid %lu does not exist", element_graphid)));
     }
 
-    /* get the tupdesc - we don't need to release this one */
-    tupdesc = RelationGetDescr(ag_label);
-
-    /* bail if the number of columns differs */
-    if (tupdesc->natts != Natts_ag_label)
-    {
-        ereport(ERROR,
-                (errcode(ERRCODE_UNDEFINED_TABLE),
-                 errmsg("Invalid number of attributes for ag_catalog.ag_label")));
-    }
-
-    /* get the label name */
-    result = NameStr(*DatumGetName(heap_getattr(tuple, Anum_ag_label_name,
-                                                tupdesc, &column_is_null)));
-    /* duplicate it */
-    result = pstrdup(result);
-
-    /* end the scan and close the relation */
-    systable_endscan(scan_desc);
-    table_close(ag_label, ShareLock);
-
-    return result;
+    return label_data;
 }
 
-static Datum get_vertex(const char *graph, const char *vertex_label,
-                        int64 graphid)
+/*
+ * Function to fetch a vertex from its label table. It probes the btree index
+ * on id, if there is one, instead of scanning the whole table. The index oid
+ * is remembered in the vertex cache for the label last used.
+ */
+static Datum get_vertex(const char *graph, label_cache_data *label_data,
+                        graphid vertex_id, vertex_cache *vcache)
 {
     ScanKeyData scan_keys[1];
     Relation graph_vertex_label;
-    TableScanDesc scan_desc;
+    SysScanDesc scan_desc;
     HeapTuple tuple;
     TupleDesc tupdesc;
     Datum id, properties, result;
     AclResult aclresult;
-
-    /* get the specific graph namespace (schema) */
-    Oid graph_namespace_oid = get_namespace_oid(graph, false);
-    /* get the specific vertex label table (schema.vertex_label) */
-    Oid vertex_label_table_oid = get_relname_relid(vertex_label,
-                                                   graph_namespace_oid);
-    /* get the active snapshot */
-    Snapshot snapshot = GetActiveSnapshot();
+    char *vertex_label = NameStr(label_data->name);
 
     /* check for SELECT permission on the table */
-    aclresult = pg_class_aclcheck(vertex_label_table_oid, GetUserId(),
+    aclresult = pg_class_aclcheck(label_data->relation, GetUserId(),
                                   ACL_SELECT);
     if (aclresult != ACLCHECK_OK)
     {
         aclcheck_error(aclresult, OBJECT_TABLE, vertex_label);
     }
 
-    /* initialize the scan key */
-    ScanKeyInit(&scan_keys[0], 1, BTEqualStrategyNumber, F_OIDEQ,
-                Int64GetDatum(graphid));
+    /* open the relation (table) and find the index on id */
+    graph_vertex_label = table_open(label_data->relation, AccessShareLock);
+    if (vcache->label_relation != label_data->relation)
+    {
+        vcache->label_relation = label_data->relation;
+        vcache->index_oid =
+            get_label_column_index(graph_vertex_label,
+                                   Anum_ag_label_vertex_table_id);
+    }
 
-    /* open the relation (table), begin the scan, and get the tuple  */
-    graph_vertex_label = table_open(vertex_label_table_oid, ShareLock);
-    scan_desc = table_beginscan(graph_vertex_label, snapshot, 1, scan_keys);
-    tuple = heap_getnext(scan_desc, ForwardScanDirection);
+    /* initialize the scan key, begin the scan, and get the tuple */
+    ScanKeyInit(&scan_keys[0], Anum_ag_label_vertex_table_id,
+                BTEqualStrategyNumber, F_GRAPHIDEQ,
+                GRAPHID_GET_DATUM(vertex_id));
+    scan_desc = systable_beginscan(graph_vertex_label, vcache->index_oid,
+                                   OidIsValid(vcache->index_oid),
+                                   GetActiveSnapshot(), 1, scan_keys);
+    tuple = systable_getnext(scan_desc);
 
     /* bail if the tuple isn't valid */
     if (!HeapTupleIsValid(tuple))
     {
-        table_endscan(scan_desc);
-        table_close(graph_vertex_label, ShareLock);
+        systable_endscan(scan_desc);
+        table_close(graph_vertex_label, AccessShareLock);
         ereport(ERROR,
                 (errcode(ERRCODE_UNDEFINED_TABLE),
-                 errmsg("graphid %lu does not exist", graphid)));
+                 errmsg("graphid %lu does not exist", vertex_id)));
     }
 
     /* Check RLS policies - error if filtered out */
     if (!check_rls_for_tuple(graph_vertex_label, tuple, CMD_SELECT))
     {
-        table_endscan(scan_desc);
-        table_close(graph_vertex_label, ShareLock);
+        systable_endscan(scan_desc);
+        table_close(graph_vertex_label, AccessShareLock);
         ereport(ERROR,
                 (errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
                  errmsg("access to vertex %lu denied by row-level security policy on \"%s\"",
-                        graphid, vertex_label)));
+                        vertex_id, vertex_label)));
     }
 
     /* get the tupdesc - we don't need to release this one */
@@ -5694,12 +6286,91 @@ static Datum get_vertex(const char *graph, const char *vertex_label,
     result = DirectFunctionCall3(_agtype_build_vertex, id,
                                  CStringGetDatum(vertex_label), properties);
     /* end the scan and close the relation */
-    table_endscan(scan_desc);
-    table_close(graph_vertex_label, ShareLock);
+    systable_endscan(scan_desc);
+    table_close(graph_vertex_label, AccessShareLock);
     /* return the vertex datum */
     return result;
 }
 
+/*
+ * Function to get a vertex for startNode() and endNode(). Recently fetched
+ * vertices are kept in a small cache, in fn_extra, for the life of the query.
+ * Edges tend to share their vertices, so this saves fetching the same ones
+ * over and over. The cache is emptied whenever the snapshot, or either command
+ * id, changes. Updates made by this query always move the command counter, so
+ * vertices modified by an earlier clause are fetched again.
+ */
+static Datum get_cached_vertex(FunctionCallInfo fcinfo, const char *graph_name,
+                               graphid vertex_id)
+{
+    vertex_cache *vcache = (vertex_cache *)fcinfo->flinfo->fn_extra;
+    vertex_cache_entry *vce = NULL;
+    Snapshot snapshot = GetActiveSnapshot();
+    Oid graph_oid = get_graph_oid(graph_name);
+    label_cache_data *label_data = NULL;
+    MemoryContext oldctx;
+    Datum result;
+    uint32 slot;
+
+    /* create the cache on the first call */
+    if (vcache == NULL)
+    {
+        vcache = MemoryContextAllocZero(fcinfo->flinfo->fn_mcxt,
+                                        sizeof(vertex_cache));
+        fcinfo->flinfo->fn_extra = vcache;
+    }
+
+    /* empty it if anything could have changed since it was filled */
+    if (vcache->graph_oid != graph_oid || vcache->snapshot != snapshot ||
+        vcache->curcid != snapshot->curcid ||
+        vcache->command_id != GetCurrentCommandId(false))
+    {
+        int i;
+
+        for (i = 0; i < VERTEX_CACHE_SIZE; i++)
+        {
+            if (vcache->entries[i].vertex != (Datum) 0)
+            {
+                pfree(DatumGetPointer(vcache->entries[i].vertex));
+                vcache->entries[i].vertex = (Datum) 0;
+            }
+        }
+
+        vcache->graph_oid = graph_oid;
+        vcache->snapshot = snapshot;
+        vcache->curcid = snapshot->curcid;
+        vcache->command_id = GetCurrentCommandId(false);
+        vcache->label_relation = InvalidOid;
+        vcache->index_oid = InvalidOid;
+    }
+
+    /* the cache is direct mapped, each vertex only has one slot */
+    slot = murmurhash32((uint32)(vertex_id ^ (vertex_id >> 32))) %
+           VERTEX_CACHE_SIZE;
+    vce = &vcache->entries[slot];
+
+    if (vce->vertex == (Datum) 0 || vce->id != vertex_id)
+    {
+        label_data = get_label_data(graph_oid, vertex_id);
+        result = get_vertex(graph_name, label_data, vertex_id, vcache);
+
+        if (vce->vertex != (Datum) 0)
+        {
+            pfree(DatumGetPointer(vce->vertex));
+        }
+
+        oldctx = MemoryContextSwitchTo(fcinfo->flinfo->fn_mcxt);
+        vce->vertex = datumCopy(result, false, -1);
+        vce->id = vertex_id;
+        MemoryContextSwitchTo(oldctx);
+
+        return result;
+    }
+
+    /* the caller gets its own copy */
+    return datumCopy(vce->vertex, false, -1);
+}
+
 PG_FUNCTION_INFO_V1(age_startnode);
 
 Datum age_startnode(PG_FUNCTION_ARGS)
@@ -5708,7 +6379,6 @@ Datum age_startnode(PG_FUNCTION_ARGS)
     agtype_value *agtv_object = NULL;
     agtype_value *agtv_value = NULL;
     char *graph_name = NULL;
-    char *label_name = NULL;
     graphid start_id;
     Datum result;
 
@@ -5753,12 +6423,7 @@ Datum age_startnode(PG_FUNCTION_ARGS)
     Assert(agtv_value->type = AGTV_INTEGER);
     start_id = agtv_value->val.int_value;
 
-    /* get the label */
-    label_name = get_label_name(graph_name, start_id);
-    /* it must not be null and must be a string */
-    Assert(label_name != NULL);
-
-    result = get_vertex(graph_name, label_name, start_id);
+    result = get_cached_vertex(fcinfo, graph_name, start_id);
 
     return result;
 }
@@ -5771,7 +6436,6 @@ Datum age_endnode(PG_FUNCTION_ARGS)
     agtype_value *agtv_object = NULL;
     agtype_value *agtv_value = NULL;
     char *graph_name = NULL;
-    char *label_name = NULL;
     graphid end_id;
     Datum result;
 
@@ -5816,12 +6480,7 @@ Datum age_endnode(PG_FUNCTION_ARGS)
     Assert(agtv_value->type = AGTV_INTEGER);
     end_id = agtv_value->val.int_value;
 
-    /* get the label */
-    label_name = get_label_name(graph_name, end_id);
-    /* it must not be null and must be a string */
-    Assert(label_name != NULL);
-
-    result = get_vertex(graph_name, label_name, end_id);
+    result = get_cached_vertex(fcinfo, graph_name, end_id);
 
     return result;
 }
@@ -6030,6 +6689,34 @@ Datum age_tail(PG_FUNCTION_ARGS)
     PG_RETURN_POINTER(agt_result);
 }
 
+PG_FUNCTION_INFO_V1(age_properties_support);
+/*
+ * Planner support function for age_properties. The properties of a vertex or
+ * edge built from its label table's columns are just its properties column.
+ */
+Datum age_properties_support(PG_FUNCTION_ARGS)
+{
+    Node *rawreq = (Node *)PG_GETARG_POINTER(0);
+    SupportRequestSimplify *req;
+    Node *properties;
+
+    if (!IsA(rawreq, SupportRequestSimplify))
+    {
+        PG_RETURN_POINTER(NULL);
+    }
+
+    req = (SupportRequestSimplify *)rawreq;
+
+    if (list_length(req->fcall->args) != 1)
+    {
+        PG_RETURN_POINTER(NULL);
+    }
+
+    properties = get_built_entity_properties(linitial(req->fcall->args));
+
+    PG_RETURN_POINTER(properties);
+}
+
 PG_FUNCTION_INFO_V1(age_properties);
 
 Datum age_properties(PG_FUNCTION_ARGS)
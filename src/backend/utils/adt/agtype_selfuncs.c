@@ -0,0 +1,1357 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Statistics and selectivity estimation for agtype.
+ *
+ * ANALYZE gathers, besides the standard statistics of whole values, the
+ * statistics of the top-level keys of agtype objects, which is how the
+ * properties of vertices and edges are stored. The selectivity functions of
+ * the containment, exists, and comparison operators use them to estimate
+ * property filters, such as the ones MATCH (n:Person {country: 'NL'}) and
+ * WHERE n.age > 30 turn into.
+ */
+
+#include "postgres.h"
+
+#include "access/htup_details.h"
+#include "catalog/pg_statistic.h"
+#include "commands/vacuum.h"
+#include "utils/builtins.h"
+#include "utils/datum.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/selfuncs.h"
+
+#include "utils/ag_func.h"
+#include "utils/agtype.h"
+
+/*
+ * Kind of the statistics slot with the statistics of the top-level keys of
+ * agtype objects. Kinds above 10000 are for private use.
+ *
+ * stavalues holds an agtype object for each of the most common keys. It has
+ * the key, "key", the estimated number of distinct values of the key,
+ * "ndistinct", its most common values, "mcv", their frequencies, "mcf", and
+ * a histogram of the rest of its values, "hist". stanumbers holds the
+ * fraction of rows that have each of the keys, followed by the fraction to
+ * assume for any other key. Keys with a null value aren't counted, and values
+ * that are arrays or objects are only counted. All of the fractions are of
+ * all of the rows, including the NULL ones.
+ */
+#define STATISTIC_KIND_AGTYPE_KEYS 10750
+
+/* a top-level key of one of the sampled objects, and its value */
+typedef struct key_sample
+{
+    char *key;
+    int key_len;
+    agtype *value; /* the value if it is a scalar, NULL if it isn't */
+} key_sample;
+
+/* the samples of one key, scalars first and in order */
+typedef struct key_samples
+{
+    key_sample *samples;
+    int num_samples;
+    int num_scalars;
+} key_samples;
+
+/* a run of equal scalar values of a key */
+typedef struct value_group
+{
+    int first;
+    int count;
+} value_group;
+
+/* the standard analyze routine, which agtype_typanalyze wraps */
+typedef struct agtype_analyze_extra
+{
+    AnalyzeAttrComputeStatsFunc std_compute_stats;
+    void *std_extra_data;
+} agtype_analyze_extra;
+
+/* the statistics of a key, read from the statistics slot */
+typedef struct key_stats
+{
+    Selectivity frac;
+    double ndistinct;
+    agtype_container *mcv;
+    agtype_container *mcf;
+    agtype_container *hist;
+} key_stats;
+
+/* the comparison a selectivity is estimated for */
+typedef enum key_compare_op
+{
+    KEY_COMPARE_EQ,
+    KEY_COMPARE_NE,
+    KEY_COMPARE_LT,
+    KEY_COMPARE_LE,
+    KEY_COMPARE_GT,
+    KEY_COMPARE_GE
+} key_compare_op;
+
+static void compute_agtype_stats(VacAttrStats *stats,
+                                 AnalyzeAttrFetchFunc fetchfunc,
+                                 int samplerows, double totalrows);
+static int compare_key_samples(const void *a, const void *b);
+static int compare_key_samples_by_key(const void *a, const void *b);
+static int compare_key_samples_by_count(const void *a, const void *b);
+static int compare_value_groups_by_count(const void *a, const void *b);
+static int compare_value_groups_by_value(const void *a, const void *b);
+static agtype *build_key_stats(key_samples *ks, int target, int samplerows,
+                               double totalrows);
+static void push_string_key(agtype_in_state *state, char *key);
+static bool get_key_stats(VariableStatData *vardata, AttStatsSlot *sslot,
+                          char *key, int key_len, key_stats *kstats);
+static agtype_container *get_stats_container(agtype *stats, char *field);
+static int compare_stats_value(agtype_container *values, int i,
+                               agtype *value);
+static Selectivity key_eq_selectivity(key_stats *kstats, agtype *value);
+static Selectivity key_ineq_selectivity(key_stats *kstats, agtype *value,
+                                        key_compare_op op);
+static Selectivity histogram_fraction_below(agtype_container *hist,
+                                            agtype *value, bool inclusive);
+static Node *get_key_access(Node *expr, char **key, int *key_len);
+static bool get_string_key(Const *con, char **key, int *key_len);
+static bool key_compare_selectivity(PlannerInfo *root, List *args,
+                                    int varRelid, key_compare_op op,
+                                    Selectivity *selec);
+static Datum agtype_compare_sel(FunctionCallInfo fcinfo, key_compare_op op,
+                                PGFunction std_func);
+static bool contains_selectivity(PlannerInfo *root, List *args, int varRelid,
+                                 Selectivity *selec);
+
+PG_FUNCTION_INFO_V1(agtype_typanalyze);
+
+/*
+ * Analyze routine for agtype columns. The standard statistics are gathered
+ * by the standard routine, which compute_agtype_stats calls before adding
+ * the statistics of the top-level keys.
+ */
+Datum agtype_typanalyze(PG_FUNCTION_ARGS)
+{
+    VacAttrStats *stats = (VacAttrStats *)PG_GETARG_POINTER(0);
+    agtype_analyze_extra *extra;
+
+    if (!std_typanalyze(stats))
+    {
+        PG_RETURN_BOOL(false);
+    }
+
+    extra = palloc(sizeof(agtype_analyze_extra));
+    extra->std_compute_stats = stats->compute_stats;
+    extra->std_extra_data = stats->extra_data;
+
+    stats->compute_stats = compute_agtype_stats;
+    stats->extra_data = extra;
+
+    PG_RETURN_BOOL(true);
+}
+
+/*
+ * Helper function to compute the statistics of an agtype column. After the
+ * standard statistics, the top-level keys of the sampled objects are sorted
+ * by key and value, and the most common keys get their statistics stored in
+ * a slot of their own.
+ */
+static void compute_agtype_stats(VacAttrStats *stats,
+                                 AnalyzeAttrFetchFunc fetchfunc,
+                                 int samplerows, double totalrows)
+{
+    agtype_analyze_extra *extra = (agtype_analyze_extra *)stats->extra_data;
+    MemoryContext tmp_cxt;
+    MemoryContext old_cxt;
+    key_sample *samples;
+    key_samples *keys;
+    int num_samples = 0;
+    int max_samples;
+    int num_keys = 0;
+    int num_kept;
+    int min_kept_samples = 0;
+    int slot;
+    int i;
+    Datum *values;
+    float4 *numbers;
+
+    /* the standard statistics are computed with the standard extra data */
+    stats->extra_data = extra->std_extra_data;
+    extra->std_compute_stats(stats, fetchfunc, samplerows, totalrows);
+    stats->extra_data = extra;
+
+    /* there is nothing to add when all of the sampled values are NULL */
+    if (!stats->stats_valid || stats->attstattarget <= 0)
+    {
+        return;
+    }
+
+    for (slot = 0; slot < STATISTIC_NUM_SLOTS; slot++)
+    {
+        if (stats->stakind[slot] == 0)
+        {
+            break;
+        }
+    }
+
+    if (slot == STATISTIC_NUM_SLOTS)
+    {
+        return;
+    }
+
+    tmp_cxt = AllocSetContextCreate(CurrentMemoryContext,
+                                    "agtype analyze temporary cxt",
+                                    ALLOCSET_DEFAULT_SIZES);
+    old_cxt = MemoryContextSwitchTo(tmp_cxt);
+
+    max_samples = Max(samplerows, 1);
+    samples = palloc(sizeof(key_sample) * max_samples);
+
+    /* collect the non-null top-level keys of the sampled objects */
+    for (i = 0; i < samplerows; i++)
+    {
+        agtype_iterator *it;
+        agtype_iterator_token token;
+        agtype_value key;
+        agtype_value value;
+        agtype *agt;
+        Datum datum;
+        bool isnull;
+
+        vacuum_delay_point();
+
+        datum = fetchfunc(stats, i, &isnull);
+        if (isnull)
+        {
+            continue;
+        }
+
+        /* the detoasted values are kept until the statistics are built */
+        agt = DATUM_GET_AGTYPE_P(datum);
+        if (!AGT_ROOT_IS_OBJECT(agt))
+        {
+            continue;
+        }
+
+        it = agtype_iterator_init(&agt->root);
+
+        while ((token = agtype_iterator_next(&it, &key, true)) != WAGT_DONE)
+        {
+            if (token != WAGT_KEY)
+            {
+                continue;
+            }
+
+            token = agtype_iterator_next(&it, &value, true);
+            Assert(token == WAGT_VALUE);
+
+            if (value.type == AGTV_NULL)
+            {
+                continue;
+            }
+
+            if (num_samples >= max_samples)
+            {
+                max_samples *= 2;
+                samples = repalloc_huge(samples,
+                                        sizeof(key_sample) * max_samples);
+            }
+
+            samples[num_samples].key = key.val.string.val;
+            samples[num_samples].key_len = key.val.string.len;
+            samples[num_samples].value = IS_A_AGTYPE_SCALAR(&value) ?
+                                         agtype_value_to_agtype(&value) :
+                                         NULL;
+            num_samples++;
+        }
+    }
+
+    if (num_samples == 0)
+    {
+        MemoryContextSwitchTo(old_cxt);
+        MemoryContextDelete(tmp_cxt);
+        return;
+    }
+
+    qsort(samples, num_samples, sizeof(key_sample), compare_key_samples);
+
+    /* split the samples by key */
+    keys = palloc(sizeof(key_samples) * num_samples);
+
+    for (i = 0; i < num_samples; i++)
+    {
+        key_samples *ks;
+
+        if (i == 0 || samples[i].key_len != samples[i - 1].key_len ||
+            memcmp(samples[i].key, samples[i - 1].key, samples[i].key_len) != 0)
+        {
+            ks = &keys[num_keys++];
+            ks->samples = &samples[i];
+            ks->num_samples = 0;
+            ks->num_scalars = 0;
+        }
+
+        ks = &keys[num_keys - 1];
+        ks->num_samples++;
+
+        if (samples[i].value != NULL)
+        {
+            ks->num_scalars++;
+        }
+    }
+
+    /* keep the most common keys, in key order */
+    num_kept = Min(num_keys, stats->attstattarget);
+
+    if (num_kept < num_keys)
+    {
+        qsort(keys, num_keys, sizeof(key_samples),
+              compare_key_samples_by_count);
+        /* the rarest kept key, before they are put back in key order */
+        min_kept_samples = keys[num_kept - 1].num_samples;
+        qsort(keys, num_kept, sizeof(key_samples),
+              compare_key_samples_by_key);
+    }
+
+    MemoryContextSwitchTo(stats->anl_context);
+
+    values = palloc(sizeof(Datum) * num_kept);
+    numbers = palloc(sizeof(float4) * (num_kept + 1));
+
+    for (i = 0; i < num_kept; i++)
+    {
+        agtype *stats_object;
+
+        MemoryContextSwitchTo(tmp_cxt);
+        stats_object = build_key_stats(&keys[i], stats->attstattarget,
+                                    samplerows, totalrows);
+        MemoryContextSwitchTo(stats->anl_context);
+
+        values[i] = datumCopy(AGTYPE_P_GET_DATUM(stats_object), false, -1);
+        numbers[i] = (float4)keys[i].num_samples / samplerows;
+    }
+
+    /*
+     * The keys that weren't kept are rarer than the rarest kept one. If all of
+     * them were kept, any other key is rarer than one in the sample.
+     */
+    if (num_kept < num_keys)
+    {
+        numbers[num_kept] = (float4)min_kept_samples / samplerows / 2;
+    }
+    else
+    {
+        numbers[num_kept] = 0.5 / samplerows;
+    }
+
+    stats->stakind[slot] = STATISTIC_KIND_AGTYPE_KEYS;
+    stats->staop[slot] = InvalidOid;
+    stats->stacoll[slot] = InvalidOid;
+    stats->stanumbers[slot] = numbers;
+    stats->numnumbers[slot] = num_kept + 1;
+    stats->stavalues[slot] = values;
+    stats->numvalues[slot] = num_kept;
+    stats->statypid[slot] = stats->attrtypid;
+    stats->statyplen[slot] = stats->attrtype->typlen;
+    stats->statypbyval[slot] = stats->attrtype->typbyval;
+    stats->statypalign[slot] = stats->attrtype->typalign;
+
+    MemoryContextSwitchTo(old_cxt);
+    MemoryContextDelete(tmp_cxt);
+}
+
+/*
+ * Helper function to order key samples by key, and then by value with the
+ * scalars first.
+ */
+static int compare_key_samples(const void *a, const void *b)
+{
+    const key_sample *ka = (const key_sample *)a;
+    const key_sample *kb = (const key_sample *)b;
+    int result;
+
+    if (ka->key_len != kb->key_len)
+    {
+        return (ka->key_len < kb->key_len) ? -1 : 1;
+    }
+
+    result = memcmp(ka->key, kb->key, ka->key_len);
+    if (result != 0)
+    {
+        return result;
+    }
+
+    if (ka->value == NULL || kb->value == NULL)
+    {
+        return (ka->value == NULL) - (kb->value == NULL);
+    }
+
+    return compare_agtype_containers_orderability(&ka->value->root,
+                                                  &kb->value->root);
+}
+
+/* Helper function to order the samples of keys by key. */
+static int compare_key_samples_by_key(const void *a, const void *b)
+{
+    const key_samples *ka = (const key_samples *)a;
+    const key_samples *kb = (const key_samples *)b;
+
+    return compare_key_samples(ka->samples, kb->samples);
+}
+
+/*
+ * Helper function to order the samples of keys by how many rows have the key,
+ * the most common first.
+ */
+static int compare_key_samples_by_count(const void *a, const void *b)
+{
+    const key_samples *ka = (const key_samples *)a;
+    const key_samples *kb = (const key_samples *)b;
+
+    if (ka->num_samples != kb->num_samples)
+    {
+        return (ka->num_samples > kb->num_samples) ? -1 : 1;
+    }
+
+    return compare_key_samples_by_key(a, b);
+}
+
+/* Helper function to order value groups by count, the most common first. */
+static int compare_value_groups_by_count(const void *a, const void *b)
+{
+    const value_group *ga = (const value_group *)a;
+    const value_group *gb = (const value_group *)b;
+
+    if (ga->count != gb->count)
+    {
+        return (ga->count > gb->count) ? -1 : 1;
+    }
+
+    return (ga->first > gb->first) - (ga->first < gb->first);
+}
+
+/* Helper function to order value groups by value, as they were sampled. */
+static int compare_value_groups_by_value(const void *a, const void *b)
+{
+    const value_group *ga = (const value_group *)a;
+    const value_group *gb = (const value_group *)b;
+
+    return (ga->first > gb->first) - (ga->first < gb->first);
+}
+
+/*
+ * Helper function to build the statistics object of a key. The most common
+ * values are chosen like the standard routine does: if every value was seen
+ * more than once, and there aren't too many of them, they all are. Otherwise,
+ * those seen more than 1.25 times as often as the average value are. The
+ * number of distinct values is the Haas and Stokes estimate the standard
+ * routine uses.
+ */
+static agtype *build_key_stats(key_samples *ks, int target, int samplerows,
+                               double totalrows)
+{
+    agtype_in_state result;
+    agtype_value agtv;
+    value_group *groups;
+    key_sample *samples = ks->samples;
+    int num_groups = 0;
+    int num_singles = 0;
+    int num_mcv = 0;
+    int num_rest = 0;
+    int num_hist;
+    double ndistinct = 0;
+    int i;
+
+    groups = palloc(sizeof(value_group) * Max(ks->num_scalars, 1));
+
+    for (i = 0; i < ks->num_scalars; i++)
+    {
+        agtype *value = samples[i].value;
+
+        if (i == 0 ||
+            compare_agtype_containers_orderability(
+                &value->root, &samples[i - 1].value->root) != 0)
+        {
+            groups[num_groups].first = i;
+            groups[num_groups].count = 0;
+            num_groups++;
+        }
+
+        groups[num_groups - 1].count++;
+    }
+
+    for (i = 0; i < num_groups; i++)
+    {
+        if (groups[i].count == 1)
+        {
+            num_singles++;
+        }
+    }
+
+    if (ks->num_scalars > 0)
+    {
+        double n = ks->num_scalars;
+        double total = totalrows * n / samplerows;
+
+        ndistinct = (n * num_groups) /
+                    ((n - num_singles) + num_singles * n / total);
+        ndistinct = Max(ndistinct, num_groups);
+        ndistinct = Min(ndistinct, total);
+    }
+
+    /* the most common values come first */
+    qsort(groups, num_groups, sizeof(value_group),
+          compare_value_groups_by_count);
+
+    if (num_singles == 0 && num_groups <= target)
+    {
+        num_mcv = num_groups;
+    }
+    else
+    {
+        double min_count = 1.25 * ks->num_scalars / Max(num_groups, 1);
+
+        min_count = Max(min_count, 2);
+
+        while (num_mcv < num_groups && num_mcv < target &&
+               groups[num_mcv].count >= min_count)
+        {
+            num_mcv++;
+        }
+    }
+
+    /* the rest of the values are put back in order for the histogram */
+    qsort(groups + num_mcv, num_groups - num_mcv, sizeof(value_group),
+          compare_value_groups_by_value);
+
+    for (i = num_mcv; i < num_groups; i++)
+    {
+        num_rest += groups[i].count;
+    }
+
+    memset(&result, 0, sizeof(agtype_in_state));
+
+    result.res = push_agtype_value(&result.parse_state, WAGT_BEGIN_OBJECT,
+                                   NULL);
+
+    push_string_key(&result, "key");
+    agtv.type = AGTV_STRING;
+    agtv.val.string.val = samples[0].key;
+    agtv.val.string.len = samples[0].key_len;
+    result.res = push_agtype_value(&result.parse_state, WAGT_VALUE, &agtv);
+
+    push_string_key(&result, "ndistinct");
+    agtv.type = AGTV_FLOAT;
+    agtv.val.float_value = ndistinct;
+    result.res = push_agtype_value(&result.parse_state, WAGT_VALUE, &agtv);
+
+    push_string_key(&result, "mcv");
+    result.res = push_agtype_value(&result.parse_state, WAGT_BEGIN_ARRAY,
+                                   NULL);
+    for (i = 0; i < num_mcv; i++)
+    {
+        agtype *value = samples[groups[i].first].value;
+
+        result.res = push_agtype_value(
+            &result.parse_state, WAGT_ELEM,
+            get_ith_agtype_value_from_container(&value->root, 0));
+    }
+    result.res = push_agtype_value(&result.parse_state, WAGT_END_ARRAY, NULL);
+
+    push_string_key(&result, "mcf");
+    result.res = push_agtype_value(&result.parse_state, WAGT_BEGIN_ARRAY,
+                                   NULL);
+    for (i = 0; i < num_mcv; i++)
+    {
+        agtv.type = AGTV_FLOAT;
+        agtv.val.float_value = (double)groups[i].count / samplerows;
+        result.res = push_agtype_value(&result.parse_state, WAGT_ELEM, &agtv);
+    }
+    result.res = push_agtype_value(&result.parse_state, WAGT_END_ARRAY, NULL);
+
+    /* the histogram bounds are spread evenly over the rest of the values */
+    push_string_key(&result, "hist");
+    result.res = push_agtype_value(&result.parse_state, WAGT_BEGIN_ARRAY,
+                                   NULL);
+    num_hist = Min(num_groups - num_mcv, target + 1);
+    if (num_hist >= 2)
+    {
+        key_sample **rest = palloc(sizeof(key_sample *) * num_rest);
+        int num = 0;
+
+        for (i = num_mcv; i < num_groups; i++)
+        {
+            int j;
+
+            for (j = 0; j < groups[i].count; j++)
+            {
+                rest[num++] = &samples[groups[i].first + j];
+            }
+        }
+
+        for (i = 0; i < num_hist; i++)
+        {
+            int pos = (int)(((int64)i * (num_rest - 1)) / (num_hist - 1));
+
+            result.res = push_agtype_value(
+                &result.parse_state, WAGT_ELEM,
+                get_ith_agtype_value_from_container(&rest[pos]->value->root,
+                                                    0));
+        }
+    }
+    result.res = push_agtype_value(&result.parse_state, WAGT_END_ARRAY, NULL);
+
+    result.res = push_agtype_value(&result.parse_state, WAGT_END_OBJECT, NULL);
+
+    return agtype_value_to_agtype(result.res);
+}
+
+/* Helper function to push an object key. */
+static void push_string_key(agtype_in_state *state, char *key)
+{
+    agtype_value agtv;
+
+    agtv.type = AGTV_STRING;
+    agtv.val.string.val = key;
+    agtv.val.string.len = strlen(key);
+
+    state->res = push_agtype_value(&state->parse_state, WAGT_KEY, &agtv);
+}
+
+/*
+ * Helper function to get the statistics of a key from the statistics of an
+ * agtype column. It returns false if there aren't any. Otherwise, the caller
+ * must free sslot. A key that isn't in the statistics gets the fraction for
+ * other keys, and no values.
+ */
+static bool get_key_stats(VariableStatData *vardata, AttStatsSlot *sslot,
+                          char *key, int key_len, key_stats *kstats)
+{
+    agtype_value key_key;
+    agtype_value ndistinct_key;
+    int i;
+
+    if (!HeapTupleIsValid(vardata->statsTuple) ||
+        !get_attstatsslot(sslot, vardata->statsTuple,
+                          STATISTIC_KIND_AGTYPE_KEYS, InvalidOid,
+                          ATTSTATSSLOT_VALUES | ATTSTATSSLOT_NUMBERS))
+    {
+        return false;
+    }
+
+    if (sslot->nnumbers != sslot->nvalues + 1)
+    {
+        free_attstatsslot(sslot);
+        return false;
+    }
+
+    key_key.type = AGTV_STRING;
+    key_key.val.string.val = "key";
+    key_key.val.string.len = 3;
+
+    ndistinct_key.type = AGTV_STRING;
+    ndistinct_key.val.string.val = "ndistinct";
+    ndistinct_key.val.string.len = 9;
+
+    for (i = 0; i < sslot->nvalues; i++)
+    {
+        agtype *stats = DATUM_GET_AGTYPE_P(sslot->values[i]);
+        agtype_value *stats_key;
+
+        stats_key = find_agtype_value_from_container(&stats->root,
+                                                     AGT_FOBJECT, &key_key);
+        if (stats_key == NULL || stats_key->type != AGTV_STRING ||
+            stats_key->val.string.len != key_len ||
+            memcmp(stats_key->val.string.val, key, key_len) != 0)
+        {
+            continue;
+        }
+
+        kstats->frac = sslot->numbers[i];
+        kstats->mcv = get_stats_container(stats, "mcv");
+        kstats->mcf = get_stats_container(stats, "mcf");
+        kstats->hist = get_stats_container(stats, "hist");
+        kstats->ndistinct = 1;
+
+        stats_key = find_agtype_value_from_container(&stats->root,
+                                                     AGT_FOBJECT,
+                                                     &ndistinct_key);
+        if (stats_key != NULL && stats_key->type == AGTV_FLOAT)
+        {
+            kstats->ndistinct = Max(stats_key->val.float_value, 1);
+        }
+
+        /* the frequencies must match the values */
+        if (kstats->mcv == NULL || kstats->mcf == NULL ||
+            AGTYPE_CONTAINER_SIZE(kstats->mcv) !=
+            AGTYPE_CONTAINER_SIZE(kstats->mcf))
+        {
+            kstats->mcv = NULL;
+            kstats->mcf = NULL;
+        }
+
+        return true;
+    }
+
+    kstats->frac = sslot->numbers[sslot->nvalues];
+    kstats->ndistinct = 1;
+    kstats->mcv = NULL;
+    kstats->mcf = NULL;
+    kstats->hist = NULL;
+
+    return true;
+}
+
+/* Helper function to get an array of a key's statistics object. */
+static agtype_container *get_stats_container(agtype *stats, char *field)
+{
+    agtype_value key;
+    agtype_value *value;
+
+    key.type = AGTV_STRING;
+    key.val.string.val = field;
+    key.val.string.len = strlen(field);
+
+    value = find_agtype_value_from_container(&stats->root, AGT_FOBJECT, &key);
+    if (value == NULL || value->type != AGTV_BINARY ||
+        !AGTYPE_CONTAINER_IS_ARRAY(value->val.binary.data))
+    {
+        return NULL;
+    }
+
+    return value->val.binary.data;
+}
+
+/*
+ * Helper function to compare the ith value of a statistics array to a value,
+ * the way the agtype comparison operators do.
+ */
+static int compare_stats_value(agtype_container *values, int i, agtype *value)
+{
+    agtype *stats_value;
+
+    stats_value = agtype_value_to_agtype(
+        get_ith_agtype_value_from_container(values, i));
+
+    return compare_agtype_containers_orderability(&stats_value->root,
+                                                  &value->root);
+}
+
+/*
+ * Helper function to estimate the fraction of rows whose key equals a value.
+ * It is the value's frequency, when it is one of the most common values.
+ * Otherwise, the rest of the rows with the key are split evenly among the
+ * rest of its distinct values.
+ */
+static Selectivity key_eq_selectivity(key_stats *kstats, agtype *value)
+{
+    Selectivity selec;
+    double sum_mcf = 0;
+    double min_mcf = 1;
+    int num_mcv = 0;
+    int i;
+
+    if (kstats->mcv != NULL)
+    {
+        num_mcv = AGTYPE_CONTAINER_SIZE(kstats->mcv);
+    }
+
+    for (i = 0; i < num_mcv; i++)
+    {
+        agtype_value *mcf;
+
+        mcf = get_ith_agtype_value_from_container(kstats->mcf, i);
+
+        if (compare_stats_value(kstats->mcv, i, value) == 0)
+        {
+            return mcf->val.float_value;
+        }
+
+        sum_mcf += mcf->val.float_value;
+        min_mcf = Min(min_mcf, mcf->val.float_value);
+    }
+
+    selec = kstats->frac - sum_mcf;
+
+    if (kstats->ndistinct - num_mcv > 1)
+    {
+        selec /= (kstats->ndistinct - num_mcv);
+    }
+
+    /* it can't be more common than the most common values */
+    if (num_mcv > 0)
+    {
+        selec = Min(selec, min_mcf);
+    }
+
+    CLAMP_PROBABILITY(selec);
+
+    return selec;
+}
+
+/*
+ * Helper function to estimate the fraction of rows whose key is less than,
+ * or greater than, a value. The most common values are checked one by one,
+ * and the histogram gives the fraction of the rest.
+ */
+static Selectivity key_ineq_selectivity(key_stats *kstats, agtype *value,
+                                        key_compare_op op)
+{
+    Selectivity selec = 0;
+    Selectivity hist_selec;
+    double sum_mcf = 0;
+    int num_mcv = 0;
+    int i;
+
+    if (kstats->mcv != NULL)
+    {
+        num_mcv = AGTYPE_CONTAINER_SIZE(kstats->mcv);
+    }
+
+    for (i = 0; i < num_mcv; i++)
+    {
+        agtype_value *mcf;
+        int cmp;
+        bool match;
+
+        mcf = get_ith_agtype_value_from_container(kstats->mcf, i);
+        cmp = compare_stats_value(kstats->mcv, i, value);
+
+        switch (op)
+        {
+        case KEY_COMPARE_LT:
+            match = (cmp < 0);
+            break;
+        case KEY_COMPARE_LE:
+            match = (cmp <= 0);
+            break;
+        case KEY_COMPARE_GT:
+            match = (cmp > 0);
+            break;
+        default:
+            match = (cmp >= 0);
+            break;
+        }
+
+        if (match)
+        {
+            selec += mcf->val.float_value;
+        }
+
+        sum_mcf += mcf->val.float_value;
+    }
+
+    if (kstats->hist != NULL && AGTYPE_CONTAINER_SIZE(kstats->hist) >= 2)
+    {
+        switch (op)
+        {
+        case KEY_COMPARE_LT:
+            hist_selec = histogram_fraction_below(kstats->hist, value, false);
+            break;
+        case KEY_COMPARE_LE:
+            hist_selec = histogram_fraction_below(kstats->hist, value, true);
+            break;
+        case KEY_COMPARE_GT:
+            hist_selec = 1 - histogram_fraction_below(kstats->hist, value,
+                                                      true);
+            break;
+        default:
+            hist_selec = 1 - histogram_fraction_below(kstats->hist, value,
+                                                      false);
+            break;
+        }
+    }
+    else
+    {
+        hist_selec = DEFAULT_INEQ_SEL;
+    }
+
+    selec += hist_selec * Max(kstats->frac - sum_mcf, 0);
+
+    CLAMP_PROBABILITY(selec);
+
+    return selec;
+}
+
+/*
+ * Helper function to estimate the fraction of a histogram that is below a
+ * value, or not above it when inclusive. A value within a bin is taken to be
+ * in its middle.
+ */
+static Selectivity histogram_fraction_below(agtype_container *hist,
+                                            agtype *value, bool inclusive)
+{
+    int num_bounds = AGTYPE_CONTAINER_SIZE(hist);
+    int below = 0;
+    int i;
+
+    for (i = 0; i < num_bounds; i++)
+    {
+        int cmp = compare_stats_value(hist, i, value);
+
+        if (cmp < 0 || (inclusive && cmp == 0))
+        {
+            below++;
+        }
+    }
+
+    if (below == 0)
+    {
+        return 0;
+    }
+
+    if (below == num_bounds)
+    {
+        return 1;
+    }
+
+    return (below - 0.5) / (num_bounds - 1);
+}
+
+/*
+ * Helper function to find what an expression accesses a key of. It handles
+ * the access of a property in Cypher, agtype_access_operator with one key,
+ * and the -> operator. It returns NULL if the expression isn't one of them.
+ */
+static Node *get_key_access(Node *expr, char **key, int *key_len)
+{
+    if (IsA(expr, FuncExpr))
+    {
+        FuncExpr *func_expr = (FuncExpr *)expr;
+        ArrayExpr *array_expr;
+
+        if (func_expr->funcid != get_ag_func_oid("agtype_access_operator", 1,
+                                                 AGTYPEARRAYOID) ||
+            !func_expr->funcvariadic || list_length(func_expr->args) != 1 ||
+            !IsA(linitial(func_expr->args), ArrayExpr))
+        {
+            return NULL;
+        }
+
+        array_expr = linitial(func_expr->args);
+        if (list_length(array_expr->elements) != 2 ||
+            !IsA(lsecond(array_expr->elements), Const) ||
+            !get_string_key(lsecond(array_expr->elements), key, key_len))
+        {
+            return NULL;
+        }
+
+        return linitial(array_expr->elements);
+    }
+
+    if (IsA(expr, OpExpr))
+    {
+        OpExpr *op_expr = (OpExpr *)expr;
+        Oid opcode;
+
+        if (list_length(op_expr->args) != 2 ||
+            !IsA(lsecond(op_expr->args), Const))
+        {
+            return NULL;
+        }
+
+        opcode = get_opcode(op_expr->opno);
+
+        if (opcode != get_ag_func_oid("agtype_object_field", 2, AGTYPEOID,
+                                      TEXTOID) &&
+            opcode != get_ag_func_oid("agtype_object_field_agtype", 2,
+                                      AGTYPEOID, AGTYPEOID))
+        {
+            return NULL;
+        }
+
+        if (!get_string_key(lsecond(op_expr->args), key, key_len))
+        {
+            return NULL;
+        }
+
+        return linitial(op_expr->args);
+    }
+
+    return NULL;
+}
+
+/*
+ * Helper function to get the key in a constant, which is either text or an
+ * agtype string.
+ */
+static bool get_string_key(Const *con, char **key, int *key_len)
+{
+    if (con->constisnull)
+    {
+        return false;
+    }
+
+    if (con->consttype == TEXTOID)
+    {
+        text *key_text = DatumGetTextPP(con->constvalue);
+
+        *key = VARDATA_ANY(key_text);
+        *key_len = VARSIZE_ANY_EXHDR(key_text);
+
+        return true;
+    }
+
+    if (con->consttype == AGTYPEOID)
+    {
+        agtype *agt = DATUM_GET_AGTYPE_P(con->constvalue);
+        agtype_value *agtv;
+
+        if (!AGT_ROOT_IS_SCALAR(agt))
+        {
+            return false;
+        }
+
+        agtv = get_ith_agtype_value_from_container(&agt->root, 0);
+        if (agtv->type != AGTV_STRING)
+        {
+            return false;
+        }
+
+        *key = agtv->val.string.val;
+        *key_len = agtv->val.string.len;
+
+        return true;
+    }
+
+    return false;
+}
+
+/*
+ * Helper function to estimate the selectivity of comparing a key of an agtype
+ * column to a constant, with the statistics of the column's keys. It returns
+ * false if it can't.
+ */
+static bool key_compare_selectivity(PlannerInfo *root, List *args,
+                                    int varRelid, key_compare_op op,
+                                    Selectivity *selec)
+{
+    VariableStatData vardata;
+    VariableStatData basedata;
+    AttStatsSlot sslot;
+    key_stats kstats;
+    Node *other;
+    Node *base;
+    bool varonleft;
+    char *key;
+    int key_len;
+    agtype *value;
+
+    if (!get_restriction_variable(root, args, varRelid, &vardata, &other,
+                                  &varonleft))
+    {
+        return false;
+    }
+
+    base = get_key_access(vardata.var, &key, &key_len);
+    if (base == NULL || !IsA(other, Const) ||
+        ((Const *)other)->consttype != AGTYPEOID)
+    {
+        ReleaseVariableStats(vardata);
+        return false;
+    }
+
+    examine_variable(root, base, varRelid, &basedata);
+    if (!get_key_stats(&basedata, &sslot, key, key_len, &kstats))
+    {
+        ReleaseVariableStats(basedata);
+        ReleaseVariableStats(vardata);
+        return false;
+    }
+
+    /* comparisons to null are never true */
+    if (((Const *)other)->constisnull)
+    {
+        *selec = 0;
+    }
+    else
+    {
+        value = DATUM_GET_AGTYPE_P(((Const *)other)->constvalue);
+
+        if (AGT_ROOT_IS_SCALAR(value) &&
+            get_ith_agtype_value_type(&value->root, 0) == AGTV_NULL)
+        {
+            *selec = 0;
+        }
+        else if (op == KEY_COMPARE_EQ)
+        {
+            *selec = key_eq_selectivity(&kstats, value);
+        }
+        else if (op == KEY_COMPARE_NE)
+        {
+            *selec = kstats.frac - key_eq_selectivity(&kstats, value);
+        }
+        else
+        {
+            /* the estimates are for the key on the left */
+            if (!varonleft)
+            {
+                op = (op == KEY_COMPARE_LT) ? KEY_COMPARE_GT :
+                     (op == KEY_COMPARE_LE) ? KEY_COMPARE_GE :
+                     (op == KEY_COMPARE_GT) ? KEY_COMPARE_LT :
+                                              KEY_COMPARE_LE;
+            }
+
+            *selec = key_ineq_selectivity(&kstats, value, op);
+        }
+    }
+
+    CLAMP_PROBABILITY(*selec);
+
+    free_attstatsslot(&sslot);
+    ReleaseVariableStats(basedata);
+    ReleaseVariableStats(vardata);
+
+    return true;
+}
+
+/*
+ * Helper function for the restriction selectivity functions of the agtype
+ * comparison operators. A comparison of a key, n.key or properties -> 'key',
+ * to a constant uses the statistics of the keys. Anything else is left to the
+ * standard function.
+ */
+static Datum agtype_compare_sel(FunctionCallInfo fcinfo, key_compare_op op,
+                                PGFunction std_func)
+{
+    Selectivity selec;
+
+    if (key_compare_selectivity((PlannerInfo *)PG_GETARG_POINTER(0),
+                                (List *)PG_GETARG_POINTER(2),
+                                PG_GETARG_INT32(3), op, &selec))
+    {
+        PG_RETURN_FLOAT8((float8)selec);
+    }
+
+    return DirectFunctionCall4Coll(std_func, PG_GET_COLLATION(),
+                                   PG_GETARG_DATUM(0), PG_GETARG_DATUM(1),
+                                   PG_GETARG_DATUM(2), PG_GETARG_DATUM(3));
+}
+
+PG_FUNCTION_INFO_V1(agtype_eqsel);
+
+/* Restriction selectivity function of the agtype = operator. */
+Datum agtype_eqsel(PG_FUNCTION_ARGS)
+{
+    return agtype_compare_sel(fcinfo, KEY_COMPARE_EQ, eqsel);
+}
+
+PG_FUNCTION_INFO_V1(agtype_neqsel);
+
+/* Restriction selectivity function of the agtype <> operator. */
+Datum agtype_neqsel(PG_FUNCTION_ARGS)
+{
+    return agtype_compare_sel(fcinfo, KEY_COMPARE_NE, neqsel);
+}
+
+PG_FUNCTION_INFO_V1(agtype_ltsel);
+
+/* Restriction selectivity function of the agtype < operator. */
+Datum agtype_ltsel(PG_FUNCTION_ARGS)
+{
+    return agtype_compare_sel(fcinfo, KEY_COMPARE_LT, scalarltsel);
+}
+
+PG_FUNCTION_INFO_V1(agtype_lesel);
+
+/* Restriction selectivity function of the agtype <= operator. */
+Datum agtype_lesel(PG_FUNCTION_ARGS)
+{
+    return agtype_compare_sel(fcinfo, KEY_COMPARE_LE, scalarlesel);
+}
+
+PG_FUNCTION_INFO_V1(agtype_gtsel);
+
+/* Restriction selectivity function of the agtype > operator. */
+Datum agtype_gtsel(PG_FUNCTION_ARGS)
+{
+    return agtype_compare_sel(fcinfo, KEY_COMPARE_GT, scalargtsel);
+}
+
+PG_FUNCTION_INFO_V1(agtype_gesel);
+
+/* Restriction selectivity function of the agtype >= operator. */
+Datum agtype_gesel(PG_FUNCTION_ARGS)
+{
+    return agtype_compare_sel(fcinfo, KEY_COMPARE_GE, scalargesel);
+}
+
+/*
+ * Helper function to estimate the selectivity of an agtype column with key
+ * statistics containing a constant object. Each of the object's keys is
+ * estimated on its own, and the estimates are multiplied. Keys with an array
+ * or object value are only estimated by how common they are. It returns
+ * false if it can't.
+ */
+static bool contains_selectivity(PlannerInfo *root, List *args, int varRelid,
+                                 Selectivity *selec)
+{
+    VariableStatData vardata;
+    AttStatsSlot sslot;
+    Form_pg_statistic stats;
+    Node *other;
+    bool varonleft;
+    agtype *object;
+    agtype_iterator *it;
+    agtype_iterator_token token;
+    agtype_value key;
+    agtype_value value;
+    bool has_keys = false;
+
+    if (!get_restriction_variable(root, args, varRelid, &vardata, &other,
+                                  &varonleft))
+    {
+        return false;
+    }
+
+    if (!varonleft || !HeapTupleIsValid(vardata.statsTuple) ||
+        !IsA(other, Const) || ((Const *)other)->constisnull ||
+        ((Const *)other)->consttype != AGTYPEOID)
+    {
+        ReleaseVariableStats(vardata);
+        return false;
+    }
+
+    object = DATUM_GET_AGTYPE_P(((Const *)other)->constvalue);
+    if (!AGT_ROOT_IS_OBJECT(object))
+    {
+        ReleaseVariableStats(vardata);
+        return false;
+    }
+
+    /* the fractions of the keys are of all of the rows, NULL ones included */
+    *selec = 1.0;
+
+    it = agtype_iterator_init(&object->root);
+
+    while ((token = agtype_iterator_next(&it, &key, true)) != WAGT_DONE)
+    {
+        key_stats kstats;
+
+        if (token != WAGT_KEY)
+        {
+            continue;
+        }
+
+        token = agtype_iterator_next(&it, &value, true);
+        Assert(token == WAGT_VALUE);
+        has_keys = true;
+
+        if (!get_key_stats(&vardata, &sslot, key.val.string.val,
+                           key.val.string.len, &kstats))
+        {
+            ReleaseVariableStats(vardata);
+            return false;
+        }
+
+        if (value.type == AGTV_NULL)
+        {
+            /* keys with a null value aren't counted */
+            *selec *= DEFAULT_EQ_SEL;
+        }
+        else if (IS_A_AGTYPE_SCALAR(&value))
+        {
+            *selec *= key_eq_selectivity(&kstats,
+                                         agtype_value_to_agtype(&value));
+        }
+        else
+        {
+            *selec *= Min(kstats.frac, DEFAULT_MATCHING_SEL);
+        }
+
+        free_attstatsslot(&sslot);
+    }
+
+    /* an empty object is contained in all of them, but the NULL ones */
+    if (!has_keys)
+    {
+        stats = (Form_pg_statistic)GETSTRUCT(vardata.statsTuple);
+        *selec = 1.0 - stats->stanullfrac;
+    }
+
+    ReleaseVariableStats(vardata);
+
+    CLAMP_PROBABILITY(*selec);
+
+    return true;
+}
+
+PG_FUNCTION_INFO_V1(agtype_contsel);
+
+/*
+ * Restriction selectivity function of the @> and @>> operators. A column
+ * containing a constant object uses the statistics of the keys. Anything else
+ * is left to matchingsel.
+ */
+Datum agtype_contsel(PG_FUNCTION_ARGS)
+{
+    Selectivity selec;
+
+    if (contains_selectivity((PlannerInfo *)PG_GETARG_POINTER(0),
+                             (List *)PG_GETARG_POINTER(2),
+                             PG_GETARG_INT32(3), &selec))
+    {
+        PG_RETURN_FLOAT8((float8)selec);
+    }
+
+    return DirectFunctionCall4Coll(matchingsel, PG_GET_COLLATION(),
+                                   PG_GETARG_DATUM(0), PG_GETARG_DATUM(1),
+                                   PG_GETARG_DATUM(2), PG_GETARG_DATUM(3));
+}
+
+PG_FUNCTION_INFO_V1(agtype_existssel);
+
+/*
+ * Restriction selectivity function of the ? operators. It is the fraction of
+ * rows that have the key, when the agtype column has key statistics.
+ * Anything else is left to matchingsel.
+ */
+Datum agtype_existssel(PG_FUNCTION_ARGS)
+{
+    PlannerInfo *root = (PlannerInfo *)PG_GETARG_POINTER(0);
+    List *args = (List *)PG_GETARG_POINTER(2);
+    int varRelid = PG_GETARG_INT32(3);
+    VariableStatData vardata;
+    AttStatsSlot sslot;
+    key_stats kstats;
+    Node *other;
+    bool varonleft;
+    char *key;
+    int key_len;
+
+    if (get_restriction_variable(root, args, varRelid, &vardata, &other,
+                                 &varonleft))
+    {
+        if (varonleft && IsA(other, Const) &&
+            get_string_key((Const *)other, &key, &key_len) &&
+            get_key_stats(&vardata, &sslot, key, key_len, &kstats))
+        {
+            free_attstatsslot(&sslot);
+            ReleaseVariableStats(vardata);
+
+            PG_RETURN_FLOAT8((float8)kstats.frac);
+        }
+
+        ReleaseVariableStats(vardata);
+    }
+
+    return DirectFunctionCall4Coll(matchingsel, PG_GET_COLLATION(),
+                                   PG_GETARG_DATUM(0), PG_GETARG_DATUM(1),
+                                   PG_GETARG_DATUM(2), PG_GETARG_DATUM(3));
+}
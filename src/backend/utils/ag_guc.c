@@ -19,10 +19,18 @@
 
 #include "postgres.h"
 
+#include "postmaster/bgworker.h"
 #include "utils/guc.h"
 #include "utils/ag_guc.h"
 
 bool age_enable_containment = true;
+bool age_enable_graph_versioning = false;
+bool age_enable_graph_csr = false;
+bool age_enable_lazy_graph_properties = false;
+int age_global_graph_load_workers = 0;
+bool age_enable_agtype_binary_send = false;
+bool age_enable_graph_join_search = true;
+bool age_enable_expand = false;
 
 /*
  * Defines AGE's custom configuration parameters.
@@ -42,5 +50,77 @@ void define_config_params(void)
                              NULL,
                              NULL,
                              NULL);
+    DefineCustomBoolVariable("age.enable_graph_versioning",
+                             "Keep global graph contexts valid until the graph is modified.",
+                             "Only the graph versions are shared. Each backend still loads its own copy of the graph.",
+                             &age_enable_graph_versioning,
+                             false,
+                             PGC_SUSET,
+                             0,
+                             NULL,
+                             NULL,
+                             NULL);
+    DefineCustomBoolVariable("age.enable_graph_csr",
+                             "Build a CSR adjacency for global graph contexts, for faster VLE traversal.",
+                             NULL,
+                             &age_enable_graph_csr,
+                             false,
+                             PGC_USERSET,
+                             0,
+                             NULL,
+                             NULL,
+                             NULL);
+    DefineCustomBoolVariable("age.enable_lazy_graph_properties",
+                             "Load global graph contexts without properties, fetching them when used.",
+                             NULL,
+                             &age_enable_lazy_graph_properties,
+                             false,
+                             PGC_USERSET,
+                             0,
+                             NULL,
+                             NULL,
+                             NULL);
+    DefineCustomIntVariable("age.global_graph_load_workers",
+                            "Sets the maximum number of parallel workers used to load a global graph context.",
+                            NULL,
+                            &age_global_graph_load_workers,
+                            0,
+                            0,
+                            MAX_PARALLEL_WORKER_LIMIT,
+                            PGC_USERSET,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
+    DefineCustomBoolVariable("age.enable_agtype_binary_send",
+                             "Send agtype in the binary format, instead of as text, to clients that ask for binary results.",
+                             NULL,
+                             &age_enable_agtype_binary_send,
+                             false,
+                             PGC_USERSET,
+                             0,
+                             NULL,
+                             NULL,
+                             NULL);
+    DefineCustomBoolVariable("age.enable_graph_join_search",
+                             "Join large MATCH patterns outward from their most selective relation, instead of with the genetic query optimizer.",
+                             NULL,
+                             &age_enable_graph_join_search,
+                             true,
+                             PGC_USERSET,
+                             0,
+                             NULL,
+                             NULL,
+                             NULL);
+    DefineCustomBoolVariable("age.enable_expand",
+                             "Enables the planner's use of Cypher Expand nodes, which join vertices with their edges through the edge label's index.",
+                             NULL,
+                             &age_enable_expand,
+                             false,
+                             PGC_USERSET,
+                             0,
+                             NULL,
+                             NULL,
+                             NULL);
     EmitWarningsOnPlaceholders("age");
 }
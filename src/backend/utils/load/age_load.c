@@ -34,6 +34,7 @@
 #include "utils/rel.h"
 #include "utils/rls.h"
 
+#include "utils/age_global_graph.h"
 #include "utils/load/ag_load_edges.h"
 #include "utils/load/ag_load_labels.h"
 #include "utils/load/age_load.h"
@@ -430,6 +431,8 @@ void insert_edge_simple(Oid graph_oid, char *label_name, graphid edge_id,
                         errmsg("label %s already exists as vertex label", label_name)));
     }
 
+    mark_graph_modified(graph_oid);
+
     /* Open the relation */
     label_relation = table_open(get_label_relation(label_name, graph_oid),
                                 RowExclusiveLock);
@@ -480,6 +483,8 @@ void insert_vertex_simple(Oid graph_oid, char *label_name, graphid vertex_id,
                                 label_name)));
     }
 
+    mark_graph_modified(graph_oid);
+
     /* Open the relation */
     label_relation = table_open(get_label_relation(label_name, graph_oid),
                                 RowExclusiveLock);
@@ -790,6 +795,9 @@ void init_batch_insert(batch_insert_state **batch_state,
     /* Get the relation OID */
     relid = get_label_relation(label_name, graph_oid);
 
+    /* the batches will modify this graph */
+    mark_graph_modified(graph_oid);
+
     /* Initialize executor state */
     estate = CreateExecutorState();
 
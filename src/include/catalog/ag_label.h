@@ -81,6 +81,7 @@ RangeVar *get_label_range_var(char *graph_name, Oid graph_oid,
                               char *label_name);
 
 List *get_all_edge_labels_per_graph(EState *estate, Oid graph_oid);
+Oid get_label_column_index(Relation label_relation, AttrNumber attnum);
 
 #define label_exists(label_name, label_graph) \
     OidIsValid(get_label_id(label_name, label_graph))
@@ -26,6 +26,7 @@
 #define SET_SCAN_STATE_NAME "Cypher Set"
 #define CREATE_SCAN_STATE_NAME "Cypher Create"
 #define MERGE_SCAN_STATE_NAME "Cypher Merge"
+#define EXPAND_SCAN_STATE_NAME "Cypher Expand"
 
 Node *create_cypher_create_plan_state(CustomScan *cscan);
 extern const CustomExecMethods cypher_create_exec_methods;
@@ -39,4 +40,7 @@ extern const CustomExecMethods cypher_delete_exec_methods;
 Node *create_cypher_merge_plan_state(CustomScan *cscan);
 extern const CustomExecMethods cypher_merge_exec_methods;
 
+Node *create_cypher_expand_plan_state(CustomScan *cscan);
+extern const CustomExecMethods cypher_expand_exec_methods;
+
 #endif
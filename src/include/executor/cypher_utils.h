@@ -20,6 +20,7 @@
 #ifndef AG_CYPHER_UTILS_H
 #define AG_CYPHER_UTILS_H
 
+#include "access/genam.h"
 #include "access/heapam.h"
 #include "nodes/execnodes.h"
 
@@ -47,6 +48,45 @@
 
 #define DELETE_VERTEX_HTAB_NAME "delete_vertex_htab"
 #define DELETE_VERTEX_HTAB_SIZE 1000000
+/* pages read by a probe for the edges of a deleted vertex, for costing */
+#define DELETE_INDEX_PROBE_PAGES 3
+
+#define ENTITY_REL_CACHE_NAME "entity_rel_cache"
+#define ENTITY_REL_CACHE_SIZE 8
+
+/*
+ * The state needed to modify the entities of a label. It is set up the first
+ * time a clause modifies the label and kept until the end of the query.
+ */
+typedef struct entity_rel_cache_entry
+{
+    char label_name[NAMEDATALEN];  /* hash key */
+    ResultRelInfo *resultRelInfo;  /* result relation, with its indices open */
+    TupleTableSlot *slot;          /* slot for the label's tuples */
+    Oid id_index;                  /* index on id, InvalidOid if there isn't */
+    bool rls_enabled;              /* is RLS enabled for the label */
+    List *qualExprs;               /* security quals (USING policies) */
+    TupleTableSlot *rls_slot;      /* slot for the old tuple (RLS check) */
+} entity_rel_cache_entry;
+
+/* limits of an entity insert buffer, the same as the loader's batches */
+#define ENTITY_INSERT_BUFFER_SIZE 1000
+#define ENTITY_INSERT_BUFFER_BYTES 65535
+
+/*
+ * Tuples created by a terminal CREATE or MERGE clause are buffered per label
+ * and written with table_multi_insert, instead of one table_tuple_insert per
+ * entity. The tuples of a buffer all share one command id.
+ */
+typedef struct entity_insert_buffer
+{
+    ResultRelInfo *resultRelInfo;
+    TupleTableSlot **slots;
+    int num_tuples;
+    size_t buffered_bytes;
+    CommandId cid;
+    BulkInsertState bistate;
+} entity_insert_buffer;
 
 typedef struct cypher_create_custom_scan_state
 {
@@ -57,6 +97,7 @@ typedef struct cypher_create_custom_scan_state
     uint32 flags;
     TupleTableSlot *slot;
     Oid graph_oid;
+    List *insert_buffers; /* entity_insert_buffers of a terminal CREATE */
 } cypher_create_custom_scan_state;
 
 typedef struct cypher_set_custom_scan_state
@@ -65,6 +106,7 @@ typedef struct cypher_set_custom_scan_state
     CustomScan *cs;
     cypher_update_information *set_list;
     int flags;
+    HTAB *label_cache; /* per label state, kept for the whole query */
 } cypher_set_custom_scan_state;
 
 typedef struct cypher_delete_custom_scan_state
@@ -74,6 +116,15 @@ typedef struct cypher_delete_custom_scan_state
     cypher_delete_information *delete_data;
     int flags;
     List *edge_labels;
+    HTAB *label_cache; /* per label state, kept for the whole query */
+
+    /*
+     * Entities waiting to be deleted, as a list of delete_batches holding the
+     * TIDs of each label. A terminal DELETE, and the DETACH of connected
+     * edges, collect their targets here and delete them in physical order
+     * once all of them are known.
+     */
+    List *delete_batches;
 
     /*
      * Deleted vertex IDs are stored in this hashtable.
@@ -83,13 +134,9 @@ typedef struct cypher_delete_custom_scan_state
      * thrown depending on the DETACH option. However, the check for connected
      * edges is not done immediately. Instead the deleted vertex IDs are stored
      * in the hashtable. Once all vertices are deleted, this hashtable is used
-     * to process the connected edges with only one scan of the edge tables.
-     *
-     * Note on performance: Additional performance gain may be possible if
-     * the standard DELETE .. USING .. command can be used instead of this
-     * hashtable. Because Postgres may create a better plan to execute that
-     * command depending on the statistics and available indexes on start_id
-     * and end_id column.
+     * to process the connected edges, either with only one scan of each edge
+     * table or, when few vertices were deleted, by probing the start_id and
+     * end_id indexes for each of them.
      */
     HTAB *vertex_id_htab;
 } cypher_delete_custom_scan_state;
@@ -107,9 +154,39 @@ typedef struct cypher_merge_custom_scan_state
     bool created_new_path;
     bool found_a_path;
     CommandId base_currentCommandId;
-    struct created_path *created_paths_list;
+    HTAB *created_paths; /* paths created when there is a previous clause */
+    bool buffer_inserts;
+    List *insert_buffers; /* entity_insert_buffers of a terminal MERGE */
 } cypher_merge_custom_scan_state;
 
+typedef struct cypher_expand_custom_scan_state
+{
+    CustomScanState css;
+    CustomScan *cs;
+    Oid relid; /* the edge label table */
+    Oid index_oid; /* its index on start_id or end_id */
+    int outer_natts; /* the outer row is the start of the scan tuple */
+    Relation rel;
+    Relation index_rel;
+    IndexScanDesc index_scan;
+    IndexFetchTableData *fetch;
+    TupleTableSlot *outer_slot;
+    TupleTableSlot *edge_slot;
+    ExprState *key_expr;
+
+    /*
+     * The TIDs of the edges of the current outer row, sorted so that the heap
+     * is read in physical order. The blocks are prefetched ahead of next_tid.
+     */
+    ItemPointerData *tids;
+    int ntids;
+    int max_tids;
+    int next_tid;
+    int next_prefetch;
+    BlockNumber last_prefetched;
+    bool call_again;
+} cypher_expand_custom_scan_state;
+
 TupleTableSlot *populate_vertex_tts(TupleTableSlot *elemTupleSlot,
                                     agtype_value *id, agtype_value *properties);
 TupleTableSlot *populate_edge_tts(
@@ -120,6 +197,16 @@ ResultRelInfo *create_entity_result_rel_info(EState *estate, char *graph_name,
                                              char *label_name);
 void destroy_entity_result_rel_info(ResultRelInfo *result_rel_info);
 
+HTAB *create_entity_rel_cache(EState *estate);
+entity_rel_cache_entry *get_entity_rel_cache_entry(HTAB *label_cache,
+                                                   CustomScanState *node,
+                                                   char *graph_name,
+                                                   char *label_name,
+                                                   CmdType cmd);
+void destroy_entity_rel_cache(HTAB *label_cache);
+HeapTuple fetch_entity_tuple(EState *estate, entity_rel_cache_entry *entry,
+                             graphid id);
+
 bool entity_exists(EState *estate, Oid graph_oid, graphid id);
 HeapTuple insert_entity_tuple(ResultRelInfo *resultRelInfo,
                               TupleTableSlot *elemTupleSlot,
@@ -128,6 +215,18 @@ HeapTuple insert_entity_tuple_cid(ResultRelInfo *resultRelInfo,
                                   TupleTableSlot *elemTupleSlot,
                                   EState *estate, CommandId cid);
 
+/* batched inserts */
+entity_insert_buffer *get_entity_insert_buffer(List **buffers,
+                                               ResultRelInfo *resultRelInfo,
+                                               EState *estate);
+void buffer_entity_tuple(entity_insert_buffer *buffer,
+                         TupleTableSlot *elemTupleSlot, EState *estate,
+                         CommandId cid);
+void flush_entity_insert_buffer(entity_insert_buffer *buffer,
+                                EState *estate);
+void flush_entity_insert_buffers(List *buffers, EState *estate);
+void free_entity_insert_buffers(List *buffers);
+
 /* RLS support */
 void setup_wcos(ResultRelInfo *resultRelInfo, EState *estate,
                 CustomScanState *node, CmdType cmd);
@@ -137,16 +236,4 @@ bool check_security_quals(List *qualExprs, TupleTableSlot *slot,
                           ExprContext *econtext);
 bool check_rls_for_tuple(Relation rel, HeapTuple tuple, CmdType cmd);
 
-/* Hash table entry for caching RLS state per label */
-typedef struct RLSCacheEntry
-{
-    Oid relid;                      /* hash key */
-    /* Security quals (USING policies) for UPDATE/DELETE */
-    List *qualExprs;
-    TupleTableSlot *slot;           /* slot for old tuple (RLS check) */
-    /* WCOs - used only in SET */
-    List *withCheckOptions;
-    List *withCheckOptionExprs;
-} RLSCacheEntry;
-
 #endif
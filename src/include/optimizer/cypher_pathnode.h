@@ -24,6 +24,7 @@
 #define SET_PATH_NAME "Cypher Set"
 #define DELETE_PATH_NAME "Cypher Delete"
 #define MERGE_PATH_NAME "Cypher Merge"
+#define EXPAND_PATH_NAME "Cypher Expand"
 
 CustomPath *create_cypher_create_path(PlannerInfo *root, RelOptInfo *rel,
                                       List *custom_private);
@@ -33,5 +34,9 @@ CustomPath *create_cypher_delete_path(PlannerInfo *root, RelOptInfo *rel,
                                       List *custom_private);
 CustomPath *create_cypher_merge_path(PlannerInfo *root, RelOptInfo *rel,
                                      List *custom_private);
+CustomPath *create_cypher_expand_path(PlannerInfo *root, RelOptInfo *joinrel,
+                                      Path *outer_path, RelOptInfo *innerrel,
+                                      IndexOptInfo *index, Expr *outer_key,
+                                      List *quals);
 
 #endif
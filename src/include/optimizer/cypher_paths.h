@@ -22,5 +22,9 @@
 
 void set_rel_pathlist_init(void);
 void set_rel_pathlist_fini(void);
+void join_search_init(void);
+void join_search_fini(void);
+void set_join_pathlist_init(void);
+void set_join_pathlist_fini(void);
 
 #endif
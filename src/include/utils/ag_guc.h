@@ -39,6 +39,65 @@
  */
 extern bool age_enable_containment;
 
+/*
+ * If set true, global graph contexts stay valid until a graph is modified,
+ * as tracked by a per graph version shared by all backends. Otherwise, they
+ * are rebuilt whenever the active snapshot changes. Cypher writes are
+ * applied to the existing contexts from a shared change log, as are writes
+ * done with plain SQL on the label tables, through the triggers every label
+ * table is created with. A graph modified by a prepared transaction is
+ * reloaded once that transaction has finished. Only the invalidation is
+ * shared, each backend still loads its own copy of the graph.
+ */
+extern bool age_enable_graph_versioning;
+
+/*
+ * If set true, frozen global graph contexts also build a compressed sparse row
+ * (CSR) adjacency, which VLE uses to walk the edges of a vertex. It costs extra
+ * memory, about as much again as the edge lists. Versioned contexts are never
+ * frozen, so they don't have one.
+ */
+extern bool age_enable_graph_csr;
+
+/*
+ * If set true, global graph contexts are loaded without the vertex and edge
+ * properties. The properties are fetched from the label tables the first
+ * time they are used, and are then kept. This saves memory and load time when
+ * most of the properties are never looked at, such as for a VLE that only
+ * matches on the edge label.
+ */
+extern bool age_enable_lazy_graph_properties;
+
+/*
+ * The maximum number of parallel workers used to load the label tables of a
+ * global graph context. The workers scan the label tables, while the backend
+ * builds the context. If set to 0, the backend loads them by itself.
+ */
+extern int age_global_graph_load_workers;
+
+/*
+ * If set true, agtype is sent to clients that ask for binary results, and by
+ * COPY ... BINARY, in the binary format (version 2). Otherwise, it is sent as
+ * text (version 1), which older clients expect. Both are always accepted.
+ */
+extern bool age_enable_agtype_binary_send;
+
+/*
+ * If set true, join problems from MATCH patterns that are large enough for
+ * the genetic query optimizer are instead ordered from their most selective
+ * relation outward, joining the neighbour that keeps the estimated result
+ * smallest at each step.
+ */
+extern bool age_enable_graph_join_search;
+
+/*
+ * If set true, the planner also considers joining a stream of vertices with
+ * an edge label through a Cypher Expand node, which probes the label's index
+ * on start_id or end_id for each vertex and reads the edges found in physical
+ * order. It competes with the regular joins on cost.
+ */
+extern bool age_enable_expand;
+
 void define_config_params(void);
 
 #endif
@@ -20,6 +20,11 @@
 #ifndef AG_AGE_GLOBAL_GRAPH_H
 #define AG_AGE_GLOBAL_GRAPH_H
 
+#include "access/htup.h"
+#include "storage/dsm.h"
+#include "storage/shm_toc.h"
+#include "utils/relcache.h"
+
 #include "utils/age_graphid_ds.h"
 
 /*
@@ -36,11 +41,35 @@ typedef struct edge_entry edge_entry;
 
 typedef struct GRAPH_global_context GRAPH_global_context;
 
+/* an edge, and the vertex on its other end, in a CSR adjacency */
+typedef struct graph_csr_edge
+{
+    graphid edge_id;               /* edge id */
+    graphid vertex_id;             /* vertex on the other end of the edge */
+    Oid edge_label_table_oid;      /* the edge's label table oid */
+} graph_csr_edge;
+
+/* kinds of changes that can be recorded against a graph */
+typedef enum graph_change_kind
+{
+    GRAPH_CHANGE_INSERT,           /* entity was inserted */
+    GRAPH_CHANGE_UPDATE,           /* entity properties were updated */
+    GRAPH_CHANGE_DELETE,           /* entity was deleted */
+    GRAPH_CHANGE_RELOAD            /* untracked change, the graph must reload */
+} graph_change_kind;
+
 /* GRAPH global context functions */
 GRAPH_global_context *manage_GRAPH_global_contexts(char *graph_name,
                                                    Oid graph_oid);
 GRAPH_global_context *find_GRAPH_global_context(Oid graph_oid);
 bool is_ggctx_invalid(GRAPH_global_context *ggctx);
+/* graph version and change tracking functions */
+void record_graph_change(Relation label_relation, graph_change_kind kind,
+                         HeapTuple tuple);
+void mark_graph_modified(Oid graph_oid);
+void release_graph_version(Oid graph_oid);
+/* parallel load worker entry point */
+PGDLLEXPORT void age_global_graph_load_main(dsm_segment *seg, shm_toc *toc);
 /* GRAPH retrieval functions */
 ListGraphId *get_graph_vertices(GRAPH_global_context *ggctx);
 vertex_entry *get_vertex_entry(GRAPH_global_context *ggctx,
@@ -51,6 +80,19 @@ graphid get_vertex_entry_id(vertex_entry *ve);
 ListGraphId *get_vertex_entry_edges_in(vertex_entry *ve);
 ListGraphId *get_vertex_entry_edges_out(vertex_entry *ve);
 ListGraphId *get_vertex_entry_edges_self(vertex_entry *ve);
+/* CSR adjacency accessor functions */
+bool has_GRAPH_global_csr(GRAPH_global_context *ggctx);
+int64 get_GRAPH_global_csr_num_vertices(GRAPH_global_context *ggctx);
+int64 get_vertex_entry_csr_index(vertex_entry *ve);
+graph_csr_edge *get_vertex_entry_csr_edges_out(GRAPH_global_context *ggctx,
+                                               vertex_entry *ve,
+                                               int64 *num_edges);
+graph_csr_edge *get_vertex_entry_csr_edges_in(GRAPH_global_context *ggctx,
+                                              vertex_entry *ve,
+                                              int64 *num_edges);
+graph_csr_edge *get_vertex_entry_csr_edges_self(GRAPH_global_context *ggctx,
+                                                vertex_entry *ve,
+                                                int64 *num_edges);
 Oid get_vertex_entry_label_table_oid(vertex_entry *ve);
 Datum get_vertex_entry_properties(vertex_entry *ve);
 /* edge entry accessor functions */
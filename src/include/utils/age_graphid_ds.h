@@ -66,6 +66,8 @@ int64 get_stack_size(ListGraphId *stack);
  * If the container is NULL, it creates the container with the entry.
  */
 ListGraphId *append_graphid(ListGraphId *container, graphid id);
+/* remove the first matching graphid from a ListGraphId container */
+bool remove_graphid(ListGraphId *container, graphid id);
 /* free a ListGraphId container */
 void free_ListGraphId(ListGraphId *container);
 /* return a reference to the head entry of a list */